@@ -38,6 +38,18 @@ else(UNIX)
 	find_package_handle_standard_args(FFTW  DEFAULT_MSG FFTW_BASE_LIB FFTW_INCLUDE_DIR)
 endif(UNIX)
 
+# fftw >= 3.3.9 allows to run its threads on our own thread pool
+if(FFTW_FOUND)
+	include(CheckSymbolExists)
+	include(CMakePushCheckState)
+	cmake_push_check_state(RESET)
+	set(CMAKE_REQUIRED_INCLUDES ${FFTW_INCLUDE_DIRS})
+	set(CMAKE_REQUIRED_LIBRARIES ${FFTW_LIBRARIES} pthread)
+	set(CMAKE_REQUIRED_QUIET ON)
+	check_symbol_exists(fftw_threads_set_callback fftw3.h FFTW_HAS_THREADS_CALLBACK)
+	cmake_pop_check_state()
+endif()
+
 # Make imported targets
 add_library(fftw::fftw INTERFACE IMPORTED)
 set_property(TARGET fftw::fftw APPEND PROPERTY INTERFACE_INCLUDE_DIRECTORIES ${FFTW_INCLUDE_DIRS})
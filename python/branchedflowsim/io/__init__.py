@@ -5,3 +5,4 @@ from .read_data import read_int, read_float, read_grid, is_potential_file, is_ve
 from .write_data import write_int, write_float, write_grid
 from .data_spec import DataSpec, Reductions
 from .result_file import ResultFile, load_result
+from .ray_file import RayFile
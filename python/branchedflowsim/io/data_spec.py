@@ -16,6 +16,9 @@ class Reductions(object):
     during the calculation.
     """
 
+    # number of elements that are added at once by `add`.
+    CHUNK_ELEMENTS = 1 << 20
+
     @staticmethod
     def equal(a, b):
         """
@@ -32,10 +35,27 @@ class Reductions(object):
         If they are not scalar, they will be converted to numpy arrays.
         (So adding to lists of the same length will result
         in an array that contains the element-wise sum).
+        Read-only arrays, e.g. memory mapped grids, are not changed: If `a` is read-only,
+        the sum is accumulated into a copy of it. `b` is never changed.
+        Large arrays are added in chunks, so that memory mapped data is read piece by piece.
         """
-        if not isinstance(a, numbers.Number):
-            a = np.asarray(a)
-        a += b
+        if isinstance(a, numbers.Number):
+            a += b
+            return a
+
+        a = np.asarray(a)
+        b = np.asarray(b)
+        if not a.flags.writeable:
+            a = np.array(a, dtype=np.result_type(a, b))
+
+        if a.ndim == 0 or b.shape != a.shape or not a.flags.c_contiguous:
+            a += b
+            return a
+
+        flat_a = a.reshape(-1)
+        flat_b = b.reshape(-1)
+        for start in range(0, flat_a.size, Reductions.CHUNK_ELEMENTS):
+            flat_a[start:start + Reductions.CHUNK_ELEMENTS] += flat_b[start:start + Reductions.CHUNK_ELEMENTS]
         return a
 
     @staticmethod
@@ -158,7 +178,7 @@ class DataSpec(namedtuple("_DataSpec", ("name", "type", "count", "is_attr", "red
         else:
             return "DataSpec(%r, %r, %r)" % (self.name, self.type, self.count)
 
-    def read(self, file_, data):
+    def read(self, file_, data, mmap=False):
         """
         Reads the entry specified by `self` from `file_` and puts the value into `data`.
         In case the reading causes the exception, additional information will be logged.
@@ -166,16 +186,17 @@ class DataSpec(namedtuple("_DataSpec", ("name", "type", "count", "is_attr", "red
         :param BinaryIO file_: File from which to read.
         :param dict data: Dict in which to put the value. Data already present in the dict will /
             be used to determine dynamic read counts.
+        :param bool mmap: If set, grids are memory mapped instead of read, see `read_grid`.
         :return: The value that was read.
         """
         try:
-            return self._read(file_, data)
+            return self._read(file_, data, mmap)
         except Exception as E:
             # pass through io exceptions, but log the corresponding DataSpec instance
             logger.error("An error %r occurred when reading data for spec '%s' (%r)", E, self.name, self)
             raise
 
-    def _read(self, file_, data):
+    def _read(self, file_, data, mmap=False):
         """
         Implementation of read.
         """
@@ -185,7 +206,7 @@ class DataSpec(namedtuple("_DataSpec", ("name", "type", "count", "is_attr", "red
 
         # and delegate to the corresponding reader.
         if type_ is "grid":
-            result = read_grid(file_, shape)
+            result = read_grid(file_, shape, mmap)
         elif type_ is int:
             result = read_int(file_, shape)
         elif type_ is float:
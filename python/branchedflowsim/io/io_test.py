@@ -124,6 +124,47 @@ def test_grid_round_trip_int(int_type, file_):
     assert np.all(loaded == array)
 
 
+@pytest.mark.parametrize("data_type", [np.float64, np.float32, np.uint32])
+def test_grid_round_trip_compressed(data_type, file_):
+    # large enough to be split into several chunks
+    array = (np.random.random((300, 1001)) * 100).astype(data_type)
+    write_grid(file_, array, compress=True)
+    write_grid(file_, array[:2, :3], compress=True)
+
+    file_.seek(0)
+    loaded = read_grid(file_, 2)
+
+    assert loaded[0].dtype == data_type
+    assert np.all(loaded[0] == array)
+    assert np.all(loaded[1] == array[:2, :3])
+
+
+def test_grid_mmap(file_):
+    array = np.random.random((5, 17))
+    write_grid(file_, array)
+    write_grid(file_, array[:2, :3], compress=True)
+    write_int(file_, 7)
+
+    file_.seek(0)
+    mapped, compressed = read_grid(file_, 2, mmap=True)
+    assert isinstance(mapped, np.memmap)
+    assert not mapped.flags.writeable
+    assert np.all(mapped == array)
+    # compressed grids are read
+    assert not isinstance(compressed, np.memmap)
+    assert np.all(compressed == array[:2, :3])
+    # the file position is behind the grids
+    assert read_int(file_) == 7
+
+
+def test_grid_mmap_truncated(file_):
+    write_grid(file_, np.random.random((5, 17)))
+    file_.truncate(file_.tell() - 8)
+    file_.seek(0)
+    with pytest.raises(IOError):
+        read_grid(file_, mmap=True)
+
+
 def test_write_grid_unsupported_dtype(file_):
     array = np.random.randint(0, 10, size=(5, 17)).astype(np.complex)
     with pytest.raises(TypeError):
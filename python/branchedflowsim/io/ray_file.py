@@ -0,0 +1,92 @@
+"""
+Binary files of initial rays, which the tracer reads with the `file` initial condition.
+"""
+
+import numpy as np
+
+from .data_spec import DataSpec
+from .result_file import ResultFile
+
+
+def ray_record_type(dim, weighted):
+    """ numpy type descriptor for a single ray of a ray file of dimension `dim`.
+    """
+    entries = [("position", np.double, (dim,)),
+               ("velocity", np.double, (dim,))]
+    if weighted:
+        entries.append(("weight", np.double))
+    return np.dtype(entries)
+
+
+class RayFile(ResultFile):
+    """
+    Initial positions, velocities and optionally weights of rays. Positions are given in world coordinates.
+    Use `from_arrays` to create a ray file from given rays, or `from_trajectories` to continue the rays of
+    a previous run that recorded their trajectories.
+    """
+    _FILE_HEADER_ = 'rays001\n'
+    _SPEC_ = (DataSpec("dimension", int),
+              DataSpec("weighted", int),
+              DataSpec("num_rays", int, is_attr=False),
+              DataSpec("rays", lambda d: ray_record_type(d["dimension"], d["weighted"]), "num_rays",
+                       reduction="concat")
+              )
+
+    def __init__(self, source=None):
+        super(RayFile, self).__init__(source)
+
+    def _from_dict(self, data):
+        self.positions = self.rays["position"]
+        self.velocities = self.rays["velocity"]
+        self.weights = self.rays["weight"] if self.weighted else np.ones(len(self.rays))
+
+    def _to_file(self, data):
+        data["num_rays"] = len(self.rays)
+
+    @classmethod
+    def from_arrays(cls, positions, velocities, weights=None):
+        """ creates a ray file from arrays of shape (N, dim) for `positions` and `velocities`, and
+            optionally N `weights`.
+        """
+        positions = np.asarray(positions, dtype=np.double)
+        velocities = np.asarray(velocities, dtype=np.double)
+        if positions.ndim != 2 or positions.shape != velocities.shape:
+            raise ValueError("Got positions of shape {} and velocities of shape {}".format(positions.shape,
+                                                                                          velocities.shape))
+
+        dim = positions.shape[1]
+        rays = np.zeros(len(positions), dtype=ray_record_type(dim, weights is not None))
+        rays["position"] = positions
+        rays["velocity"] = velocities
+        if weights is not None:
+            rays["weight"] = weights
+        return cls({"dimension": dim, "weighted": int(weights is not None), "rays": rays})
+
+    @classmethod
+    def from_trajectories(cls, trajectories, time=None, selection=None):
+        """ creates a ray file from the last recorded sample of each trajectory, or the last sample not later
+            than `time`.
+
+        :param branchedflowsim.results.Trajectories trajectories: Output of the trajectory observer.
+        :param float time: Latest sample time to use.
+        :param callable selection: If given, only rays for which `selection(positions, velocities)` is True
+                                   are kept.
+        """
+        samples = trajectories.trajectories
+        if time is not None:
+            samples = samples[samples["time"] <= time]
+
+        # sort by trajectory, then time, and take the last entry of each trajectory
+        order = np.lexsort((samples["time"], samples["trajectory"]))
+        samples = samples[order]
+        is_last = np.ones(len(samples), dtype=bool)
+        is_last[:-1] = samples["trajectory"][1:] != samples["trajectory"][:-1]
+        samples = samples[is_last]
+
+        positions = samples["position"]
+        velocities = samples["velocity"]
+        if selection is not None:
+            keep = np.asarray(selection(positions, velocities), dtype=bool)
+            positions = positions[keep]
+            velocities = velocities[keep]
+        return cls.from_arrays(positions, velocities)
@@ -0,0 +1,50 @@
+import numpy as np
+
+from ..test_utils import *
+from .ray_file import RayFile
+from ..results.trajectories import Trajectories, trajectory_sample_type
+
+
+def test_roundtrip(file_):
+    rays = RayFile.from_arrays([[0.1, 0.2], [0.3, 0.4]], [[1.0, 0.0], [0.0, 1.0]], weights=[0.5, 2.0])
+    rays.to_file(file_)
+
+    file_.seek(0)
+    data = file_.read()
+    assert data.startswith(b'rays001\n')
+    # header, three integers and two records of five doubles
+    assert len(data) == 8 + 3 * 8 + 2 * 5 * 8
+
+    file_.seek(0)
+    loaded = RayFile(file_)
+    assert loaded.dimension == 2
+    assert loaded.weighted == 1
+    assert np.allclose(loaded.positions, [[0.1, 0.2], [0.3, 0.4]])
+    assert np.allclose(loaded.velocities, [[1.0, 0.0], [0.0, 1.0]])
+    assert np.allclose(loaded.weights, [0.5, 2.0])
+
+
+def test_unweighted():
+    rays = RayFile.from_arrays(np.zeros((3, 3)), np.ones((3, 3)))
+    assert rays.weighted == 0
+    assert np.allclose(rays.weights, 1.0)
+
+    with pytest.raises(ValueError):
+        RayFile.from_arrays(np.zeros((3, 3)), np.ones((3, 2)))
+
+
+def test_from_trajectories():
+    samples = np.zeros(6, dtype=trajectory_sample_type(2))
+    samples["trajectory"] = [1, 0, 1, 0, 0, 1]
+    samples["time"] = [0.0, 0.0, 1.0, 2.0, 1.0, 2.0]
+    samples["position"][:, 0] = np.arange(6)
+    trajectories = Trajectories({"dimension": 2, "max_index": 1, "trajectories": samples})
+
+    last = RayFile.from_trajectories(trajectories)
+    assert np.allclose(last.positions[:, 0], [3, 5])
+
+    early = RayFile.from_trajectories(trajectories, time=1.5)
+    assert np.allclose(early.positions[:, 0], [4, 2])
+
+    selected = RayFile.from_trajectories(trajectories, selection=lambda p, v: p[:, 0] > 4)
+    assert np.allclose(selected.positions[:, 0], [5])
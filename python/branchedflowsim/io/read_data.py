@@ -5,8 +5,13 @@ Created on Fri Jan 09 17:30:14 2015
 @author: Erik
 """
 
+import zlib
 import numpy as np
 from collections import Iterable
+from multiprocessing.pool import ThreadPool
+
+# prefix of the type string of grids that are saved in compressed form.
+COMPRESSED_GRID_MARKER = 'zlib:'
 
 
 def read_int(f, count=1):
@@ -54,13 +59,17 @@ def read_array(file_, dtype, count=1):
     return result
 
 
-def read_grid(file_, count=1):
+def read_grid(file_, count=1, mmap=False):
     """ 
     Loads a grid saved from c++ from a file. This is basically an array with a shape and data type
-    assigned to it.
+    assigned to it. Grids saved in compressed form (byte-shuffled, deflated chunks) are decompressed
+    transparently, using several threads for grids that consist of multiple chunks.
     
     :param BinaryIO file_: File object from which the grid is loaded. Has to be open in binary mode.
     :param int count: Number of grids to read.
+    :param bool mmap: If set, uncompressed grids are not read, but returned as read-only `np.memmap` views of \
+        the file. Only the header of the grid is read, and the file position is moved past its data. \
+        Compressed grids are always read.
     :return np.ndarray: A numpy array representing the grid data in correct shape, or a list of numpy arrays \
         in case of `count != 1`.
     :raises IOError: If the file does not contain a grid at the current position, or any form of data corruption could \
@@ -68,16 +77,16 @@ def read_grid(file_, count=1):
     :raises NotImplementedError: If the data type in the grid is not one of `int64`, `uint64`, `float64`, \
         `float32`, `uint32`.
     """
-    data = [_read_single_grid(file_) for _ in range(count)]
+    data = [_read_single_grid(file_, mmap) for _ in range(count)]
     if count == 1:
         return data[0]
     else:
         return data
 
 
-def _read_single_grid(file_):
+def _read_single_grid(file_, mmap=False):
     """
-    Reads a single data grid from `file_`.
+    Reads a single data grid from `file_`, or maps it if `mmap` is set and it is not compressed.
     """
     # read header
     if file_.read(1) != 'g':
@@ -89,22 +98,96 @@ def _read_single_grid(file_):
     if len(size) != dim:
         raise IOError("Corrupt grid data, trying to read {} dimensions but got {}".format(dim, len(size)))
 
-    data_type = _read_dtype(file_)
+    data_type, compressed = _read_dtype(file_)
     num_elements = read_int(file_)
 
     if num_elements != np.prod(size):
         raise IOError("Number of elements {} are incompatible with specified shape {}".format(num_elements, size))
 
+    if compressed:
+        return _read_compressed(file_, data_type, num_elements).reshape(size)
+    if mmap:
+        return _map_array(file_, data_type, tuple(int(extent) for extent in size))
     return read_array(file_, data_type, size)
 
 
+def _map_array(file_, dtype, shape):
+    """
+    Maps the array of type `dtype` and shape `shape` at the current position of `file_`, and moves
+    the file position to its end.
+    """
+    offset = file_.tell()
+    nbytes = int(np.prod(shape)) * np.dtype(dtype).itemsize
+    file_.seek(0, 2)
+    if file_.tell() < offset + nbytes:
+        raise IOError("Expected {} bytes of grid data but the file ends after {}".format(nbytes,
+                                                                                       file_.tell() - offset))
+    if nbytes == 0:
+        result = np.empty(shape, dtype=dtype)
+    else:
+        result = np.memmap(file_, dtype=dtype, mode="r", offset=offset, shape=shape)
+    # np.memmap may move the file position
+    file_.seek(offset + nbytes)
+    return result
+
+
+def _read_compressed(file_, dtype, count):
+    """
+    Reads the chunk table and the chunks of a compressed grid with `count` elements of type `dtype`,
+    and returns the decompressed data as a flat array.
+    """
+    chunk_elements = read_int(file_)
+    chunk_count = read_int(file_)
+    sizes = np.atleast_1d(read_array(file_, np.uint64, chunk_count))
+    if chunk_count != (count + chunk_elements - 1) // chunk_elements:
+        raise IOError("Corrupt grid data, got {} chunks for {} elements".format(chunk_count, count))
+
+    payloads = [file_.read(int(size)) for size in sizes]
+    if any(len(payload) != size for payload, size in zip(payloads, sizes)):
+        raise IOError("Corrupt grid data, compressed chunks are incomplete")
+
+    itemsize = np.dtype(dtype).itemsize
+    result = np.empty(count, dtype=dtype)
+
+    def decode(index):
+        start = index * chunk_elements
+        elements = min(chunk_elements, count - start)
+        raw = np.frombuffer(zlib.decompress(payloads[index]), dtype=np.uint8)
+        if len(raw) != elements * itemsize:
+            raise IOError("Corrupt grid data in chunk {}".format(index))
+        # undo the byte shuffle: the file contains all first bytes, then all second bytes etc.
+        result[start:start + elements] = raw.reshape(itemsize, elements).T.copy().view(dtype).ravel()
+
+    if chunk_count > 1:
+        # zlib releases the GIL, so threads decompress in parallel
+        pool = ThreadPool()
+        try:
+            pool.map(decode, range(chunk_count))
+        finally:
+            pool.close()
+            pool.join()
+    else:
+        for index in range(chunk_count):
+            decode(index)
+    return result
+
+
 def _read_dtype(f):
+    """
+    Reads the type string of a grid.
+
+    :return: The numpy data type and whether the grid data is compressed.
+    """
     typestr = ''
+    compressed = False
     while True:
         c = f.read(1)  # type: chr
         if c != '\0':
             typestr += c
-            if not c.isalnum():
+            if typestr == COMPRESSED_GRID_MARKER:
+                compressed = True
+                typestr = ''
+            elif not c.isalnum() and not COMPRESSED_GRID_MARKER.startswith(typestr):
                 raise IOError("Invalid type string {}".format(typestr))
         else:
             break
@@ -120,7 +203,7 @@ def _read_dtype(f):
         data_type = np.uint32
     else:
         raise NotImplementedError("unsupported grid type %r" % typestr)
-    return data_type
+    return data_type, compressed
 
 
 def is_potential_file(filename):
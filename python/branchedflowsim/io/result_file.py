@@ -30,17 +30,39 @@ class ResultFile(object):
         """
         if source is not None:
             if isinstance(source, (str, unicode)):
-                if os.path.isfile(source):
-                    self.from_file(source)
-                elif hasattr(self, "_FILE_NAME_"):
-                    self.from_file(os.path.join(source, self._FILE_NAME_))
-                else:
-                    raise IOError("Could not open result {}".format(source))
+                self.from_file(self._find_file(source))
             elif isinstance(source, dict):
                 self.from_dict(source)
             else:
                 self.from_file(source)
 
+    @classmethod
+    def memory_mapped(cls, source):
+        """
+        Creates a result from the file (or directory with the default `_FILE_NAME_`) `source`, whose grids
+        are memory mapped instead of read. This only reads the metadata of the file, and the grid data when
+        it is accessed. The mapped grids are read-only; `reduce` does not change them.
+
+        :param str|BinaryIO source: File name, directory or opened file.
+        """
+        result = cls(None)
+        if isinstance(source, (str, unicode)):
+            source = result._find_file(source)
+        result.from_file(source, mmap=True)
+        return result
+
+    def _find_file(self, path):
+        """
+        Returns `path` if it is a file, otherwise the default `_FILE_NAME_` inside the directory `path`.
+        :raises IOError: If `path` is not a file and there is no default file name.
+        """
+        if os.path.isfile(path):
+            return path
+        elif hasattr(self, "_FILE_NAME_"):
+            return os.path.join(path, self._FILE_NAME_)
+        else:
+            raise IOError("Could not open result {}".format(path))
+
     @property
     def spec(self):
         """
@@ -50,19 +72,20 @@ class ResultFile(object):
         """
         return getattr(self, "_SPEC_")
 
-    def from_file(self, source_file):
+    def from_file(self, source_file, mmap=False):
         """
         Loads the data from a file, that can be either specified as a filename string, or an already opened file.
         This checks the file header (if specified) and then reads all data according to the objects `_SPEC_`.
         Additional postprocessing can be performed with a user defined `_from_file` function, then the gathered
         data will be passed on to the `from_dict` function.
         
+        :param bool mmap: If set, grids are memory mapped instead of read, see `read_grid`.
         :raises IOError: if the file header does not match the specified `_FILE_HEADER_`.
         """
 
         if isinstance(source_file, (str, unicode)):
             with open(source_file, "rb") as opened_file:
-                self.from_file(opened_file)
+                self.from_file(opened_file, mmap)
                 return
 
         # if a _FILE_HEADER_ is specified, check that it is present
@@ -75,7 +98,7 @@ class ResultFile(object):
         # now read the file as far as _SPEC_ goes
         data = {}
         for spec in self.spec:  # type: DataSpec
-            spec.read(source_file, data)
+            spec.read(source_file, data, mmap)
 
         self._from_file(source_file, data)
         self.from_dict(data)
@@ -136,7 +159,11 @@ class ResultFile(object):
           for next_result in generate_results():
               result = next_result.reduce(result)
         
-        The operation does modify `self`, and returns a new reference just for convenience.
+        The operation does modify `self`, and returns a new reference just for convenience. `other` is
+        not changed. Memory mapped grids (see `memory_mapped`) are not modified either: Those of `self`
+        are copied into a writeable array, those of `other` are added chunk by chunk. To keep only the
+        sums in memory when reducing many mapped results, reduce into the accumulated result, i.e.
+        `result = next_result if result is None else result.reduce(next_result)`.
         
         :param ResultFile other: the result file to be merged with this one, of the same type as `self`, or `None`.
         :return: `self`.
@@ -184,14 +211,15 @@ class ResultFile(object):
         pass
 
 
-def load_result(file_or_filename):
+def load_result(file_or_filename, mmap=False):
     """
     Load a ResultFile object from a given file. The correct subclass is chosen according to the first bytes in the file.
     :param str|BinaryIO file_or_filename: A filename, or an opened file object.
+    :param bool mmap: If set, grids are memory mapped instead of read, see `ResultFile.memory_mapped`.
     :return:
     """
     if isinstance(file_or_filename, (str, unicode)):
-        return load_result(open(file_or_filename, "rb"))
+        return load_result(open(file_or_filename, "rb"), mmap)
 
     file_ = file_or_filename  # type: file
     # iterate over all
@@ -202,6 +230,6 @@ def load_result(file_or_filename):
         init_bytes = file_.read(len(header))
         file_.seek(0)
         if init_bytes == header:
-            return type_(file_)
+            return type_.memory_mapped(file_) if mmap else type_(file_)
 
     raise IOError("Could not find a suitable ResultsFile subtype for file %s" % file_)
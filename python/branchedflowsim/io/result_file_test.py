@@ -7,7 +7,8 @@ except ImportError:
     import mock as mock
 from ..test_utils import *
 from .result_file import ResultFile
-from . import DataSpec, write_int
+from . import DataSpec, Reductions, write_int
+import numpy as np
 
 
 class Dummy(ResultFile):
@@ -204,3 +205,39 @@ def test_reduce_errors():
 def test_reduce_unary():
     d = Dummy()
     assert d.reduce(None) is d
+
+
+def test_reduce_read_only(monkeypatch):
+    spec = (DataSpec("value", "grid", reduction="add"),)
+    monkeypatch.setattr(Dummy, "_SPEC_", spec)
+    monkeypatch.setattr(Reductions, "CHUNK_ELEMENTS", 7)
+
+    mapped = np.arange(20, dtype=np.float64).reshape(4, 5)
+    mapped.flags.writeable = False
+    d1 = Dummy({"value": mapped})
+    d2 = Dummy({"value": mapped})
+
+    # neither array can be changed, so the sum is a new array
+    d3 = d1.reduce(d2)
+    assert np.all(d3.value == 2 * mapped)
+    assert np.all(mapped == np.arange(20).reshape(4, 5))
+
+    # the read-only array is copied, the other operand is not changed
+    accumulated = d3.value
+    d4 = Dummy({"value": mapped}).reduce(d3)
+    assert np.all(d4.value == 3 * mapped)
+    assert np.all(accumulated == 2 * mapped)
+    assert d4.value is not accumulated
+
+
+def test_memory_mapped(tmpdir, monkeypatch):
+    spec = (DataSpec("value", int, 1), DataSpec("grid", "grid", reduction="add"))
+    monkeypatch.setattr(Dummy, "_SPEC_", spec)
+
+    array = np.random.random((3, 4))
+    Dummy({"value": 5, "grid": array}).to_file(str(tmpdir.join("default_name")))
+
+    mapped = Dummy.memory_mapped(str(tmpdir))
+    assert mapped.value == 5
+    assert isinstance(mapped.grid, np.memmap)
+    assert np.all(mapped.grid == array)
@@ -5,8 +5,10 @@ Created on Fri Jan 09 17:30:14 2016
 @author: Erik
 """
 
+import zlib
 import numpy as np
 import numbers
+from .read_data import COMPRESSED_GRID_MARKER
 
 
 def write_int(f, value, shape=-1):
@@ -82,12 +84,13 @@ def verify_shape(value, shape):
         return value.shape == shape
 
 
-def write_grid(f, grid):
+def write_grid(f, grid, compress=False):
     """
     writes a grid (array) so that it can be read from c++.
     
     :param BinaryIO f: A file opened for binary writing.
     :param np.ndarray grid: An array that is to be saved.
+    :param bool compress: Whether to save the data byte-shuffled and deflated in independent chunks.
     :return:
     """
 
@@ -96,6 +99,9 @@ def write_grid(f, grid):
     write_int(f, len(grid.shape))
     np.array(grid.shape).astype(np.uint64).tofile(f)
 
+    if compress:
+        f.write(COMPRESSED_GRID_MARKER)
+
     # write data type
     if grid.dtype == np.dtype(np.float64):
         f.write('d\0')
@@ -112,4 +118,25 @@ def write_grid(f, grid):
 
     # write container
     write_int(f, grid.size)
-    np.asarray(grid, order="C").tofile(f)
+    if compress:
+        _write_compressed(f, np.ascontiguousarray(grid).ravel())
+    else:
+        np.asarray(grid, order="C").tofile(f)
+
+
+def _write_compressed(f, data, chunk_bytes=1 << 20):
+    """
+    Writes the flat array `data` as byte-shuffled, deflated chunks, in the same format as the c++ side.
+    """
+    itemsize = data.dtype.itemsize
+    chunk_elements = max(1, chunk_bytes // itemsize)
+    chunks = []
+    for start in range(0, data.size, chunk_elements):
+        raw = data[start:start + chunk_elements].view(np.uint8).reshape(-1, itemsize)
+        chunks.append(zlib.compress(raw.T.tobytes()))
+
+    write_int(f, chunk_elements)
+    write_int(f, len(chunks))
+    write_int(f, [len(chunk) for chunk in chunks])
+    for chunk in chunks:
+        f.write(chunk)
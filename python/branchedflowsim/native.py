@@ -0,0 +1,300 @@
+"""
+In-process tracing through the shared tracer library (`tracer_c_api.h`), loaded with ctypes.
+
+In contrast to `branchedflowsim.tracer.trace`, no process is started and no files are written: potentials and initial
+rays are passed as numpy arrays, and the results of the observers are returned as numpy arrays that view the memory
+of the tracer. This makes small, iterative experiments much cheaper.
+
+Example::
+
+    potential = NativePotential.from_file("potential.dat")
+    result = trace(potential, 0.1, 1000, "planar", observers=[Density(size=(256, 256))])
+    density = result.arrays("density")["density"]
+"""
+from __future__ import absolute_import
+
+import ctypes
+import logging
+
+import numpy as np
+
+from branchedflowsim import config
+from branchedflowsim.io.ray_file import RayFile, ray_record_type
+from branchedflowsim.potential import Potential
+
+_logger = logging.getLogger(__name__)
+
+_library = None
+
+# element types of bfs_array
+_ARRAY_TYPES = {0: ctypes.c_float, 1: ctypes.c_double}
+
+
+class _Array(ctypes.Structure):
+    _fields_ = [("name", ctypes.c_char_p),
+                ("data", ctypes.c_void_p),
+                ("type", ctypes.c_int),
+                ("rank", ctypes.c_size_t),
+                ("shape", ctypes.POINTER(ctypes.c_size_t))]
+
+
+def _load_library(path=None):
+    """
+    Loads the shared tracer library and declares the signatures of its functions. The library is loaded only once.
+
+    :param str path: Path to the library. If `None`, uses `branchedflowsim.config.tracer_lib`.
+    :rtype: ctypes.CDLL
+    """
+    global _library
+    if _library is not None:
+        return _library
+
+    lib = ctypes.CDLL(path or config.tracer_lib)
+    c_size_p = ctypes.POINTER(ctypes.c_size_t)
+    c_double_p = ctypes.POINTER(ctypes.c_double)
+
+    lib.bfs_last_error.restype = ctypes.c_char_p
+    lib.bfs_last_error.argtypes = []
+    lib.bfs_potential_load.restype = ctypes.c_void_p
+    lib.bfs_potential_load.argtypes = [ctypes.c_char_p]
+    lib.bfs_potential_new.restype = ctypes.c_void_p
+    lib.bfs_potential_new.argtypes = [ctypes.c_size_t, c_size_p, c_double_p]
+    lib.bfs_potential_set_grid.restype = ctypes.c_int
+    lib.bfs_potential_set_grid.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), c_double_p]
+    lib.bfs_potential_dimension.restype = ctypes.c_size_t
+    lib.bfs_potential_dimension.argtypes = [ctypes.c_void_p]
+    lib.bfs_potential_free.restype = None
+    lib.bfs_potential_free.argtypes = [ctypes.c_void_p]
+    lib.bfs_trace_run.restype = ctypes.c_void_p
+    lib.bfs_trace_run.argtypes = [ctypes.c_void_p, ctypes.c_char_p, c_double_p, ctypes.c_uint64, ctypes.c_int]
+    lib.bfs_trace_particle_count.restype = ctypes.c_size_t
+    lib.bfs_trace_particle_count.argtypes = [ctypes.c_void_p]
+    lib.bfs_trace_observer_count.restype = ctypes.c_size_t
+    lib.bfs_trace_observer_count.argtypes = [ctypes.c_void_p]
+    lib.bfs_trace_observer_file.restype = ctypes.c_char_p
+    lib.bfs_trace_observer_file.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+    lib.bfs_trace_array_count.restype = ctypes.c_size_t
+    lib.bfs_trace_array_count.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+    lib.bfs_trace_array.restype = ctypes.c_int
+    lib.bfs_trace_array.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t, ctypes.POINTER(_Array)]
+    lib.bfs_trace_save.restype = ctypes.c_int
+    lib.bfs_trace_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    lib.bfs_trace_free.restype = None
+    lib.bfs_trace_free.argtypes = [ctypes.c_void_p]
+
+    _library = lib
+    return lib
+
+
+def _check(result):
+    """ raises a RuntimeError with the last error of the library if `result` signals a failure. """
+    if not result:
+        raise RuntimeError(_load_library().bfs_last_error())
+    return result
+
+
+def _as_double_pointer(array):
+    return array.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+
+
+class NativePotential(object):
+    """
+    A potential that is kept in the memory of the tracer library. The grids are copied into the library on creation,
+    so the arrays that were used to create the potential may be changed afterwards.
+    """
+    def __init__(self, handle):
+        self._lib = _load_library()
+        self._handle = handle
+
+    @staticmethod
+    def from_file(file_name):
+        """ loads the potential file `file_name`, as written by potgen.
+        :rtype: NativePotential
+        """
+        lib = _load_library()
+        return NativePotential(_check(lib.bfs_potential_load(file_name.encode("utf-8"))))
+
+    @staticmethod
+    def from_arrays(support, grids):
+        """
+        Creates a potential from numpy arrays.
+
+        :param support: Size of the domain along each axis.
+        :param dict grids: Maps derivative indices, e.g. `(0, 0)` for the potential and `(1, 0)` for its derivative \
+               along x, to arrays with the extents of the potential. The dynamics need at least the first \
+               derivatives, and the second ones if monodromy is tracked.
+        :rtype: NativePotential
+        """
+        lib = _load_library()
+        support = np.ascontiguousarray(support, dtype=np.double)
+        extents = None
+        for grid in grids.values():
+            extents = extents or np.shape(grid)
+            if np.shape(grid) != extents:
+                raise ValueError("Grids of shape {} and {} given for the same potential".format(extents,
+                                                                                                np.shape(grid)))
+        if extents is None or len(extents) != len(support):
+            raise ValueError("Got grids of shape {} for support {}".format(extents, support))
+
+        c_extents = (ctypes.c_size_t * len(extents))(*extents)
+        potential = NativePotential(_check(lib.bfs_potential_new(len(extents), c_extents,
+                                                                 _as_double_pointer(support))))
+        for derivative, grid in grids.items():
+            grid = np.ascontiguousarray(grid, dtype=np.double)
+            if any(derivative):
+                c_derivative = (ctypes.c_int * len(derivative))(*derivative)
+            else:
+                c_derivative = None
+            _check(lib.bfs_potential_set_grid(potential._handle, c_derivative, _as_double_pointer(grid)))
+        return potential
+
+    @staticmethod
+    def from_potential(potential):
+        """ copies the `potential` field of a `branchedflowsim.potential.Potential`, together with its derivatives.
+        :param Potential potential:
+        :rtype: NativePotential
+        """
+        field = potential.get_field("potential")
+        grids = {derivative: field.get_partial_derivative(*derivative) for derivative in field.derivatives()}
+        return NativePotential.from_arrays(potential.support, grids)
+
+    @property
+    def dimension(self):
+        return self._lib.bfs_potential_dimension(self._handle)
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self._lib.bfs_potential_free(self._handle)
+            self._handle = None
+
+
+class NativeTraceResult(object):
+    """
+    The observers of a trace run by `trace`, together with their results. The arrays returned by `arrays` view the
+    memory of the tracer, which is kept alive as long as any of them is in use. They are read-only.
+    """
+    def __init__(self, handle):
+        self._lib = _load_library()
+        self._handle = handle
+
+        self._files = [self._lib.bfs_trace_observer_file(handle, observer).decode("utf-8")
+                       for observer in range(self._lib.bfs_trace_observer_count(handle))]
+
+    def _make_array(self, observer, index):
+        """ wraps result array `index` of `observer` into a numpy array without copying it. """
+        description = _Array()
+        _check(self._lib.bfs_trace_array(self._handle, observer, index, ctypes.byref(description)))
+        shape = tuple(description.shape[i] for i in range(description.rank))
+        count = int(np.prod(shape))
+        buffer_ = (_ARRAY_TYPES[description.type] * count).from_address(description.data)
+        # the buffer keeps the trace, and thus the memory it points to, alive.
+        buffer_.owner = self
+        array = np.frombuffer(buffer_, dtype=_ARRAY_TYPES[description.type]).reshape(shape)
+        array.flags.writeable = False
+        return description.name.decode("utf-8"), array
+
+    @property
+    def particle_count(self):
+        """ number of rays that were traced. """
+        return self._lib.bfs_trace_particle_count(self._handle)
+
+    def keys(self):
+        """ names of the observers, i.e. their result files without the extension. """
+        return [file_name.rsplit(".", 1)[0] for file_name in self._files]
+
+    def arrays(self, name):
+        """
+        The results that observer `name` keeps as arrays, e.g. `density` for the density observer, as a dictionary.
+        Observers that do not keep arrays in memory, like the trajectory observer, give an empty dictionary; their
+        results can be written with `save`.
+
+        :param str name: Name of the observer, as in `keys`, or its result file.
+        :rtype: dict[str, np.ndarray]
+        """
+        for observer, file_name in enumerate(self._files):
+            if name == file_name or name == file_name.rsplit(".", 1)[0]:
+                # the arrays refer to this object, so they are not cached here to avoid a reference cycle
+                return dict(self._make_array(observer, index)
+                            for index in range(self._lib.bfs_trace_array_count(self._handle, observer)))
+        raise KeyError("No observer {} in trace, got {}".format(name, self._files))
+
+    def save(self, path):
+        """
+        Saves the results of all observers into the existing directory `path`, as the tracer program does.
+        :return TraceResult: A trace result for loading the saved files.
+        """
+        from branchedflowsim.tracer import TraceResult
+        _check(self._lib.bfs_trace_save(self._handle, path.encode("utf-8")))
+        return TraceResult(path, [])
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self._lib.bfs_trace_free(self._handle)
+            self._handle = None
+
+
+def make_trace_arguments(strength, count, initial_condition, periodic=True, end_time=2.0, dynamics=None,
+                         threads=None, observers=None, integrator=None, args=None):
+    """
+    Builds the arguments of `trace` for the library. These are the arguments of the tracer program, without the
+    potential file and the result path; see `branchedflowsim.tracer.make_trace_command` for the parameters.
+
+    :return str: The arguments, separated by spaces.
+    """
+    from branchedflowsim.tracer import make_trace_command
+    command = make_trace_command("", strength, count, initial_condition, ".", periodic, end_time, dynamics, threads,
+                                 observers, integrator, args)
+    # drop the executable, the potential and the result path
+    command = command[2:]
+    result = command.index("-r")
+    del command[result:result+2]
+    # the strength is not changed unless requested
+    if strength is None:
+        del command[command.index("-s"):command.index("-s")+2]
+    return " ".join(command)
+
+
+def trace(potential, strength, ray_count, initial_condition="planar", periodic=True, end_time=2.0, dynamics=None,
+          threads=None, observers=None, integrator=None, args=None, rays=None):
+    """
+    Traces `potential` within this process.
+
+    :param NativePotential|Potential|str potential: The potential. A `Potential` or a potential file is copied into \
+           the library, so for repeated traces on the same potential, create a `NativePotential` once.
+    :param float strength: Strength of the potential. Scales the grids of `potential`. If `None`, the strength \
+           of the potential is kept.
+    :param int ray_count: Number of rays to trace. Ignored if `rays` are given.
+    :param Incoming|str initial_condition: Initial conditions for rays. Ignored if `rays` are given.
+    :param RayFile|np.ndarray rays: Initial rays, either as a `RayFile` or as an array with records of type \
+           `branchedflowsim.io.ray_file.ray_record_type`. The rays are only read during the call.
+    :param observers: A list of observers. See `branchedflowsim.tracer.trace` for the other parameters.
+    :rtype: NativeTraceResult
+    :raises: RuntimeError If the tracer encounters an error.
+    """
+    lib = _load_library()
+    if isinstance(potential, Potential):
+        potential = potential.file_name if potential.file_name else NativePotential.from_potential(potential)
+    if isinstance(potential, (str, unicode)):
+        potential = NativePotential.from_file(potential)
+
+    if isinstance(rays, RayFile):
+        rays = rays.rays
+    if rays is not None:
+        rays = np.ascontiguousarray(rays)
+        weighted = "weight" in rays.dtype.names
+        if rays.dtype != ray_record_type(potential.dimension, weighted):
+            raise ValueError("Got rays of type {} for a {} dimensional potential".format(rays.dtype,
+                                                                                        potential.dimension))
+        ray_count = len(rays)
+        rays_pointer = rays.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+    else:
+        weighted = False
+        rays_pointer = None
+
+    arguments = make_trace_arguments(strength, ray_count, initial_condition, periodic, end_time, dynamics, threads,
+                                     observers, integrator, args)
+    _logger.info("Start tracing %d rays in process", ray_count)
+    _logger.debug("Tracer arguments: %s", arguments)
+    handle = _check(lib.bfs_trace_run(potential._handle, arguments.encode("utf-8"), rays_pointer,
+                                      len(rays) if rays is not None else 0, int(weighted)))
+    return NativeTraceResult(handle)
@@ -0,0 +1,52 @@
+import os
+import pytest
+import numpy as np
+from branchedflowsim.observers import Density
+from branchedflowsim.io.ray_file import RayFile
+from branchedflowsim import config
+from native import make_trace_arguments
+
+needs_library = pytest.mark.skipif(not os.path.isfile(config.tracer_lib), reason="tracer library not installed")
+
+
+def test_trace_arguments():
+    args = make_trace_arguments(0.5, 1000, "planar", periodic=True, end_time=1.0, threads=2)
+    assert args == "-n 1000 -s 0.5 --end-time 1.0 --incoming planar --periodic --threads 2"
+
+    args = make_trace_arguments(None, 1000, "planar vx 1", periodic=False)
+    assert args == "-n 1000 --end-time 2.0 --incoming planar vx 1"
+
+
+def _flat_potential():
+    from native import NativePotential
+    zeros = np.zeros((16, 16))
+    return NativePotential.from_arrays((1.0, 1.0), {(0, 0): zeros, (1, 0): zeros, (0, 1): zeros})
+
+
+@needs_library
+def test_native_density():
+    from native import trace
+    potential = _flat_potential()
+    assert potential.dimension == 2
+
+    result = trace(potential, None, 100, "planar", end_time=1.0, threads=1, observers=[Density(size=(8, 8))])
+    assert result.particle_count == 100
+    assert "density" in result.keys()
+    density = result.arrays("density")["density"]
+    assert density.shape == (8, 8)
+    assert density.dtype == np.float32
+    assert not density.flags.writeable
+    # the array keeps the trace alive
+    del result
+    assert np.sum(density) > 0
+
+    with pytest.raises(RuntimeError):
+        trace(potential, None, 100, "nonsense")
+
+
+@needs_library
+def test_native_rays():
+    from native import trace
+    rays = RayFile.from_arrays([[0.1, 0.2], [0.1, 0.5]], [[1.0, 0.0], [1.0, 0.0]], weights=[1.0, 2.0])
+    result = trace(_flat_potential(), None, 0, rays=rays, threads=1, observers=[Density(size=(8, 8))])
+    assert result.particle_count == 2
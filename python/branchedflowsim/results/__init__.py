@@ -7,3 +7,4 @@ from .trajectories import Trajectories
 from .velocity_histograms import VelocityHistograms
 from .velocity_transitions import VelocityTransitions
 from .angular_density import AngularDensity
+from .ray_cost import RayCost
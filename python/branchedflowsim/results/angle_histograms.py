@@ -12,7 +12,7 @@ from branchedflowsim.io import ResultFile, DataSpec
 
 
 class AngleHistograms(ResultFile):
-    _FILE_HEADER_ = 'angh001\n'
+    _FILE_HEADER_ = 'angh002\n'
     _FILE_NAME_ = 'angle_histograms.dat'
     _SPEC_ = (DataSpec("num_hists", int),
               DataSpec("num_bins", int),
@@ -20,7 +20,7 @@ class AngleHistograms(ResultFile):
               DataSpec("angles", float, "num_bins"),
               DataSpec("sum_angles", float, "num_hists", reduction="add"),
               DataSpec("sum_angles_squared", float, "num_hists", reduction="add"),
-              DataSpec("counts", int, ("num_hists", "num_bins"), reduction="add")
+              DataSpec("counts", float, ("num_hists", "num_bins"), reduction="add")
               )
 
     def __init__(self, source):
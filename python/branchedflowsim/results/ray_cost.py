@@ -0,0 +1,48 @@
+# -*- coding: utf-8 -*-
+import numpy as np
+from branchedflowsim.io import ResultFile, DataSpec
+
+
+class RayCost(ResultFile):
+    """
+    Integration cost of the traced rays, as recorded by the `ray_cost` observer.
+
+    `histograms` contains one logarithmic histogram per quantity in `QUANTITIES`; bin `i` counts the rays whose value
+    lies in `[bin_edges[i], bin_edges[i+1])`. The maps count the accepted steps, rejected steps and rhs evaluations
+    spent in each cell of the grid.
+    """
+    _FILE_HEADER_ = 'rcst001\n'
+    _FILE_NAME_ = 'ray_cost.dat'
+    QUANTITIES = ("accepted_steps", "rejected_steps", "rhs_evaluations", "min_time_step", "wall_time")
+    _SPEC_ = (DataSpec("dimensions", int),
+              DataSpec("support", float, "dimensions"),
+              DataSpec("num_rays", int, reduction="add"),
+              DataSpec("num_bins", int),
+              DataSpec("bin_edges", float, "num_bins"),
+              DataSpec("totals", float, len(QUANTITIES), reduction="add"),
+              DataSpec("histograms", int, (len(QUANTITIES), "num_bins"), reduction="add"),
+              DataSpec("step_map", "grid", reduction="add"),
+              DataSpec("rejected_step_map", "grid", reduction="add"),
+              DataSpec("rhs_evaluation_map", "grid", reduction="add"))
+
+    def __init__(self, source):
+        super(RayCost, self).__init__(source)
+
+    def histogram(self, quantity):
+        """ returns the per-ray histogram of `quantity`, which has to be one of `QUANTITIES`. """
+        return self.histograms[self.QUANTITIES.index(quantity)]
+
+    def mean(self, quantity):
+        """ average of `quantity` over all rays. """
+        return self.totals[self.QUANTITIES.index(quantity)] / max(self.num_rays, 1)
+
+    def rejection_rate(self):
+        """ fraction of attempted steps that were rejected, per grid cell. NaN where no steps were taken. """
+        attempted = self.step_map + self.rejected_step_map
+        with np.errstate(divide="ignore", invalid="ignore"):
+            return self.rejected_step_map / attempted
+
+    def cost_per_step(self):
+        """ rhs evaluations per accepted step, per grid cell. NaN where no steps were taken. """
+        with np.errstate(divide="ignore", invalid="ignore"):
+            return self.rhs_evaluation_map / self.step_map
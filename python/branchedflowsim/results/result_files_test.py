@@ -136,14 +136,14 @@ class TestAngleHistogramsIO(ResultFileIO):
 
     @staticmethod
     def write(target_file):
-        target_file.write('angh001\n')
+        target_file.write('angh002\n')
         write_int(target_file, 25)  # 25 hists
         write_int(target_file, 50)  # 50 bins
         write_float(target_file, [0.5] * 25)  # times
         write_float(target_file, [0.5] * 50)  # angles
         write_float(target_file, [0.8] * 25)  # sum
         write_float(target_file, [1.5] * 25)  # sumsq
-        write_int(target_file, [1] * 25 * 50)
+        write_float(target_file, [1.0] * 25 * 50)
 
     @staticmethod
     def source_dict():
@@ -154,14 +154,14 @@ class TestAngleHistogramsIO(ResultFileIO):
             "sum_angles": [0.8] * 25,
             "sum_angles_squared": [1.5] * 25,
             "times": [0.5] * 25,
-            "counts": np.ones((25, 50), dtype=int)
+            "counts": np.ones((25, 50))
         }
 
     @classmethod
     def reduced(cls):
         old = cls.source_dict()
         old.update(
-            {"counts": 2 * np.ones((25, 50), dtype=int),
+            {"counts": 2 * np.ones((25, 50)),
              "sum_angles": [2*0.8] * 25,
              "sum_angles_squared": [2*1.5] * 25
              }
@@ -2,11 +2,17 @@ from __future__ import absolute_import
 
 import logging
 import shutil
+import socket
 import subprocess
 import os
 import tempfile
 from collections import defaultdict
 
+try:
+    from shlex import quote
+except ImportError:
+    from pipes import quote
+
 from branchedflowsim import config
 from branchedflowsim.observers.observer import Observer
 from branchedflowsim.incoming.incoming import Incoming
@@ -85,7 +91,7 @@ def make_trace_command(potential, strength, count, initial_condition, path, peri
 
 
 def trace(potential_file, strength, ray_count, initial_condition, path, periodic=True, end_time=2.0, dynamics=None, threads=None,
-          observers=None, integrator=None, args=None):
+          observers=None, integrator=None, args=None, daemon=None):
     """ calls the external trace program.
     
     :param str|Potential potential_file: Path to the file that contains the potential. If a `Potential` object \
@@ -101,12 +107,24 @@ def trace(potential_file, strength, ray_count, initial_condition, path, periodic
     :param list[Observer] observers: A list of observers.
     :param str integrator: The integrator to be used for ray tracing. See `tracer.Integrator`.
     :param list[str] args: Additional arguments to be passed.
+    :param str daemon: Socket of a tracer started with `--daemon`. If given, the trace is run by that tracer, which \
+           keeps the potential loaded for the next trace, instead of by a new process.
     :return: A trace result object for lazily loading the results produced by the observers.
     :rtype:  TraceResult
     :raises: CalledProcessError If the trace program encounters an error.
+    :raises: RuntimeError If the daemon could not run the trace.
     """
     if isinstance(potential_file, Potential):
         potential_file = potential_file.file_name
+    if daemon is not None:
+        # the daemon resolves relative paths against its own working directory
+        command = make_trace_command(os.path.abspath(potential_file), strength, ray_count, initial_condition,
+                                     os.path.abspath(path), periodic, end_time, dynamics, threads, observers,
+                                     integrator=integrator, args=args)
+        _logger.info("Sending trace of %d rays on potential %s to daemon %s", ray_count, potential_file, daemon)
+        _logger.debug("tracer daemon answered: %s", send_to_daemon(daemon, command))
+        return TraceResult(path, observers)
+
     command = make_trace_command(potential_file, strength, ray_count, initial_condition, path, periodic,
                                  end_time, dynamics, threads, observers, integrator=integrator, args=args)
 
@@ -124,6 +142,57 @@ def trace(potential_file, strength, ray_count, initial_condition, path, periodic
     return TraceResult(path, observers)
 
 
+def send_to_daemon(socket_path, command):
+    """
+    Runs a tracer call on a tracer daemon and waits until its results are saved.
+
+    :param str socket_path: The socket the daemon listens on.
+    :param list[str] command: The tracer call, as returned by `make_trace_command`. Relative paths are resolved \
+           against the working directory of the daemon.
+    :return str: The answer of the daemon, `ok` followed by the number of traced rays and the duration in seconds.
+    :raises: RuntimeError If the daemon could not run the trace.
+    """
+    request = " ".join(quote(arg) for arg in command[1:]) + "\n"
+    connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        connection.connect(socket_path)
+        connection.sendall(request.encode("utf-8"))
+        answer = b""
+        while not answer.endswith(b"\n"):
+            data = connection.recv(4096)
+            if not data:
+                break
+            answer += data
+    finally:
+        connection.close()
+
+    answer = answer.decode("utf-8").strip()
+    if not answer.startswith("ok"):
+        raise RuntimeError("tracer daemon could not trace: %s" % answer)
+    return answer
+
+
+def make_potgen_options(observers, potgen_options=None):
+    """
+    Completes the options for creating potentials to trace with `observers`. If no derivative `order` is given, it is
+    chosen as low as the observers allow.
+
+    :param list[Observer] observers: The observers of the traces.
+    :param dict potgen_options: Options to be passed to the `create` function of the potential.
+    :return dict: A copy of `potgen_options` that contains the `order`.
+    """
+    potgen_options = dict(potgen_options or {})
+
+    # if any of the observers require monodromy, we need the potential up to second order.
+    # Otherwise first order is sufficient.
+    if "order" not in potgen_options:
+        if any(observer.need_monodromy for observer in observers):
+            potgen_options["order"] = 2
+        else:
+            potgen_options["order"] = 1
+    return potgen_options
+
+
 def trace_multiple(medium_spec, repeat, ray_count, work_dir=None, potgen_options=None, **kwargs):
     """
     perform multiple tracings with the same settings on different potential realizations.
@@ -146,16 +215,7 @@ def trace_multiple(medium_spec, repeat, ray_count, work_dir=None, potgen_options
 
     :return: A generator for the tracing results.
     """
-    if potgen_options is None:
-        potgen_options = {}
-
-    # if any of the observers require monodromy, we need the potential up to second order.
-    # Otherwise first order is sufficient.
-    if "order" not in potgen_options:
-        if any(observer.need_monodromy for observer in kwargs["observers"]):
-            potgen_options["order"] = 2
-        else:
-            potgen_options["order"] = 1
+    potgen_options = make_potgen_options(kwargs["observers"], potgen_options)
 
     work_dir = tempfile.mkdtemp(dir=config.get_workdir(work_dir))
     try:
@@ -179,7 +239,10 @@ def reduce_trace_multiple(*args, **kwargs):
     result_iterator = trace_multiple(*args, **kwargs)
     for result in result_iterator:
         for key in result.keys():
-            results[key] = result.get_result(key).reduce(results[key])
+            # reduce into the accumulated result, which is writeable after the first reduction, so the
+            # memory mapped grids of the new result are only read
+            current = result.get_result(key)
+            results[key] = current if results[key] is None else results[key].reduce(current)
     return results
 
 
@@ -196,6 +259,7 @@ def _observer_result_mapping():
     from branchedflowsim.results import AngleHistograms
     from branchedflowsim.results import Density
     from branchedflowsim.results import AngularDensity
+    from branchedflowsim.results import RayCost
     mapping = {
         "caustics": Caustics,
         "density": Density,
@@ -203,12 +267,13 @@ def _observer_result_mapping():
         "angle_histogram": AngleHistograms,
         "velocity_histogram": VelocityHistograms,
         "velocity_transitions": VelocityTransitions,
-        "radial_density": AngularDensity
+        "radial_density": AngularDensity,
+        "ray_cost": RayCost
     }
     return mapping
 
 
-def _make_loader(result_type, base_path, file_name):
+def _make_loader(result_type, base_path, file_name, mmap=False):
     """
     Takes a target type, base path and file name and returns a function that loads from that file.
     Used to implement lazy loading of results.
@@ -216,6 +281,7 @@ def _make_loader(result_type, base_path, file_name):
     :param result_type: Type of the result. Should be one of the `ResultFile` classes.
     :param base_path: Directory for the result files.
     :param file_name: Filename of the result file. If None the default file name will be used.
+    :param bool mmap: Whether to memory map the grids of the result instead of reading them.
     :return: A function that loads the data.
     """
     if file_name is None:
@@ -225,6 +291,8 @@ def _make_loader(result_type, base_path, file_name):
 
     def loader():
         _logger.debug("Loading %s from file %s", result_type.__name__, path)
+        if mmap:
+            return result_type.memory_mapped(path)
         return result_type(path)
 
     return loader
@@ -246,10 +314,13 @@ class TraceResult(object):
     is required. If you want to remove the result folder but get the data beforehand
     you can use `load_files` which caches all results.
 
+    If `mmap` is set, the grids of the results (e.g. densities) are memory mapped instead of read, so only
+    the parts that are accessed are loaded from disk.
+
     TODO track more data about the tracing configuration (incoming, raycount etc).
     """
 
-    def __init__(self, base_path, observers):
+    def __init__(self, base_path, observers, mmap=False):
         self.basepath = base_path  # path in which all result files are saved
 
         self._loaded_cache = {}
@@ -258,7 +329,7 @@ class TraceResult(object):
         mapping = _observer_result_mapping()
 
         for obs in observers:  # type: Observer
-            loader = _make_loader(mapping[obs.name], self.basepath, getattr(obs, "file_name", None))
+            loader = _make_loader(mapping[obs.name], self.basepath, getattr(obs, "file_name", None), mmap)
 
             # if we got a file_name, register the loader under that name, else use the default (=observer name).
             if getattr(obs, "file_name", None):
@@ -324,6 +395,11 @@ class TraceResult(object):
         """:rtype: branchedflowsim.results.VelocityTransitions"""
         return self._lazy_load("velocity_transitions")
 
+    @property
+    def ray_cost(self):
+        """:rtype: branchedflowsim.results.RayCost"""
+        return self._lazy_load("ray_cost")
+
     def load_files(self):
         for name in self._loaders:
             self._lazy_load(name)
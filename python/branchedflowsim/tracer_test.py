@@ -3,7 +3,7 @@ import mock
 import os
 from branchedflowsim.observers import *
 from branchedflowsim.config import trace_exe
-from tracer import make_trace_command, trace, TraceResult, trace_multiple
+from tracer import make_trace_command, trace, TraceResult, trace_multiple, send_to_daemon
 
 
 def test_simple_tracing():
@@ -61,6 +61,29 @@ def test_trace():
     assert set(result._loaders.viewkeys()) == {"caustics"}
 
 
+def test_send_to_daemon():
+    with mock.patch("socket.socket") as socket_mock:
+        connection = socket_mock.return_value
+        connection.recv.side_effect = [b"ok 1000 ", b"2.5\n"]
+        answer = send_to_daemon("daemon.sock", [trace_exe, "pot file.pot", "-n", "1000"])
+        connection.connect.assert_called_once_with("daemon.sock")
+        connection.sendall.assert_called_once_with(b"'pot file.pot' -n 1000\n")
+        assert answer == "ok 1000 2.5"
+
+        connection.recv.side_effect = [b"error Could not open potential file pot.pot\n"]
+        with pytest.raises(RuntimeError):
+            send_to_daemon("daemon.sock", [trace_exe, "pot.pot"])
+
+
+def test_trace_on_daemon():
+    with mock.patch("branchedflowsim.tracer.send_to_daemon") as send, mock.patch("subprocess.check_output") as check_output:
+        result = trace("potential_file.pot", 0.5, 1000, "planar", "result_path", periodic=False, daemon="daemon.sock")
+        assert not check_output.called
+        send.assert_called_once_with("daemon.sock", make_trace_command(
+            os.path.abspath("potential_file.pot"), 0.5, 1000, "planar", os.path.abspath("result_path"), periodic=False))
+    assert result.basepath == "result_path"
+
+
 def test_trace_result_empty():
     simple = TraceResult("basepath", [])
 
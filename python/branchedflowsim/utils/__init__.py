@@ -1,2 +1,3 @@
 from .convenience import single_density
 from .experiment import Experiment, Visualization
+from .scheduler import TraceScheduler
@@ -319,9 +319,11 @@ class Experiment(object):
 class TraceExperiment(Experiment):
     """
     This `Experiment` performs a trace-reduce operation and persists the results.
+    The realizations are generated and traced concurrently by a `TraceScheduler`, within a budget of `cores`
+    and `memory` (in bytes). These only affect the speed, so they are not part of the config.
     """
     def __init__(self, name, medium_spec, repeat, ray_count, work_dir=None, potgen_options=None, trace_options=None,
-                 data_directory=None, persistence=None):
+                 data_directory=None, persistence=None, cores=None, memory=None):
         super(TraceExperiment, self).__init__(name, data_directory, persistence=persistence)
 
         self.trace_options = trace_options
@@ -330,6 +332,8 @@ class TraceExperiment(Experiment):
         self.ray_count = ray_count
         self.repeat = repeat
         self.medium_spec = medium_spec
+        self.cores = cores
+        self.memory = memory
 
     @property
     def config(self):
@@ -342,9 +346,52 @@ class TraceExperiment(Experiment):
         }
 
     def generate_data(self, dependencies):
-        from branchedflowsim.tracer import reduce_trace_multiple
-        return reduce_trace_multiple(self.medium_spec, self.repeat, self.ray_count, self.work_dir, self.potgen_options,
-                                     **self.trace_options)
+        from .scheduler import TraceScheduler
+        scheduler = TraceScheduler(self.cores, self.memory, self.work_dir)
+        scheduler.add(self.name, self.medium_spec, self.repeat, self.ray_count, self.potgen_options,
+                      self.trace_options)
+        return scheduler.run()[self.name]
+
+
+class TraceSweepExperiment(Experiment):
+    """
+    This `Experiment` performs a trace-reduce operation for each of several parameter points, and persists the
+    results. All realizations of all points are run concurrently by a `TraceScheduler`.
+    The data is a dictionary that contains the reduced results of each point under its key.
+    """
+    def __init__(self, name, medium_specs, repeat, ray_count, work_dir=None, potgen_options=None, trace_options=None,
+                 data_directory=None, persistence=None, cores=None, memory=None):
+        """
+        :param dict[str, MediumSpec] medium_specs: The medium of each parameter point, by the name of the point.
+        See `TraceExperiment` for the other parameters, which are the same for all points.
+        """
+        super(TraceSweepExperiment, self).__init__(name, data_directory, persistence=persistence)
+
+        self.trace_options = trace_options
+        self.potgen_options = potgen_options
+        self.work_dir = work_dir
+        self.ray_count = ray_count
+        self.repeat = repeat
+        self.medium_specs = medium_specs
+        self.cores = cores
+        self.memory = memory
+
+    @property
+    def config(self):
+        return {
+            "trace": self.trace_options,
+            "potgen": self.potgen_options,
+            "media": self.medium_specs,
+            "num_rays": self.ray_count,
+            "repeat": self.repeat
+        }
+
+    def generate_data(self, dependencies):
+        from .scheduler import TraceScheduler
+        scheduler = TraceScheduler(self.cores, self.memory, self.work_dir)
+        for key, medium_spec in self.medium_specs.items():
+            scheduler.add(key, medium_spec, self.repeat, self.ray_count, self.potgen_options, self.trace_options)
+        return scheduler.run()
 
 
 class Visualization(Experiment):
@@ -0,0 +1,273 @@
+"""
+Local scheduler that runs the potgen - tracer - load steps of many tracings concurrently.
+
+`trace_multiple` runs one realization after the other, so each step only uses the parallelism of the programs
+themselves. The `TraceScheduler` instead runs the realizations of one or more parameter points at the same time,
+within a budget of cores and memory. Each realization holds its share of the memory budget from the start of potgen
+until its results are reduced, and the cores of a step while the step runs. With the default thread counts, potgen
+for the next realization runs while the current one is traced. Results are reduced as soon as they are loaded, and
+the files of a realization are deleted right afterwards.
+"""
+from __future__ import absolute_import
+
+import logging
+import multiprocessing
+import os
+import shutil
+import tempfile
+import threading
+from collections import defaultdict, namedtuple
+
+import numpy as np
+
+from branchedflowsim import config
+
+_logger = logging.getLogger(__name__)
+
+_Point = namedtuple("_Point", ("key", "medium_spec", "repeat", "ray_count", "potgen_options", "trace_options",
+                               "memory"))
+
+
+def count_potential_grids(dimension, order):
+    """ number of grids in a potential file with all derivatives up to `order`, including the potential itself. """
+    count = 0
+    combinations = 1
+    for k in range(order + 1):
+        # number of distinct k-th partial derivatives: (dimension + k - 1) choose k
+        count += combinations
+        combinations = combinations * (dimension + k) // (k + 1)
+    return count
+
+
+def estimate_potential_bytes(medium_spec, order):
+    """
+    Estimates the size of a potential generated for `medium_spec` with derivatives up to `order`. This is the size of
+    the potential file, and roughly the memory the tracer needs to hold the potential.
+    """
+    return int(np.prod(medium_spec.shape)) * np.dtype(np.float64).itemsize * \
+        count_potential_grids(medium_spec.dimension, order)
+
+
+def default_memory_budget():
+    """ half of the physical memory of this machine, in bytes. """
+    return os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES") // 2
+
+
+class _Resources(object):
+    """
+    A budget of cores and memory that is shared by the worker threads of a `TraceScheduler`. Requests for tracing
+    take precedence over requests for potgen, so that generated potentials do not pile up.
+    """
+    def __init__(self, cores, memory):
+        self.cores = cores
+        self.memory = memory
+        self._free_cores = cores
+        self._free_memory = memory
+        self._waiting_traces = 0
+        self._cancelled = False
+        self._condition = threading.Condition()
+
+    def acquire(self, cores=0, memory=0, urgent=False):
+        """
+        Blocks until `cores` and `memory` are free and takes them. Requests larger than the whole budget are
+        clamped to it, so they run alone. Non-urgent requests also wait while urgent ones are waiting.
+
+        :return: The amount of cores and memory that was taken, to be passed to `release`.
+        :raises RuntimeError: If the scheduler was cancelled.
+        """
+        cores = min(cores, self.cores)
+        memory = min(memory, self.memory)
+        with self._condition:
+            if urgent:
+                self._waiting_traces += 1
+            try:
+                while not self._cancelled and (cores > self._free_cores or memory > self._free_memory or
+                                               (not urgent and self._waiting_traces > 0)):
+                    self._condition.wait()
+            finally:
+                if urgent:
+                    self._waiting_traces -= 1
+                self._condition.notify_all()
+            if self._cancelled:
+                raise RuntimeError("Scheduler was cancelled")
+            self._free_cores -= cores
+            self._free_memory -= memory
+        return cores, memory
+
+    def release(self, taken):
+        cores, memory = taken
+        with self._condition:
+            self._free_cores += cores
+            self._free_memory += memory
+            self._condition.notify_all()
+
+    def cancel(self):
+        """ makes all current and future `acquire` calls fail. """
+        with self._condition:
+            self._cancelled = True
+            self._condition.notify_all()
+
+
+class TraceScheduler(object):
+    """
+    Runs multiple tracings for one or more parameter points concurrently and reduces their results.
+
+    Example::
+
+        scheduler = TraceScheduler(cores=16, memory=32 * 2**30)
+        for strength in (0.05, 0.1, 0.2):
+            medium_spec = ScalarPotentialSpec(1024, 2, IsotropicGaussian(0.01), strength)
+            scheduler.add(strength, medium_spec, repeat=10, ray_count=10**6,
+                          trace_options={"initial_condition": "planar", "observers": [Density()]})
+        results = scheduler.run()
+        density = results[0.1]["density"]
+    """
+    def __init__(self, cores=None, memory=None, work_dir=None):
+        """
+        :param int cores: Number of cores that may be used at the same time. Defaults to all cores.
+        :param int memory: Memory in bytes that may be used at the same time. Defaults to `default_memory_budget`. \
+               The potential files count towards the budget, as the default work directory is in RAM.
+        :param str work_dir: Directory in which the temporary files are created. If `None` uses \
+               `branchedflowsim.config.DEFAULT_WORKDIR`.
+        """
+        self.cores = cores or multiprocessing.cpu_count()
+        self.memory = memory or default_memory_budget()
+        self.work_dir = work_dir
+        self._points = []
+
+    def add(self, key, medium_spec, repeat, ray_count, potgen_options=None, trace_options=None, memory=None):
+        """
+        Adds a parameter point. Its results are reduced over all `repeat` realizations of `medium_spec`.
+
+        :param key: Hashable key under which the results of this point are returned by `run`.
+        :param MediumSpec medium_spec: Specifies the medium on which to trace.
+        :param int repeat: The number of potential realizations to use.
+        :param int ray_count: Number of rays to trace per medium realization.
+        :param dict potgen_options: Options to be passed to the `create` function of the potential, as for \
+               `trace_multiple`. If `fft_threads` is not given, potgen uses `branchedflowsim.config.DEFAULT_FFT_THREADS`.
+        :param dict trace_options: Options that are passed through to `trace`. If `threads` is not given, each trace \
+               uses all cores that potgen does not need.
+        :param int memory: Memory in bytes that a realization needs. Defaults to twice the estimated size of the \
+               potential, for the potential file and the grids held by potgen or the tracer. Give a larger value \
+               if the observers need a lot of memory, e.g. for 3D densities.
+        """
+        from branchedflowsim.tracer import make_potgen_options
+        if any(point.key == key for point in self._points):
+            raise KeyError("Parameter point {} was already added".format(key))
+        trace_options = dict(trace_options or {})
+        potgen_options = make_potgen_options(trace_options.get("observers", []), potgen_options)
+        self._points.append(_Point(key, medium_spec, repeat, ray_count, potgen_options, trace_options, memory))
+
+    def _potgen_cores(self, point):
+        return min(point.potgen_options.get("fft_threads") or config.DEFAULT_FFT_THREADS, self.cores)
+
+    def _trace_cores(self, point):
+        threads = point.trace_options.get("threads")
+        if threads:
+            return min(threads, self.cores)
+        return max(1, self.cores - self._potgen_cores(point))
+
+    def _realization_memory(self, point):
+        """ memory that a realization of `point` holds from the start of potgen until it is reduced. """
+        if point.memory:
+            return point.memory
+        potential = estimate_potential_bytes(point.medium_spec, point.potgen_options["order"])
+        # the potential file, and the grids held by potgen or the tracer on top of it
+        return 2 * potential
+
+    def run(self):
+        """
+        Runs all realizations of all parameter points and returns their reduced results.
+
+        :return: The results reduced over all realizations, as a dictionary for each parameter point.
+        :rtype: dict[object, dict[str, ResultFile]]
+        :raises: The first error that occurred in any of the steps. No new steps are started after an error.
+        """
+        resources = _Resources(self.cores, self.memory)
+        jobs = [(point, n) for point in self._points for n in range(point.repeat)]
+        results = {point.key: defaultdict(lambda: None) for point in self._points}
+        errors = []
+        lock = threading.Lock()
+        work_dir = tempfile.mkdtemp(dir=config.get_workdir(self.work_dir))
+
+        def worker():
+            while True:
+                with lock:
+                    if not jobs or errors:
+                        return
+                    point, n = jobs.pop(0)
+                try:
+                    self._run_realization(point, n, resources, work_dir, results[point.key], lock)
+                except Exception as error:
+                    _logger.error("Realization %d of %s failed: %r", n, point.key, error)
+                    with lock:
+                        errors.append(error)
+                    resources.cancel()
+                    return
+
+        # more workers than can run at once would only wait, so limit them by cores and memory
+        workers = 0
+        for point in self._points:
+            per_memory = self.memory // max(self._realization_memory(point), 1)
+            per_cores = self.cores // max(min(self._potgen_cores(point), self._trace_cores(point)), 1) + 1
+            workers = max(workers, min(per_memory, per_cores))
+        workers = max(1, min(workers, len(jobs)))
+
+        _logger.info("Running %d tracings of %d parameter points with %d workers on %d cores and %d MB in %s",
+                     len(jobs), len(self._points), workers, self.cores, self.memory // 2**20, work_dir)
+        threads = [threading.Thread(target=worker) for _ in range(workers)]
+        try:
+            for thread in threads:
+                thread.daemon = True
+                thread.start()
+            for thread in threads:
+                thread.join()
+        finally:
+            shutil.rmtree(work_dir)
+
+        if errors:
+            raise errors[0]
+        return {key: dict(result) for key, result in results.items()}
+
+    def _run_realization(self, point, n, resources, work_dir, results, lock):
+        """ generates, traces, loads and reduces realization `n` of `point`. """
+        from branchedflowsim.tracer import trace
+
+        path = tempfile.mkdtemp(dir=work_dir)
+        memory = resources.acquire(memory=self._realization_memory(point))
+        try:
+            # potgen
+            cores = resources.acquire(cores=self._potgen_cores(point))
+            try:
+                options = dict(point.potgen_options)
+                options["fft_threads"] = cores[0]
+                potential = point.medium_spec.create(os.path.join(path, "potential.dat"), options=options)
+            finally:
+                resources.release(cores)
+
+            # tracer
+            cores = resources.acquire(cores=self._trace_cores(point), urgent=True)
+            try:
+                options = dict(point.trace_options)
+                options["threads"] = cores[0]
+                args = list(options.get("args") or [])
+                if "--memory" not in args:
+                    args += ["--memory", str(max(memory[1] // 2**20, 1))]
+                options["args"] = args
+                result = trace(potential_file=potential, strength=point.medium_spec.strength,
+                               ray_count=point.ray_count, path=path, **options)
+            finally:
+                resources.release(cores)
+
+            # loading happens in parallel, only the reduction is serialized
+            result.load_files()
+            with lock:
+                for key in result.keys():
+                    # reduce into the accumulated result, which is writeable after the first reduction, so the
+                    # memory mapped grids of the new result are only read
+                    current = result.get_result(key)
+                    results[key] = current if results[key] is None else results[key].reduce(current)
+            _logger.info("Finished realization %d of %s", n, point.key)
+        finally:
+            shutil.rmtree(path)
+            resources.release(memory)
@@ -0,0 +1,110 @@
+import threading
+import time
+from ..test_utils import *
+from .scheduler import TraceScheduler, count_potential_grids, estimate_potential_bytes, _Resources
+
+
+class SumResult(object):
+    """ stands in for a ResultFile that is reduced by summation. """
+    def __init__(self, value):
+        self.value = value
+
+    def reduce(self, other):
+        if other is not None:
+            self.value += other.value
+        return self
+
+
+class FakeTrace(object):
+    """ records how many traces run at once, and with how many threads. """
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.running = 0
+        self.max_running = 0
+        self.threads = []
+
+    def __call__(self, potential_file, strength, ray_count, path, threads, args, **kwargs):
+        with self.lock:
+            self.running += 1
+            self.max_running = max(self.max_running, self.running)
+            self.threads.append(threads)
+        time.sleep(0.05)
+        with self.lock:
+            self.running -= 1
+        result = mock.Mock()
+        result.keys.return_value = ["density"]
+        result.get_result.return_value = SumResult(strength)
+        return result
+
+
+def make_medium(strength=1.0):
+    medium = mock.Mock()
+    medium.shape = (16, 16)
+    medium.dimension = 2
+    medium.strength = strength
+    return medium
+
+
+def test_count_potential_grids():
+    assert count_potential_grids(2, 0) == 1
+    assert count_potential_grids(2, 1) == 3
+    assert count_potential_grids(2, 2) == 6
+    assert count_potential_grids(3, 2) == 10
+    assert estimate_potential_bytes(make_medium(), 1) == 16 * 16 * 8 * 3
+
+
+def test_resources_clamp_and_release():
+    resources = _Resources(4, 100)
+    taken = resources.acquire(cores=8, memory=50)
+    assert taken == (4, 50)
+    resources.release(taken)
+    assert resources.acquire(cores=4, memory=100) == (4, 100)
+
+    resources.cancel()
+    with pytest.raises(RuntimeError):
+        resources.acquire(cores=1)
+
+
+def test_scheduler_reduces_points(tmpdir):
+    fake_trace = FakeTrace()
+    scheduler = TraceScheduler(cores=4, memory=10**9, work_dir=str(tmpdir))
+    scheduler.add("a", make_medium(1.0), 5, 100, potgen_options={"fft_threads": 1})
+    scheduler.add("b", make_medium(2.0), 3, 100, potgen_options={"fft_threads": 1})
+    with pytest.raises(KeyError):
+        scheduler.add("a", make_medium(), 1, 100)
+
+    with mock.patch("branchedflowsim.tracer.trace", side_effect=fake_trace):
+        results = scheduler.run()
+
+    assert results["a"]["density"].value == 5.0
+    assert results["b"]["density"].value == 6.0
+    # traces get the cores that potgen does not need, so only one runs at a time
+    assert fake_trace.threads == [3] * 8
+    assert fake_trace.max_running == 1
+    # temporary files are removed
+    assert tmpdir.listdir() == []
+
+
+def test_scheduler_memory_budget(tmpdir):
+    fake_trace = FakeTrace()
+    scheduler = TraceScheduler(cores=8, memory=3 * 10**6, work_dir=str(tmpdir))
+    scheduler.add("a", make_medium(), 6, 100, trace_options={"threads": 1}, memory=10**6)
+
+    with mock.patch("branchedflowsim.tracer.trace", side_effect=fake_trace):
+        scheduler.run()
+
+    assert fake_trace.max_running == 3
+    assert fake_trace.threads == [1] * 6
+
+
+def test_scheduler_error(tmpdir):
+    medium = make_medium()
+    medium.create.side_effect = IOError("potgen failed")
+    scheduler = TraceScheduler(cores=2, memory=10**9, work_dir=str(tmpdir))
+    scheduler.add("a", medium, 4, 100)
+
+    with mock.patch("branchedflowsim.tracer.trace") as trace:
+        with pytest.raises(IOError):
+            scheduler.run()
+    trace.assert_not_called()
+    assert tmpdir.listdir() == []
@@ -0,0 +1,150 @@
+#include "bench.hpp"
+#include "global.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <thread>
+#include <unistd.h>
+
+namespace bench
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock clock_t;
+
+        std::map<std::string, setup_t>& registry()
+        {
+            static std::map<std::string, setup_t> benchmarks;
+            return benchmarks;
+        }
+
+        /// runs \p body with \p operations operations and returns the elapsed time in nanoseconds.
+        double time_body( const body_t& body, std::size_t operations )
+        {
+            auto start = clock_t::now();
+            body( operations );
+            auto end = clock_t::now();
+            return std::chrono::duration<double, std::nano>(end - start).count();
+        }
+
+        /// finds the number of operations needed to run for at least \p min_time seconds.
+        std::size_t calibrate( const body_t& body, double min_time )
+        {
+            const double target_ns = min_time * 1e9;
+            std::size_t operations = 1;
+            while(true)
+            {
+                double ns = time_body( body, operations );
+                if(ns >= target_ns)
+                    return operations;
+                // grow by at most a factor of 10 per step, so we do not overshoot for noisy first measurements.
+                double factor = ns > 0 ? 1.2 * target_ns / ns : 10.0;
+                operations = std::max( operations + 1, (std::size_t)(operations * std::min(factor, 10.0)) );
+            }
+        }
+    }
+
+    bool registerBenchmark( std::string name, setup_t setup )
+    {
+        auto inserted = registry().emplace( std::move(name), std::move(setup) );
+        if(!inserted.second)
+            THROW_EXCEPTION( std::logic_error, "benchmark %1% registered twice", inserted.first->first );
+        return true;
+    }
+
+    std::vector<std::string> listBenchmarks( const std::string& filter )
+    {
+        std::regex pattern( filter.empty() ? ".*" : filter );
+        std::vector<std::string> names;
+        // std::map is sorted by key
+        for(const auto& entry : registry())
+        {
+            if(std::regex_search( entry.first, pattern ))
+                names.push_back( entry.first );
+        }
+        return names;
+    }
+
+    std::vector<Result> runBenchmarks( const Options& options, std::ostream& log )
+    {
+        if(options.repetitions == 0)
+            THROW_EXCEPTION( std::invalid_argument, "at least one repetition is required" );
+
+        std::vector<Result> results;
+        for(const auto& name : listBenchmarks( options.filter ))
+        {
+            body_t body = registry().at( name )();
+
+            // warm up caches and lazily initialized data (e.g. fft plans), then find the operation count.
+            body( 1 );
+            std::size_t operations = calibrate( body, options.min_time );
+
+            std::vector<double> ns_per_op;
+            for(std::size_t i = 0; i < options.repetitions; ++i)
+                ns_per_op.push_back( time_body( body, operations ) / operations );
+            std::sort( ns_per_op.begin(), ns_per_op.end() );
+
+            Result result{name, operations, options.repetitions, ns_per_op[ns_per_op.size() / 2],
+                          ns_per_op.front(), ns_per_op.back()};
+            results.push_back( result );
+
+            auto flags = log.flags();
+            log << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(14) << result.ns_per_op << " ns/op"
+                << "  [" << result.ns_per_op_min << ", " << result.ns_per_op_max << "]"
+                << "  x" << operations << "\n";
+            log.flags( flags );
+        }
+        return results;
+    }
+
+    void writeJSON( std::ostream& out, const std::vector<Result>& results, const Options& options )
+    {
+        char date[32] = "";
+        std::time_t now = std::time(nullptr);
+        std::strftime( date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now) );
+
+        char host[256] = "";
+        gethostname( host, sizeof(host) - 1 );
+
+#ifdef BENCH_BUILD_TYPE
+        const char* build_type = BENCH_BUILD_TYPE;
+#else
+        const char* build_type = "";
+#endif
+
+        auto sorted = results;
+        std::sort( sorted.begin(), sorted.end(), [](const Result& a, const Result& b) { return a.name < b.name; } );
+
+        auto flags = out.flags();
+        out << std::setprecision(3) << std::fixed;
+        out << "{\n";
+        out << "  \"format\": \"branchedflowsim-bench\",\n";
+        out << "  \"version\": 1,\n";
+        out << "  \"context\": {\n";
+        out << "    \"date\": \"" << date << "\",\n";
+        out << "    \"host\": \"" << json_escape(host) << "\",\n";
+        out << "    \"compiler\": \"" << json_escape(__VERSION__) << "\",\n";
+        out << "    \"build_type\": \"" << json_escape(build_type) << "\",\n";
+        out << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "    \"min_time\": " << options.min_time << ",\n";
+        out << "    \"repetitions\": " << options.repetitions << "\n";
+        out << "  },\n";
+        out << "  \"benchmarks\": [";
+        for(std::size_t i = 0; i < sorted.size(); ++i)
+        {
+            const auto& r = sorted[i];
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    {\"name\": \"" << json_escape(r.name) << "\", \"operations\": " << r.operations
+                << ", \"repetitions\": " << r.repetitions << ", \"ns_per_op\": " << r.ns_per_op
+                << ", \"ns_per_op_min\": " << r.ns_per_op_min << ", \"ns_per_op_max\": " << r.ns_per_op_max << "}";
+        }
+        out << "\n  ]\n}\n";
+        out.flags( flags );
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef BENCH_HPP_INCLUDED
+#define BENCH_HPP_INCLUDED
+
+/*! \file bench.hpp
+    \brief Minimal micro-benchmark harness for the performance critical kernels.
+    \details Benchmarks are registered by name and consist of a setup function, which prepares all data
+            (potentials, grids, observers) outside of the measurement, and returns the body that is timed.
+            The body is called with a number of operations, which it has to perform, so the harness can
+            report the time per operation. Results can be written as json, see writeJSON.
+*/
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    /// a benchmark body. Called with the number of operations it has to perform.
+    typedef std::function<void(std::size_t)> body_t;
+
+    /// setup function of a benchmark. Called once before the measurement, returns the body to time.
+    typedef std::function<body_t()> setup_t;
+
+    /// options that control which benchmarks are run and how long.
+    struct Options
+    {
+        /// minimum time in seconds for a single repetition. The number of operations is chosen accordingly.
+        double min_time = 0.2;
+        /// number of timed repetitions, the median of which is reported.
+        std::size_t repetitions = 5;
+        /// regular expression that selects the benchmarks to run. Empty means all.
+        std::string filter;
+    };
+
+    /// timing result of a single benchmark.
+    struct Result
+    {
+        std::string name;
+        /// number of operations performed in each repetition
+        std::size_t operations;
+        /// number of timed repetitions
+        std::size_t repetitions;
+        /// median, minimum and maximum time per operation over all repetitions, in nanoseconds.
+        double ns_per_op;
+        double ns_per_op_min;
+        double ns_per_op_max;
+    };
+
+    /// registers a benchmark. Names are hierarchical, separated by '/', e.g. "linear_interpolate/2d/interior".
+    /// \return true, so the result can be used to initialize a static variable.
+    bool registerBenchmark( std::string name, setup_t setup );
+
+    /// gets the names of all registered benchmarks that match \p filter, sorted by name.
+    std::vector<std::string> listBenchmarks( const std::string& filter );
+
+    /// runs all benchmarks selected by \p options. Prints a human readable line per benchmark to \p log.
+    std::vector<Result> runBenchmarks( const Options& options, std::ostream& log );
+
+    /*! \brief writes \p results as json.
+        \details The format is stable, so results of different builds can be compared by name:
+        \code
+        {
+          "format": "branchedflowsim-bench", "version": 1,
+          "context": {"date": ..., "host": ..., "compiler": ..., "build_type": ..., "hardware_concurrency": ...,
+                      "min_time": ..., "repetitions": ...},
+          "benchmarks": [{"name": ..., "operations": ..., "repetitions": ...,
+                          "ns_per_op": ..., "ns_per_op_min": ..., "ns_per_op_max": ...}, ...]
+        }
+        \endcode
+        Benchmarks are sorted by name.
+    */
+    void writeJSON( std::ostream& out, const std::vector<Result>& results, const Options& options );
+
+    /// prevents the compiler from optimizing away the computation of \p value.
+    template<class T>
+    inline void doNotOptimize( const T& value )
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#endif // BENCH_HPP_INCLUDED
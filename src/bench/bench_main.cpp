@@ -0,0 +1,71 @@
+#include "bench.hpp"
+#include <fstream>
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+namespace po = boost::program_options;
+
+int main(int argc, char* argv[])
+{
+    bench::Options options;
+    std::string json_file;
+    bool list = false;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "Produce help message.")
+        ("filter,f", po::value<std::string>(&options.filter), "Regular expression that selects the benchmarks to run.")
+        ("min-time", po::value<double>(&options.min_time)->default_value(options.min_time), "Minimum duration of a single repetition, in seconds.")
+        ("repetitions", po::value<std::size_t>(&options.repetitions)->default_value(options.repetitions), "Number of timed repetitions per benchmark. The median is reported.")
+        ("json,o", po::value<std::string>(&json_file), "Write the results as json to this file. Use - for stdout.")
+        ("list", po::bool_switch(&list), "Only list the selected benchmarks.")
+    ;
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch( std::exception& ex )
+    {
+        std::cerr << "error parsing command line parameters!\n";
+        std::cerr << boost::diagnostic_information(ex, true) << "\n\n";
+        return EXIT_FAILURE;
+    }
+
+    if(vm.count("help"))
+    {
+        std::cout << desc << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    try
+    {
+        if(list)
+        {
+            for(const auto& name : bench::listBenchmarks(options.filter))
+                std::cout << name << "\n";
+            return EXIT_SUCCESS;
+        }
+
+        // when json goes to stdout, keep the progress lines out of it
+        std::ostream& log = json_file == "-" ? std::cerr : std::cout;
+        auto results = bench::runBenchmarks(options, log);
+
+        if(json_file == "-")
+        {
+            bench::writeJSON(std::cout, results, options);
+        } else if(!json_file.empty())
+        {
+            std::ofstream out(json_file);
+            bench::writeJSON(out, results, options);
+        }
+    } catch (std::exception& e)
+    {
+        std::cerr << boost::diagnostic_information(e) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
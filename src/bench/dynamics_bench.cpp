@@ -0,0 +1,63 @@
+#include "bench.hpp"
+#include "fixtures.hpp"
+#include "potential.hpp"
+#include "ode_state.hpp"
+#include "dynamics/ParticleInPotentialDynamics.hpp"
+#include <memory>
+#include <random>
+#include <string>
+
+namespace
+{
+    const std::size_t STATE_COUNT = 1024;
+
+    bench::body_t stateUpdateBench( std::size_t dimension, bool periodic, bool monodromy )
+    {
+        auto dynamics = std::make_shared<ParticleInPotentialDynamics>( bench::getPotential(dimension), periodic, monodromy );
+
+        // positions in world coordinates, away from the boundary so non-periodic dynamics do not stop the ray.
+        auto positions = bench::randomPoints( STATE_COUNT, std::vector<std::size_t>(dimension, 1), 0.05, 0.95 );
+        auto states = std::make_shared<std::vector<GState>>();
+        std::mt19937 engine( 7 );
+        std::normal_distribution<double> distribution;
+        for(std::size_t i = 0; i < STATE_COUNT; ++i)
+        {
+            GState state( dimension, monodromy );
+            for(std::size_t j = 0; j < dimension; ++j)
+            {
+                state.position()[j] = positions[i * dimension + j];
+                state.velocity()[j] = distribution( engine );
+            }
+            if(monodromy)
+                state.init_monodromy();
+            states->push_back( state );
+        }
+
+        auto deriv = std::make_shared<GState>( dimension, monodromy );
+        return [dynamics, states, deriv](std::size_t operations)
+        {
+            for(std::size_t i = 0; i < operations; ++i)
+                dynamics->stateUpdate( (*states)[i % STATE_COUNT], *deriv, 0.0 );
+            bench::doNotOptimize( *deriv->begin() );
+        };
+    }
+
+    bool registerDynamicsBenchmarks()
+    {
+        for(std::size_t dim = 2; dim <= 3; ++dim)
+        {
+            for(bool periodic : {false, true})
+            {
+                for(bool monodromy : {false, true})
+                {
+                    std::string name = "state_update/" + std::to_string(dim) + "d/" +
+                                       (periodic ? "periodic" : "bounded") + (monodromy ? "/monodromy" : "");
+                    bench::registerBenchmark( name, [=]() { return stateUpdateBench( dim, periodic, monodromy ); } );
+                }
+            }
+        }
+        return true;
+    }
+
+    const bool registered = registerDynamicsBenchmarks();
+}
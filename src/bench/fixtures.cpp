@@ -0,0 +1,53 @@
+#include "fixtures.hpp"
+#include "potential.hpp"
+#include "potgen.hpp"
+#include "correlation.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace bench
+{
+    const Potential& getPotential( std::size_t dimension )
+    {
+        static std::mutex mutex;
+        static std::map<std::size_t, std::unique_ptr<Potential>> cache;
+
+        std::lock_guard<std::mutex> lock( mutex );
+        auto& potential = cache[dimension];
+        if(!potential)
+        {
+            std::size_t size = dimension == 3 ? 64 : 256;
+
+            PGOptions opt;
+            opt.randomSeed = 42;
+            opt.maxDerivativeOrder = 2;
+            opt.corrlength = 0.1;
+            opt.cor_fun = makeCorrelation( {"gauss"}, opt.corrlength, "" );
+            opt.numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+            potential.reset( new Potential( generatePotential( std::vector<std::size_t>(dimension, size),
+                                                               std::vector<double>(dimension, 1.0), opt ) ) );
+            potential->setStrength( 0.05 );
+        }
+        return *potential;
+    }
+
+    std::vector<double> randomPoints( std::size_t count, const std::vector<std::size_t>& extents,
+                                      double lower, double upper )
+    {
+        std::mt19937 engine( 12345 );
+        std::vector<double> points( count * extents.size() );
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            for(std::size_t j = 0; j < extents.size(); ++j)
+            {
+                std::uniform_real_distribution<double> distribution( lower * extents[j], upper * extents[j] );
+                points[i * extents.size() + j] = distribution( engine );
+            }
+        }
+        return points;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef BENCH_FIXTURES_HPP_INCLUDED
+#define BENCH_FIXTURES_HPP_INCLUDED
+
+/*! \file fixtures.hpp
+    \brief Shared data for the benchmarks, so every benchmark runs on the same kind of input.
+*/
+
+#include <cstddef>
+#include <vector>
+
+class Potential;
+
+namespace bench
+{
+    /// gets a random potential (gaussian correlation, length 0.1, strength 0.05) with derivatives up to
+    /// second order. 2D potentials are 256x256, 3D potentials 64^3. Generated once with a fixed seed and cached.
+    const Potential& getPotential( std::size_t dimension );
+
+    /// creates \p count random points with \p dimension coordinates each, stored contiguously.
+    /// Coordinate i is uniformly distributed in [lower * extents[i], upper * extents[i]). Uses a fixed seed.
+    std::vector<double> randomPoints( std::size_t count, const std::vector<std::size_t>& extents,
+                                      double lower, double upper );
+}
+
+#endif // BENCH_FIXTURES_HPP_INCLUDED
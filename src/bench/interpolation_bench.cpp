@@ -0,0 +1,97 @@
+#include "bench.hpp"
+#include "fixtures.hpp"
+#include "interpolation.hpp"
+#include "dynamic_grid.hpp"
+#include <memory>
+#include <random>
+#include <string>
+
+namespace
+{
+    /// number of distinct sample positions. Large enough that branch predictors cannot learn the pattern,
+    /// small enough to stay in cache, so we measure the grid accesses.
+    const std::size_t POINT_COUNT = 4096;
+
+    std::vector<std::size_t> gridExtents( std::size_t dimension )
+    {
+        switch(dimension)
+        {
+            case 1: return {1 << 16};
+            case 2: return {512, 512};
+            default: return {64, 64, 64};
+        }
+    }
+
+    std::vector<gen_vect> toVectors( const std::vector<double>& points, std::size_t dimension )
+    {
+        std::vector<gen_vect> vectors;
+        for(std::size_t i = 0; i < points.size(); i += dimension)
+        {
+            gen_vect v(dimension);
+            for(std::size_t j = 0; j < dimension; ++j)
+                v[j] = points[i + j];
+            vectors.push_back( v );
+        }
+        return vectors;
+    }
+
+    // interpolation requires periodic grids, so instead of comparing access modes we compare positions inside
+    // the grid with positions that need to be wrapped around the boundary.
+    bench::body_t linearInterpolateBench( std::size_t dimension, bool wrapped )
+    {
+        auto extents = gridExtents( dimension );
+        auto grid = std::make_shared<default_grid>( extents, TransformationType::PERIODIC );
+        std::mt19937 engine( 1 );
+        std::normal_distribution<double> distribution;
+        for(auto& value : *grid)
+            value = distribution( engine );
+
+        auto points = std::make_shared<std::vector<double>>(
+                wrapped ? bench::randomPoints( POINT_COUNT, extents, -1.0, 2.0 )
+                        : bench::randomPoints( POINT_COUNT, extents, 0.0, 1.0 ) );
+
+        return [grid, points, dimension](std::size_t operations)
+        {
+            double sum = 0;
+            const double* data = points->data();
+            for(std::size_t i = 0; i < operations; ++i)
+                sum += linearInterpolate( *grid, data + (i % POINT_COUNT) * dimension );
+            bench::doNotOptimize( sum );
+        };
+    }
+
+    bench::body_t drawInterpolatedDotBench( std::size_t dimension )
+    {
+        std::vector<std::size_t> extents = dimension == 2 ? std::vector<std::size_t>{512, 512}
+                                                          : std::vector<std::size_t>{128, 128, 128};
+        auto grid = std::make_shared<DynamicGrid<float>>( extents, TransformationType::PERIODIC );
+        auto points = std::make_shared<std::vector<gen_vect>>(
+                toVectors( bench::randomPoints( POINT_COUNT, extents, 0.0, 1.0 ), dimension ) );
+
+        return [grid, points](std::size_t operations)
+        {
+            for(std::size_t i = 0; i < operations; ++i)
+                drawInterpolatedDot( *grid, (*points)[i % POINT_COUNT], 1.0 );
+            bench::doNotOptimize( (*grid)[0] );
+        };
+    }
+
+    bool registerInterpolationBenchmarks()
+    {
+        for(std::size_t dim = 1; dim <= 3; ++dim)
+        {
+            std::string prefix = "linear_interpolate/" + std::to_string(dim) + "d/";
+            bench::registerBenchmark( prefix + "interior", [dim]() { return linearInterpolateBench( dim, false ); } );
+            bench::registerBenchmark( prefix + "wrapped", [dim]() { return linearInterpolateBench( dim, true ); } );
+        }
+
+        for(std::size_t dim = 2; dim <= 3; ++dim)
+        {
+            bench::registerBenchmark( "draw_interpolated_dot/" + std::to_string(dim) + "d",
+                                      [dim]() { return drawInterpolatedDotBench( dim ); } );
+        }
+        return true;
+    }
+
+    const bool registered = registerInterpolationBenchmarks();
+}
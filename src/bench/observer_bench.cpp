@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "fixtures.hpp"
+#include "potential.hpp"
+#include "ode_state.hpp"
+#include "dynamics/ParticleInPotentialDynamics.hpp"
+#include "initial_conditions/initial_conditions.hpp"
+#include "observers/master_observer.hpp"
+#include "observers/observer.hpp"
+#include "observers/observer_factory.hpp"
+#include <memory>
+#include <string>
+
+namespace
+{
+    /// number of integration steps per trajectory
+    const std::size_t TRAJECTORY_LENGTH = 500;
+
+    /// everything needed to feed trajectories into a MasterObserver.
+    struct ObserverContext
+    {
+        std::shared_ptr<const RayDynamics> dynamics;
+        std::unique_ptr<MasterObserver> master;
+        InitCondGenPtr generator;
+        std::unique_ptr<InitialCondition> incoming;
+        std::vector<GState> states;
+        std::vector<double> times;
+        std::size_t step = 0;
+    };
+
+    /// \p observers is a list of observer configurations as they would be passed to the tracer, e.g. {{"density"}}.
+    bench::body_t masterObserverBench( const std::vector<std::vector<std::string>>& observers )
+    {
+        const Potential& potential = bench::getPotential( 2 );
+
+        auto context = std::make_shared<ObserverContext>();
+        bool monodromy = false;
+        for(const auto& cfg : observers)
+            monodromy = monodromy || getObserverFactory().get_builder(cfg.front())->need_monodromy();
+
+        context->dynamics = std::make_shared<ParticleInPotentialDynamics>( potential, false, monodromy );
+        context->master.reset( new MasterObserver( 2, context->dynamics ) );
+        for(const auto& cfg : observers)
+        {
+            std::vector<std::string> options( cfg.begin() + 1, cfg.end() );
+            context->master->addObserverObject( getObserverFactory().create(cfg.front(), options, potential) );
+        }
+
+        InitialConditionConfiguration config;
+        config.setParticleCount( 1 << 30 ).setEnergyNormalization( false )
+              .setDynamics( context->dynamics ).setSupport( potential.getSupport() ).setOffset( gen_vect(2) );
+        context->generator = createInitialConditionGenerator( 2, {"planar"} );
+        context->generator->init( config );
+        context->incoming.reset( new InitialCondition( context->generator->next() ) );
+
+        // a straight ray through the potential, so all observers keep watching until the end.
+        for(std::size_t i = 0; i < TRAJECTORY_LENGTH; ++i)
+        {
+            double t = 0.9 * i / TRAJECTORY_LENGTH;
+            GState state( 2, monodromy );
+            state.position()[0] = 0.05 + t;
+            state.position()[1] = 0.5;
+            state.velocity()[0] = 1.0;
+            state.velocity()[1] = 0.0;
+            if(monodromy)
+                state.init_monodromy();
+            context->states.push_back( state );
+            context->times.push_back( t );
+        }
+
+        context->master->startTracing();
+
+        return [context](std::size_t operations)
+        {
+            auto& master = *context->master;
+            for(std::size_t i = 0; i < operations; ++i)
+            {
+                if(context->step == 0)
+                    master.startTrajectory( *context->incoming );
+
+                // the master observer throws once no observer is interested in the trajectory any more
+                try
+                {
+                    master( context->states[context->step], context->times[context->step] );
+                } catch(int&) {}
+
+                if(++context->step == TRAJECTORY_LENGTH)
+                {
+                    master.finishTrajectory( *context->incoming );
+                    context->step = 0;
+                }
+            }
+        };
+    }
+
+    bool registerObserverBenchmarks()
+    {
+        bench::registerBenchmark( "master_observer/density",
+                                  []() { return masterObserverBench( {{"density"}} ); } );
+        bench::registerBenchmark( "master_observer/density_caustics",
+                                  []() { return masterObserverBench( {{"density"}, {"caustics"}} ); } );
+        bench::registerBenchmark( "master_observer/density_caustics_angles",
+                                  []() { return masterObserverBench( {{"density"}, {"caustics"}, {"angle_histogram"}} ); } );
+        return true;
+    }
+
+    const bool registered = registerObserverBenchmarks();
+}
@@ -0,0 +1,82 @@
+#include "bench.hpp"
+#include "dynamic_grid.hpp"
+#include "fft.hpp"
+#include "potgen.hpp"
+#include <memory>
+#include <random>
+#include <string>
+
+// not part of the public potgen interface
+default_grid calculateDerivative( std::vector<int> order_per_dir, const complex_grid& f_k );
+
+namespace
+{
+    std::shared_ptr<complex_grid> randomComplexGrid( const std::vector<std::size_t>& extents )
+    {
+        auto grid = std::make_shared<complex_grid>( extents, TransformationType::FFT_INDEX );
+        std::mt19937 engine( 3 );
+        std::normal_distribution<double> distribution;
+        for(auto& value : *grid)
+            value = complex_t( distribution(engine), distribution(engine) );
+        return grid;
+    }
+
+    std::string sizeName( const std::vector<std::size_t>& extents )
+    {
+        std::string name = std::to_string(extents.size()) + "d/" + std::to_string(extents[0]);
+        for(std::size_t i = 1; i < extents.size(); ++i)
+            name += "x" + std::to_string(extents[i]);
+        return name;
+    }
+
+    // one operation is a single transform. Forward and backward transforms alternate, so the values stay bounded.
+    bench::body_t fftBench( std::vector<std::size_t> extents )
+    {
+        auto grid = randomComplexGrid( extents );
+        return [grid](std::size_t operations)
+        {
+            for(std::size_t i = 0; i < operations; ++i)
+            {
+                if(i % 2 == 0)
+                    fft( *grid );
+                else
+                    ifft( *grid );
+            }
+            bench::doNotOptimize( (*grid)[0] );
+        };
+    }
+
+    bench::body_t derivativeBench( std::vector<std::size_t> extents )
+    {
+        auto grid = randomComplexGrid( extents );
+        std::vector<int> order( extents.size(), 0 );
+        order[0] = 1;
+        return [grid, order](std::size_t operations)
+        {
+            for(std::size_t i = 0; i < operations; ++i)
+            {
+                auto derivative = calculateDerivative( order, *grid );
+                bench::doNotOptimize( derivative[0] );
+            }
+        };
+    }
+
+    bool registerPotgenBenchmarks()
+    {
+        const std::vector<std::vector<std::size_t>> fft_sizes = {
+            {256, 256}, {512, 512}, {1024, 1024}, {64, 64, 64}, {128, 128, 128}
+        };
+        for(const auto& extents : fft_sizes)
+            bench::registerBenchmark( "fft/" + sizeName(extents), [extents]() { return fftBench( extents ); } );
+
+        const std::vector<std::vector<std::size_t>> derivative_sizes = { {512, 512}, {64, 64, 64} };
+        for(const auto& extents : derivative_sizes)
+        {
+            bench::registerBenchmark( "calculate_derivative/" + sizeName(extents),
+                                      [extents]() { return derivativeBench( extents ); } );
+        }
+        return true;
+    }
+
+    const bool registered = registerPotgenBenchmarks();
+}
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+End-to-end performance scenarios for potgen and tracer.
+
+Every scenario (a json file in `scenarios/`) describes a deterministic potential (fixed seed and size) and a tracer
+configuration. The runner generates the potential with `potgen`, runs `tracer` and collects throughput (rays/s,
+integration steps/s), peak memory and the time spent in each phase from the `config.txt` the tracer writes.
+Results can be saved as json and compared against a stored baseline; the exit code is 1 if a scenario regressed
+by more than the given tolerance, so the script can be used to gate builds.
+
+Typical usage:
+
+    # record a baseline on the gating machine
+    run_scenarios.py --bin-dir build/src --update-baseline baseline.json
+    # later builds
+    run_scenarios.py --bin-dir build/src --baseline baseline.json --output results.json
+"""
+
+import argparse
+import glob
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SCENARIO_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "scenarios")
+FORMAT = "branchedflowsim-scenarios"
+VERSION = 1
+
+# metrics that are compared against the baseline. Time per phase is recorded, but only reported.
+HIGHER_IS_BETTER = ("rays_per_s", "steps_per_s")
+LOWER_IS_BETTER = ("peak_memory_mb",)
+
+
+def find_executable(name, bin_dir):
+    """ Finds `name` in the build directory layout (`bin_dir/<name>/<name>`), directly in `bin_dir` or on the PATH. """
+    if bin_dir:
+        for candidate in (os.path.join(bin_dir, name, name), os.path.join(bin_dir, name)):
+            if os.path.isfile(candidate) and os.access(candidate, os.X_OK):
+                return candidate
+    found = shutil.which(name)
+    if found is None:
+        raise RuntimeError("Could not find the %s executable. Use --bin-dir to specify the build directory." % name)
+    return found
+
+
+def load_scenarios(paths):
+    scenarios = []
+    for path in paths:
+        with open(path) as source:
+            scenario = json.load(source)
+        scenario.setdefault("name", os.path.splitext(os.path.basename(path))[0])
+        scenarios.append(scenario)
+    return scenarios
+
+
+def potential_file(potgen, spec, work_dir):
+    """ Generates the potential described by `spec`, unless an identical one was already generated in this run. """
+    dimension = spec["dimension"]
+    name = "pot_%dd_%d_seed%d_l%g_o%d.dat" % (dimension, spec["size"], spec.get("seed", 1),
+                                                spec.get("corrlength", 0.1), spec.get("derivative_order", 1))
+    path = os.path.join(work_dir, name)
+    if os.path.exists(path):
+        return path, 0.0
+
+    command = [potgen, "-d", str(dimension), "-s", str(spec["size"]),
+               "-l", str(spec.get("corrlength", 0.1)), "--seed", str(spec.get("seed", 1)),
+               "--derivative-order", str(spec.get("derivative_order", 1)), "--no-wisdom", "-o", path]
+    start = time.time()
+    subprocess.check_call(command, stdout=subprocess.DEVNULL)
+    return path, time.time() - start
+
+
+def parse_config(path):
+    """ Reads the `# key value` lines that the tracer appends to its config.txt. """
+    values = {}
+    with open(path) as source:
+        for line in source:
+            if not line.startswith("# "):
+                continue
+            key, _, value = line[2:].strip().rpartition(" ")
+            try:
+                values[key] = float(value)
+            except ValueError:
+                pass
+    return values
+
+
+def run_tracer(tracer, potential, spec, result_dir):
+    command = [tracer, potential, "-n", str(spec["particles"]), "-r", result_dir]
+    if "strength" in spec:
+        command += ["-s", str(spec["strength"])]
+    if "threads" in spec:
+        command += ["-t", str(spec["threads"])]
+    if spec.get("observers"):
+        command += ["--observers"] + [str(o) for o in spec["observers"]]
+    command += [str(a) for a in spec.get("args", [])]
+
+    subprocess.check_call(command, stdout=subprocess.DEVNULL)
+    info = parse_config(os.path.join(result_dir, "config.txt"))
+    trace_time = info["trace time [s]"]
+    return {
+        "rays_per_s": info["particles"] / trace_time,
+        "steps_per_s": info["integration steps"] / trace_time,
+        "integration_steps": info["integration steps"],
+        "peak_memory_mb": info["peak memory [MB]"],
+        "setup_s": info["setup time [s]"],
+        "trace_s": trace_time,
+        "save_s": info["save time [s]"],
+    }
+
+
+def run_scenario(scenario, potgen, tracer, work_dir, repeat):
+    """ Runs a scenario `repeat` times and returns the median of each metric. """
+    potential, potgen_time = potential_file(potgen, scenario["potential"], work_dir)
+    runs = []
+    for i in range(repeat):
+        result_dir = os.path.join(work_dir, "%s_%d" % (scenario["name"], i))
+        runs.append(run_tracer(tracer, potential, scenario["tracer"], result_dir))
+        shutil.rmtree(result_dir, ignore_errors=True)
+
+    metrics = {key: statistics.median(run[key] for run in runs) for key in runs[0]}
+    if potgen_time > 0:
+        metrics["potgen_s"] = potgen_time
+    return metrics
+
+
+def compare(results, baseline, tolerance, memory_tolerance):
+    """
+    Compares `results` against `baseline` (both in the format written by this script).
+    :return list[str]: Descriptions of all regressions.
+    """
+    regressions = []
+    for name, metrics in sorted(results["scenarios"].items()):
+        reference = baseline.get("scenarios", {}).get(name)
+        if reference is None:
+            print("%-20s no baseline" % name)
+            continue
+
+        for key in HIGHER_IS_BETTER + LOWER_IS_BETTER:
+            if key not in reference or key not in metrics:
+                continue
+            ratio = metrics[key] / reference[key] if reference[key] else 1.0
+            if key in HIGHER_IS_BETTER:
+                regressed = ratio < 1.0 - tolerance
+            else:
+                regressed = ratio > 1.0 + memory_tolerance
+            print("%-20s %-16s %12.4g  baseline %12.4g  (%+.1f%%)%s" % (
+                name, key, metrics[key], reference[key], (ratio - 1.0) * 100, "  REGRESSION" if regressed else ""))
+            if regressed:
+                regressions.append("%s: %s %.4g vs baseline %.4g" % (name, key, metrics[key], reference[key]))
+
+        # with fixed seeds, the amount of work is deterministic. If it changes, throughput is not comparable.
+        if reference.get("integration_steps") and metrics.get("integration_steps") != reference["integration_steps"]:
+            print("%-20s warning: integration steps changed from %d to %d, the scenario does different work now." % (
+                name, reference["integration_steps"], metrics["integration_steps"]))
+    return regressions
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("scenarios", nargs="*", help="Scenario files. Defaults to all scenarios in %s." % SCENARIO_DIR)
+    parser.add_argument("--bin-dir", help="Directory containing the potgen and tracer executables (e.g. build/src).")
+    parser.add_argument("--work-dir", help="Directory for potentials and tracer output. Defaults to a temporary one.")
+    parser.add_argument("--repeat", type=int, default=1, help="Number of tracer runs per scenario; the median is used.")
+    parser.add_argument("--output", help="Write the results to this json file.")
+    parser.add_argument("--baseline", help="Compare against this baseline file.")
+    parser.add_argument("--update-baseline", metavar="FILE", help="Write the results as new baseline to FILE.")
+    parser.add_argument("--tolerance", type=float, default=0.1,
+                        help="Allowed relative throughput loss before a scenario counts as regressed.")
+    parser.add_argument("--memory-tolerance", type=float, default=0.1,
+                        help="Allowed relative increase of peak memory before a scenario counts as regressed.")
+    args = parser.parse_args(argv)
+
+    potgen = find_executable("potgen", args.bin_dir)
+    tracer = find_executable("tracer", args.bin_dir)
+    scenarios = load_scenarios(args.scenarios or sorted(glob.glob(os.path.join(SCENARIO_DIR, "*.json"))))
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix="bfs_scenarios_")
+    os.makedirs(work_dir, exist_ok=True)
+
+    results = {
+        "format": FORMAT,
+        "version": VERSION,
+        "context": {
+            "date": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+            "host": platform.node(),
+            "machine": platform.machine(),
+            "cpu_count": os.cpu_count(),
+            "repeat": args.repeat,
+        },
+        "scenarios": {},
+    }
+
+    try:
+        for scenario in scenarios:
+            metrics = run_scenario(scenario, potgen, tracer, work_dir, args.repeat)
+            results["scenarios"][scenario["name"]] = metrics
+            print("%-20s %10.1f rays/s %12.1f steps/s %8.1f MB  setup %.2fs  trace %.2fs  save %.2fs" % (
+                scenario["name"], metrics["rays_per_s"], metrics["steps_per_s"], metrics["peak_memory_mb"],
+                metrics["setup_s"], metrics["trace_s"], metrics["save_s"]))
+    finally:
+        if not args.work_dir:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    for path in (args.output, args.update_baseline):
+        if path:
+            with open(path, "w") as target:
+                json.dump(results, target, indent=2, sort_keys=True)
+
+    if args.baseline:
+        with open(args.baseline) as source:
+            baseline = json.load(source)
+        if baseline.get("format") != FORMAT:
+            raise RuntimeError("%s is not a scenario baseline file" % args.baseline)
+        regressions = compare(results, baseline, args.tolerance, args.memory_tolerance)
+        if regressions:
+            print("\n%d regression(s):\n  %s" % (len(regressions), "\n  ".join(regressions)))
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
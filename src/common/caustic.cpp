@@ -36,19 +36,25 @@ Caustic::Caustic( int dimension ) :
 
 void Caustic::write(std::ostream& file) const
 {
-    writeInteger( file, mTrajectory );
+    BinaryWriter writer(file, 256);
+    write(writer);
+}
+
+void Caustic::write(BinaryWriter& writer) const
+{
+    writer.putInteger( mTrajectory );
     // write position
-    writeVec( file, mCausticPosition );
-    writeVec( file, mCausticVelocity );
+    writer.putVec( mCausticPosition );
+    writer.putVec( mCausticVelocity );
     // write origin
-    writeVec( file, mInitialPosition );
-    writeVec( file, mInitialVelocity );
-    writeFloat( file, mTime );
+    writer.putVec( mInitialPosition );
+    writer.putVec( mInitialVelocity );
+    writer.putFloat( mTime );
     // write the caustic index (on trajectory) as a single byte
-    file.write(reinterpret_cast<const char*>(&mIndex), sizeof(mIndex));
+    writer.putBytes( &mIndex, sizeof(mIndex) );
 }
 
-void Caustic::read( std::fstream& file )
+void Caustic::read( std::istream& file )
 {
     readInteger( file, mTrajectory );
     // read
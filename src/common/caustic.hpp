@@ -9,6 +9,8 @@
 #include "vector.hpp"
 #include <iosfwd>
 
+class BinaryWriter;
+
 /*! \class Caustic
     \ingroup common
     \brief Class for recording data of a single caustic.
@@ -55,15 +57,22 @@ public:
     /// gets the index of the caustic on the trajectory.
     uint8_t getIndex() const { return mIndex; }
 
+    /// changes the ID of the trajectory this caustic is on.
+    void setTrajectoryID( uint64_t trajectory ) { mTrajectory = trajectory; }
+
     // I/O
     /// writes this caustic into the file \p file.
     /// \attention Does not include dimension information, since it is expected to
     ///             be used to write whole arrays.
     void write(std::ostream& file) const;
 
+    /// appends this caustic to the buffered \p writer. Produces the same format as write(std::ostream&),
+    /// but should be preferred when writing many caustics.
+    void write(BinaryWriter& writer) const;
+
     /// reads caustic data from \p file into this objects.
     /// \attention The caustic has to be set to the correct dimension, i.e. by using Caustic(int) ctor.
-    void read( std::fstream& file );
+    void read( std::istream& file );
 
 private:
     // use uint64_t to be independent of sizeof(int)
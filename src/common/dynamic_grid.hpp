@@ -5,6 +5,7 @@
 #include <functional>
 #include <boost/lexical_cast.hpp>
 #include "grid_storage.hpp"
+#include "grid_compression.hpp"
 #include "dynamic_grid_base.hpp"
 #include "util.hpp"
 
@@ -141,6 +142,61 @@ public:
         // return
         return std::move(grid);
     }
+
+    /// \brief replaces the data of this grid with a grid read from \p in. Other than load(),
+    ///        this keeps the indexing of this grid.
+    /// \throw std::runtime_error if the saved grid has different extents.
+    void reload( std::istream& in )
+    {
+        auto extents = load_info(in);
+        if( extents != mExtents )
+            THROW_EXCEPTION( std::runtime_error, "saved grid of dimension %1% does not match the extents of this grid",
+                             extents.size() );
+        mData.load( in );
+    }
+
+    /// position of a grid inside a binary file, as determined by scan().
+    struct FileLocation
+    {
+        extents_type extents;       //!< extents of the saved grid
+        std::uint64_t offset;       //!< file offset of the grid data
+        GridEncoding encoding;      //!< format of the grid data
+    };
+
+    /// reads the header of a grid from \p in and skips over its data, so that the data
+    /// can be read later (and possibly concurrently) with load(int, const FileLocation&) or load_range().
+    static FileLocation scan( std::istream& in )
+    {
+        FileLocation location;
+        location.extents = load_info(in);
+        auto header = GridStorage::load_header( in, typeid(value_type) );
+        if( header.count != safe_product(location.extents) )
+            THROW_EXCEPTION( std::runtime_error, "number of data elements %1% does not match grid size %2%",
+                             header.count, safe_product(location.extents) );
+        location.offset = in.tellg();
+        location.encoding = header.encoding;
+        if(header.encoding == GridEncoding::COMPRESSED)
+            skipCompressed( in );
+        else
+            in.seekg( header.count * sizeof(value_type), std::ios::cur );
+        return location;
+    }
+
+    /// loads a grid whose position in the file \p fd was determined by scan().
+    static DynamicGrid load( int fd, const FileLocation& location )
+    {
+        DynamicGrid grid( location.extents, TransformationType::IDENTITY );
+        grid.mData.load_raw( fd, location.offset, location.encoding );
+        return grid;
+    }
+
+    /// reads the bytes [\p begin, \p end) of the uncompressed grid data at \p location into this grid,
+    /// which has to have the extents of the saved grid. Disjoint ranges can be read concurrently.
+    void load_range( int fd, const FileLocation& location, std::size_t begin, std::size_t end )
+    {
+        assert( location.encoding == GridEncoding::RAW && location.extents == mExtents );
+        mData.load_raw( fd, location.offset, begin, end );
+    }
 private:
     /// this c'tor is used for a shallow copy, and therefore only privately available
     DynamicGrid(const DynamicGrid&) = default;
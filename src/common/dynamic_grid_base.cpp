@@ -151,14 +151,14 @@ TransformationType DynamicGridBase::getAccessMode() const
     return mTrafoType;
 }
 
-void DynamicGridBase::dump( std::ostream& out ) const
+void DynamicGridBase::dump( std::ostream& out, GridEncoding encoding ) const
 {
     out.write( "g", 1 );
     writeInteger( out, mDimension );
     for( auto e : mExtents )
         writeInteger(out, e);
 
-    mData.dump( out );
+    mData.dump( out, encoding );
 }
 
 auto DynamicGridBase::load_info(std::istream& in) -> extents_type
@@ -97,7 +97,7 @@ public:
     // ----------------------
     //        file io
     // ----------------------
-    void dump( std::ostream& out ) const;
+    void dump( std::ostream& out, GridEncoding encoding = GridEncoding::RAW ) const;
 
 protected:
     DynamicGridBase(const DynamicGridBase& dg);
@@ -2,6 +2,13 @@
 #include <vector>
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "global.hpp"
 #include "fileIO.hpp"
 
@@ -23,12 +30,143 @@ double readFloat( std::istream& file )
 
 void writeVec( std::ostream& file, const gen_vect& value)
 {
-    for(unsigned i = 0; i < value.size(); ++i)
-        writeFloat( file, value[i] );
+    // gen_vect stores its doubles contiguously, so they can be written in one go
+    file.write( (const char*)&value[0], value.size() * sizeof(double) );
 }
 
 void readVec( std::istream& file, gen_vect& value)
 {
-    for(unsigned i = 0; i < value.size(); ++i)
-        readFloat( file, value[i] );
+    file.read( (char*)&value[0], value.size() * sizeof(double) );
+}
+
+// ------------------------------------------------------------------------------------------------------
+//                                    BinaryWriter
+// ------------------------------------------------------------------------------------------------------
+
+BinaryWriter::BinaryWriter( std::ostream& target, std::size_t buffer_size ) :
+    mTarget( target ),
+    mBuffer( std::max(buffer_size, std::size_t(64)) )
+{
+}
+
+BinaryWriter::~BinaryWriter()
+{
+    flush();
+}
+
+void BinaryWriter::putVec( const gen_vect& value )
+{
+    putBytes( &value[0], value.size() * sizeof(double) );
+}
+
+void BinaryWriter::flush()
+{
+    if(mFill > 0)
+        mTarget.write( mBuffer.data(), mFill );
+    mFill = 0;
+}
+
+void BinaryWriter::putBytesSlow( const void* data, std::size_t count )
+{
+    flush();
+    // large blocks are passed through directly, there is no benefit from copying them first
+    if(count >= mBuffer.size())
+    {
+        mTarget.write( (const char*)data, count );
+    } else
+    {
+        std::memcpy( mBuffer.data(), data, count );
+        mFill = count;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------
+//                                    file creation
+// ------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    /// flushes the kernel buffers of \p filename to disk.
+    bool syncFile( const std::string& filename )
+    {
+        int fd = ::open( filename.c_str(), O_RDONLY );
+        if(fd < 0)
+            return false;
+        bool success = ::fsync( fd ) == 0;
+        ::close( fd );
+        return success;
+    }
+}
+
+void writeFileAtomic( const std::string& filename, const std::function<void(std::ostream&)>& writer )
+{
+    std::string temp_name = filename + ".part";
+    try
+    {
+        std::fstream out( temp_name, std::fstream::out | std::fstream::binary | std::fstream::trunc );
+        if(!out.is_open())
+            THROW_EXCEPTION( std::runtime_error, "could not create data file %1% : %2%", temp_name, std::strerror(errno) );
+
+        writer( out );
+
+        out.close();
+        if(out.fail())
+            THROW_EXCEPTION( std::runtime_error, "error while writing data file %1%", temp_name );
+
+        if(!syncFile( temp_name ))
+            THROW_EXCEPTION( std::runtime_error, "could not sync data file %1% : %2%", temp_name, std::strerror(errno) );
+
+        if(std::rename( temp_name.c_str(), filename.c_str() ) != 0)
+            THROW_EXCEPTION( std::runtime_error, "could not rename %1% to %2% : %3%", temp_name, filename, std::strerror(errno) );
+    } catch( ... )
+    {
+        std::remove( temp_name.c_str() );
+        throw;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------
+//                                    memory mapped files
+// ------------------------------------------------------------------------------------------------------
+
+MappedFile::MappedFile( const std::string& filename )
+{
+    int fd = ::open( filename.c_str(), O_RDONLY );
+    if(fd < 0)
+        THROW_EXCEPTION( std::runtime_error, "could not open file %1% : %2%", filename, std::strerror(errno) );
+
+    struct stat info;
+    if(::fstat( fd, &info ) != 0)
+    {
+        int error = errno;
+        ::close( fd );
+        THROW_EXCEPTION( std::runtime_error, "could not stat file %1% : %2%", filename, std::strerror(error) );
+    }
+    mSize = static_cast<std::size_t>( info.st_size );
+
+    // mapping an empty file fails, but there is nothing to read anyway
+    if(mSize > 0)
+    {
+        void* mapping = ::mmap( nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0 );
+        int error = errno;
+        ::close( fd );
+        if(mapping == MAP_FAILED)
+            THROW_EXCEPTION( std::runtime_error, "could not map file %1% : %2%", filename, std::strerror(error) );
+        mData = static_cast<const char*>( mapping );
+    } else
+    {
+        ::close( fd );
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if(mData)
+        ::munmap( const_cast<char*>(mData), mSize );
+}
+
+void MappedFile::adviseSequential() const
+{
+    if(mData)
+        ::madvise( const_cast<char*>(mData), mSize, MADV_SEQUENTIAL );
 }
@@ -7,6 +7,12 @@
 */
 
 #include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <boost/numeric/conversion/cast.hpp>
 
@@ -52,11 +58,11 @@ void writeFloat( std::ostream& file, T value )
 
 /// writes a container of floating point numbers to file
 template<class C>
-void writeFloats(std::ostream& file, const C& container)
-{
-    for(auto f : container)
-        writeFloat(file, f);
-}
+void writeFloats(std::ostream& file, const C& container);
+
+/// writes a container of integers to file, each as 64 bit.
+template<class C>
+void writeIntegers(std::ostream& file, const C& container);
 
 /// reads a floating point number from a file
 double readFloat( std::istream& file );
@@ -74,6 +80,202 @@ void writeVec( std::ostream& file, const gen_vect& value);
 /// reads the contents of a gen_vec from a file (i.e. does not change its dimension)
 void readVec( std::istream& file, gen_vect& value);
 
+// ------------------------------------------------------------------------------------------------------
+//                                    bulk input/output
+// ------------------------------------------------------------------------------------------------------
+
+/*! \class BinaryWriter
+    \brief Buffered writer for large amounts of binary data.
+    \details Writing values one at a time with writeFloat / writeInteger results in one
+            `ostream::write` call per value, which dominates the save time of observers that
+            produce millions of entries. The BinaryWriter converts the values into an internal
+            staging buffer that uses the same on-disk format (64 bit integers and doubles), and
+            only passes full buffers to the stream.
+            The buffer is flushed on destruction, but call flush() explicitly if the stream is
+            used directly afterwards.
+*/
+class BinaryWriter
+{
+public:
+    /// create a writer that writes to \p target, using a staging buffer of \p buffer_size bytes.
+    explicit BinaryWriter( std::ostream& target, std::size_t buffer_size = 1 << 16 );
+    ~BinaryWriter();
+
+    BinaryWriter( const BinaryWriter& ) = delete;
+    BinaryWriter& operator=( const BinaryWriter& ) = delete;
+
+    /// appends an integer, always as 64 bit.
+    template<class T>
+    void putInteger( T value )
+    {
+        static_assert( std::is_integral<T>::value, "putInteger only supports integral types" );
+        std::uint64_t fixed_size = value;
+        putBytes( &fixed_size, sizeof(fixed_size) );
+    }
+
+    /// appends a floating point number, always as double.
+    template<class T>
+    void putFloat( T value )
+    {
+        static_assert( std::is_floating_point<T>::value, "putFloat only supports float point types" );
+        double bit64 = value;
+        putBytes( &bit64, sizeof(bit64) );
+    }
+
+    /// appends all floating point numbers in \p container.
+    template<class C>
+    void putFloats( const C& container )
+    {
+        for(auto f : container)
+            putFloat( f );
+    }
+
+    /// appends all integers in \p container.
+    template<class C>
+    void putIntegers( const C& container )
+    {
+        for(auto i : container)
+            putInteger( i );
+    }
+
+    /// appends the contents of a gen_vect (without its dimension).
+    void putVec( const gen_vect& value );
+
+    /// appends \p count raw bytes starting at \p data.
+    void putBytes( const void* data, std::size_t count )
+    {
+        if(mFill + count <= mBuffer.size())
+        {
+            std::memcpy( mBuffer.data() + mFill, data, count );
+            mFill += count;
+        } else
+        {
+            putBytesSlow( data, count );
+        }
+    }
+
+    /// passes all buffered data on to the stream.
+    void flush();
+private:
+    void putBytesSlow( const void* data, std::size_t count );
+
+    std::ostream& mTarget;
+    std::vector<char> mBuffer;
+    std::size_t mFill = 0;
+};
+
+/// reads \p count 64 bit integers from \p file and converts them to \p T.
+/// \throws boost::numeric::bad_numeric_cast if a value does not fit into \p T.
+template<class T>
+void readIntegers( std::istream& file, T* target, std::size_t count );
+
+/// reads \p count doubles from \p file and converts them to \p T.
+template<class T>
+void readFloats( std::istream& file, T* target, std::size_t count );
+
+// ------------------------------------------------------------------------------------------------------
+//                                    template implementations
+// ------------------------------------------------------------------------------------------------------
+
+template<class C>
+void writeFloats(std::ostream& file, const C& container)
+{
+    BinaryWriter writer(file);
+    writer.putFloats(container);
+    writer.flush();
+}
+
+template<class C>
+void writeIntegers(std::ostream& file, const C& container)
+{
+    BinaryWriter writer(file);
+    writer.putIntegers(container);
+    writer.flush();
+}
+
+namespace detail
+{
+    /// number of values that are converted at once by the bulk readers.
+    constexpr std::size_t BULK_READ_CHUNK = 8192;
+}
+
+template<class T>
+void readIntegers( std::istream& file, T* target, std::size_t count )
+{
+    static_assert( std::is_integral<T>::value, "readIntegers only supports integral types" );
+    std::vector<std::uint64_t> staging( std::min(count, detail::BULK_READ_CHUNK) );
+    while(count > 0)
+    {
+        std::size_t chunk = std::min(count, staging.size());
+        file.read( (char*)staging.data(), chunk * sizeof(std::uint64_t) );
+        for(std::size_t i = 0; i < chunk; ++i)
+            target[i] = boost::numeric_cast<T>( staging[i] );
+        target += chunk;
+        count -= chunk;
+    }
+}
+
+template<class T>
+void readFloats( std::istream& file, T* target, std::size_t count )
+{
+    static_assert( std::is_floating_point<T>::value, "readFloats only supports float point types" );
+    std::vector<double> staging( std::min(count, detail::BULK_READ_CHUNK) );
+    while(count > 0)
+    {
+        std::size_t chunk = std::min(count, staging.size());
+        file.read( (char*)staging.data(), chunk * sizeof(double) );
+        std::copy( staging.begin(), staging.begin() + chunk, target );
+        target += chunk;
+        count -= chunk;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------
+//                                    file creation
+// ------------------------------------------------------------------------------------------------------
+
+/*! \brief Creates the file \p filename with the contents produced by \p writer, without ever exposing a
+            partially written file.
+    \details The data is written to a temporary file in the same directory, which is synced to disk
+            and then renamed to \p filename. If \p writer throws or any of the file operations fails,
+            the temporary file is removed and a previously existing \p filename is left untouched.
+    \throw std::runtime_error if the file cannot be created, written or renamed.
+*/
+void writeFileAtomic( const std::string& filename, const std::function<void(std::ostream&)>& writer );
+
+// ------------------------------------------------------------------------------------------------------
+//                                    memory mapped files
+// ------------------------------------------------------------------------------------------------------
+
+/*! \class MappedFile
+    \brief Read-only memory mapping of a whole file.
+    \details The pages are loaded by the kernel when they are accessed, so files larger than the
+            main memory can be read. The mapping stays valid as long as the MappedFile exists.
+*/
+class MappedFile
+{
+public:
+    /// maps the file \p filename.
+    /// \throw std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile( const std::string& filename );
+    ~MappedFile();
+
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+
+    /// start of the file contents. The mapping is page aligned.
+    const char* data() const { return mData; }
+
+    /// size of the file in bytes.
+    std::size_t size() const { return mSize; }
+
+    /// tells the kernel that the file will be read front to back.
+    void adviseSequential() const;
+private:
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
 /// \todo use boost::serialization
 
 //! \}
@@ -0,0 +1,154 @@
+#include "grid_compression.hpp"
+#include "fileIO.hpp"
+#include "global.hpp"
+#include "profiling.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace
+{
+    /// byte offsets of the chunks inside the payload.
+    std::vector<std::uint64_t> chunk_offsets( const CompressedData& data )
+    {
+        std::vector<std::uint64_t> offsets( data.chunk_sizes.size() + 1, 0 );
+        std::partial_sum( data.chunk_sizes.begin(), data.chunk_sizes.end(), offsets.begin() + 1 );
+        return offsets;
+    }
+
+    /// reads exactly \p count bytes from \p fd at \p offset.
+    void pread_all( int fd, void* target, std::size_t count, std::uint64_t offset )
+    {
+        char* pos = (char*)target;
+        while(count > 0)
+        {
+            ssize_t got = ::pread( fd, pos, count, offset );
+            if(got < 0 && errno == EINTR)
+                continue;
+            if(got <= 0)
+                THROW_EXCEPTION( std::runtime_error, "error reading compressed grid data: %1%",
+                                 got == 0 ? "unexpected end of file" : std::strerror(errno) );
+            pos += got;
+            offset += got;
+            count -= got;
+        }
+    }
+}
+
+CompressedData compressShuffled( const void* data, std::size_t count, std::size_t stride, std::size_t chunk_bytes )
+{
+    PROFILE_BLOCK("compress grid data");
+    CompressedData result;
+    result.chunk_elements = std::max<std::size_t>( 1, chunk_bytes / stride );
+    std::size_t chunk_count = (count + result.chunk_elements - 1) / result.chunk_elements;
+
+    std::vector<std::vector<char>> chunks( chunk_count );
+    ThreadPool::global().parallel_for( chunk_count, [&](std::size_t c)
+    {
+        std::size_t first = c * result.chunk_elements;
+        std::size_t elements = std::min<std::size_t>( result.chunk_elements, count - first );
+        const char* source = (const char*)data + first * stride;
+
+        std::vector<char> shuffled( elements * stride );
+        for(std::size_t i = 0; i < elements; ++i)
+            for(std::size_t b = 0; b < stride; ++b)
+                shuffled[b * elements + i] = source[i * stride + b];
+
+        uLongf size = compressBound( shuffled.size() );
+        chunks[c].resize( size );
+        if(compress2( (Bytef*)chunks[c].data(), &size, (const Bytef*)shuffled.data(), shuffled.size(),
+                      Z_DEFAULT_COMPRESSION ) != Z_OK)
+            THROW_EXCEPTION( std::runtime_error, "compression of grid chunk %1% failed", c );
+        chunks[c].resize( size );
+    });
+
+    for(auto& chunk : chunks)
+    {
+        result.chunk_sizes.push_back( chunk.size() );
+        result.payload.insert( result.payload.end(), chunk.begin(), chunk.end() );
+    }
+    return result;
+}
+
+void decompressShuffled( const CompressedData& source, void* target, std::size_t count, std::size_t stride )
+{
+    PROFILE_BLOCK("decompress grid data");
+    std::size_t chunk_count = source.chunk_elements == 0 ? 0 :
+                              (count + source.chunk_elements - 1) / source.chunk_elements;
+    if(chunk_count != source.chunk_sizes.size())
+        THROW_EXCEPTION( std::runtime_error, "compressed grid has %1% chunks, expected %2%",
+                         source.chunk_sizes.size(), chunk_count );
+
+    auto offsets = chunk_offsets( source );
+    if(offsets.back() != source.payload.size())
+        THROW_EXCEPTION( std::runtime_error, "compressed grid payload has %1% bytes, expected %2%",
+                         source.payload.size(), offsets.back() );
+
+    ThreadPool::global().parallel_for( chunk_count, [&](std::size_t c)
+    {
+        std::size_t first = c * source.chunk_elements;
+        std::size_t elements = std::min<std::size_t>( source.chunk_elements, count - first );
+
+        std::vector<char> shuffled( elements * stride );
+        uLongf size = shuffled.size();
+        int status = uncompress( (Bytef*)shuffled.data(), &size, (const Bytef*)source.payload.data() + offsets[c],
+                                 source.chunk_sizes[c] );
+        if(status != Z_OK || size != shuffled.size())
+            THROW_EXCEPTION( std::runtime_error, "corrupted compressed grid chunk %1%", c );
+
+        char* dest = (char*)target + first * stride;
+        for(std::size_t i = 0; i < elements; ++i)
+            for(std::size_t b = 0; b < stride; ++b)
+                dest[i * stride + b] = shuffled[b * elements + i];
+    });
+}
+
+void writeCompressed( std::ostream& out, const CompressedData& data )
+{
+    writeInteger( out, data.chunk_elements );
+    writeInteger( out, data.chunk_sizes.size() );
+    writeIntegers( out, data.chunk_sizes );
+    out.write( data.payload.data(), data.payload.size() );
+}
+
+CompressedData readCompressed( std::istream& in )
+{
+    CompressedData data;
+    data.chunk_elements = readInteger( in );
+    data.chunk_sizes.resize( readInteger( in ) );
+    readIntegers( in, data.chunk_sizes.data(), data.chunk_sizes.size() );
+    data.payload.resize( chunk_offsets( data ).back() );
+    in.read( data.payload.data(), data.payload.size() );
+    if(!in)
+        THROW_EXCEPTION( std::runtime_error, "unexpected end of file while reading compressed grid data" );
+    return data;
+}
+
+CompressedData readCompressed( int fd, std::uint64_t offset )
+{
+    CompressedData data;
+    std::uint64_t info[2];
+    pread_all( fd, info, sizeof(info), offset );
+    offset += sizeof(info);
+
+    data.chunk_elements = info[0];
+    data.chunk_sizes.resize( info[1] );
+    pread_all( fd, data.chunk_sizes.data(), data.chunk_sizes.size() * sizeof(std::uint64_t), offset );
+    offset += data.chunk_sizes.size() * sizeof(std::uint64_t);
+
+    data.payload.resize( chunk_offsets( data ).back() );
+    pread_all( fd, data.payload.data(), data.payload.size(), offset );
+    return data;
+}
+
+void skipCompressed( std::istream& in )
+{
+    readInteger( in );
+    std::vector<std::uint64_t> sizes( readInteger( in ) );
+    readIntegers( in, sizes.data(), sizes.size() );
+    in.seekg( std::accumulate( sizes.begin(), sizes.end(), std::uint64_t(0) ), std::ios::cur );
+}
@@ -0,0 +1,61 @@
+#ifndef GRID_COMPRESSION_HPP_INCLUDED
+#define GRID_COMPRESSION_HPP_INCLUDED
+
+/*! \file grid_compression.hpp
+    \ingroup common
+    \brief Chunked, byte-shuffled zlib compression for grid data.
+    \details The data is split into chunks of a fixed number of elements. Inside each chunk, the bytes are
+            reordered such that the first byte of all elements comes first, then the second byte etc.
+            This groups the slowly varying exponent bytes of floating point data together and greatly
+            improves the compression ratio. Every chunk is deflated independently, so compression and
+            decompression can be done in parallel.
+
+            On disk, a compressed block is stored as
+
+            Data type   | Count | Meaning
+            ---------   | ----- | -------
+            Int         | 1     | elements per chunk
+            Int [\#C]   | 1     | number of chunks
+            Int         | \#C   | compressed size of each chunk (bytes)
+            Bytes       | sum   | compressed chunks
+*/
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+//! \addtogroup common
+//! \{
+
+/// compressed representation of an array, see grid_compression.hpp for details.
+struct CompressedData
+{
+    std::uint64_t chunk_elements = 0;           //!< number of elements in each chunk (except possibly the last).
+    std::vector<std::uint64_t> chunk_sizes;     //!< compressed size of each chunk.
+    std::vector<char> payload;                  //!< concatenated compressed chunks.
+};
+
+/// compresses \p count elements of \p stride bytes each, starting at \p data.
+/// \param chunk_bytes approximate amount of uncompressed data per chunk.
+CompressedData compressShuffled( const void* data, std::size_t count, std::size_t stride,
+                                 std::size_t chunk_bytes = 1 << 20 );
+
+/// decompresses \p source into \p target, which has to provide space for \p count elements of \p stride bytes.
+/// \throw std::runtime_error if the data is corrupted or does not contain \p count elements.
+void decompressShuffled( const CompressedData& source, void* target, std::size_t count, std::size_t stride );
+
+/// writes the chunk table and payload of \p data.
+void writeCompressed( std::ostream& out, const CompressedData& data );
+
+/// reads a compressed block written by writeCompressed.
+CompressedData readCompressed( std::istream& in );
+
+/// reads a compressed block that starts at byte \p offset of the file \p fd, using pread.
+CompressedData readCompressed( int fd, std::uint64_t offset );
+
+/// skips over a compressed block in \p in without reading its payload.
+void skipCompressed( std::istream& in );
+
+//! \}
+
+#endif // GRID_COMPRESSION_HPP_INCLUDED
@@ -1,8 +1,12 @@
 #include "grid_storage.hpp"
 #include "fileIO.hpp"
+#include "grid_compression.hpp"
 #include "global.hpp"
 #include <ostream>
 #include <cstring>
+#include <string>
+#include <cerrno>
+#include <unistd.h>
 
 void* GridStorage::getStartingAddress() const
 {
@@ -29,32 +33,89 @@ GridStorage GridStorage::shallow_copy() const
     return GridStorage(*this);
 }
 
+// marker that precedes the type name of compressed dumps
+static const std::string COMPRESSED_MARKER = "zlib:";
+
 // write to file
-void GridStorage::dump( std::ostream& out ) const
+void GridStorage::dump( std::ostream& out, GridEncoding encoding ) const
 {
     PROFILE_BLOCK("grid storage dump");
+    if(encoding == GridEncoding::COMPRESSED)
+        out << COMPRESSED_MARKER;
     // size + 1 to write trailing \0
     out.write( mType.name(), std::strlen(mType.name())+1 );
     writeInteger( out, size() );
-    out.write((char*)getStartingAddress(), getStride() * size());
+    if(encoding == GridEncoding::COMPRESSED)
+        writeCompressed( out, compressShuffled( getStartingAddress(), size(), getStride() ) );
+    else
+        out.write((char*)getStartingAddress(), getStride() * size());
 }
 
 // read from file
 void GridStorage::load( std::istream& in )
 {
     PROFILE_BLOCK("grid storage load");
-    std::string type;
+    auto header = load_header( in, mType );
+
+    if( header.count != size() )
+        THROW_EXCEPTION( std::runtime_error, "number of data elements %1% does not match container size %2%", (long)header.count, (long)size());
+
+    if(header.encoding == GridEncoding::COMPRESSED)
+        decompressShuffled( readCompressed( in ), getStartingAddress(), size(), getStride() );
+    else
+        in.read( (char*)getStartingAddress(), getStride() * size() );
+}
+
+auto GridStorage::load_header( std::istream& in, std::type_index type ) -> DumpHeader
+{
+    std::string type_name;
     // read count and type id
-    std::getline(in, type, (char)0);
-    auto count = readInteger( in );
+    std::getline(in, type_name, (char)0);
+    DumpHeader header;
+    header.count = readInteger( in );
+    header.encoding = GridEncoding::RAW;
+    if(type_name.compare(0, COMPRESSED_MARKER.size(), COMPRESSED_MARKER) == 0)
+    {
+        header.encoding = GridEncoding::COMPRESSED;
+        type_name.erase(0, COMPRESSED_MARKER.size());
+    }
 
-    if(type != mType.name())
+    if(type_name != type.name())
         THROW_EXCEPTION(std::runtime_error,
                         "binary reading of incompatible data : expected %1%, got %2%",
-                        mType.name(), type);
+                        type.name(), type_name);
+    return header;
+}
 
-    if( count != size() )
-        THROW_EXCEPTION( std::runtime_error, "number of data elements %1% does not match container size %2%", (long)count, (long)size());
+void GridStorage::load_raw( int fd, std::uint64_t offset, GridEncoding encoding )
+{
+    PROFILE_BLOCK("grid storage load raw");
+    if(encoding == GridEncoding::COMPRESSED)
+    {
+        decompressShuffled( readCompressed( fd, offset ), getStartingAddress(), size(), getStride() );
+        return;
+    }
+    load_raw( fd, offset, 0, getStride() * size() );
+}
 
-    in.read( (char*)getStartingAddress(), getStride() * size() );
+void GridStorage::load_raw( int fd, std::uint64_t offset, std::size_t begin, std::size_t end )
+{
+    assert( begin <= end && end <= getStride() * size() );
+    char* target = (char*)getStartingAddress() + begin;
+    std::size_t remaining = end - begin;
+    offset += begin;
+    // pread may return less than requested, e.g. for very large reads or when interrupted
+    while(remaining > 0)
+    {
+        ssize_t count = ::pread( fd, target, remaining, offset );
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count < 0)
+            THROW_EXCEPTION( std::runtime_error, "error reading grid data: %1%", std::strerror(errno) );
+        if(count == 0)
+            THROW_EXCEPTION( std::runtime_error, "unexpected end of file while reading grid data, %1% bytes missing", remaining );
+        target += count;
+        offset += count;
+        remaining -= count;
+    }
 }
@@ -16,6 +16,14 @@
 #include <typeindex>
 #include <boost/align/aligned_allocator.hpp>
 
+/// \brief storage format of grid data in binary files.
+/// \ingroup common
+enum class GridEncoding
+{
+    RAW,            //!< data is saved as a plain copy of the memory.
+    COMPRESSED      //!< data is byte-shuffled and compressed in independent chunks, see grid_compression.hpp.
+};
+
 /*! \class GridStorage
     \brief class that manages memory for grids.
     \details this class hides the details of memory management of the DynamicGrid class. It is
@@ -33,6 +41,12 @@
             helpful anyway.
     \ingroup common
 */
+namespace detail
+{
+    template<class T>
+    struct StorageImpl;
+}
+
 class GridStorage
 {
 public:
@@ -117,14 +131,35 @@ public:
     // -------------------------------------------
     //    file io
     // -------------------------------------------
-    /// dumpy the containers contents
-    void dump( std::ostream& out ) const;
+    /// dumpy the containers contents. With GridEncoding::COMPRESSED, the data is stored
+    /// byte-shuffled and deflated, see grid_compression.hpp.
+    void dump( std::ostream& out, GridEncoding encoding = GridEncoding::RAW ) const;
 
     /// read a binary dump of container contents. This
     /// only works if the dump contains the same amount of
     /// elements of the same type as this container.
     void load( std::istream& in );
 
+    /// information about a binary dump, as read by load_header.
+    struct DumpHeader
+    {
+        GridEncoding encoding;      //!< how the data is stored
+        std::uint64_t count;        //!< number of saved elements
+    };
+
+    /// reads the type and element count that precede the data of a binary dump, and
+    /// checks that the dump contains data of type \p type.
+    /// \return encoding and number of elements in the dump. The stream is positioned at the start of the data.
+    static DumpHeader load_header( std::istream& in, std::type_index type );
+
+    /// reads the data of a dump, starting at byte \p offset of the file \p fd, into this container.
+    /// Uses pread, so different containers can be filled from the same file concurrently.
+    void load_raw( int fd, std::uint64_t offset, GridEncoding encoding = GridEncoding::RAW );
+
+    /// reads the bytes [\p begin, \p end) of an uncompressed dump that starts at byte \p offset of the
+    /// file \p fd into the same bytes of this container. Disjoint ranges can be read concurrently.
+    void load_raw( int fd, std::uint64_t offset, std::size_t begin, std::size_t end );
+
 private:
     /// constructor for GridStorage for data of type T
     /// needs the second dummy parameter to deduce the type T, the value of \p type is never used.
@@ -138,6 +173,8 @@ private:
     // implementation hiding internal type manage data
     /// \brief helper struct that contains the type specific data management
     struct Impl;
+    template<class T>
+    friend struct detail::StorageImpl;
     std::shared_ptr<Impl> mDataRecord;    //!< the implementation details are hidden behind this pointer.
 
     // data variables
@@ -0,0 +1,128 @@
+#include "numa.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /// node of each core, as read from /sys/devices/system/node.
+    struct NumaTopology
+    {
+        std::vector<int> nodes;             //!< ids of the online nodes
+        std::vector<int> core_nodes;        //!< node of each core, indexed by core id
+
+        NumaTopology()
+        {
+            std::ifstream online( "/sys/devices/system/node/online" );
+            std::string list;
+            if( std::getline( online, list ) )
+                nodes = parse_list( list );
+
+            for( int node : nodes )
+            {
+                std::ifstream cores( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+                if( !std::getline( cores, list ) )
+                    continue;
+                for( int core : parse_list( list ) )
+                {
+                    if( core >= (int)core_nodes.size() )
+                        core_nodes.resize( core + 1, 0 );
+                    core_nodes[core] = node;
+                }
+            }
+
+            if( nodes.empty() )
+                nodes.push_back( 0 );
+        }
+
+        /// parses the kernel's list format, e.g. "0-3,8,10-11".
+        static std::vector<int> parse_list( const std::string& list )
+        {
+            std::vector<int> result;
+            std::stringstream stream( list );
+            std::string range;
+            while( std::getline( stream, range, ',' ) )
+            {
+                if( range.empty() )
+                    continue;
+                try
+                {
+                    std::size_t dash = range.find( '-' );
+                    int first = std::stoi( range.substr( 0, dash ) );
+                    int last = dash == std::string::npos ? first : std::stoi( range.substr( dash + 1 ) );
+                    for( int i = first; i <= last; ++i )
+                        result.push_back( i );
+                } catch( const std::exception& )
+                {
+                    // malformed entries are ignored, we then assume a single node
+                }
+            }
+            return result;
+        }
+    };
+
+    const NumaTopology& topology()
+    {
+        static NumaTopology topology;
+        return topology;
+    }
+}
+
+std::size_t getNumaNodeCount()
+{
+    return topology().nodes.size();
+}
+
+int getNumaNodeOfCore( int core )
+{
+    const auto& nodes = topology().core_nodes;
+    if( core < 0 || core >= (int)nodes.size() )
+        return 0;
+    return nodes[core];
+}
+
+int getCurrentNumaNode()
+{
+#ifdef __linux__
+    if( getNumaNodeCount() > 1 )
+        return getNumaNodeOfCore( sched_getcpu() );
+#endif
+    return 0;
+}
+
+bool interleaveMemory( const void* start, std::size_t bytes )
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    const auto& nodes = topology().nodes;
+    if( nodes.size() < 2 || bytes == 0 )
+        return false;
+
+    // mbind works on whole pages
+    std::uintptr_t page = sysconf( _SC_PAGESIZE );
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>( start ) / page * page;
+    std::uintptr_t end = reinterpret_cast<std::uintptr_t>( start ) + bytes;
+
+    const std::size_t bits = 8 * sizeof(unsigned long);
+    int max_node = *std::max_element( nodes.begin(), nodes.end() );
+    std::vector<unsigned long> mask( max_node / bits + 1, 0 );
+    for( int node : nodes )
+        mask[node / bits] |= 1ul << (node % bits);
+
+    const int MPOL_INTERLEAVE = 3;
+    const unsigned MPOL_MF_MOVE = 1 << 1;
+    // the kernel expects the number of mask bits plus one
+    long result = syscall( SYS_mbind, begin, end - begin, MPOL_INTERLEAVE, mask.data(), mask.size() * bits + 1,
+                           MPOL_MF_MOVE );
+    return result == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef NUMA_HPP_INCLUDED
+#define NUMA_HPP_INCLUDED
+
+/*! \file numa.hpp
+    \ingroup common
+    \brief Queries the NUMA topology and places memory on the NUMA nodes.
+    \details The topology is read from sysfs and memory is placed using the mbind system call, so no
+            libnuma is needed. On machines with a single node, or if the information is not available,
+            all functions behave as if there was only node 0.
+*/
+
+#include <cstddef>
+
+/// \addtogroup common
+/// \{
+
+/// number of NUMA nodes of the machine, at least one.
+std::size_t getNumaNodeCount();
+
+/// the NUMA node of core \p core, or 0 if it is unknown.
+int getNumaNodeOfCore( int core );
+
+/// the NUMA node of the core the calling thread is currently running on.
+int getCurrentNumaNode();
+
+/// \brief distributes the pages of the \p bytes bytes at \p start round robin over all NUMA nodes. Pages that
+///        have already been touched are moved.
+/// \return whether the pages could be placed, always false if there is only a single node.
+bool interleaveMemory( const void* start, std::size_t bytes );
+
+/// \}
+
+#endif // NUMA_HPP_INCLUDED
@@ -4,7 +4,14 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 #include "fileIO.hpp"
+#include "thread_pool.hpp"
+#include "numa.hpp"
 #include <boost/lexical_cast.hpp>
 
 
@@ -205,7 +212,7 @@ void Potential::setSupport( const std::vector<double>& supp, const std::string&
 // version 4, header contains also dimension
 const char header[] = {'b', 'p', 'o', 't', '5'};
 
-void Potential::writeToFile( std::fstream& file ) const
+void Potential::writeToFile( std::fstream& file, GridEncoding encoding ) const
 {
     PROFILE_BLOCK("write potential to file");
     // header
@@ -256,7 +263,7 @@ void Potential::writeToFile( std::fstream& file ) const
         for(unsigned i = 0; i < mDimension; ++i)
             writeInteger(file, data.first.derivations[i]);
         
-        data.second.dump(file);
+        data.second.dump(file, encoding);
     }
 }
 
@@ -267,6 +274,114 @@ Potential Potential::readFromFile( std::fstream& file )
     }
 
     PROFILE_BLOCK("read potential from file");
+    auto header = readHeader( file );
+    Potential& pot = header.first;
+
+    for(unsigned j = 0; j < header.second; ++j)
+    {
+        auto key = readGridKey( file, pot.getDimension() );
+        pot.setDerivative( key.derivations, default_grid::load(file), key.name );
+    }
+
+    return std::move(pot);
+}
+
+namespace
+{
+    /// closes the wrapped file descriptor on destruction.
+    struct FileDescriptor
+    {
+        explicit FileDescriptor( int f ) : fd( f ) { }
+        ~FileDescriptor() { if(fd >= 0) ::close( fd ); }
+        FileDescriptor( const FileDescriptor& ) = delete;
+        FileDescriptor& operator=( const FileDescriptor& ) = delete;
+        int fd;
+    };
+}
+
+Potential Potential::readFromFile( const std::string& filename, unsigned threads )
+{
+    PROFILE_BLOCK("read potential from file (parallel)");
+    std::fstream file( filename, std::fstream::in | std::fstream::binary );
+    if(!file.is_open())
+        THROW_EXCEPTION( std::runtime_error, "could not open potential file %1% : %2%", filename, std::strerror(errno) );
+
+    // first pass: collect the positions of all grids, without reading their data
+    auto header = readHeader( file );
+    Potential& pot = header.first;
+
+    std::vector<IndexType> keys;
+    std::vector<grid_type::FileLocation> locations;
+    for(unsigned j = 0; j < header.second; ++j)
+    {
+        keys.push_back( readGridKey( file, pot.getDimension() ) );
+        locations.push_back( grid_type::scan( file ) );
+    }
+    if(!file)
+        THROW_EXCEPTION( std::runtime_error, "potential file %1% is truncated", filename );
+
+    // second pass: read the grids concurrently
+    FileDescriptor source( ::open( filename.c_str(), O_RDONLY ) );
+    if(source.fd < 0)
+        THROW_EXCEPTION( std::runtime_error, "could not open potential file %1% : %2%", filename, std::strerror(errno) );
+
+    auto& pool = ThreadPool::global();
+    if(threads == 0)
+        threads = pool.getConcurrency();
+
+    // allocate the grids, one task per grid. Compressed grids are decompressed right away.
+    std::vector<grid_type> grids( locations.size() );
+    std::atomic<std::size_t> next_grid{0};
+    pool.parallel_for( std::min<std::size_t>( threads, locations.size() ), [&](std::size_t)
+    {
+        for(std::size_t i = next_grid++; i < locations.size(); i = next_grid++)
+        {
+            if(locations[i].encoding == GridEncoding::COMPRESSED)
+                grids[i] = grid_type::load( source.fd, locations[i] );
+            else
+                grids[i] = grid_type( locations[i].extents, TransformationType::IDENTITY );
+        }
+    });
+
+    // split the raw grids into page aligned ranges, so that a single large grid is still read by all threads.
+    constexpr std::size_t RANGE_BYTES = 16 << 20;
+    struct Range
+    {
+        std::size_t grid;
+        std::size_t begin;
+        std::size_t end;
+    };
+    std::vector<Range> ranges;
+    for(std::size_t i = 0; i < grids.size(); ++i)
+    {
+        if(locations[i].encoding == GridEncoding::COMPRESSED)
+            continue;
+        const auto& storage = grids[i].getContainer();
+        std::size_t bytes = storage.size() * storage.getStride();
+        auto address = reinterpret_cast<std::uintptr_t>( storage.getStartingAddress() );
+        for(std::size_t begin = 0; begin < bytes; )
+        {
+            std::size_t end = std::min<std::size_t>( bytes, ((address + begin) / RANGE_BYTES + 1) * RANGE_BYTES - address );
+            ranges.push_back( Range{i, begin, end} );
+            begin = end;
+        }
+    }
+
+    std::atomic<std::size_t> next_range{0};
+    pool.parallel_for( std::min<std::size_t>( threads, ranges.size() ), [&](std::size_t)
+    {
+        for(std::size_t i = next_range++; i < ranges.size(); i = next_range++)
+            grids[ranges[i].grid].load_range( source.fd, locations[ranges[i].grid], ranges[i].begin, ranges[i].end );
+    });
+
+    for(std::size_t i = 0; i < grids.size(); ++i)
+        pot.setDerivative( keys[i].derivations, std::move(grids[i]), keys[i].name );
+
+    return std::move(pot);
+}
+
+auto Potential::readHeader( std::istream& file ) -> std::pair<Potential, std::size_t>
+{
     char cmp[sizeof(header)+1];
     cmp[sizeof(header)] = 0;
     file.read( cmp, sizeof(header) );
@@ -296,26 +411,21 @@ Potential Potential::readFromFile( std::fstream& file )
 
     Potential pot( extents, support, strength );
     pot.setCreationInfo(seed, potgen, corrlength);
+    return std::make_pair( std::move(pot), (std::size_t)gridcount );
+}
+
+auto Potential::readGridKey( std::istream& file, std::size_t dimension ) -> IndexType
+{
+    auto namelen = readInteger(file);
+    std::string name( namelen, '\0' );
+    file.read( &name[0], namelen );
 
-    /// \todo rewrite reading!
-    for(unsigned j = 0; j < gridcount; ++j)
+    std::vector<int> index( dimension );
+    for(unsigned i = 0; i < dimension; ++i)
     {
-        auto namelen = readInteger(file);
-        std::string name;
-        for(unsigned i = 0; i < namelen; ++i)
-        {
-            name += file.get();
-        }
-        
-        std::vector<int> index( dimension );
-        for(unsigned i = 0; i < dimension; ++i)
-        {
-            index[i] = readInteger(file);
-        }
-        pot.setDerivative(index, default_grid::load(file), name );
+        index[i] = readInteger(file);
     }
-
-    return std::move(pot);
+    return IndexType( std::move(name), std::move(index) );
 }
 
 double Potential::getStrength() const
@@ -329,4 +439,21 @@ void Potential::setStrength(double new_strength)
     mStrength = new_strength;
 }
 
+std::size_t Potential::getMemorySize() const
+{
+    std::size_t bytes = 0;
+    for(const auto& grid : mData)
+        bytes += grid.second.getContainer().size() * grid.second.getContainer().getStride();
+    return bytes;
+}
 
+bool Potential::interleaveMemory() const
+{
+    bool success = true;
+    for(const auto& grid : mData)
+    {
+        const auto& storage = grid.second.getContainer();
+        success = ::interleaveMemory( storage.getStartingAddress(), storage.size() * storage.getStride() ) && success;
+    }
+    return success;
+}
@@ -155,6 +155,14 @@ public:
     ///                scalePotential.
     void setSupport( const std::vector<double>&  supp, const std::string& name = "potential");
 
+    /// \brief spreads the memory of all grids evenly over the NUMA nodes, see interleaveMemory(). The data
+    ///        itself is not changed.
+    /// \return whether the memory of all grids could be placed.
+    bool interleaveMemory() const;
+
+    /// number of bytes used by the data of all grids.
+    std::size_t getMemorySize() const;
+
     // --------------------------------------------------
     //               strength
     // --------------------------------------------------
@@ -168,15 +176,32 @@ public:
     //               serialization
     // --------------------------------------------------
 
-    /// writes this potential to a file
-    void writeToFile( std::fstream& file ) const;
+    /// writes this potential to a file. \p encoding determines how the grid data is stored.
+    void writeToFile( std::fstream& file, GridEncoding encoding = GridEncoding::RAW ) const;
 
     /// creates a potential object by reading from a file
     static Potential readFromFile( std::fstream& file );
 
+    /*! \brief creates a potential object by reading from the file \p filename.
+        \details The file is scanned for the positions of all grids first, then the grid data
+                is read by up to \p threads concurrent readers. Uncompressed grids are split into
+                page aligned ranges, so that even a single grid is read in parallel; compressed grids
+                are read and decompressed by one reader each. The grids are allocated, and thus their
+                memory first touched, by the loader tasks and not by the threads that later use them.
+                If \p threads is 0, all threads of the global ThreadPool are used.
+    */
+    static Potential readFromFile( const std::string& filename, unsigned threads = 0 );
+
 
 private:
     // helper functions
+    /// reads the file header and all meta data, and creates an empty potential from it.
+    /// \return the potential and the number of grids that follow the header in the file.
+    static std::pair<Potential, std::size_t> readHeader( std::istream& file );
+
+    /// reads name and derivative index that precede every grid in the file.
+    static IndexType readGridKey( std::istream& file, std::size_t dimension );
+
     /// gets the total order of the derivative index
     std::size_t getOrder( const MultiIndex& dindex ) const;
 
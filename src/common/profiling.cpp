@@ -1,49 +1,439 @@
 #include "profiling.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <atomic>
+#include <iomanip>
 #include <iostream>
-#include <unordered_set>
+#include <memory>
+#include <mutex>
 #include <vector> // for dummy max_size
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 //                Timing
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 using namespace std::chrono;
 
-ScopeTimer::ScopeTimer( ProfileRecord& target ) : mTarget(target), mStartTime( clock_t::now() )
+namespace profiling_detail
+{
+    /// node in the call tree of profiled scopes.
+    struct CallNode
+    {
+        CallNode( const ProfileRecord* rec, CallNode* p ) : record( rec ), parent( p ) { }
+
+        const ProfileRecord* record;
+        CallNode* parent;
+        std::uint64_t total_ns = 0;
+        std::uint64_t calls = 0;
+        /// number of threads that contributed to this node
+        std::uint64_t threads = 0;
+        /// accumulated hardware counter deltas, see HW_COUNTER_NAMES
+        std::uint64_t counters[HW_COUNTER_COUNT] = {0, 0, 0, 0};
+        std::vector<std::unique_ptr<CallNode>> children;
+
+        /// gets the child node for \p rec, creating it if necessary.
+        CallNode* child( const ProfileRecord* rec )
+        {
+            for(auto& c : children)
+                if(c->record == rec)
+                    return c.get();
+            children.push_back( std::unique_ptr<CallNode>(new CallNode(rec, this)) );
+            return children.back().get();
+        }
+    };
+
+    /// a single execution of a timed scope, used for trace export.
+    struct TraceEvent
+    {
+        const ProfileRecord* record;
+        std::uint64_t start_ns;
+        std::uint64_t duration_ns;
+        unsigned thread;
+        std::uint64_t counters[HW_COUNTER_COUNT];
+    };
+
+    /// names of the hardware counters, as used in the trace output.
+    const char* const HW_COUNTER_NAMES[HW_COUNTER_COUNT] = {"cycles", "instructions", "llc_misses", "dtlb_misses"};
+
+    /*! \brief Hardware performance counters of a single thread.
+        \details Opens cycles, instructions, LLC misses and dTLB load misses as one perf_event group for
+                the calling thread, so all of them can be read with a single system call. Counters that
+                cannot be opened are left out, and if none can be opened, valid() returns false.
+    */
+    class HardwareCounters : public boost::noncopyable
+    {
+    public:
+        HardwareCounters()
+        {
+            std::fill( std::begin(mSlot), std::end(mSlot), -1 );
+#ifdef __linux__
+            const std::pair<std::uint32_t, std::uint64_t> events[HW_COUNTER_COUNT] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+            };
+
+            for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+            {
+                perf_event_attr attr;
+                std::memset( &attr, 0, sizeof(attr) );
+                attr.size = sizeof(attr);
+                attr.type = events[i].first;
+                attr.config = events[i].second;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // this thread, any cpu
+                int fd = (int)syscall( __NR_perf_event_open, &attr, 0, -1, mLeader, 0 );
+                if(fd < 0)
+                    continue;
+                if(mLeader < 0)
+                    mLeader = fd;
+                mFds[mOpened] = fd;
+                mSlot[i] = mOpened++;
+            }
+#endif
+        }
+
+        ~HardwareCounters()
+        {
+#ifdef __linux__
+            // members first, then the group leader
+            for(unsigned i = mOpened; i > 0; --i)
+                close( mFds[i - 1] );
+#endif
+        }
+
+        /// whether at least one counter could be opened.
+        bool valid() const { return mLeader >= 0; }
+
+        /// whether counter \p i could be opened.
+        bool available( unsigned i ) const { return mSlot[i] >= 0; }
+
+        /// reads the current values of all counters. Counters that are not available read as zero.
+        void read( std::uint64_t* values ) const
+        {
+            std::fill( values, values + HW_COUNTER_COUNT, 0 );
+#ifdef __linux__
+            // layout of a group read: nr, time enabled, time running, value[nr]
+            std::uint64_t buffer[3 + HW_COUNTER_COUNT];
+            if(!valid() || ::read( mLeader, buffer, sizeof(buffer) ) < (ssize_t)(3 * sizeof(std::uint64_t)))
+                return;
+
+            // if the group had to share the pmu with other events, extrapolate to the full time.
+            double scale = 1.0;
+            if(buffer[2] > 0 && buffer[2] < buffer[1])
+                scale = (double)buffer[1] / buffer[2];
+
+            for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+            {
+                if(mSlot[i] >= 0 && (std::uint64_t)mSlot[i] < buffer[0])
+                    values[i] = (std::uint64_t)(buffer[3 + mSlot[i]] * scale);
+            }
+#endif
+        }
+
+    private:
+        int mLeader = -1;
+        unsigned mOpened = 0;
+        int mFds[HW_COUNTER_COUNT];
+        /// position of each counter in the group read, or -1 if not available
+        int mSlot[HW_COUNTER_COUNT];
+    };
+
+    /// adds the data of \p source to \p target, recursively.
+    void merge( CallNode& target, const CallNode& source )
+    {
+        for(const auto& c : source.children)
+        {
+            CallNode* t = target.child( c->record );
+            t->total_ns += c->total_ns;
+            t->calls += c->calls;
+            // nodes that have already been merged count the threads they combine
+            t->threads += std::max<std::uint64_t>( c->threads, 1 );
+            for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+                t->counters[i] += c->counters[i];
+            merge( *t, *c );
+        }
+    }
+
+    struct ThreadProfile;
+
+    /// global collection of the profiling data of all threads
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<ThreadProfile*> live;
+        CallNode finished{nullptr, nullptr};
+        std::vector<TraceEvent> finished_events;
+        std::atomic<unsigned> next_thread_id{0};
+        std::atomic<bool> tracing{false};
+        std::atomic<bool> hw_counters{false};
+        /// which of the hardware counters could be opened
+        bool hw_available[HW_COUNTER_COUNT] = {false, false, false, false};
+        steady_clock::time_point origin = steady_clock::now();
+    };
+
+    Registry& registry()
+    {
+        static Registry reg;
+        return reg;
+    }
+
+    /// profiling data of a single thread. Merged into the registry when the thread exits.
+    struct ThreadProfile
+    {
+        ThreadProfile() : thread_id( registry().next_thread_id++ )
+        {
+            std::lock_guard<std::mutex> lock( registry().mutex );
+            registry().live.push_back( this );
+        }
+
+        ~ThreadProfile()
+        {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock( reg.mutex );
+            reg.live.erase( std::find(reg.live.begin(), reg.live.end(), this) );
+            merge( reg.finished, root );
+            reg.finished_events.insert( reg.finished_events.end(), events.begin(), events.end() );
+        }
+
+        /// protects root and events against concurrent reading during printing.
+        std::mutex mutex;
+        CallNode root{nullptr, nullptr};
+        CallNode* current = &root;
+        std::vector<TraceEvent> events;
+        unsigned thread_id;
+        /// hardware counters of this thread, opened on the first timed scope after they were enabled.
+        std::unique_ptr<HardwareCounters> counters;
+    };
+
+    ThreadProfile& thread_profile()
+    {
+        thread_local ThreadProfile profile;
+        return profile;
+    }
+
+    /// maximum number of events recorded per thread, so tracing cannot exhaust memory.
+    constexpr std::size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+}
+
+using namespace profiling_detail;
+
+ScopeTimer::ScopeTimer( ProfileRecord& target ) : mTarget(target)
 {
+    auto& profile = thread_profile();
+    {
+        std::lock_guard<std::mutex> lock( profile.mutex );
+        mNode = profile.current->child( &target );
+        profile.current = mNode;
+    }
+
+    if(registry().hw_counters)
+    {
+        if(!profile.counters)
+            profile.counters.reset( new HardwareCounters );
+        mCounting = profile.counters->valid();
+        if(mCounting)
+            profile.counters->read( mStartCounters );
+    }
+    mStartTime = clock_t::now();
 }
 
 ScopeTimer::~ScopeTimer()
 {
-    mTarget.record(getTiming());
+    auto end = clock_t::now();
+    std::uint64_t ns = duration_cast<nanoseconds>(end - mStartTime).count();
+    mTarget.record( ns );
+
+    auto& profile = thread_profile();
+    std::uint64_t counters[HW_COUNTER_COUNT] = {0, 0, 0, 0};
+    if(mCounting)
+    {
+        profile.counters->read( counters );
+        for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+            counters[i] = counters[i] > mStartCounters[i] ? counters[i] - mStartCounters[i] : 0;
+    }
+
+    std::lock_guard<std::mutex> lock( profile.mutex );
+    mNode->total_ns += ns;
+    mNode->calls += 1;
+    for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+        mNode->counters[i] += counters[i];
+    profile.current = mNode->parent;
+    if(registry().tracing && profile.events.size() < MAX_EVENTS_PER_THREAD)
+    {
+        std::uint64_t start = duration_cast<nanoseconds>(mStartTime - registry().origin).count();
+        profile.events.push_back( TraceEvent{&mTarget, start, ns, profile.thread_id,
+                                             {counters[0], counters[1], counters[2], counters[3]}} );
+    }
 }
 
-unsigned ScopeTimer::getTiming() const
+std::uint64_t ScopeTimer::getTiming() const
 {
-    auto duration = clock_t::now() - mStartTime;
-    auto ms = duration_cast<milliseconds>(duration);
-    return ms.count();
+    return duration_cast<nanoseconds>(clock_t::now() - mStartTime).count();
 }
 
 ProfileRecord::ProfileRecord( std::string&& name ) : mName( name )
 {
-    addRecord(this);
 }
 
-// internal map to save all records
-std::unordered_set<const ProfileRecord*> profile_records;
+namespace
+{
+    /// merges the data of all finished and running threads into a single tree.
+    CallNode collect_call_tree()
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        CallNode total{nullptr, nullptr};
+        merge( total, reg.finished );
+        for(auto profile : reg.live)
+        {
+            std::lock_guard<std::mutex> thread_lock( profile->mutex );
+            merge( total, profile->root );
+        }
+        return total;
+    }
+
+    /// prints the hardware counter columns for \p node. Counters that are not available are shown as '-'.
+    void print_counters( std::ostream& out, const CallNode& node )
+    {
+        const auto& available = registry().hw_available;
+        auto column = [&](bool valid, double value) {
+            if(valid)
+                out << std::setw(13) << value;
+            else
+                out << std::setw(13) << "-";
+        };
+        column( available[0], node.counters[0] * 1e-6 );
+        column( available[0] && available[1] && node.counters[0] > 0,
+                node.counters[0] > 0 ? (double)node.counters[1] / node.counters[0] : 0.0 );
+        column( available[2], node.counters[2] * 1e-3 );
+        column( available[3], node.counters[3] * 1e-3 );
+    }
+
+    void print_node( std::ostream& out, CallNode& node, int depth )
+    {
+        std::sort( node.children.begin(), node.children.end(),
+                   [](const std::unique_ptr<CallNode>& a, const std::unique_ptr<CallNode>& b) {
+                       return a->total_ns > b->total_ns;
+                   } );
 
-void ProfileRecord::addRecord( const ProfileRecord* rec )
+        for(auto& c : node.children)
+        {
+            std::string name = std::string(2 * depth, ' ') + c->record->getName();
+            out << std::left << std::setw(40) << name << std::right
+                << std::setw(10) << c->calls
+                << std::setw(14) << std::fixed << std::setprecision(3) << c->total_ns * 1e-6
+                << std::setw(14) << (c->calls > 0 ? c->total_ns * 1e-3 / c->calls : 0.0)
+                << std::setw(9) << c->threads;
+            if(registry().hw_counters)
+                print_counters( out, *c );
+            out << "\n";
+            print_node( out, *c, depth + 1 );
+        }
+    }
+}
+
+std::string json_escape( const std::string& text )
 {
-    profile_records.insert(rec);
+    std::string result;
+    for(char c : text)
+    {
+        if(c == '"' || c == '\\')
+            result += '\\';
+        if((unsigned char)c < 0x20)
+            continue;
+        result += c;
+    }
+    return result;
 }
 
 void ProfileRecord::print_profiling_data()
 {
-    for( auto& rec : profile_records )
+    print_profiling_data( std::cout );
+}
+
+void ProfileRecord::print_profiling_data( std::ostream& out )
+{
+    auto tree = collect_call_tree();
+    auto flags = out.flags();
+    out << std::left << std::setw(40) << "scope" << std::right << std::setw(10) << "calls"
+        << std::setw(14) << "total [ms]" << std::setw(14) << "mean [us]" << std::setw(9) << "threads";
+    if(registry().hw_counters)
     {
-        std::cout << rec->getName() << ": " << rec->getCallCount() << "x" << rec->getCallTime() << " =\t" << rec->getTotalTime() << "ms\n";
+        out << std::setw(13) << "cycles [M]" << std::setw(13) << "IPC"
+            << std::setw(13) << "LLC miss [k]" << std::setw(13) << "dTLB miss [k]";
     }
+    out << "\n";
+    print_node( out, tree, 0 );
+    out.flags( flags );
+}
+
+void ProfileRecord::enable_tracing()
+{
+    registry().tracing = true;
+}
+
+bool ProfileRecord::enable_hardware_counters()
+{
+    auto& reg = registry();
+    HardwareCounters probe;
+    if(!probe.valid())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+            reg.hw_available[i] = probe.available(i);
+    }
+    reg.hw_counters = true;
+    return true;
+}
+
+void ProfileRecord::write_trace( std::ostream& out )
+{
+    auto& reg = registry();
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock( reg.mutex );
+        events = reg.finished_events;
+        for(auto profile : reg.live)
+        {
+            std::lock_guard<std::mutex> thread_lock( profile->mutex );
+            events.insert( events.end(), profile->events.begin(), profile->events.end() );
+        }
+    }
+
+    // timestamps in the trace event format are given in microseconds
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    for(const auto& e : events)
+    {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "{\"name\": \"" << json_escape(e.record->getName()) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << e.thread
+            << ", \"ts\": " << std::fixed << std::setprecision(3) << e.start_ns * 1e-3
+            << ", \"dur\": " << e.duration_ns * 1e-3;
+        if(reg.hw_counters)
+        {
+            out << ", \"args\": {";
+            for(unsigned i = 0; i < HW_COUNTER_COUNT; ++i)
+                out << (i > 0 ? ", " : "") << "\"" << HW_COUNTER_NAMES[i] << "\": " << e.counters[i];
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
 }
 
 //                 memory profiling
@@ -68,11 +458,107 @@ void profile_deallocate( std::size_t bytes )
     profile_memory_use -= bytes;
 }
 
-std::size_t getBytesInUse()
+std::size_t getTrackedBytes()
 {
     return profile_memory_use;
 }
 
+std::size_t getBytesInUse()
+{
+    return std::max( getResidentBytes(), getTrackedBytes() );
+}
+
+std::size_t getResidentBytes()
+{
+#ifdef __linux__
+    // statm contains the sizes in pages: total program size, resident, ...
+    std::ifstream statm("/proc/self/statm");
+    std::size_t total = 0;
+    std::size_t resident = 0;
+    if( statm >> total >> resident )
+        return resident * sysconf(_SC_PAGESIZE);
+#endif
+    return getTrackedBytes();
+}
+
+std::size_t getPeakResidentBytes()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while( std::getline(status, line) )
+    {
+        // VmHWM:    1234 kB
+        if( line.compare(0, 6, "VmHWM:") == 0 )
+            return std::stoull( line.substr(6) ) * 1024;
+    }
+#endif
+    return getResidentBytes();
+}
+
+bool resetPeakResidentBytes()
+{
+#ifdef __linux__
+    // writing 5 to clear_refs resets the high water mark of the resident set (linux 4.0+)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return clear_refs.good();
+#else
+    return false;
+#endif
+}
+
+namespace
+{
+    struct PhaseRecord
+    {
+        std::string name;
+        std::size_t start_bytes;
+        std::size_t end_bytes;
+        std::size_t peak_bytes;
+        /// if false, peak_bytes is the peak since process start
+        bool exact_peak;
+    };
+
+    std::mutex phase_mutex;
+    std::vector<PhaseRecord> finished_phases;
+    /// whether the last reset of the peak memory succeeded, i.e. the current phase peak is exact.
+    std::atomic<bool> peak_was_reset(false);
+}
+
+MemoryPhase::MemoryPhase( std::string name ) : mName( std::move(name) ), mStartBytes( getResidentBytes() )
+{
+    peak_was_reset = resetPeakResidentBytes();
+}
+
+MemoryPhase::~MemoryPhase()
+{
+    PhaseRecord record{mName, mStartBytes, getResidentBytes(), getPeakResidentBytes(), peak_was_reset};
+    std::lock_guard<std::mutex> lock( phase_mutex );
+    finished_phases.push_back( record );
+}
+
+void MemoryPhase::print_memory_phases( std::ostream& out )
+{
+    std::lock_guard<std::mutex> lock( phase_mutex );
+    auto flags = out.flags();
+    out << std::left << std::setw(20) << "phase" << std::right << std::setw(14) << "start [MB]"
+        << std::setw(14) << "end [MB]" << std::setw(14) << "peak [MB]" << "\n";
+    bool inexact = false;
+    for(const auto& phase : finished_phases)
+    {
+        out << std::left << std::setw(20) << phase.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(14) << phase.start_bytes / 1048576.0
+            << std::setw(14) << phase.end_bytes / 1048576.0
+            << std::setw(14) << phase.peak_bytes / 1048576.0 << (phase.exact_peak ? "" : "*") << "\n";
+        inexact = inexact || !phase.exact_peak;
+    }
+    if(inexact)
+        out << "* peak since process start, the kernel does not allow resetting the peak.\n";
+    out.flags( flags );
+}
+
 std::size_t getMaximumMemoryAvailable()
 {
     return max_mem_avail;
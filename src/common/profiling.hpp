@@ -8,43 +8,66 @@
 
 #include <boost/noncopyable.hpp>
 #include <chrono>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <atomic>
 
 class ProfileRecord;
 
+namespace profiling_detail
+{
+    struct CallNode;
+
+    /// number of hardware counters recorded per scope: cycles, instructions, LLC misses, dTLB misses.
+    constexpr unsigned HW_COUNTER_COUNT = 4;
+}
+
 /*! \class ScopeTimer
     \ingroup common
     \brief Allows to measure the time spent in a certain scope, i.e. a function.
-    \details Counts the milliseconds between creating and destruction of an instance
-            and adds to a designated counter. Should not be used inside the innermost
-            functions to prevent measuring overhead, but should be a good tool to
-            estimate time in sub-algorithms whose calculation time is in the millisecond scale.
+    \details Counts the nanoseconds between creating and destruction of an instance
+            and adds them to a designated counter. Timers that are created while another timer
+            is active on the same thread are recorded as children of that scope, so the profile
+            can be displayed as a call tree. The data is accumulated per thread and merged when
+            the thread exits (or the profile is printed).
+            Each timer costs a few hundred nanoseconds, so it should not be used inside the
+            innermost functions, but is a good tool to estimate time in sub-algorithms.
+            If hardware counters are enabled, each timer additionally reads the performance
+            counters of its thread on entry and exit, which costs about a microsecond per scope.
 */
 class ScopeTimer final : public boost::noncopyable
 {
-    /// clock type used to measure time. high_resolution_clock to be able to capture small time differences.
-    typedef std::chrono::high_resolution_clock clock_t;
+    /// clock type used to measure time. steady_clock, so measurements are not affected by clock adjustments.
+    typedef std::chrono::steady_clock clock_t;
 public:
-    /// create the timer, and add passed time (in milliseconds) to target upon destruction, i.e. scope exit
+    /// create the timer, and add passed time to target upon destruction, i.e. scope exit
     ScopeTimer( ProfileRecord& target );
     /// stop measuring time and add to target
     ~ScopeTimer();
 
-    /// gets the time this timer has measured
-    unsigned getTiming() const;
+    /// gets the time this timer has measured so far, in nanoseconds
+    std::uint64_t getTiming() const;
 private:
     /// this is the counter to which the passed time will be added
     ProfileRecord& mTarget;
+    /// node of the per-thread call tree that corresponds to this scope
+    profiling_detail::CallNode* mNode;
     /// save the time point when the ScopeTimer was created as reference point.
     clock_t::time_point mStartTime;
+    /// hardware counter values when the ScopeTimer was created. Only valid if counters are enabled.
+    std::uint64_t mStartCounters[profiling_detail::HW_COUNTER_COUNT];
+    /// whether mStartCounters were recorded, i.e. whether counters were active when the timer was created.
+    bool mCounting = false;
 };
 
 /*! \class ProfileRecord
     \ingroup common
     \brief class for storing profile data.
-    \details This class is used to store profiling data. This includes total running time and number of calls.
-            The variables are atomic, so that profiling can be performed thread safe.
+    \details This class is used to store profiling data. This includes total running time and number of calls,
+            summed over all threads and call sites. The variables are atomic, so that profiling can be performed
+            thread safe. The per-thread, hierarchical data is managed internally and can be displayed
+            with print_profiling_data.
 */
 class ProfileRecord final : public boost::noncopyable
 {
@@ -52,12 +75,12 @@ class ProfileRecord final : public boost::noncopyable
 public:
     ProfileRecord( std::string&& name );
 
-    /// gets the total time this record counted
-    unsigned getTotalTime() const { return mTotalTime; };
+    /// gets the total time this record counted, in nanoseconds
+    std::uint64_t getTotalTime() const { return mTotalTime; };
     /// gets the number of times the record was invoked
-    unsigned getCallCount() const { return mCallCount; };
+    std::uint64_t getCallCount() const { return mCallCount; };
 
-    /// gets the average time per call
+    /// gets the average time per call, in nanoseconds
     double getCallTime() const { return (double)mTotalTime / mCallCount; };
 
     // info
@@ -66,23 +89,37 @@ public:
     const std::string& getName() const { return mName; };
 
     // manage collection of all profile records
+    /// prints the call tree of all profiled scopes, sorted by total time, to std::cout.
     static void print_profiling_data();
+    /// prints the call tree of all profiled scopes, sorted by total time.
+    static void print_profiling_data( std::ostream& out );
+
+    /// starts recording every single timed scope, so that a trace can be written with write_trace.
+    /// \note Only scopes that are entered after this call are recorded.
+    static void enable_tracing();
+
+    /// writes all recorded scopes in the chrome trace event format (json), which can be
+    /// viewed e.g. in chrome://tracing or perfetto.
+    static void write_trace( std::ostream& out );
+
+    /// starts counting cycles, instructions, last level cache misses and dTLB misses for all
+    /// profiled scopes, using the linux perf_event interface. The counters are only measured in user space.
+    /// \return false if the counters are not supported or the kernel does not permit their use
+    ///         (see /proc/sys/kernel/perf_event_paranoid). Profiling then continues with wall time only.
+    static bool enable_hardware_counters();
 
 private:
     // counts the time
-    inline void record( unsigned ms )
+    inline void record( std::uint64_t ns )
     {
-        mTotalTime += ms;
+        mTotalTime += ns;
         ++mCallCount;
     }
 
-    // manage collection
-    static void addRecord( const ProfileRecord* rec );
-
-    /// total time in ms
-    std::atomic<unsigned> mTotalTime = {0u};
+    /// total time in ns
+    std::atomic<std::uint64_t> mTotalTime = {0u};
     /// total call count
-    std::atomic<unsigned> mCallCount = {0u};
+    std::atomic<std::uint64_t> mCallCount = {0u};
 
     // info
     std::string mName;
@@ -101,12 +138,50 @@ void profile_allocate( std::size_t bytes );
 /// calls this function when memory which was registered with profile_allocate is freed again.
 void profile_deallocate( std::size_t bytes );
 
-/// gets an estimate for the total amount of bytes allocated now
-/// since only grid allocations are tracked by profiling right now,
-/// only that memory is taken into account, but it should comprise
-/// the majority of memory use for big potentials
+/// gets the amount of memory explicitly registered with profile_allocate, i.e. the memory of all grids.
+std::size_t getTrackedBytes();
+
+/// gets an estimate for the total amount of bytes allocated now.
+/// This is the larger one of the resident memory of the whole process and the tracked grid memory,
+/// so allocations that are not registered with profile_allocate (trajectory buffers, fft scratch space, ...)
+/// are taken into account, as are grids whose pages have not been touched yet.
 std::size_t getBytesInUse();
 
+/// gets the resident set size of the process, as reported by /proc/self/statm.
+/// If that is not available, falls back to getTrackedBytes().
+std::size_t getResidentBytes();
+
+/// gets the maximum resident set size of the process since start or since the last
+/// call to resetPeakResidentBytes().
+std::size_t getPeakResidentBytes();
+
+/// resets the peak resident set size to the current resident set size, if the kernel supports this.
+/// \return whether resetting was possible. If not, getPeakResidentBytes() keeps reporting the peak since process start.
+bool resetPeakResidentBytes();
+
+/*! \class MemoryPhase
+    \brief Records the peak memory consumption during a phase of the programme.
+    \details The peak resident memory is reset on construction and read on destruction.
+            All finished phases are kept and can be printed with print_memory_phases. Phases
+            are meant to be used sequentially for the coarse stages of a programme (setup, tracing, saving),
+            nesting them distorts the peak of the outer phase.
+*/
+class MemoryPhase final : public boost::noncopyable
+{
+public:
+    MemoryPhase( std::string name );
+    ~MemoryPhase();
+
+    /// prints resident memory at begin and end, and peak memory of all finished phases.
+    static void print_memory_phases( std::ostream& out );
+private:
+    std::string mName;
+    std::size_t mStartBytes;
+};
+
+/// escapes \p text for use inside a json string. Control characters are dropped.
+std::string json_escape( const std::string& text );
+
 // maximum memory available
 /// gets the maximum memory available to the programme, either a physical (i.e. address space for 32 bit)
 /// or a user imposed limit.
@@ -3,6 +3,8 @@
 #include "multiindex.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <cmath>
 
 using std::size_t;
 
@@ -163,4 +165,54 @@ BOOST_AUTO_TEST_CASE( check_nonsquare_grid )
 }
 
 
+BOOST_AUTO_TEST_CASE( compressed_dump_roundtrip )
+{
+    // odd size and small chunks, so that the last chunk is incomplete
+    DynamicGrid<float> grid( std::vector<std::size_t>{33, 31} );
+    int i = 0;
+    for(auto& v : grid)
+        v = std::sin(0.01f * i++);
+
+    std::stringstream raw;
+    std::stringstream compressed;
+    grid.dump( raw );
+    grid.dump( compressed, GridEncoding::COMPRESSED );
+    BOOST_CHECK_LT( compressed.str().size(), raw.str().size() );
+
+    auto loaded = DynamicGrid<float>::load( compressed );
+    BOOST_CHECK( loaded.getExtents() == grid.getExtents() );
+    BOOST_CHECK_EQUAL_COLLECTIONS( loaded.begin(), loaded.end(), grid.begin(), grid.end() );
+
+    // chunked compression on its own
+    auto data = compressShuffled( grid.begin(), grid.size(), sizeof(float), 100 );
+    BOOST_CHECK_EQUAL( data.chunk_sizes.size(), (grid.size() + 24) / 25 );
+    std::vector<float> target( grid.size() );
+    decompressShuffled( data, target.data(), target.size(), sizeof(float) );
+    BOOST_CHECK_EQUAL_COLLECTIONS( target.begin(), target.end(), grid.begin(), grid.end() );
+
+    // corrupted data is detected
+    data.payload.at(3) ^= 0x55;
+    BOOST_CHECK_THROW( decompressShuffled( data, target.data(), target.size(), sizeof(float) ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( reload )
+{
+    DynamicGrid<float> grid( std::vector<std::size_t>{4, 3} );
+    int i = 0;
+    for(auto& v : grid)
+        v = i++;
+    std::stringstream dump;
+    grid.dump( dump );
+    grid.dump( dump );
+
+    DynamicGrid<float> target( std::vector<std::size_t>{4, 3}, TransformationType::PERIODIC );
+    target.reload( dump );
+    BOOST_CHECK_EQUAL_COLLECTIONS( target.begin(), target.end(), grid.begin(), grid.end() );
+    BOOST_CHECK( target.getAccessMode() == TransformationType::PERIODIC );
+
+    DynamicGrid<float> other( std::vector<std::size_t>{3, 4} );
+    BOOST_CHECK_THROW( other.reload( dump ), std::runtime_error );
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
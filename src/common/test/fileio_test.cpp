@@ -3,6 +3,8 @@
 #include "test_helpers.hpp"
 
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 
 #include <boost/test/unit_test.hpp>
 
@@ -81,6 +83,87 @@ BOOST_AUTO_TEST_CASE( fileio_error_check )
     /// \todo maybe there is a possibility to test whether a file is opened binary
 }
 */
+
+BOOST_AUTO_TEST_CASE( fileio_bulk_roundtrip )
+{
+    std::vector<float> floats(20000);
+    std::vector<unsigned> ints(20000);
+    for(unsigned i = 0; i < floats.size(); ++i)
+    {
+        floats[i] = rand01();
+        ints[i] = rand();
+    }
+
+    std::stringstream stream;
+    {
+        // small buffer, so that both the buffered and the pass-through path are used
+        BinaryWriter writer(stream, 1024);
+        writer.putInteger( 5 );
+        writer.putFloats( floats );
+        writer.putIntegers( ints );
+        writer.putFloat( 1.5 );
+    }
+    writeFloats( stream, floats );
+
+    BOOST_CHECK_EQUAL( stream.str().size(), 8 * (3 * floats.size() + 2) );
+
+    std::vector<float> read_floats(floats.size());
+    std::vector<unsigned> read_ints(ints.size());
+    BOOST_CHECK_EQUAL( readInteger(stream), 5 );
+    readFloats( stream, read_floats.data(), read_floats.size() );
+    BOOST_CHECK( read_floats == floats );
+    readIntegers( stream, read_ints.data(), read_ints.size() );
+    BOOST_CHECK( read_ints == ints );
+    BOOST_CHECK_EQUAL( readFloat(stream), 1.5 );
+    readFloats( stream, read_floats.data(), read_floats.size() );
+    BOOST_CHECK( read_floats == floats );
+
+    // values that do not fit into the target type are rejected
+    std::stringstream big;
+    writeInteger( big, std::uint64_t(1) << 40 );
+    BOOST_CHECK_THROW( readIntegers( big, read_ints.data(), 1 ), boost::numeric::bad_numeric_cast );
+}
+
+BOOST_AUTO_TEST_CASE( fileio_atomic_write )
+{
+    writeFileAtomic( "tmp.atomic", [](std::ostream& out) { writeInteger(out, 42); } );
+    std::fstream source("tmp.atomic", std::fstream::in | std::fstream::binary);
+    BOOST_CHECK_EQUAL( readInteger(source), 42 );
+    source.close();
+
+    // a failing writer leaves the old file in place and does not keep the temporary file around
+    BOOST_CHECK_THROW( writeFileAtomic( "tmp.atomic", [](std::ostream& out) {
+        writeInteger(out, 7);
+        throw std::runtime_error("failure");
+    } ), std::runtime_error );
+    source.open("tmp.atomic", std::fstream::in | std::fstream::binary);
+    BOOST_CHECK_EQUAL( readInteger(source), 42 );
+    BOOST_CHECK( !std::ifstream("tmp.atomic.part").is_open() );
+    std::remove("tmp.atomic");
+}
+
+BOOST_AUTO_TEST_CASE( fileio_mapped_file )
+{
+    {
+        std::fstream out("tmp.mapped", std::fstream::out | std::fstream::binary);
+        writeInteger( out, 42 );
+        writeFloat( out, 1.5 );
+    }
+    {
+        MappedFile mapped("tmp.mapped");
+        BOOST_REQUIRE_EQUAL( mapped.size(), 16 );
+        std::uint64_t integer;
+        double floating;
+        std::memcpy( &integer, mapped.data(), 8 );
+        std::memcpy( &floating, mapped.data() + 8, 8 );
+        BOOST_CHECK_EQUAL( integer, 42 );
+        BOOST_CHECK_EQUAL( floating, 1.5 );
+    }
+    std::remove("tmp.mapped");
+
+    BOOST_CHECK_THROW( MappedFile("tmp.does_not_exist"), std::runtime_error );
+}
+
 /// \todo some more testing of TGA writing methods
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,30 @@
+#include "numa.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(numa_test)
+
+BOOST_AUTO_TEST_CASE( topology )
+{
+    BOOST_CHECK_GE( getNumaNodeCount(), 1 );
+    BOOST_CHECK_GE( getCurrentNumaNode(), 0 );
+    BOOST_CHECK_EQUAL( getNumaNodeOfCore( -1 ), 0 );
+    BOOST_CHECK_EQUAL( getNumaNodeOfCore( 1 << 20 ), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( interleave )
+{
+    std::vector<double> data( 1 << 16, 1.0 );
+    bool placed = interleaveMemory( data.data(), data.size() * sizeof(double) );
+    if( getNumaNodeCount() == 1 )
+        BOOST_CHECK( !placed );
+
+    // placing the pages must not change the data
+    for( double value : data )
+        BOOST_REQUIRE_EQUAL( value, 1.0 );
+    BOOST_CHECK( !interleaveMemory( data.data(), 0 ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -154,3 +154,82 @@ BOOST_AUTO_TEST_CASE( check_serialization )
 
 BOOST_AUTO_TEST_SUITE_END()
 */
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include "test_helpers.hpp"
+
+BOOST_AUTO_TEST_SUITE(potential_io)
+
+BOOST_AUTO_TEST_CASE( parallel_load )
+{
+    Potential potential( std::vector<std::size_t>{8, 6}, std::vector<double>{1.0, 2.0}, 0.5 );
+    potential.setCreationInfo( 3, 4, 0.1 );
+    for(auto idx : std::vector<std::vector<int>>{{0,0}, {1,0}, {0,1}, {2,0}})
+    {
+        default_grid grid( potential.getExtents() );
+        for(auto& v : grid)
+            v = rand01();
+        potential.setDerivative( idx, std::move(grid) );
+    }
+
+    {
+        std::fstream tmp("tmp.pot", std::ios::out | std::ios::binary);
+        potential.writeToFile( tmp );
+    }
+
+    {
+        std::fstream tmp("tmp_z.pot", std::ios::out | std::ios::binary);
+        potential.writeToFile( tmp, GridEncoding::COMPRESSED );
+    }
+
+    std::fstream load("tmp.pot", std::ios::in | std::ios::binary);
+    auto sequential = Potential::readFromFile( load );
+    auto parallel = Potential::readFromFile( "tmp.pot", 3 );
+    std::fstream load_z("tmp_z.pot", std::ios::in | std::ios::binary);
+    auto sequential_z = Potential::readFromFile( load_z );
+    auto parallel_z = Potential::readFromFile( "tmp_z.pot", 3 );
+
+    for(const Potential* pot : {&sequential, &parallel, &sequential_z, &parallel_z})
+    {
+        BOOST_CHECK( pot->getExtents() == potential.getExtents() );
+        BOOST_CHECK( pot->getSupport() == potential.getSupport() );
+        BOOST_CHECK_EQUAL( pot->getSeed(), potential.getSeed() );
+        BOOST_CHECK_EQUAL( pot->getStrength(), potential.getStrength() );
+        for(auto idx : std::vector<std::vector<int>>{{0,0}, {1,0}, {0,1}, {2,0}})
+        {
+            auto& expected = potential.getDerivative( idx );
+            auto& got = pot->getDerivative( idx );
+            BOOST_CHECK_EQUAL_COLLECTIONS( got.begin(), got.end(), expected.begin(), expected.end() );
+        }
+    }
+
+    BOOST_CHECK_THROW( Potential::readFromFile( "does_not_exist.pot" ), std::runtime_error );
+    std::remove("tmp.pot");
+    std::remove("tmp_z.pot");
+}
+
+// a single grid that is larger than the ranges the parallel reader splits grids into
+BOOST_AUTO_TEST_CASE( parallel_read_large_grid )
+{
+    Potential potential( std::vector<std::size_t>{2048, 1536}, std::vector<double>{1.0, 1.0}, 1.0 );
+    potential.setCreationInfo( 3, 4, 0.1 );
+    default_grid grid( potential.getExtents() );
+    std::size_t i = 0;
+    for(auto& v : grid)
+        v = i++;
+    potential.setDerivative( std::vector<int>{0, 0}, std::move(grid) );
+
+    {
+        std::fstream tmp("tmp_large.pot", std::ios::out | std::ios::binary);
+        potential.writeToFile( tmp );
+    }
+
+    auto parallel = Potential::readFromFile( "tmp_large.pot", 4 );
+    auto& expected = potential.getDerivative( std::vector<int>{0, 0} );
+    auto& got = parallel.getDerivative( std::vector<int>{0, 0} );
+    BOOST_CHECK( std::equal( got.begin(), got.end(), expected.begin() ) );
+    std::remove("tmp_large.pot");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
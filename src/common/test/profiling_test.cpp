@@ -0,0 +1,133 @@
+#include "profiling.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(profiling_test)
+
+namespace
+{
+    void inner_scope()
+    {
+        PROFILE_BLOCK("profiling_test inner");
+    }
+
+    void outer_scope()
+    {
+        PROFILE_BLOCK("profiling_test outer");
+        inner_scope();
+        inner_scope();
+    }
+}
+
+BOOST_AUTO_TEST_CASE( call_counts )
+{
+    static ProfileRecord record("profiling_test record");
+    {
+        ScopeTimer timer(record);
+        std::this_thread::sleep_for( std::chrono::milliseconds(2) );
+        BOOST_CHECK_GE( timer.getTiming(), 2000000u );
+    }
+    BOOST_CHECK_EQUAL( record.getCallCount(), 1u );
+    BOOST_CHECK_GE( record.getTotalTime(), 2000000u );
+}
+
+BOOST_AUTO_TEST_CASE( nested_scopes )
+{
+    std::thread worker( [](){ outer_scope(); } );
+    worker.join();
+    outer_scope();
+
+    std::stringstream out;
+    ProfileRecord::print_profiling_data( out );
+    std::string table = out.str();
+
+    // inner is printed indented below outer, and both threads are merged into a single entry.
+    auto outer_pos = table.find("profiling_test outer ");
+    auto inner_pos = table.find("  profiling_test inner ");
+    BOOST_REQUIRE( outer_pos != std::string::npos );
+    BOOST_REQUIRE( inner_pos != std::string::npos );
+    BOOST_CHECK( outer_pos < inner_pos );
+    BOOST_CHECK_EQUAL( table.find("profiling_test outer ", outer_pos + 1), std::string::npos );
+}
+
+/// the threads of finished threads have to be kept when their merged data is merged again for printing.
+BOOST_AUTO_TEST_CASE( thread_counts )
+{
+    auto scope = []() { PROFILE_BLOCK("profiling_test threads"); };
+    for(int i = 0; i < 2; ++i)
+    {
+        std::thread worker( scope );
+        worker.join();
+    }
+    scope();
+
+    std::stringstream out;
+    ProfileRecord::print_profiling_data( out );
+    std::string table = out.str();
+    auto row = table.find("profiling_test threads ");
+    BOOST_REQUIRE( row != std::string::npos );
+
+    // name (two words), calls, total, mean, threads
+    std::stringstream line( table.substr(row, table.find('\n', row) - row) );
+    std::string word;
+    std::vector<std::string> columns;
+    while(line >> word)
+        columns.push_back(word);
+    BOOST_REQUIRE_GE( columns.size(), 6u );
+    BOOST_CHECK_EQUAL( columns[2], "3" );
+    BOOST_CHECK_EQUAL( columns[5], "3" );
+}
+
+BOOST_AUTO_TEST_CASE( trace_events )
+{
+    ProfileRecord::enable_tracing();
+    outer_scope();
+
+    std::stringstream out;
+    ProfileRecord::write_trace( out );
+    std::string trace = out.str();
+
+    BOOST_CHECK_EQUAL( trace.find("{\"displayTimeUnit\""), 0u );
+    BOOST_CHECK( trace.find("\"name\": \"profiling_test outer\"") != std::string::npos );
+    BOOST_CHECK( trace.find("\"name\": \"profiling_test inner\"") != std::string::npos );
+    BOOST_CHECK( trace.find("\"ph\": \"X\"") != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( hardware_counters )
+{
+    // counters may legitimately be unavailable, e.g. in containers. Then profiling has to continue without them.
+    bool available = ProfileRecord::enable_hardware_counters();
+    outer_scope();
+
+    std::stringstream table;
+    ProfileRecord::print_profiling_data( table );
+    BOOST_CHECK_EQUAL( table.str().find("cycles [M]") != std::string::npos, available );
+
+    std::stringstream trace;
+    ProfileRecord::write_trace( trace );
+    BOOST_CHECK_EQUAL( trace.str().find("\"instructions\": ") != std::string::npos, available );
+}
+
+BOOST_AUTO_TEST_CASE( resident_memory )
+{
+    std::size_t before = getResidentBytes();
+    BOOST_CHECK_GT( before, 0u );
+    {
+        MemoryPhase phase("profiling_test phase");
+        // untracked allocation, only visible in the resident memory once the pages are touched.
+        std::vector<char> buffer(64 * 1024 * 1024, 1);
+        BOOST_CHECK_GE( getResidentBytes(), before + buffer.size() / 2 );
+        BOOST_CHECK_GE( getBytesInUse(), getResidentBytes() / 2 );
+        BOOST_CHECK_GE( getPeakResidentBytes(), before + buffer.size() / 2 );
+    }
+
+    std::stringstream out;
+    MemoryPhase::print_memory_phases( out );
+    BOOST_CHECK( out.str().find("profiling_test phase") != std::string::npos );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
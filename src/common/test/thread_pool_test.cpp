@@ -0,0 +1,108 @@
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(thread_pool_test)
+
+BOOST_AUTO_TEST_CASE( submit_and_wait )
+{
+    ThreadPool pool(3);
+    BOOST_CHECK_EQUAL( pool.getConcurrency(), 3 );
+
+    std::vector<std::future<int>> results;
+    for(int i = 0; i < 20; ++i)
+        results.push_back( pool.submit( [i]() { return i * i; } ) );
+    for(int i = 0; i < 20; ++i)
+        BOOST_CHECK_EQUAL( pool.wait( results[i] ), i * i );
+
+    auto failing = pool.submit( []() -> int { throw std::runtime_error("task failed"); } );
+    BOOST_CHECK_THROW( pool.wait( failing ), std::runtime_error );
+
+    BOOST_CHECK_THROW( ThreadPool(0), std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( parallel_for )
+{
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> calls(1000);
+    for(auto& c : calls)
+        c = 0;
+    pool.parallel_for( calls.size(), [&](std::size_t i) { ++calls[i]; } );
+    for(auto& c : calls)
+        BOOST_CHECK_EQUAL( c, 1 );
+
+    // the first exception is rethrown, and the remaining jobs are skipped
+    std::atomic<int> count{0};
+    BOOST_CHECK_THROW( pool.parallel_for( 100, [&](std::size_t i) {
+        ++count;
+        if(i == 10)
+            throw std::logic_error("job failed");
+    } ), std::logic_error );
+    BOOST_CHECK_LT( count, 100 );
+
+    pool.parallel_for( 0, [](std::size_t) { BOOST_FAIL("no job expected"); } );
+}
+
+// tasks that wait for other tasks must not block the pool, even if they occupy all workers.
+BOOST_AUTO_TEST_CASE( nested_tasks )
+{
+    for(std::size_t concurrency : {1, 2})
+    {
+        ThreadPool pool(concurrency);
+        std::vector<std::future<long>> outer;
+        for(int i = 0; i < 8; ++i)
+        {
+            outer.push_back( pool.submit( [&pool]()
+            {
+                std::vector<long> values(50);
+                pool.parallel_for( values.size(), [&](std::size_t j) { values[j] = j; } );
+                return std::accumulate( values.begin(), values.end(), 0l );
+            } ) );
+        }
+        for(auto& result : outer)
+            BOOST_CHECK_EQUAL( pool.wait( result ), 50 * 49 / 2 );
+    }
+}
+
+// threads that wait without pending tasks sleep until a task has finished
+BOOST_AUTO_TEST_CASE( sleeping_wait )
+{
+    ThreadPool pool(3);
+    std::vector<std::future<int>> results;
+    for(int i = 0; i < 4; ++i)
+        results.push_back( pool.submit( [i]() {
+            std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+            return i;
+        } ) );
+
+    // another thread waits for the same pool concurrently
+    int other_result = -1;
+    std::thread other( [&]() { other_result = pool.wait( results[3] ); } );
+    for(int i = 0; i < 3; ++i)
+        BOOST_CHECK_EQUAL( pool.wait( results[i] ), i );
+    other.join();
+    BOOST_CHECK_EQUAL( other_result, 3 );
+}
+
+BOOST_AUTO_TEST_CASE( global_pool )
+{
+    ThreadPool& pool = ThreadPool::global();
+    BOOST_CHECK_EQUAL( &pool, &ThreadPool::global() );
+    BOOST_CHECK_GE( pool.getConcurrency(), 1 );
+    BOOST_CHECK_THROW( ThreadPool::configureGlobal( 2, false ), std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE( pinned_workers )
+{
+    ThreadPool pool(2, true);
+    auto result = pool.submit( []() { return 1; } );
+    BOOST_CHECK_EQUAL( pool.wait( result ), 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,214 @@
+#include "thread_pool.hpp"
+#include "global.hpp"
+#include <algorithm>
+#include <exception>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    /// pool and queue of the worker that runs on the current thread, if any.
+    thread_local ThreadPool* current_pool = nullptr;
+    thread_local std::size_t current_queue = 0;
+
+    std::mutex global_mutex;
+    /// intentionally leaked, so that tasks can still be run during static destruction.
+    ThreadPool* global_pool = nullptr;
+    std::size_t global_concurrency = 0;
+    bool global_pin = false;
+
+    /// the cores this process may run on.
+    std::vector<int> allowed_cores()
+    {
+        std::vector<int> cores;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        if( sched_getaffinity( 0, sizeof(set), &set ) == 0 )
+        {
+            for( int core = 0; core < CPU_SETSIZE; ++core )
+                if( CPU_ISSET( core, &set ) )
+                    cores.push_back( core );
+        }
+#endif
+        return cores;
+    }
+
+    void pin_to_core( int core )
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        CPU_SET( core, &set );
+        pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+#endif
+    }
+}
+
+ThreadPool::ThreadPool( std::size_t concurrency, bool pin )
+{
+    if( concurrency == 0 )
+        THROW_EXCEPTION( std::invalid_argument, "a thread pool needs a concurrency of at least one" );
+
+    std::size_t workers = concurrency - 1;
+    for( std::size_t i = 0; i < std::max<std::size_t>( workers, 1 ); ++i )
+        mQueues.emplace_back( new Queue );
+
+    // the first core is left to the thread that creates the pool, which usually waits for the tasks.
+    std::vector<int> cores;
+    if( pin )
+        cores = allowed_cores();
+    for( std::size_t i = 0; i < workers; ++i )
+    {
+        int core = cores.empty() ? -1 : cores[(i + 1) % cores.size()];
+        mWorkers.emplace_back( [this, i, core]() { workerLoop( i, core ); } );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mSleepMutex );
+        mStop = true;
+    }
+    mWake.notify_all();
+    for( auto& worker : mWorkers )
+        worker.join();
+    // without workers, tasks that nobody waited for are still run.
+    while( runPendingTask() ) { }
+}
+
+ThreadPool& ThreadPool::global()
+{
+    std::lock_guard<std::mutex> lock( global_mutex );
+    if( !global_pool )
+    {
+        std::size_t concurrency = global_concurrency;
+        if( concurrency == 0 )
+            concurrency = std::max( 1u, std::thread::hardware_concurrency() );
+        global_pool = new ThreadPool( concurrency, global_pin );
+    }
+    return *global_pool;
+}
+
+void ThreadPool::configureGlobal( std::size_t concurrency, bool pin )
+{
+    std::lock_guard<std::mutex> lock( global_mutex );
+    if( global_pool )
+        THROW_EXCEPTION( std::logic_error, "the global thread pool is already running" );
+    global_concurrency = concurrency;
+    global_pin = pin;
+}
+
+std::size_t ThreadPool::getConcurrency() const
+{
+    return mWorkers.size() + 1;
+}
+
+void ThreadPool::parallel_for( std::size_t count, const std::function<void(std::size_t)>& job )
+{
+    std::atomic<std::size_t> next{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto run = [&]()
+    {
+        for( std::size_t i = next++; i < count; i = next++ )
+        {
+            try
+            {
+                job( i );
+            } catch( ... )
+            {
+                std::lock_guard<std::mutex> lock( error_mutex );
+                if( !error )
+                    error = std::current_exception();
+                next = count;
+            }
+        }
+    };
+
+    std::size_t helpers = std::min( mWorkers.size(), count > 0 ? count - 1 : 0 );
+    std::vector<std::future<void>> started;
+    for( std::size_t i = 0; i < helpers; ++i )
+        started.push_back( submit( run ) );
+    run();
+    // the helpers reference the local variables, so all of them have to finish
+    for( auto& helper : started )
+        wait( helper );
+
+    if( error )
+        std::rethrow_exception( error );
+}
+
+void ThreadPool::push( std::function<void()> task )
+{
+    std::size_t index = current_pool == this ? current_queue : mNextQueue++ % mQueues.size();
+    {
+        std::lock_guard<std::mutex> lock( mQueues[index]->mutex );
+        mQueues[index]->tasks.push_back( std::move(task) );
+    }
+    {
+        std::lock_guard<std::mutex> lock( mSleepMutex );
+        ++mPending;
+    }
+    mWake.notify_one();
+}
+
+bool ThreadPool::runPendingTask()
+{
+    bool own = current_pool == this;
+    std::size_t start = own ? current_queue : 0;
+    std::function<void()> task;
+    for( std::size_t k = 0; k < mQueues.size() && !task; ++k )
+    {
+        Queue& queue = *mQueues[(start + k) % mQueues.size()];
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        if( queue.tasks.empty() )
+            continue;
+        // the own queue is used as a stack, as its newest tasks are most likely to find their data in the cache
+        if( own && k == 0 )
+        {
+            task = std::move( queue.tasks.back() );
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move( queue.tasks.front() );
+            queue.tasks.pop_front();
+        }
+    }
+
+    if( !task )
+        return false;
+    --mPending;
+    task();
+    {
+        std::lock_guard<std::mutex> lock( mSleepMutex );
+        ++mCompleted;
+        if( mWaiting == 0 )
+            return true;
+    }
+    mWake.notify_all();
+    return true;
+}
+
+void ThreadPool::workerLoop( std::size_t index, int core )
+{
+    current_pool = this;
+    current_queue = index;
+    if( core >= 0 )
+        pin_to_core( core );
+
+    while( true )
+    {
+        if( runPendingTask() )
+            continue;
+
+        std::unique_lock<std::mutex> lock( mSleepMutex );
+        mWake.wait( lock, [this]() { return mPending > 0 || mStop; } );
+        if( mStop && mPending <= 0 )
+            return;
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef THREAD_POOL_HPP_INCLUDED
+#define THREAD_POOL_HPP_INCLUDED
+
+/*! \file thread_pool.hpp
+    \ingroup common
+    \brief Work stealing thread pool that is shared by all parallel stages of a programme.
+*/
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \class ThreadPool
+    \ingroup common
+    \brief Runs tasks on a fixed set of worker threads.
+    \details Every worker has its own task queue. Tasks submitted by a worker go to the back of its own queue and
+            are taken from there by the same worker, idle workers steal from the front of the other queues.
+            Threads that wait for a task with wait() run pending tasks in the meantime, so tasks may submit and
+            wait for further tasks without deadlocking the pool, and the waiting thread counts as one of the
+            threads of the pool: A pool of concurrency \a N starts \a N - 1 workers.
+
+            Because all parallel stages share the global() pool, nested parallelism (e.g. parallel FFTs inside
+            concurrently computed derivatives) never uses more threads than the configured concurrency.
+*/
+class ThreadPool final : public boost::noncopyable
+{
+public:
+    /// starts \p concurrency - 1 workers. If \p pin is set, each worker is bound to its own core.
+    explicit ThreadPool( std::size_t concurrency, bool pin = false );
+    /// runs the remaining tasks and joins the workers.
+    ~ThreadPool();
+
+    /// \brief the pool that is used by all parallel algorithms of the programme.
+    /// \details Created on first use, with the settings of configureGlobal() or one thread per core.
+    ///          It is never destroyed, so it can be used until the very end of the programme.
+    static ThreadPool& global();
+
+    /// \brief sets the concurrency and pinning of the global() pool. A \p concurrency of zero uses all cores.
+    /// \throw std::logic_error if the global pool has already been created.
+    static void configureGlobal( std::size_t concurrency, bool pin );
+
+    /// number of threads that can run tasks concurrently, i.e. the workers and one waiting thread.
+    std::size_t getConcurrency() const;
+
+    /// schedules \p function, and returns a future for its result. The future should be waited for with wait().
+    template<class F>
+    auto submit( F&& function ) -> std::future<decltype(function())>
+    {
+        typedef decltype(function()) result_type;
+        auto task = std::make_shared<std::packaged_task<result_type()>>( std::forward<F>(function) );
+        auto result = task->get_future();
+        push( [task]() { (*task)(); } );
+        return result;
+    }
+
+    /// waits until \p future is ready and returns its value. Runs pending tasks while waiting, and sleeps until
+    /// a task finishes or a new one is submitted when there are none, so \p future has to belong to a task of this pool.
+    template<class T>
+    T wait( std::future<T>& future )
+    {
+        while( !isReady( future ) )
+        {
+            if( runPendingTask() )
+                continue;
+
+            std::unique_lock<std::mutex> lock( mSleepMutex );
+            // tasks count their completion under the lock after making their result ready, so checking the
+            // future under the lock cannot miss the notification.
+            if( isReady( future ) )
+                break;
+            std::uint64_t completed = mCompleted;
+            ++mWaiting;
+            mWake.wait( lock, [&]() { return mCompleted != completed || mPending > 0; } );
+            --mWaiting;
+        }
+        return future.get();
+    }
+
+    /*! \brief calls \p job for all indices in [0, \p count), using the calling thread and idle workers.
+     *  \details Returns when all calls have finished. If a call throws, the remaining indices are skipped
+     *          and the first exception is rethrown.
+     */
+    void parallel_for( std::size_t count, const std::function<void(std::size_t)>& job );
+
+private:
+    template<class T>
+    static bool isReady( const std::future<T>& future )
+    {
+        return future.wait_for( std::chrono::seconds(0) ) == std::future_status::ready;
+    }
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /// adds \p task to the queue of the calling worker, or distributes it over the queues for other threads.
+    void push( std::function<void()> task );
+    /// runs a single task from the own queue or one stolen from another queue. Returns false if there was none.
+    bool runPendingTask();
+    void workerLoop( std::size_t index, int core );
+
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mWorkers;
+    std::atomic<std::size_t> mNextQueue{0};         //!< queue for the next task from a thread outside the pool
+
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+    std::atomic<long> mPending{0};                  //!< tasks in the queues, incremented under mSleepMutex
+    std::uint64_t mCompleted = 0;                   //!< number of finished tasks, protected by mSleepMutex
+    std::size_t mWaiting = 0;                       //!< threads sleeping in wait(), protected by mSleepMutex
+    bool mStop = false;                             //!< protected by mSleepMutex
+};
+
+#endif // THREAD_POOL_HPP_INCLUDED
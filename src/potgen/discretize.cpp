@@ -1,6 +1,5 @@
-#include <future>
-#include <thread>
 #include "discretize.hpp"
+#include "thread_pool.hpp"
 
 template<std::size_t DIM>
 void fillGrid(complex_grid& grid, MultiIndex index, const std::vector<double>& scale, const correlation_fn& F)
@@ -78,17 +77,12 @@ complex_grid discretizeFunctionForFFT(std::vector<std::size_t> gridsize, std::ve
     complex_grid grid( gridsize, TransformationType::IDENTITY );
 
     // now distribute computation to many threads
-    std::vector<std::future<void>> tasks;
-    auto sub_indices = index.split(std::thread::hardware_concurrency());
-    for(const auto& sub : sub_indices)
+    auto& pool = ThreadPool::global();
+    auto sub_indices = index.split(pool.getConcurrency());
+    pool.parallel_for(sub_indices.size(), [&](std::size_t i)
     {
-        tasks.push_back( std::async(std::launch::async, fillGrid_generic, std::ref(grid), sub, std::ref(support), std::ref(F)) );
-    }
-
-    for(unsigned i = 0; i < tasks.size(); ++i)
-    {
-        tasks[i].get();
-    }
+        fillGrid_generic(grid, sub_indices[i], support, F);
+    });
 
     grid.setAccessMode( TransformationType::FFT_INDEX );
 
@@ -8,16 +8,32 @@
 #include "fft.hpp"
 #include "global.hpp"
 #include "profiling.hpp"
+#include "thread_pool.hpp"
 #include "dynamic_grid.hpp"
 #include "config.h" // for wisdom filename
 
 using std::size_t;
 
+#ifdef FFTW_HAS_THREADS_CALLBACK
+namespace
+{
+	/// runs the parallel loops of fftw on the global thread pool instead of fftw's own threads, so
+	/// that FFTs started by concurrent tasks do not oversubscribe the cores.
+	void fftw_parallel_loop( void* (*work)(char*), char* jobdata, size_t elsize, int njobs, void* /*data*/ )
+	{
+		ThreadPool::global().parallel_for( njobs, [&](std::size_t job) { work( jobdata + elsize * job ); } );
+	}
+}
+#endif
+
 void setFFTThreads( size_t threads )
 {
 	// this is a general purpose init method
 	/// \todo error handling
 	fftw_init_threads();
+#ifdef FFTW_HAS_THREADS_CALLBACK
+	fftw_threads_set_callback( fftw_parallel_loop, nullptr );
+#endif
 	fftw_import_wisdom_from_filename(WISDOM_FILENAME);
 	fftw_plan_with_nthreads( threads );
 }
@@ -6,6 +6,7 @@
 #include "multiindex.hpp"
 #include "discretize.hpp"
 #include "randomize.hpp"
+#include "thread_pool.hpp"
 
 #include <array>
 #include <cmath>
@@ -153,6 +154,7 @@ void calculateAllDerivatives(Potential &potential, const complex_grid &potential
     typedef std::future<default_grid> f_type;
     std::vector<f_type> started_tasks;
     std::vector<MultiIndex> task_orders;
+    auto& pool = ThreadPool::global();
 
     // calculation function
     auto calc_deriv = [&potential_k](MultiIndex order)
@@ -172,16 +174,33 @@ void calculateAllDerivatives(Potential &potential, const complex_grid &potential
         std::size_t total_order = order.getAccumulated();
         if(total_order <= max_order && total_order > 0)
         {
-            started_tasks.push_back( std::async(std::launch::async, calc_deriv, order) );
+            started_tasks.push_back( pool.submit( std::bind(calc_deriv, order) ) );
             task_orders.push_back( order );
         }
     }
 
+    // if an error is propagated, the remaining tasks still have to finish, as they reference potential_k
+    struct WaitForTasks
+    {
+        ThreadPool& pool;
+        std::vector<f_type>& tasks;
+        ~WaitForTasks()
+        {
+            for(auto& task : tasks)
+            {
+                try {
+                    if(task.valid())
+                        pool.wait(task);
+                } catch(...) { }
+            }
+        }
+    } wait_for_tasks{pool, started_tasks};
+
     for(unsigned i = 0; i < task_orders.size(); ++i)
     {
         try
         {
-            potential.setDerivative( task_orders[i], std::move(started_tasks[i].get()) );
+            potential.setDerivative( task_orders[i], pool.wait(started_tasks[i]) );
         } catch (const std::bad_alloc& e)
         {
             std::cerr << "bad alloc called in multi threaded derivative calculation. probably ran out of memory. "
@@ -11,9 +11,14 @@ namespace pargs
 	unsigned int seed = 1u;
 
 	unsigned int threads = 1u;
+	unsigned int max_threads = 0u;
+	bool pin_threads = false;
 	bool no_wisdom = false;
 	bool print_profile = false;
+	std::string profile_trace;
+	bool hw_counters = false;
 	bool correlation_only = false;
+	bool compress = false;
 
 	int derivative_order = 2;
 
@@ -43,9 +48,14 @@ namespace pargs
 			("derivative-order", po::value<int>(&derivative_order)->default_value( derivative_order ), "highest order to which the derivatives should be calculated")
 			("output,o", po::value<std::string>(&potential_outfile)->required(), "File to store the potential.")
 			("threads,t", po::value<unsigned>(&threads), "Number of threads for fftw to use.")
+			("max-threads", po::value<unsigned>(&max_threads)->default_value( max_threads ), "Maximum number of threads used by all parallel stages together, including fftw. 0 uses all cores.")
+			("pin-threads", po::bool_switch(&pin_threads), "Bind each worker thread to its own core.")
 			("no-wisdom", po::bool_switch(&no_wisdom), "Disable saving fftw wisdom.")
 			("print-profile", po::bool_switch(&print_profile), "Prints profiling information after the potential generation is finished.")
+			("profile-trace", po::value<std::string>(&profile_trace), "Write a trace of all profiled scopes in chrome trace event format (json) to this file.")
+			("hw-counters", po::bool_switch(&hw_counters), "Record cycles, instructions, cache and TLB misses for all profiled scopes. Requires perf_event support by the kernel.")
 			("correlation-only", po::bool_switch(&correlation_only), "Do not generate potential. Just create the correlation function.")
+			("compress", po::bool_switch(&compress), "Save the potential grids in compressed form.")
 		;
 
 		po::positional_options_description p;
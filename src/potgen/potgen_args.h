@@ -13,9 +13,14 @@ namespace pargs
 	extern unsigned int seed;
 
 	extern unsigned int threads;
+	extern unsigned int max_threads;
+	extern bool pin_threads;
 	extern bool no_wisdom;
 	extern bool print_profile;
+	extern std::string profile_trace;
+	extern bool hw_counters;
 	extern bool correlation_only;
+	extern bool compress;
 
 	// generation switches
 	extern int derivative_order;
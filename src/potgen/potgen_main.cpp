@@ -2,6 +2,7 @@
 #include <cmath>
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/lexical_cast.hpp>
 #include "fft.hpp"
@@ -9,12 +10,19 @@
 #include "fileIO.hpp"
 #include "potgen_args.h"
 #include "profiling.hpp"
+#include "thread_pool.hpp"
 #include "correlation.hpp"
 #include "discretize.hpp"
 
 int main(int argc, const char* argv[])
 {
 	parse_parameters(argc, argv);
+	if( !pargs::profile_trace.empty() )
+		ProfileRecord::enable_tracing();
+	if( pargs::hw_counters && !ProfileRecord::enable_hardware_counters() )
+		std::cerr << "hardware counters are not available, profiling wall time only (check /proc/sys/kernel/perf_event_paranoid).\n";
+
+	ThreadPool::configureGlobal( pargs::max_threads, pargs::pin_threads );
 
 	PGOptions opt;
 
@@ -93,7 +101,9 @@ int main(int argc, const char* argv[])
 		}
 		else
 		{
+			std::unique_ptr<MemoryPhase> generate_phase(new MemoryPhase("generate"));
 			auto pot = generatePotential(extents, support, opt);
+			generate_phase.reset();
 
 			auto &pot_data = pot.getPotential();
 
@@ -117,7 +127,7 @@ int main(int argc, const char* argv[])
 			std::cout << "saving potential to " << pargs::potential_outfile << "\n";
 			char write_buffer[1024 * 512];
 			save.rdbuf()->pubsetbuf(write_buffer, sizeof(write_buffer));
-			pot.writeToFile(save);
+			pot.writeToFile(save, pargs::compress ? GridEncoding::COMPRESSED : GridEncoding::RAW);
 			save.close();
 		}
 
@@ -130,6 +140,11 @@ int main(int argc, const char* argv[])
 		if( pargs::print_profile )
 		{
 			ProfileRecord::print_profiling_data();
+			MemoryPhase::print_memory_phases(std::cout);
+		}
+		if( !pargs::profile_trace.empty() )
+		{
+			writeFileAtomic(pargs::profile_trace, [](std::ostream& out) { ProfileRecord::write_trace(out); });
 		}
 	} catch ( boost::exception& e )
 	{
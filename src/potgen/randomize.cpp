@@ -2,9 +2,8 @@
 // Created by eriks on 6/1/17.
 //
 
-#include <thread>
-#include <future>
 #include "randomize.hpp"
+#include "thread_pool.hpp"
 
 template<std::size_t DIM>
 void randomize_over_index(complex_grid& grid, std::function<double()> rnd, MultiIndex index)
@@ -84,7 +83,6 @@ void randomizePhases(complex_grid& grid, std::uint64_t seed)
     // setup iteration index
     MultiIndex index = fft_indexing(grid);
 
-    std::vector<std::future<void>> tasks;
     // figure out how many threads to use. This has to be independent of the number of
     // available hardware threads, otherwise we would compromise reproducability.
     // Thus by default we use many threads, wasting a few resources on small systems
@@ -106,7 +104,9 @@ void randomizePhases(complex_grid& grid, std::uint64_t seed)
             std::numeric_limits<std::seed_seq::result_type>::max());
     auto seeder = std::bind(seed_dist, seed_engine);
 
-    for(auto sub : sub_indices)
+    // the generators are seeded in order, so the phases do not depend on the order in which the parts are processed.
+    std::vector<std::function<double()>> generators;
+    for(std::size_t i = 0; i < sub_indices.size(); ++i)
     {
         // create a seed sequence using seeder
         std::array<std::seed_seq::result_type, std::mt19937_64::state_size> seq;
@@ -118,8 +118,11 @@ void randomizePhases(complex_grid& grid, std::uint64_t seed)
         // create a new rng from the seed sequence
         std::mt19937_64 generator(seed_seq);
         std::uniform_real_distribution<double> distribution(0.0, 2 * pi);
-        auto rnd = std::bind(distribution, generator);
-
-        tasks.push_back(std::async(std::launch::async, randomize_generic, std::ref(grid), rnd, sub));
+        generators.push_back(std::bind(distribution, generator));
     }
+
+    ThreadPool::global().parallel_for(sub_indices.size(), [&](std::size_t i)
+    {
+        randomize_generic(grid, generators[i], sub_indices[i]);
+    });
 }
@@ -0,0 +1,181 @@
+#include "checkpoint.hpp"
+#include "fileIO.hpp"
+#include "global.hpp"
+#include <istream>
+#include <ostream>
+
+namespace
+{
+	const std::string CHECKPOINT_HEADER = "ckpt001\n";
+	const std::string SHARD_HEADER = "shrd001\n";
+
+	void writeString( std::ostream& target, const std::string& value )
+	{
+		writeInteger( target, value.size() );
+		target.write( value.data(), value.size() );
+	}
+
+	std::string readString( std::istream& source )
+	{
+		std::uint64_t size = readInteger( source );
+		if( !source )
+			THROW_EXCEPTION( std::runtime_error, "checkpoint file is truncated" );
+		std::string value( size, '\0' );
+		source.read( &value[0], value.size() );
+		if( !source )
+			THROW_EXCEPTION( std::runtime_error, "checkpoint file is truncated" );
+		return value;
+	}
+
+	/// writes everything in front of the observer data of a checkpoint, for \p observers observers.
+	void writeCheckpointInfo( std::ostream& target, const Checkpoint& checkpoint, std::uint64_t observers )
+	{
+		/*! Checkpoint file format.
+			Header: ckpt001\\n
+			Data type   | Count | Meaning
+			---------   | ----- | -------
+			String      | 1     | generator type
+			Int         | 1     | requested number of particles
+			Int         | 1     | finished rays, i.e. the rays [0, N) of the generator
+			Int         | 1     | rays that contributed to the observers
+			Int         | 1     | observed integration steps
+			Int [\#O]   | 1     | number of observers
+			String      | 2 \#O | file name and serialized data of each observer
+			Strings are saved as their length (Int), followed by the characters.
+		*/
+		target << CHECKPOINT_HEADER;
+		writeString( target, checkpoint.mGeneratorType );
+		writeInteger( target, checkpoint.mRequestedParticles );
+		writeInteger( target, checkpoint.mRayCount );
+		writeInteger( target, checkpoint.mParticleCount );
+		writeInteger( target, checkpoint.mStepCount );
+		writeInteger( target, observers );
+	}
+
+	/// writes the data produced by \p writer as a string. The length is not known in advance, so a placeholder
+	/// is written first and overwritten when the data is complete.
+	void writeStreamed( std::ostream& target, const std::function<void(std::ostream&)>& writer )
+	{
+		auto start = target.tellp();
+		if( start == std::ostream::pos_type(-1) )
+			THROW_EXCEPTION( std::runtime_error, "checkpoint data can only be streamed into a seekable file" );
+		writeInteger( target, std::uint64_t(0) );
+		writer( target );
+		auto end = target.tellp();
+		if( !target || end == std::ostream::pos_type(-1) )
+			THROW_EXCEPTION( std::runtime_error, "error while writing checkpoint data" );
+		target.seekp( start );
+		writeInteger( target, static_cast<std::uint64_t>( end - start ) - sizeof(std::uint64_t) );
+		target.seekp( end );
+	}
+
+	/// writes everything in front of the checkpoint of a shard.
+	void writeShardInfo( std::ostream& target, const ShardResult& shard )
+	{
+		/*! Shard file format.
+			Header: shrd001\\n
+			Data type   | Count | Meaning
+			---------   | ----- | -------
+			Int         | 1     | index of the shard
+			Int         | 1     | number of shards
+			Int         | 1     | index of the first ray of the shard
+			Int [D]     | 1     | dimension of the potential
+			Int         | D     | potential size
+			Double      | D     | potential support
+			Int [\#A]   | 1     | number of observer arguments
+			String      | \#A   | observer arguments
+			Checkpoint  | 1     | traced rays and observer data, see writeCheckpoint()
+		*/
+		target << SHARD_HEADER;
+		writeInteger( target, shard.mShardIndex );
+		writeInteger( target, shard.mShardCount );
+		writeInteger( target, shard.mFirstRay );
+		writeInteger( target, shard.mExtents.size() );
+		for( auto extent : shard.mExtents )
+			writeInteger( target, extent );
+		for( double support : shard.mSupport )
+			writeFloat( target, support );
+		writeInteger( target, shard.mObserverConfig.size() );
+		for( const auto& argument : shard.mObserverConfig )
+			writeString( target, argument );
+}
+}
+
+void writeCheckpoint( std::ostream& target, const Checkpoint& checkpoint )
+{
+	writeCheckpointInfo( target, checkpoint, checkpoint.mObservers.size() );
+	for( const auto& observer : checkpoint.mObservers )
+	{
+		writeString( target, observer.first );
+		writeString( target, observer.second );
+	}
+}
+
+void writeCheckpoint( std::ostream& target, const Checkpoint& checkpoint, const std::vector<ObserverWriter>& observers )
+{
+	writeCheckpointInfo( target, checkpoint, observers.size() );
+	for( const auto& observer : observers )
+	{
+		writeString( target, observer.first );
+		writeStreamed( target, observer.second );
+	}
+}
+
+Checkpoint readCheckpoint( std::istream& source )
+{
+	std::string header( CHECKPOINT_HEADER.size(), '\0' );
+	source.read( &header[0], header.size() );
+	if( header != CHECKPOINT_HEADER )
+		THROW_EXCEPTION( std::runtime_error, "not a checkpoint file" );
+
+	Checkpoint checkpoint;
+	checkpoint.mGeneratorType = readString( source );
+	readInteger( source, checkpoint.mRequestedParticles );
+	readInteger( source, checkpoint.mRayCount );
+	readInteger( source, checkpoint.mParticleCount );
+	readInteger( source, checkpoint.mStepCount );
+	std::uint64_t observers = readInteger( source );
+	for( std::uint64_t i = 0; i < observers; ++i )
+	{
+		std::string name = readString( source );
+		checkpoint.mObservers.emplace_back( std::move(name), readString( source ) );
+	}
+	return checkpoint;
+}
+
+void writeShardResult( std::ostream& target, const ShardResult& shard )
+{
+	writeShardInfo( target, shard );
+	writeCheckpoint( target, shard.mState );
+}
+
+void writeShardResult( std::ostream& target, const ShardResult& shard, const std::vector<ObserverWriter>& observers )
+{
+	writeShardInfo( target, shard );
+	writeCheckpoint( target, shard.mState, observers );
+}
+
+ShardResult readShardResult( std::istream& source )
+{
+	std::string header( SHARD_HEADER.size(), '\0' );
+	source.read( &header[0], header.size() );
+	if( header != SHARD_HEADER )
+		THROW_EXCEPTION( std::runtime_error, "not a shard file" );
+
+	ShardResult shard;
+	readInteger( source, shard.mShardIndex );
+	readInteger( source, shard.mShardCount );
+	readInteger( source, shard.mFirstRay );
+	std::uint64_t dimension = readInteger( source );
+	if( !source || dimension > 3 )
+		THROW_EXCEPTION( std::runtime_error, "shard file is corrupt" );
+	for( std::uint64_t i = 0; i < dimension; ++i )
+		shard.mExtents.push_back( readInteger( source ) );
+	for( std::uint64_t i = 0; i < dimension; ++i )
+		shard.mSupport.push_back( readFloat( source ) );
+	std::uint64_t arguments = readInteger( source );
+	for( std::uint64_t i = 0; i < arguments; ++i )
+		shard.mObserverConfig.push_back( readString( source ) );
+	shard.mState = readCheckpoint( source );
+	return shard;
+}
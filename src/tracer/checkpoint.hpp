@@ -0,0 +1,70 @@
+#ifndef CHECKPOINT_HPP_INCLUDED
+#define CHECKPOINT_HPP_INCLUDED
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*! \struct Checkpoint
+	\brief State of an interrupted trace, from which tracing can be resumed.
+	\details The tracer writes checkpoints only while all threads are between two rays, so the finished rays are
+			always the first mRayCount rays of the initial condition generator. The observers are stored as the
+			data written by Observer::serialize(), identified by their file names. When a checkpoint is written,
+			the observers are usually serialized directly into the file, see writeCheckpoint().
+*/
+struct Checkpoint
+{
+	std::string mGeneratorType;				//!< type of the initial condition generator
+	std::uint64_t mRequestedParticles = 0;	//!< particle count the generator was configured with
+	std::uint64_t mRayCount = 0;			//!< number of rays that have been started and finished
+	std::uint64_t mParticleCount = 0;		//!< number of finished rays that contributed to the observers
+	std::uint64_t mStepCount = 0;			//!< observed integration steps of the finished rays
+	std::vector<std::pair<std::string, std::string>> mObservers;	//!< file name and serialized data of each observer
+};
+
+/*! \struct ShardResult
+	\brief Results of one shard of a trace that was split over several processes.
+	\details The observers are saved as in a checkpoint, before they are normalized, together with everything the merge
+			tool needs to recreate them. The trajectory numbers of the shard start at one, the merge tool renumbers
+			them according to the ray counts of the preceding shards.
+*/
+struct ShardResult
+{
+	std::uint64_t mShardIndex = 0;
+	std::uint64_t mShardCount = 1;
+	std::uint64_t mFirstRay = 0;					//!< index of the first ray of the shard among all rays
+	std::vector<std::uint64_t> mExtents;			//!< size of the potential grid
+	std::vector<double> mSupport;					//!< support of the potential
+	std::vector<std::string> mObserverConfig;		//!< the command line arguments that configured the observers
+	Checkpoint mState;								//!< the traced rays and the data of the observers
+};
+
+/// file name of an observer and a function that writes its serialized data to a stream.
+typedef std::pair<std::string, std::function<void(std::ostream&)>> ObserverWriter;
+
+/// writes \p checkpoint to \p target, which should be opened in binary mode.
+void writeCheckpoint( std::ostream& target, const Checkpoint& checkpoint );
+
+/// writes \p checkpoint to \p target, with the observer data written directly by \p observers instead of taken
+/// from Checkpoint::mObservers, so that no copy of the serialized observers has to be kept in memory. The length
+/// of each observer's data is filled in afterwards, so \p target has to be seekable.
+void writeCheckpoint( std::ostream& target, const Checkpoint& checkpoint, const std::vector<ObserverWriter>& observers );
+
+/// reads a checkpoint written by writeCheckpoint().
+/// \throw std::runtime_error if \p source does not contain a complete checkpoint.
+Checkpoint readCheckpoint( std::istream& source );
+
+/// writes \p shard to \p target, which should be opened in binary mode.
+void writeShardResult( std::ostream& target, const ShardResult& shard );
+
+/// writes \p shard to \p target, with the observer data written by \p observers, see writeCheckpoint().
+void writeShardResult( std::ostream& target, const ShardResult& shard, const std::vector<ObserverWriter>& observers );
+
+/// reads a shard written by writeShardResult().
+/// \throw std::runtime_error if \p source does not contain a complete shard.
+ShardResult readShardResult( std::istream& source );
+
+#endif // CHECKPOINT_HPP_INCLUDED
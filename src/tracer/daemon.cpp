@@ -0,0 +1,355 @@
+#include "daemon.hpp"
+#include "tracer_factory.h"
+#include "potential.hpp"
+#include "initial_conditions_fwd.hpp"
+#include "dynamics/ray_dynamics.hpp"
+#include "global.hpp"
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace po = boost::program_options;
+
+namespace
+{
+	/// longest request that is accepted, the rest is discarded.
+	const std::size_t MAX_REQUEST_LENGTH = 1 << 16;
+
+	/// creates the directory \p path and its parents, if they do not exist yet.
+	void create_directories( const std::string& path )
+	{
+		for( std::size_t end = path.find( '/', 1 ); ; end = path.find( '/', end + 1 ) )
+		{
+			std::string part = path.substr( 0, end );
+			if( !part.empty() && mkdir( part.c_str(), 0777 ) != 0 && errno != EEXIST )
+				THROW_EXCEPTION( std::runtime_error, "Could not create directory %1%: %2%", part, std::strerror(errno) );
+			if( end == std::string::npos )
+				return;
+		}
+	}
+
+	Potential load_potential( const std::string& file_name )
+	{
+		if( !std::ifstream( file_name, std::ios::in | std::ios::binary ) )
+			THROW_EXCEPTION( std::runtime_error, "Could not open potential file %1%", file_name );
+		return Potential::readFromFile( file_name );
+	}
+
+	/// reads a single line from the socket \p client, without the newline.
+	std::string read_request( int client )
+	{
+		std::string request;
+		char buffer[4096];
+		while( request.find( '\n' ) == std::string::npos && request.size() < MAX_REQUEST_LENGTH )
+		{
+			ssize_t count = recv( client, buffer, sizeof(buffer), 0 );
+			if( count < 0 && errno == EINTR )
+				continue;
+			if( count <= 0 )
+				break;
+			request.append( buffer, count );
+		}
+		return request.substr( 0, request.find( '\n' ) );
+	}
+
+	void send_answer( int client, std::string answer )
+	{
+		answer += "\n";
+		std::size_t sent = 0;
+		while( sent < answer.size() )
+		{
+			// the client may have given up waiting, which must not raise SIGPIPE
+			ssize_t count = send( client, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL );
+			if( count < 0 && errno == EINTR )
+				continue;
+			if( count <= 0 )
+				return;
+			sent += count;
+		}
+	}
+}
+
+TraceJob parseTraceJob( const std::string& command, bool need_potential )
+{
+	TraceJob job;
+	bool no_norm_energy = false;
+	po::options_description desc("Job options");
+	desc.add_options()
+		("num-particles,n", po::value<std::size_t>(&job.mParticleCount))
+		("potential_strength,s", po::value<double>(&job.mStrength))
+		("periodic", po::bool_switch(&job.mPeriodic))
+		("potential", need_potential ? po::value<std::string>(&job.mPotentialFile)->required()
+		                             : po::value<std::string>(&job.mPotentialFile))
+		("incoming", po::value<std::vector<std::string>>(&job.mIncoming)->multitoken())
+		("observers", po::value<std::vector<std::string>>(&job.mObservers)->composing()->multitoken())
+		("dynamics", po::value<std::vector<std::string>>(&job.mDynamics)->composing()->multitoken())
+		("rel-err-bound", po::value<double>(&job.mRelErr))
+		("abs-err-bound", po::value<double>(&job.mAbsErr))
+		("end-time,e", po::value<double>(&job.mEndTime))
+		("result-path,r", po::value<std::string>(&job.mResultPath))
+		("no-norm-energy", po::bool_switch(&no_norm_energy))
+		("threads,t", po::value<std::size_t>(&job.mThreads))
+		("integrator", po::value<std::string>(&job.mIntegrator))
+		("time-step", po::value<double>(&job.mTimeStep))
+		("time-budget", po::value<double>(&job.mTimeBudget))
+	;
+	po::positional_options_description p;
+	p.add("potential", 1);
+
+	po::variables_map vm;
+	try
+	{
+		po::store(po::command_line_parser(po::split_unix(command)).options(desc).positional(p).run(), vm);
+		po::notify(vm);
+	} catch( const po::error& error )
+	{
+		THROW_EXCEPTION( std::invalid_argument, "Invalid trace job: %1%", error.what() );
+	}
+	job.mOverrideStrength = vm.count("potential_strength") != 0;
+	job.mNormalizeEnergy = !no_norm_energy;
+	return job;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                          PotentialCache
+// ---------------------------------------------------------------------------------------------------------------------
+
+PotentialCache::PotentialCache( std::size_t max_bytes, loader_type loader ) :
+	mMaxBytes( max_bytes ), mLoader( loader ? std::move(loader) : load_potential )
+{
+}
+
+PotentialCache::Entry& PotentialCache::get( const std::string& file_name, bool override_strength, double strength )
+{
+	std::string key = file_name;
+	if( override_strength )
+		key += "@" + boost::lexical_cast<std::string>( strength );
+
+	auto found = mIndex.find( key );
+	if( found != mIndex.end() )
+	{
+		++mHits;
+		mEntries.splice( mEntries.begin(), mEntries, found->second );
+		return found->second->second;
+	}
+
+	++mMisses;
+	Potential potential = mLoader( file_name );
+	if( override_strength )
+		potential.setStrength( strength );
+
+	Entry entry;
+	entry.mBytes = potential.getMemorySize();
+	entry.mPotential = std::make_shared<Potential>( std::move(potential) );
+	mEntries.emplace_front( key, std::move(entry) );
+	mIndex[key] = mEntries.begin();
+	mBytes += mEntries.front().second.mBytes;
+
+	// the new potential itself is never evicted, even if it alone exceeds the limit
+	while( mBytes > mMaxBytes && mEntries.size() > 1 )
+	{
+		mBytes -= mEntries.back().second.mBytes;
+		mIndex.erase( mEntries.back().first );
+		mEntries.pop_back();
+	}
+	return mEntries.front().second;
+}
+
+std::size_t PotentialCache::size() const
+{
+	return mEntries.size();
+}
+
+std::size_t PotentialCache::getBytes() const
+{
+	return mBytes;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                          TraceDaemon
+// ---------------------------------------------------------------------------------------------------------------------
+
+TraceDaemon::TraceDaemon( std::string socket_path, std::size_t cache_bytes, PotentialCache::loader_type loader ) :
+	mSocketPath( std::move(socket_path) ), mCache( cache_bytes, std::move(loader) )
+{
+}
+
+TraceDaemon::~TraceDaemon()
+{
+	if( mSocket >= 0 )
+	{
+		close( mSocket );
+		unlink( mSocketPath.c_str() );
+	}
+}
+
+void TraceDaemon::run()
+{
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	if( mSocketPath.size() >= sizeof(address.sun_path) )
+		THROW_EXCEPTION( std::runtime_error, "Socket path %1% is too long", mSocketPath );
+	std::strcpy( address.sun_path, mSocketPath.c_str() );
+
+	mSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( mSocket < 0 )
+		THROW_EXCEPTION( std::runtime_error, "Could not create socket: %1%", std::strerror(errno) );
+
+	// a socket file that nobody listens on is left over from a daemon that did not shut down cleanly
+	if( connect( mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address) ) == 0 )
+	{
+		close( mSocket );
+		mSocket = -1;
+		THROW_EXCEPTION( std::runtime_error, "Another daemon is already listening on %1%", mSocketPath );
+	}
+	close( mSocket );
+	unlink( mSocketPath.c_str() );
+
+	mSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( mSocket < 0 || bind( mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address) ) != 0 ||
+		listen( mSocket, SOMAXCONN ) != 0 )
+	{
+		std::string error = std::strerror(errno);
+		if( mSocket >= 0 )
+			close( mSocket );
+		mSocket = -1;
+		THROW_EXCEPTION( std::runtime_error, "Could not listen on %1%: %2%", mSocketPath, error );
+	}
+
+	std::cout << "listening on " << mSocketPath << std::endl;
+	while( !mStop )
+	{
+		// wake up regularly, so that stop() is noticed
+		pollfd listener{ mSocket, POLLIN, 0 };
+		if( poll( &listener, 1, 200 ) <= 0 )
+			continue;
+		int client = accept( mSocket, nullptr, nullptr );
+		if( client < 0 )
+			continue;
+
+		// a client that never finishes its request must not block the daemon
+		timeval timeout{ 10, 0 };
+		setsockopt( client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout) );
+		send_answer( client, handleRequest( read_request( client ) ) );
+		close( client );
+	}
+
+	// clients that connect from now on fail right away, instead of waiting for an answer
+	close( mSocket );
+	mSocket = -1;
+	unlink( mSocketPath.c_str() );
+}
+
+void TraceDaemon::stop()
+{
+	mStop = true;
+	if( Tracer* tracer = mRunningTracer.load() )
+		tracer->requestStop();
+}
+
+std::string TraceDaemon::handleRequest( const std::string& request )
+{
+	std::string command = boost::algorithm::trim_copy( request );
+	if( command.empty() )
+		return "error empty request";
+	if( command == "shutdown" )
+	{
+		mStop = true;
+		return "ok shutdown";
+	}
+
+	try
+	{
+		auto start = std::chrono::steady_clock::now();
+		TraceResult result = runJob( parseTraceJob( command ), command );
+		std::ostringstream answer;
+		answer << "ok " << result.mParticleCount << " "
+			   << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return answer.str();
+	} catch( const std::exception& error )
+	{
+		// the answer has to fit on a single line
+		std::string message = error.what();
+		std::replace( message.begin(), message.end(), '\n', ' ' );
+		std::cerr << "job failed: " << message << "\n";
+		return "error " + message;
+	}
+}
+
+TraceResult TraceDaemon::runJob( const TraceJob& job, const std::string& command )
+{
+	auto start = std::chrono::steady_clock::now();
+	PotentialCache::Entry& entry = mCache.get( job.mPotentialFile, job.mOverrideStrength, job.mStrength );
+
+	TracerFactory factory;
+	factory.setPotential( entry.mPotential );
+	factory.setPeriodicBondaries( job.mPeriodic );
+	factory.setObserverConfig( job.mObservers );
+	factory.setDynamicsConfig( job.mDynamics );
+	factory.setThreadCount( job.mThreads );
+	factory.setErrorBounds( job.mAbsErr, job.mRelErr );
+	factory.setEndTime( job.mEndTime );
+	factory.setIntegrator( job.mIntegrator );
+	factory.setTimeStep( job.mTimeStep );
+
+	// besides the potential, the dynamics only depend on their configuration, the boundaries and the monodromy
+	std::string dynamics_key = boost::algorithm::join( job.mDynamics, " " );
+	dynamics_key += job.mPeriodic ? " periodic" : "";
+	dynamics_key += factory.needsMonodromy() ? " monodromy" : "";
+	auto& dynamics = entry.mDynamics[dynamics_key];
+	if( !dynamics )
+		dynamics = factory.createDynamics();
+	factory.setDynamics( dynamics );
+
+	auto tracer = factory.createTracer();
+	auto generator = createInitialConditionGenerator( tracer->getDimension(), job.mIncoming );
+	InitialConditionConfiguration config;
+	config.setParticleCount( job.mParticleCount ).setEnergyNormalization( job.mNormalizeEnergy );
+	tracer->setTimeBudget( job.mTimeBudget );
+	create_directories( job.mResultPath );
+	double setup_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	TraceResult result;
+	mRunningTracer = tracer.get();
+	try
+	{
+		// stop() might have been called before the tracer was published
+		if( mStop )
+			tracer->requestStop();
+		result = tracer->trace( generator, config );
+	} catch( ... )
+	{
+		mRunningTracer = nullptr;
+		throw;
+	}
+	mRunningTracer = nullptr;
+	bool saved = tracer->saveObservers( job.mResultPath );
+
+	std::fstream info( job.mResultPath + "/config.txt", std::fstream::out );
+	info << "# daemon job\n" << command << "\n\n# potential data\n";
+	info << factory.getPotentialInfo() << "\n";
+	info << "\n# tracing info\n";
+	info << "\n  energy normalization " << job.mNormalizeEnergy << "\n";
+	info << "# setup time [s] " << setup_time << "\n";
+	info << "# integration steps " << result.mStepCount << "\n";
+	info << "# stopped early " << result.mStoppedEarly << "\n";
+	info << "# particles " << result.mParticleCount << "\n";
+
+	if( !saved )
+		THROW_EXCEPTION( std::runtime_error, "Could not save all results to %1%", job.mResultPath );
+	return result;
+}
@@ -0,0 +1,148 @@
+#ifndef DAEMON_HPP_INCLUDED
+#define DAEMON_HPP_INCLUDED
+
+#include "tracer.hpp"
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+class Potential;
+class RayDynamics;
+
+/*! \file daemon.hpp
+	\brief Tracer service that keeps potentials loaded between traces.
+	\details A tracer started with `--daemon <socket>` listens on a local unix socket instead of tracing. Each
+			connection sends a single line, which is either `shutdown` or the command line of a trace, with the same
+			options as the tracer (see parseTraceJob()). The daemon answers with a single line, `ok <particles>
+			<seconds>` once the results are saved, or `error <message>`. Loaded potentials and the dynamics created
+			for them are kept in a PotentialCache, so repeated traces on the same potential skip the setup.
+*/
+
+/// a single trace requested from the daemon.
+struct TraceJob
+{
+	std::string mPotentialFile;
+	bool mOverrideStrength = false;		//!< whether mStrength replaces the strength of the potential file
+	double mStrength = 0.1;
+	std::size_t mParticleCount = 1000;
+	std::vector<std::string> mIncoming = {"planar"};
+	std::vector<std::string> mObservers = {"density"};
+	std::vector<std::string> mDynamics = {"particle_potential"};
+	std::string mResultPath = ".";
+	double mEndTime = 1.0;
+	double mAbsErr = 1e-6;
+	double mRelErr = 1e-6;
+	double mTimeStep = -1;				//!< time step of the integrator, the default if not positive
+	std::string mIntegrator = "adaptive";
+	bool mPeriodic = false;
+	bool mNormalizeEnergy = true;
+	std::size_t mThreads = -1;			//!< maximum number of threads of the shared pool used by the trace
+	double mTimeBudget = 0;
+};
+
+/*! \brief parses \p command, the arguments of a tracer call, into a trace job.
+	\details Understands the options of the tracer that describe a single trace: the potential file, `-s`, `-n`,
+			`--incoming`, `--observers`, `--dynamics`, `-r`, `-e`, `--periodic`, `--no-norm-energy`, the error bounds,
+			`--integrator`, `--time-step`, `--threads` and `--time-budget`. Arguments are separated by whitespace
+			and may be quoted. If \p need_potential is false, the potential file may be omitted, e.g. if the
+			potential is already in memory.
+	\throw std::invalid_argument if \p command contains other options or no potential.
+*/
+TraceJob parseTraceJob( const std::string& command, bool need_potential = true );
+
+/*! \class PotentialCache
+	\brief Least recently used cache of potentials, together with the dynamics created for them.
+	\details Potentials are identified by their file and strength, as the strength is applied to the grids. The
+			memory of the cached potentials is kept below a limit by evicting the least recently used ones, but the
+			most recently requested potential is always kept. The dynamics share the grids of their potential, so
+			they do not count towards the limit.
+*/
+class PotentialCache : boost::noncopyable
+{
+public:
+	/// loads the potential from a file.
+	using loader_type = std::function<Potential(const std::string&)>;
+
+	/// a cached potential.
+	struct Entry
+	{
+		std::shared_ptr<Potential> mPotential;
+		std::map<std::string, std::shared_ptr<RayDynamics>> mDynamics;	//!< dynamics by their configuration
+		std::size_t mBytes = 0;
+	};
+
+	/// creates a cache that keeps at most \p max_bytes of potentials. If not given, \p loader reads the potential
+	/// files with Potential::readFromFile().
+	explicit PotentialCache( std::size_t max_bytes, loader_type loader = loader_type() );
+
+	/// \brief gets the potential in \p file_name, scaled to \p strength if \p override_strength is set. Loads the
+	///			potential on a cache miss, which may evict other potentials. The entry stays valid until the next
+	///			call.
+	Entry& get( const std::string& file_name, bool override_strength, double strength );
+
+	/// number of cached potentials.
+	std::size_t size() const;
+	/// memory used by the cached potentials.
+	std::size_t getBytes() const;
+	/// number of get() calls that found their potential in the cache.
+	std::size_t getHits() const { return mHits; }
+	/// number of get() calls that had to load their potential.
+	std::size_t getMisses() const { return mMisses; }
+
+private:
+	using list_type = std::list<std::pair<std::string, Entry>>;
+
+	std::size_t mMaxBytes;
+	loader_type mLoader;
+	list_type mEntries;										//!< most recently used first
+	std::map<std::string, list_type::iterator> mIndex;		//!< the entries by file and strength
+	std::size_t mBytes = 0;
+	std::size_t mHits = 0;
+	std::size_t mMisses = 0;
+};
+
+/*! \class TraceDaemon
+	\brief Serves trace jobs on a unix socket, see daemon.hpp.
+	\details Jobs are run one after another, as observers number their rays with a counter that is shared by all
+			tracers. Each trace runs on the global ThreadPool, which is shared with loading the potentials and saving
+			the results. Clients that connect while a job is running wait in the backlog of the socket.
+*/
+class TraceDaemon : boost::noncopyable
+{
+public:
+	/// creates a daemon for \p socket_path, whose cache keeps at most \p cache_bytes of potentials. The socket is
+	/// only opened by run().
+	TraceDaemon( std::string socket_path, std::size_t cache_bytes, PotentialCache::loader_type loader = {} );
+	~TraceDaemon();
+
+	/// \brief listens on the socket and answers requests until stop() is called or a `shutdown` request arrives.
+	/// \throw std::runtime_error if the socket cannot be opened.
+	void run();
+
+	/// \brief makes run() return, after stopping the running trace early as with Tracer::requestStop().
+	/// \details Only sets atomic flags, so this may be called from a signal handler.
+	void stop();
+
+	/// handles a single request line and returns the answer, without the trailing newline.
+	std::string handleRequest( const std::string& request );
+
+	/// the cache of loaded potentials.
+	const PotentialCache& getCache() const { return mCache; }
+
+private:
+	/// runs \p job and saves its results, \p command is recorded in the config.txt of the job.
+	TraceResult runJob( const TraceJob& job, const std::string& command );
+
+	std::string mSocketPath;
+	int mSocket = -1;
+	PotentialCache mCache;
+	std::atomic<bool> mStop{false};
+	std::atomic<Tracer*> mRunningTracer{nullptr};
+};
+
+#endif // DAEMON_HPP_INCLUDED
@@ -128,3 +128,24 @@ double ParticleInPotentialDynamics::getEnergy( const State& state ) const
 	return epot + ekin;
 
 }
+
+ParticleInPotentialDynamics::ParticleInPotentialDynamics(const ParticleInPotentialDynamics& other):
+	mDimension( other.mDimension ),
+	mPeriodicBoundaries( other.mPeriodicBoundaries ),
+	mTraceMonodromy( other.mTraceMonodromy ),
+	mScalingFactor( other.mScalingFactor ),
+	mGridSize( other.mGridSize ),
+	mPotential( other.mPotential.clone() ),
+	mFirstDerGrid( other.mFirstDerGrid.size() ),
+	mSecondDerGrid( other.mSecondDerGrid.size() )
+{
+	for(unsigned i = 0; i < mFirstDerGrid.size(); ++i)
+		mFirstDerGrid[i] = other.mFirstDerGrid[i].clone();
+	for(unsigned i = 0; i < mSecondDerGrid.size(); ++i)
+		mSecondDerGrid[i] = other.mSecondDerGrid[i].clone();
+}
+
+std::shared_ptr<RayDynamics> ParticleInPotentialDynamics::replicate() const
+{
+	return std::shared_ptr<RayDynamics>( new ParticleInPotentialDynamics(*this) );
+}
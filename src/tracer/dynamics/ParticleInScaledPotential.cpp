@@ -141,3 +141,25 @@ double ParticleInScaledPotentialDynamics::getEnergy( const State& state ) const
 	double ekin = 0.5 * std::inner_product( state.getVelocity().begin(), state.getVelocity().end(), state.getVelocity().begin(), 0.0 );
 	return epot + ekin;
 }
+
+ParticleInScaledPotentialDynamics::ParticleInScaledPotentialDynamics(const ParticleInScaledPotentialDynamics& other):
+	mDimension( other.mDimension ),
+	mPeriodicBoundaries( other.mPeriodicBoundaries ),
+	mTraceMonodromy( other.mTraceMonodromy ),
+	mPotScaleFactor( other.mPotScaleFactor ),
+	mScalingFactor( other.mScalingFactor ),
+	mGridSize( other.mGridSize ),
+	mPotential( other.mPotential.clone() ),
+	mFirstDerGrid( other.mFirstDerGrid.size() ),
+	mSecondDerGrid( other.mSecondDerGrid.size() )
+{
+	for(unsigned i = 0; i < mFirstDerGrid.size(); ++i)
+		mFirstDerGrid[i] = other.mFirstDerGrid[i].clone();
+	for(unsigned i = 0; i < mSecondDerGrid.size(); ++i)
+		mSecondDerGrid[i] = other.mSecondDerGrid[i].clone();
+}
+
+std::shared_ptr<RayDynamics> ParticleInScaledPotentialDynamics::replicate() const
+{
+	return std::shared_ptr<RayDynamics>( new ParticleInScaledPotentialDynamics(*this) );
+}
@@ -28,6 +28,10 @@ public:
 	
 	/// gets the states total energy.
 	virtual double getEnergy( const State& state ) const = 0;
+	
+	/// creates a copy of these dynamics whose grids are stored in new memory, so that they are placed on the NUMA
+	/// node of the calling thread. Returns nullptr if the dynamics cannot be copied, the original is used then.
+	virtual std::shared_ptr<RayDynamics> replicate() const { return nullptr; }
 };
 
 
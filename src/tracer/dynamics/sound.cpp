@@ -110,3 +110,25 @@ double Sound::getEnergy( const State& ) const
 {
 	return 0;
 }
+
+Sound::Sound(const Sound& other):
+	mDimension( other.mDimension ),
+	mPeriodicBoundaries( other.mPeriodicBoundaries ),
+	mTraceMonodromy( other.mTraceMonodromy ),
+	mPotScaleFactor( other.mPotScaleFactor ),
+	mScalingFactor( other.mScalingFactor ),
+	mGridSize( other.mGridSize ),
+	mSpeedOfSound( other.mSpeedOfSound ),
+	mVelocities( other.mVelocities.size() ),
+	mVelDerivatives( other.mVelDerivatives.size() )
+{
+	for(unsigned i = 0; i < mVelocities.size(); ++i)
+		mVelocities[i] = other.mVelocities[i].clone();
+	for(unsigned i = 0; i < mVelDerivatives.size(); ++i)
+		mVelDerivatives[i] = other.mVelDerivatives[i].clone();
+}
+
+std::shared_ptr<RayDynamics> Sound::replicate() const
+{
+	return std::shared_ptr<RayDynamics>( new Sound(*this) );
+}
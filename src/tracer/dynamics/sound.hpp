@@ -20,8 +20,12 @@ public:
 	bool hasPeriodicBoundary() const override;
 	void normalizeEnergy(State& state, double energy) const override;
 	double getEnergy( const State& state ) const override;
+	std::shared_ptr<RayDynamics> replicate() const override;
 	
 private:
+	/// deep copy, which allocates new grids. Used by replicate().
+	Sound(const Sound& other);
+
 	std::size_t mDimension;
 	bool mPeriodicBoundaries;
 	bool mTraceMonodromy;
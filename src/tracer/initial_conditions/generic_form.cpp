@@ -4,6 +4,14 @@
 namespace init_cond
 {
 
+/// returns the interpreter to the pool when the evaluation ends, also by an exception.
+struct GenericCaustic2D::LuaLease
+{
+	const GenericCaustic2D& generator;
+	LuaStatePtr state;
+	~LuaLease() { generator.releaseLuaState( std::move(state) ); }
+};
+
 /*! \page ic_cst Generic Caustic Initial Condition Generation
  *		Initial manifold form: f(x) = g(x,y) + (x^2 + y^2) / 2 Z0
  *		Initial velocity: two vectors on manifold: a = (x + d, y, f) - (x, y, f); b = (x, y + d, f) - (x, y, f)
@@ -13,29 +21,68 @@ namespace init_cond
 */
 GenericCaustic2D::GenericCaustic2D(std::size_t dim, double boundary, double scale) : 
     InitialConditionGenerator(dim, 2, "generic"),
-    mState( luaL_newstate() ),
     size(boundary), /// \todo even the name is wrong, what is this?
     mUVScale(scale)
 {
-	luaL_openlibs( mState );
 	// does not make much sense in 2d, but will work so do not disallow it
 	if(dim < 2)
 		BOOST_THROW_EXCEPTION( std::runtime_error("generic 2d requires at least 2 dimensions") );
 }
 
+GenericCaustic2D::~GenericCaustic2D() = default;
+
+void GenericCaustic2D::LuaStateDeleter::operator()(lua_State* state) const
+{
+	lua_close( state );
+}
+
+GenericCaustic2D::LuaStatePtr GenericCaustic2D::acquireLuaState() const
+{
+	{
+		std::lock_guard<std::mutex> lock( mLuaMutex );
+		if(!mLuaStates.empty())
+		{
+			LuaStatePtr state = std::move( mLuaStates.back() );
+			mLuaStates.pop_back();
+			return state;
+		}
+	}
+
+	LuaStatePtr state( luaL_newstate() );
+	luaL_openlibs( state.get() );
+	if(luaL_dostring( state.get(), mScript.c_str() ))
+	{
+		const char* error = lua_tostring(state.get(), -1);
+		std::cerr << error << "\n";
+	}
+	return state;
+}
+
+void GenericCaustic2D::releaseLuaState(LuaStatePtr state) const
+{
+	std::lock_guard<std::mutex> lock( mLuaMutex );
+	mLuaStates.push_back( std::move(state) );
+}
+
 double GenericCaustic2D::getHeight(double u, double v) const
 {
-	lua_getglobal(mState, "f");
-	assert(lua_isfunction(mState, -1));
-	lua_pushnumber(mState, u);
-	lua_pushnumber(mState, v);
-	if(lua_pcall(mState, 2, 1, 0))
+	LuaLease lease{*this, acquireLuaState()};
+	return evaluate(lease.state.get(), u, v);
+}
+
+double GenericCaustic2D::evaluate(lua_State* state, double u, double v) const
+{
+	lua_getglobal(state, "f");
+	assert(lua_isfunction(state, -1));
+	lua_pushnumber(state, u);
+	lua_pushnumber(state, v);
+	if(lua_pcall(state, 2, 1, 0))
 	{
-		const char* error = lua_tostring(mState, -1);
+		const char* error = lua_tostring(state, -1);
 		std::cerr << error << "\n";
 	}
-	double result = lua_tonumber(mState, -1);
-	lua_pop(mState, 1);
+	double result = lua_tonumber(state, -1);
+	lua_pop(state, 1);
 	return result;
 }
 
@@ -64,11 +111,13 @@ double GenericCaustic2D::getHeight(double u, double v) const
 	ray_velocity[1] = 0;
 	ray_velocity[2] = 0;
 
-	double h = getHeight(p1v, p2v);
+	LuaLease lease{*this, acquireLuaState()};
+	lua_State* state = lease.state.get();
+	double h = evaluate(state, p1v, p2v);
 	ray_position[0] = h;
 	const double delta = 1e-6;
-	ray_velocity[1] = -(getHeight( p1v + delta, p2v ) - h) / delta;
-	ray_velocity[2] = -(getHeight( p1v, p2v +delta ) - h) / delta;
+	ray_velocity[1] = -(evaluate( state, p1v + delta, p2v ) - h) / delta;
+	ray_velocity[2] = -(evaluate( state, p1v, p2v +delta ) - h) / delta;
 
 	// trace back to initial plane
 	double tx = (ray_position[0]) / ray_velocity[0];
@@ -89,11 +138,13 @@ void GenericCaustic2D::setFunction( std::string terms )
 {
     std::string script = "function f(u, v)\n";
 	script += "return " + terms + "\n end\n";
-	if(luaL_dostring( mState, script.c_str() ))
+
+	// interpreters that have loaded the previous function are not used anymore
 	{
-		const char* error = lua_tostring(mState, -1);
-		std::cerr << error << "\n";
+		std::lock_guard<std::mutex> lock( mLuaMutex );
+		mLuaStates.clear();
 	}
+	mScript = script;
 	getHeight(0,0);
 }
 
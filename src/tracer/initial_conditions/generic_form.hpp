@@ -1,6 +1,10 @@
 #ifndef GENERIC_FORM_HPP_INCLUDED
 #define GENERIC_FORM_HPP_INCLUDED
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "initial_conditions.hpp"
 
 extern "C"
@@ -15,16 +19,37 @@ class GenericCaustic2D final : public InitialConditionGenerator
 {
 public:
 	GenericCaustic2D(std::size_t dim, double boundary, double scale);
+	~GenericCaustic2D();
 
 	double getHeight(double u, double v) const;
 
 	/// generate next IC
     void generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& params) const override;
+	/// every concurrent generate() call evaluates the height function in its own lua interpreter.
+	bool isGenerationReentrant() const override { return true; }
 	
 	void setFunction( std::string terms );
 
 private:
-	lua_State* mState;
+	struct LuaStateDeleter
+	{
+		void operator()(lua_State* state) const;
+	};
+	using LuaStatePtr = std::unique_ptr<lua_State, LuaStateDeleter>;
+	struct LuaLease;
+
+	/// takes an idle interpreter from the pool, or creates one that has loaded the current script.
+	LuaStatePtr acquireLuaState() const;
+	/// returns an interpreter to the pool.
+	void releaseLuaState(LuaStatePtr state) const;
+	/// evaluates the height function in \p state.
+	double evaluate(lua_State* state, double u, double v) const;
+
+	std::string mScript;
+	/// idle interpreters that have loaded mScript. Lua states cannot be used by several threads at once, so there
+	/// are as many as there have been concurrent calls to generate().
+	mutable std::vector<LuaStatePtr> mLuaStates;
+	mutable std::mutex mLuaMutex;
 	double size;
 	double mUVScale = 1;
 };
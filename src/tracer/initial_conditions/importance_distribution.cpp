@@ -0,0 +1,164 @@
+#include "importance_distribution.hpp"
+#include "global.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <lua.hpp>
+
+using namespace init_cond;
+
+namespace
+{
+    /// default grid resolution, such that the table has a few thousand to ten thousand entries.
+    std::size_t defaultResolution(std::size_t dimension)
+    {
+        switch(dimension)
+        {
+            case 1: return 4096;
+            case 2: return 128;
+            default: return 24;
+        }
+    }
+}
+
+ImportanceDistribution::ImportanceDistribution(std::size_t dimension,
+                                               const std::function<double(const manifold_pos&)>& density,
+                                               std::size_t resolution) :
+        mDimension(dimension),
+        mResolution(resolution == 0 ? defaultResolution(dimension) : resolution)
+{
+    if(dimension == 0 || dimension > 3)
+        THROW_EXCEPTION(std::invalid_argument, "Importance sampling supports 1 to 3 manifold dimensions, got %1%",
+                        dimension);
+
+    std::size_t cells = 1;
+    for(unsigned i = 0; i < mDimension; ++i)
+        cells *= mResolution;
+
+    // tabulate the density at the cell centers
+    mDensity.resize(cells);
+    manifold_pos center(mDimension);
+    for(std::size_t cell = 0; cell < cells; ++cell)
+    {
+        std::size_t rest = cell;
+        for(int i = mDimension - 1; i >= 0; --i)
+        {
+            center[i] = (rest % mResolution + 0.5) / mResolution;
+            rest /= mResolution;
+        }
+        double value = density(center);
+        if(!std::isfinite(value) || value < 0)
+            THROW_EXCEPTION(std::invalid_argument, "Invalid importance density %1% in cell %2%", value, cell);
+        mDensity[cell] = value;
+    }
+
+    // marginal masses, summing over the last coordinate to get the marginal of the coordinates before it.
+    std::vector<std::vector<double>> masses(mDimension);
+    masses.back() = mDensity;
+    for(int k = mDimension - 2; k >= 0; --k)
+    {
+        const auto& finer = masses[k + 1];
+        auto& coarser = masses[k];
+        coarser.assign(finer.size() / mResolution, 0.0);
+        for(std::size_t i = 0; i < finer.size(); ++i)
+            coarser[i / mResolution] += finer[i];
+    }
+
+    double total = std::accumulate(masses.front().begin(), masses.front().end(), 0.0);
+    if(!(total > 0))
+        THROW_EXCEPTION(std::invalid_argument, "Importance density vanishes everywhere");
+
+    // cumulative sums within each row
+    mCumulative.resize(mDimension);
+    for(unsigned k = 0; k < mDimension; ++k)
+    {
+        mCumulative[k] = masses[k];
+        for(std::size_t row = 0; row < mCumulative[k].size(); row += mResolution)
+            std::partial_sum(mCumulative[k].begin() + row, mCumulative[k].begin() + row + mResolution,
+                             mCumulative[k].begin() + row);
+    }
+
+    for(auto& value : mDensity)
+        value *= cells / total;
+}
+
+std::size_t ImportanceDistribution::getDimension() const
+{
+    return mDimension;
+}
+
+std::size_t ImportanceDistribution::getResolution() const
+{
+    return mResolution;
+}
+
+double ImportanceDistribution::transform(manifold_pos& position) const
+{
+    std::size_t prefix = 0;
+    for(unsigned k = 0; k < mDimension; ++k)
+    {
+        auto row = mCumulative[k].begin() + prefix * mResolution;
+        double target = position[k] * row[mResolution - 1];
+
+        // the first cell whose cumulative probability exceeds the target has a positive mass.
+        std::size_t cell = std::upper_bound(row, row + mResolution, target) - row;
+        cell = std::min(cell, mResolution - 1);
+        double before = cell > 0 ? row[cell - 1] : 0.0;
+        double mass = row[cell] - before;
+        double fraction = mass > 0 ? (target - before) / mass : 0.5;
+
+        position[k] = (cell + std::min(std::max(fraction, 0.0), 1.0)) / mResolution;
+        prefix = prefix * mResolution + cell;
+    }
+    return 1.0 / mDensity[prefix];
+}
+
+double ImportanceDistribution::getDensity(const manifold_pos& position) const
+{
+    std::size_t cell = 0;
+    for(unsigned k = 0; k < mDimension; ++k)
+    {
+        auto index = static_cast<std::size_t>(position[k] * mResolution);
+        cell = cell * mResolution + std::min(index, mResolution - 1);
+    }
+    return mDensity[cell];
+}
+
+namespace init_cond
+{
+    std::shared_ptr<const ImportanceDistribution> createImportanceDistribution(const std::string& expression,
+                                                                               std::size_t dimension)
+    {
+        std::unique_ptr<lua_State, decltype(&lua_close)> state(luaL_newstate(), &lua_close);
+        luaL_openlibs(state.get());
+
+        std::string script = "function f(u, v, w)\nreturn " + expression + "\nend\n";
+        if(luaL_dostring(state.get(), script.c_str()))
+            THROW_EXCEPTION(std::invalid_argument, "Invalid importance density '%1%': %2%", expression,
+                            lua_tostring(state.get(), -1));
+
+        auto density = [&](const manifold_pos& position)
+        {
+            lua_State* L = state.get();
+            lua_getglobal(L, "f");
+            for(unsigned i = 0; i < 3; ++i)
+            {
+                if(i < position.size())
+                    lua_pushnumber(L, position[i]);
+                else
+                    lua_pushnil(L);
+            }
+            if(lua_pcall(L, 3, 1, 0))
+                THROW_EXCEPTION(std::invalid_argument, "Error evaluating importance density '%1%': %2%", expression,
+                                lua_tostring(L, -1));
+            if(!lua_isnumber(L, -1))
+                THROW_EXCEPTION(std::invalid_argument, "Importance density '%1%' does not evaluate to a number",
+                                expression);
+            double result = lua_tonumber(L, -1);
+            lua_pop(L, 1);
+            return result;
+        };
+
+        return std::make_shared<ImportanceDistribution>(dimension, density);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef IMPORTANCE_DISTRIBUTION_HPP_INCLUDED
+#define IMPORTANCE_DISTRIBUTION_HPP_INCLUDED
+
+/// \file
+/// Non-uniform distribution of the rays on the initial manifold, compensated by ray weights.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "initial_conditions.hpp"
+
+namespace init_cond
+{
+    /*! \class ImportanceDistribution
+     *  \brief Distributes the rays on the initial manifold according to a user supplied density.
+     *  \details The density is tabulated on a regular grid of the unit cube and treated as piecewise constant. A point
+     *          that is uniformly distributed in the unit cube is mapped to the density by sampling the coordinates one
+     *          after the other from the conditional distributions, using their inverse cumulative distribution
+     *          functions. This map is continuous and monotonic in each coordinate, so a lattice or a low discrepancy
+     *          sequence stays stratified.
+     *
+     *          Each ray gets the importance weight 1/p, where p is the density normalized to a mean of one. Regions
+     *          where the density vanishes receive no rays. Since weighted observers normalize their results by the
+     *          total weight, the result then describes a source that only emits where the density is positive.
+     */
+    class ImportanceDistribution
+    {
+    public:
+        /*! \param dimension dimension of the manifold.
+         *  \param density unnormalized density. Evaluated once for each grid cell, at the cell centers.
+         *  \param resolution number of grid cells per dimension. If zero, a default depending on the dimension is used.
+         *  \throw std::invalid_argument if the density is negative or not finite somewhere, or zero everywhere.
+         */
+        ImportanceDistribution(std::size_t dimension, const std::function<double(const manifold_pos&)>& density,
+                               std::size_t resolution = 0);
+
+        std::size_t getDimension() const;
+        std::size_t getResolution() const;
+
+        /// maps the uniformly distributed point \p position to the density, in place, and returns its importance weight.
+        double transform(manifold_pos& position) const;
+
+        /// gets the density at \p position, normalized to a mean of one over the unit cube.
+        double getDensity(const manifold_pos& position) const;
+
+    private:
+        std::size_t mDimension;
+        std::size_t mResolution;
+
+        /// normalized density of each cell, the first coordinate varying slowest.
+        std::vector<double> mDensity;
+
+        /// mCumulative[k] contains, for each index (i_0, ..., i_{k-1}) of the first k coordinates, the cumulative
+        /// probabilities over i_k, of the marginal distribution of the first k+1 coordinates.
+        std::vector<std::vector<double>> mCumulative;
+    };
+
+    /*! \brief creates an importance distribution from a lua expression.
+     *  \param expression density in terms of the manifold coordinates u, v and w, in lua syntax. Conditions can be
+     *         written as `(u > 0.4 and u < 0.6) and 1 or 0`.
+     *  \throw std::invalid_argument if the expression cannot be evaluated or does not describe a valid density.
+     */
+    std::shared_ptr<const ImportanceDistribution> createImportanceDistribution(const std::string& expression,
+                                                                               std::size_t dimension);
+}
+
+#endif // IMPORTANCE_DISTRIBUTION_HPP_INCLUDED
@@ -4,6 +4,10 @@
 #include "generic_form.hpp"
 #include "planar_wave.hpp"
 #include "radial_wave.hpp"
+#include "manifold_sampler.hpp"
+#include "manifold_refinement.hpp"
+#include "importance_distribution.hpp"
+#include "ray_file.hpp"
 #include "factory/builder_base.hpp"
 #include <boost/numeric/ublas/io.hpp>
 
@@ -12,10 +16,59 @@ using args::ArgumentSpec;
 
 namespace
 {
-    class GenericInitCondBuilder final : public InitBuilder
+    /// base class for builders of generators that support placing the rays with a ManifoldSampler, ManifoldRefinement
+    /// or ImportanceDistribution.
+    class SampledInitBuilder : public InitBuilder
     {
     public:
-        GenericInitCondBuilder() : BuilderBase("generic")
+        explicit SampledInitBuilder(std::string name) : BuilderBase(std::move(name))
+        {
+            BuilderBaseType::args() << ArgumentSpec("sampling").optional().store(mSampling)
+                    .description("'lattice'|'sobol'|'sobol_scrambled'|'r2'|'r2_shifted'\n"
+                                 "How the rays are placed on the initial manifold. lattice uses a regular grid, the "
+                                 "others low discrepancy sequences, which converge faster for smooth observables.");
+            BuilderBaseType::args() << ArgumentSpec("sampling_seed").optional().store(mSeed)
+                    .description("Seed for the randomization of sobol_scrambled and r2_shifted sampling.");
+            BuilderBaseType::args() << ArgumentSpec("refine_levels").optional().store(mRefineLevels)
+                    .description("If positive, start with a coarse lattice and subdivide the cells in which neighbouring "
+                                 "rays diverge up to this many times. The rays are weighted by their cell size.");
+            BuilderBaseType::args() << ArgumentSpec("refine_threshold").optional().store(mRefineThreshold)
+                    .description("Distance between the final positions of neighbouring rays above which a cell is "
+                                 "refined.");
+            BuilderBaseType::args() << ArgumentSpec("importance").optional().store(mImportance)
+                    .description("Density of the rays on the initial manifold as a lua expression of the manifold "
+                                 "coordinates u, v in [0, 1], e.g. '(u > 0.2 and u < 0.3) and 1 or 0'. For radial "
+                                 "waves, u is the angle / 2pi. Rays are weighted by the inverse density, which "
+                                 "is taken into account by all observers that accumulate over rays.");
+        }
+
+    protected:
+        template<class T>
+        std::unique_ptr<InitialConditionGenerator> applySampling(std::unique_ptr<T> generator) const
+        {
+            generator->setSampler( createManifoldSampler(mSampling, generator->getManifoldDimension(), mSeed) );
+            if(mRefineLevels > 0)
+            {
+                generator->setRefinement( std::make_shared<ManifoldRefinement>(generator->getManifoldDimension(),
+                                                                               mRefineThreshold, mRefineLevels) );
+            }
+            if(!mImportance.empty())
+                generator->setImportance( createImportanceDistribution(mImportance, generator->getManifoldDimension()) );
+            return std::move(generator);
+        }
+
+    private:
+        std::string mImportance;
+        std::string mSampling = "lattice";
+        unsigned mSeed = 0;
+        unsigned mRefineLevels = 0;
+        double mRefineThreshold = 0.01;
+    };
+
+    class GenericInitCondBuilder final : public SampledInitBuilder
+    {
+    public:
+        GenericInitCondBuilder() : SampledInitBuilder("generic")
         {
             BuilderBaseType::args().description("Define an initial wavefront in terms of local coordinates u and v in lua syntax, "
                                        "and this generator will generate rays starting from that wavefront.");
@@ -29,7 +82,7 @@ namespace
         {
             auto res = make_unique<GenericCaustic2D>( dimension, mBoundary, mScale );
             res->setFunction( mTerm );
-            return std::move(res);
+            return applySampling( std::move(res) );
         }
 
         double mBoundary = 0.0;
@@ -37,10 +90,10 @@ namespace
         std::string mTerm = "";
     };
 
-    class PlanarInitCondBuilder final : public InitBuilder
+    class PlanarInitCondBuilder final : public SampledInitBuilder
     {
     public:
-        PlanarInitCondBuilder() : BuilderBase("planar")
+        PlanarInitCondBuilder() : SampledInitBuilder("planar")
         {
             BuilderBaseType::args().description("Starts all rays from a plane/line.");
             BuilderBaseType::args() << ArgumentSpec("velocity").alias("vel").store_many(mVelocity).optional()
@@ -62,7 +115,7 @@ namespace
                 pw->setOrigin(mOrigin);
             }
 
-            return std::move(pw);
+            return applySampling( std::move(pw) );
         }
 
         gen_vect mVelocity{0};
@@ -101,10 +154,10 @@ namespace
         gen_vect mOrigin{0};
     };
 
-    class RadialInitCondBuilder final : public InitBuilder
+    class RadialInitCondBuilder final : public SampledInitBuilder
     {
     public:
-        RadialInitCondBuilder() : BuilderBase("radial")
+        RadialInitCondBuilder() : SampledInitBuilder("radial")
         {
             BuilderBaseType::args().description("All rays start from a single point and are evenly distributed in angle.");
             BuilderBaseType::args() << ArgumentSpec("origin").alias("pos").optional().store_many(mOrigin)
@@ -124,12 +177,12 @@ namespace
             {
                 auto rw = make_unique<RadialWave2D>(dimension);
                 rw->setOrigin(mOrigin);
-                return std::move(rw);
+                return applySampling( std::move(rw) );
             } else if (dimension == 3)
             {
                 auto rw = make_unique<RadialWave3D>(dimension);
                 rw->setOrigin(mOrigin);
-                return std::move(rw);
+                return applySampling( std::move(rw) );
             }
 
             THROW_EXCEPTION(std::runtime_error, "Invalid dimension %1% for RadialWave initial condition", dimension);
@@ -154,6 +207,38 @@ namespace
             return make_unique<RandomRadial>(dimension);
         }
     };
+
+    class RayFileInitCondBuilder final : public InitBuilder
+    {
+    public:
+        RayFileInitCondBuilder() : BuilderBase("file")
+        {
+            BuilderBaseType::args().description("Reads the rays from a binary ray file (rays001), e.g. to continue "
+                               "rays from a previous run. The number of rays is given by the file, not by the "
+                               "particle count. The deltas are zero, so caustics are not detected.");
+            BuilderBaseType::args() << ArgumentSpec("file").positional().store(mFileName)
+                    .description("Path of the ray file.");
+            BuilderBaseType::args() << ArgumentSpec("first").optional().store(mFirst)
+                    .description("Index of the first record to trace.");
+            BuilderBaseType::args() << ArgumentSpec("count").optional().store(mCount)
+                    .description("Number of records to trace. All records after first if zero.");
+        }
+
+    private:
+        std::unique_ptr<InitialConditionGenerator> create(unsigned dimension) override
+        {
+            auto rf = make_unique<RayFile>(dimension, mFileName);
+            if(mFirst > rf->getFileRecordCount())
+                THROW_EXCEPTION(std::out_of_range, "first record %1% exceeds the %2% records of %3%", mFirst,
+                                rf->getFileRecordCount(), mFileName);
+            rf->selectRecords(mFirst, mCount == 0 ? rf->getFileRecordCount() - mFirst : mCount);
+            return std::move(rf);
+        }
+
+        std::string mFileName;
+        std::uint64_t mFirst = 0;
+        std::uint64_t mCount = 0;
+    };
 }
 
 InitFactory& init_cond::getInitialConditionFactory()
@@ -166,6 +251,7 @@ InitFactory& init_cond::getInitialConditionFactory()
         factory.add_builder<RandomPlanarInitCondBuilder>();
         factory.add_builder<RadialInitCondBuilder>();
         factory.add_builder<RandomRadialInitCondBuilder>();
+        factory.add_builder<RayFileInitCondBuilder>();
         init = true;
     }
     return factory;
@@ -7,6 +7,9 @@
 
 // concrete IC implementations
 #include "init_factory.hpp"
+#include "manifold_sampler.hpp"
+#include "manifold_refinement.hpp"
+#include "importance_distribution.hpp"
 
 using namespace init_cond;
 
@@ -136,14 +139,55 @@ void InitialConditionGenerator::init(const InitialConditionConfiguration& config
                         config.getOffset().size(), mWorldDimension);
     }
 
+    if(mSampler && mRefinement) {
+        THROW_EXCEPTION(std::logic_error, "A generator cannot use a sampler and a refinement at the same time.");
+    }
+
+    if(getRecordCount() > 0 && (mSampler || mRefinement || mImportance)) {
+        THROW_EXCEPTION(std::logic_error, "The %1% generator reads its rays and cannot place them with a sampler, a "
+                                          "refinement or importance sampling.", mName);
+    }
+
+    if(mImportance && !mSampler && !mRefinement && !hasUniformLattice()) {
+        THROW_EXCEPTION(std::logic_error, "Importance sampling with the %1% generator requires a sampler or a "
+                                          "refinement.", mName);
+    }
+
     mConfig = config;
 
     mManifoldPosition.resize( mManifoldDimension );
-    mManifoldIndex.setLowerBound(0);
-    init_generator( mManifoldIndex );
-    mManifoldIndex.init();
+    mSampleIndex = 0;
+    mNextRecord = 0;
+    resetLattice();
+    if(mRefinement)
+        mRefinement->start(getParticleCount());
+
+    mShardBegin = 0;
+    mShardEnd = std::numeric_limits<std::uint64_t>::max();
+    if(mShardCount > 1)
+    {
+        if(mRefinement)
+            THROW_EXCEPTION( std::logic_error, "The rays of the %1% generator are refined and cannot be split into "
+                                               "shards.", mName );
 
-    updateManifoldPosition();
+        std::uint64_t total = getParticleCount();
+        if(getRecordCount() > 0)
+        {
+            total = getRecordCount();
+        }
+        else if(!mSampler)
+        {
+            total = walkLattice(std::numeric_limits<std::uint64_t>::max());
+            resetLattice();
+        }
+        mShardBegin = total * mShardIndex / mShardCount;
+        mShardEnd = total * (mShardIndex + 1) / mShardCount;
+
+        mNextRecord = mShardBegin;
+        mSampleIndex = mShardBegin;
+        if(getRecordCount() == 0 && !mSampler)
+            walkLattice(mShardBegin);
+    }
 }
 
 void InitialConditionGenerator::generateNormalized( State& state, const manifold_pos& pos ) const
@@ -182,28 +226,91 @@ void InitialConditionGenerator::advance( InitialCondition& newCondition )
     // instead of throwing an exception.
     assert(newCondition.mGenerator == this);
 
-    // for the rest of the function, lock the mutex.
+    if( getRecordCount() > 0 )
+    {
+        advanceRecord(newCondition);
+        return;
+    }
+
+    // choosing the manifold position of the ray modifies the generator, so it happens under the lock.
     std::unique_lock<std::mutex> lock(mIsGenerating);
-    if(! mManifoldIndex.valid() )
+    newCondition.mWeight = 1.0;
+    newCondition.mIsCorrection = false;
+    if( mRefinement )
+    {
+        // this may wait for other threads to finish their rays, which requires the lock
+        if( !mRefinement->next(lock, newCondition.mRayId) )
+        {
+            newCondition.mIsValid = false;
+            return;
+        }
+        mRefinement->getPosition(newCondition.mRayId, mManifoldPosition);
+        newCondition.mWeight = mRefinement->getWeight(newCondition.mRayId);
+        newCondition.mIsCorrection = mRefinement->isCorrection(newCondition.mRayId);
+    }
+    else if( mSampler ? mSampleIndex >= std::min<std::uint64_t>(getParticleCount(), mShardEnd)
+                      : !mManifoldIndex.valid() || mLatticeRay >= mShardEnd )
     {
         newCondition.mIsValid = false;
         return;
     }
+    else if( mSampler )
+    {
+        mSampler->sample(mSampleIndex, mManifoldPosition);
+    }
+    else
+    {
+        next_trajectory(mManifoldPosition, mManifoldIndex);
+    }
 
-    next_trajectory(mManifoldPosition, mManifoldIndex);
+    if( mImportance )
+        newCondition.mWeight *= mImportance->transform(mManifoldPosition);
+    if( mRefinement || mSampler )
+        warp_sample(mManifoldPosition);
 
-    generateNormalized(newCondition.mCurrentState, mManifoldPosition);
+    for(unsigned i = 0; i < getManifoldDimension(); ++i)
+    {
+        // refined rays report the index of their cell. Sampled rays have no lattice position, their index is
+        // reported as the ray id instead.
+        if( mRefinement )
+            newCondition.mManifoldIndex[i] = mRefinement->getCell(newCondition.mRayId)[i];
+        else if( mSampler )
+            newCondition.mManifoldIndex[i] = 0;
+        else
+            newCondition.mManifoldIndex[i] = mManifoldIndex[i];
+        newCondition.mManifoldCoordinates[i] = mManifoldPosition[i];
+    }
+
+    // move on to the next ray
+    if( mSampler )
+    {
+        newCondition.mRayId = mSampleIndex++;
+    }
+    else if( !mRefinement )
+    {
+        ++mLatticeRay;
+        mManifoldIndex.increment();
+        if(mManifoldIndex.valid()) {
+            updateManifoldPosition();
+        }
+    }
+
+    // from here on, only the manifold position of this ray is needed. If the generator allows it, the other
+    // threads can already continue with their rays.
+    if( isGenerationReentrant() )
+        lock.unlock();
+
+    manifold_pos position = newCondition.mManifoldCoordinates;
+    generateNormalized(newCondition.mCurrentState, position);
     newCondition.mIsValid = true;
 
     // deltas
     double STEP = 1e-5;
     for(unsigned i = 0; i < getManifoldDimension(); ++i)
     {
-        newCondition.mManifoldIndex[i] = mManifoldIndex[i];
-        newCondition.mManifoldCoordinates[i] = mManifoldPosition[i];
-        mManifoldPosition[i] += STEP;
-        generateNormalized( newCondition.mDeltas[i], mManifoldPosition);
-        mManifoldPosition[i] -= STEP;
+        position[i] += STEP;
+        generateNormalized( newCondition.mDeltas[i], position);
+        position[i] = newCondition.mManifoldCoordinates[i];
 
         // subtract state and calculate derivative as difference quotient
         newCondition.mDeltas[i].editVel() -= newCondition.mCurrentState.getVelocity();
@@ -211,11 +318,115 @@ void InitialConditionGenerator::advance( InitialCondition& newCondition )
         newCondition.mDeltas[i].editPos() -= newCondition.mCurrentState.getPosition();
         newCondition.mDeltas[i].editPos() /= STEP;
     }
+}
 
-    mManifoldIndex.increment();
-    if(mManifoldIndex.valid()) {
-        updateManifoldPosition();
+void InitialConditionGenerator::advanceRecord( InitialCondition& newCondition )
+{
+    // claim a new block of records when the current one is used up. Towards the end, the blocks get smaller, so
+    // that the remaining records are shared among all threads.
+    if( newCondition.mClaimBegin == newCondition.mClaimEnd )
+    {
+        const std::uint64_t count = std::min(getRecordCount(), mShardEnd);
+        std::uint64_t remaining = count - std::min(count, mNextRecord.load());
+        std::uint64_t block = std::max<std::uint64_t>(1, std::min<std::uint64_t>(256, remaining / 64));
+        std::uint64_t begin = mNextRecord.fetch_add(block);
+        if( begin >= count )
+        {
+            newCondition.mIsValid = false;
+            return;
+        }
+        newCondition.mClaimBegin = begin;
+        newCondition.mClaimEnd = std::min(begin + block, count);
     }
+
+    std::uint64_t record = newCondition.mClaimBegin++;
+    newCondition.mRayId = record;
+    State& state = newCondition.mCurrentState;
+    newCondition.mWeight = read_record(record, state.editPos(), state.editVel());
+    if(mConfig.getEnergyNormalization())
+    {
+        mConfig.getDynamics().normalizeEnergy(state, 0.5);
+    }
+
+    for(unsigned i = 0; i < getManifoldDimension(); ++i)
+    {
+        newCondition.mManifoldIndex[i] = 0;
+        newCondition.mManifoldCoordinates[i] = i == 0 ? (record + 0.5) / getRecordCount() : 0.5;
+        newCondition.mDeltas[i].editPos() = boost::numeric::ublas::zero_vector<double>(mWorldDimension);
+        newCondition.mDeltas[i].editVel() = boost::numeric::ublas::zero_vector<double>(mWorldDimension);
+    }
+    newCondition.mIsValid = true;
+}
+
+double InitialConditionGenerator::read_record(std::uint64_t record, gen_vect&, gen_vect&) const
+{
+    THROW_EXCEPTION( std::logic_error, "Generator %1% cannot read record %2%.", mName, record );
+}
+
+void InitialConditionGenerator::skip(std::uint64_t count)
+{
+    if( !isResumable() )
+        THROW_EXCEPTION( std::logic_error, "The rays of the %1% generator are refined and cannot be skipped.", mName );
+
+    if( getRecordCount() > 0 )
+    {
+        mNextRecord = mShardBegin + count;
+    }
+    else if( mSampler )
+    {
+        mSampleIndex = mShardBegin + count;
+    }
+    else
+    {
+        walkLattice(count);
+    }
+}
+
+void InitialConditionGenerator::resetLattice()
+{
+    mLatticeRay = 0;
+    mManifoldIndex.setLowerBound(0);
+    init_generator( mManifoldIndex );
+    mManifoldIndex.init();
+    updateManifoldPosition();
+}
+
+std::uint64_t InitialConditionGenerator::walkLattice(std::uint64_t count)
+{
+    // the lattice may change its bounds in next_trajectory(), so we have to walk over it.
+    std::uint64_t ray = 0;
+    for(; ray < count && mManifoldIndex.valid(); ++ray)
+    {
+        next_trajectory(mManifoldPosition, mManifoldIndex);
+        ++mLatticeRay;
+        mManifoldIndex.increment();
+        if(mManifoldIndex.valid())
+            updateManifoldPosition();
+    }
+    return ray;
+}
+
+void InitialConditionGenerator::setShard(std::size_t index, std::size_t count)
+{
+    if(index >= count)
+        THROW_EXCEPTION( std::invalid_argument, "Shard %1% of %2% does not exist.", index, count );
+    mShardIndex = index;
+    mShardCount = count;
+}
+
+std::uint64_t InitialConditionGenerator::getShardBegin() const
+{
+    return mShardBegin;
+}
+
+bool InitialConditionGenerator::isResumable() const
+{
+    return !mRefinement;
+}
+
+bool InitialConditionGenerator::hasUniformPrefixes() const
+{
+    return mSampler && !mRefinement && getRecordCount() == 0;
 }
 
 InitialCondition InitialConditionGenerator::next()
@@ -230,6 +441,49 @@ const std::string& InitialConditionGenerator::getGeneratorType() const
     return mName;
 }
 
+void InitialConditionGenerator::setSampler(std::shared_ptr<const ManifoldSampler> sampler)
+{
+    if(sampler && sampler->getDimension() != mManifoldDimension)
+        THROW_EXCEPTION( std::invalid_argument, "%1% dimensional sampler supplied for %2% dimensional manifold",
+                         sampler->getDimension(), mManifoldDimension );
+    mSampler = std::move(sampler);
+}
+
+void InitialConditionGenerator::setRefinement(std::shared_ptr<ManifoldRefinement> refinement)
+{
+    if(refinement && refinement->getDimension() != mManifoldDimension)
+        THROW_EXCEPTION( std::invalid_argument, "%1% dimensional refinement supplied for %2% dimensional manifold",
+                         refinement->getDimension(), mManifoldDimension );
+    mRefinement = std::move(refinement);
+}
+
+void InitialConditionGenerator::setImportance(std::shared_ptr<const ImportanceDistribution> distribution)
+{
+    if(distribution && distribution->getDimension() != mManifoldDimension)
+        THROW_EXCEPTION( std::invalid_argument, "%1% dimensional importance distribution supplied for %2% dimensional "
+                         "manifold", distribution->getDimension(), mManifoldDimension );
+    mImportance = std::move(distribution);
+}
+
+void InitialConditionGenerator::finishTrajectory(const InitialCondition& ray, const State& final_state)
+{
+    assert(ray.mGenerator == this);
+    if(!mRefinement)
+        return;
+
+    std::lock_guard<std::mutex> lock(mIsGenerating);
+    mRefinement->finish(ray.mRayId, final_state.getPosition());
+}
+
+void InitialConditionGenerator::abort()
+{
+    if(!mRefinement)
+        return;
+
+    std::lock_guard<std::mutex> lock(mIsGenerating);
+    mRefinement->abort();
+}
+
 std::size_t InitialConditionGenerator::getManifoldDimension() const
 {
     return mManifoldDimension;
@@ -297,6 +551,26 @@ const manifold_pos & InitialCondition::getManifoldCoordinates() const
     return mManifoldCoordinates;
 }
 
+double InitialCondition::getWeight() const
+{
+    return mWeight;
+}
+
+std::uint64_t InitialCondition::getRayId() const
+{
+    return mRayId;
+}
+
+bool InitialCondition::isCorrection() const
+{
+    return mIsCorrection;
+}
+
+bool InitialCondition::hasPendingRecords() const
+{
+    return mClaimBegin != mClaimEnd;
+}
+
 InitialCondition::operator bool() const
 {
     return mIsValid;
@@ -4,7 +4,11 @@
 /// \file
 /// This file defines the basic classes used for initial condition generation.
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <functional>
 #include "state.hpp"
 #include "initial_conditions_fwd.hpp"
@@ -18,6 +22,9 @@ namespace init_cond
 {
 
     class InitialCondition;
+    class ManifoldSampler;
+    class ManifoldRefinement;
+    class ImportanceDistribution;
 
     // -----------------------------------------------------------------------------------------------------------------
     //                        Initial Condition Configuration
@@ -118,6 +125,26 @@ namespace init_cond
         /// gets the manifold position as coordinates
         const manifold_pos& getManifoldCoordinates() const;
 
+        /// gets the number with which the generator identifies the ray. For rays placed by a ManifoldSampler, this
+        /// is the index of the sample, for generators that read records the index of the record among the selected
+        /// records. Such rays have no position on the lattice, so their manifold index is zero.
+        std::uint64_t getRayId() const;
+
+        /// gets the weight of the ray's contribution to the observables. This is the measure of the manifold
+        /// cell the ray represents, relative to a cell of the regular lattice, times the importance weight of
+        /// the ray. Always 1 unless the generator refines the manifold (InitialConditionGenerator::setRefinement())
+        /// or uses importance sampling (InitialConditionGenerator::setImportance()).
+        double getWeight() const;
+
+        /// whether this ray only corrects the weight of a ray that has already been traced, see ManifoldRefinement.
+        /// It repeats that trajectory, so observers that do not use getWeight() should ignore it.
+        bool isCorrection() const;
+
+        /// whether this iterator has claimed records that it has not yet generated. These count as handed out
+        /// by the generator, so the generator is only in a consistent state for InitialConditionGenerator::skip()
+        /// if no iterator holds such records.
+        bool hasPendingRecords() const;
+
 
         // ------  iterator interface ------
         explicit operator bool() const;
@@ -137,6 +164,15 @@ namespace init_cond
         std::vector<int> mManifoldIndex;
         /// normalized manifold coordinates
         manifold_pos mManifoldCoordinates;
+        /// weight of the ray
+        double mWeight = 1.0;
+        /// whether the ray is a correction ray of a refinement
+        bool mIsCorrection = false;
+        /// id with which the generator identifies the ray when it is finished
+        std::uint64_t mRayId = 0;
+        /// range of records this iterator has claimed but not yet generated, for generators that read records.
+        std::uint64_t mClaimBegin = 0;
+        std::uint64_t mClaimEnd = 0;
 
         /// sets whether this state is valid (i.e. not yet reached the end)
         /// default constructed to false, as soon as advanced was called valid
@@ -191,9 +227,71 @@ namespace init_cond
         /// \throw std::logic_error, if not yet initialized.
         InitialCondition next();
 
+        /*! \brief Skips the first \p count rays, so that iteration continues with ray \p count. Has to be called after
+         *  init(), before any ray is generated. This allows to continue an interrupted trace.
+         *  \throw std::logic_error if the generator is not resumable (see isResumable()).
+         */
+        void skip(std::uint64_t count);
+
+        /// whether the rays can be skipped. This is not the case for a refinement, where the rays depend on the
+        /// results of the earlier rays.
+        bool isResumable() const;
+
+        /// whether every prefix of the rays is spread over the whole manifold, so that a trace which is stopped early
+        /// still covers all of it. This holds for rays placed by a sampler, but not for the lattice, which is filled
+        /// one row after the other.
+        bool hasUniformPrefixes() const;
+
+        /*! \brief Restricts the generator to part \p index of \p count contiguous parts of equal size of its rays.
+         *  \details Separate processes can trace the parts (shards) and merge their results afterwards. The part
+         *          starts at ray getShardBegin() of the complete set, and skip() counts from there. For a lattice, all
+         *          rays are walked over once in init() to find their number. Has to be called before init().
+         *  \throw std::invalid_argument if \p index is not smaller than \p count.
+         */
+        void setShard(std::size_t index, std::size_t count);
+
+        /// index of the first ray of the shard in the complete set of rays. Zero if not sharded, valid after init().
+        std::uint64_t getShardBegin() const;
+
         /// gets a string that identifies the type of the generator.
         const std::string& getGeneratorType() const;
 
+        /*! \brief Places the rays on the manifold using \p sampler instead of the regular lattice.
+         *  \details Exactly getParticleCount() rays are generated, ray `i` at the warped (see warp_sample()) point
+         *          `i` of the sampler, and `i` is reported as InitialCondition::getRayId(). Passing a null pointer
+         *          restores the lattice. Has to be called before init().
+         *  \throw std::invalid_argument if the sampler dimension does not match the manifold dimension.
+         */
+        void setSampler(std::shared_ptr<const ManifoldSampler> sampler);
+
+        /*! \brief Places the rays on an adaptively refined lattice.
+         *  \details The rays are generated in passes, and cells of the manifold in which neighbouring rays diverge
+         *          are subdivided for the next pass. As with a sampler, the manifold coordinates of the rays are
+         *          transformed by warp_sample(). The rays carry weights (InitialCondition::getWeight()) according to
+         *          the size of their cell, and the final state of every ray has to be reported via
+         *          finishTrajectory(), otherwise next() blocks at the end of the first pass. Passing a null pointer
+         *          disables the refinement. Has to be called before init().
+         *  \throw std::invalid_argument if the refinement dimension does not match the manifold dimension.
+         */
+        void setRefinement(std::shared_ptr<ManifoldRefinement> refinement);
+
+        /*! \brief Distributes the rays on the manifold according to \p distribution.
+         *  \details The distribution is applied to the rays placed by the lattice, the sampler or the refinement,
+         *          before warp_sample(), and the rays are weighted by the inverse density. Passing a null pointer
+         *          restores the uniform distribution. Has to be called before init().
+         *  \throw std::invalid_argument if the distribution dimension does not match the manifold dimension.
+         */
+        void setImportance(std::shared_ptr<const ImportanceDistribution> distribution);
+
+        /// Notifies the generator that the ray started from \p ray has been traced, and ended in \p final_state.
+        /// Generators that do not refine the manifold ignore this.
+        void finishTrajectory(const InitialCondition& ray, const State& final_state);
+
+        /// Stops the generation after a ray has failed, so that it will never be reported to finishTrajectory().
+        /// The iterators that wait for the pass of a refinement to finish end instead of waiting forever.
+        /// Generators that do not refine the manifold ignore this.
+        void abort();
+
         // -------------------------------------------------------------------------------------------------------------
         //  info functions
         /// get how many particles will be traced
@@ -213,11 +311,23 @@ namespace init_cond
          *        whose lower bound is set to zero, and upper bound is not yet set.
          */
         virtual void init_generator(MultiIndex& manifold_index);
+
+        /*! \brief Maps a point of a ManifoldSampler to manifold coordinates.
+         *  \details The samplers produce points that are uniformly distributed in the unit cube. Generators whose
+         *          lattice is not uniform in manifold coordinates (e.g. because rows have different lengths) override
+         *          this to transform the point such that the rays end up with the same distribution as on the lattice.
+         */
+        virtual void warp_sample(manifold_pos& pos) const { (void)pos; };
+
+        /// whether the points of the lattice are uniformly distributed in the coordinates that are passed to
+        /// warp_sample(). Otherwise, importance sampling requires a sampler or refinement.
+        virtual bool hasUniformLattice() const { return true; }
     private:
 
         /// called before a new trajectory is requested.
         /// param pos the manifold position of the trajectory in coordinates.
         /// param index the manifold position as index. Changing this allows to dynamically adapt the bounds.
+        /// \note Not called when the rays are placed by a ManifoldSampler.
         virtual void next_trajectory(const manifold_pos& pos, MultiIndex& index) { (void)pos; (void)index; };
 
         /*! \brief Generate position anv velocity for given initial manifold position.
@@ -231,6 +341,30 @@ namespace init_cond
         virtual void
         generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& manifold_position) const = 0;
 
+        /*! \brief Whether generate() may run concurrently in several threads.
+         *  \details If true, only the choice of the manifold position happens under the generator lock, and the
+         *          initial states are computed in parallel. Generators whose generate() depends on state that is set
+         *          in next_trajectory() must not enable this.
+         */
+        virtual bool isGenerationReentrant() const { return false; }
+
+        /*! \brief Number of rays that are read as records, instead of being placed on the manifold.
+         *  \details Zero for generators that place rays on the manifold. Otherwise, read_record() replaces
+         *          generate(), and the rays are the records 0 to getRecordCount() - 1. The iterators claim blocks of
+         *          records without taking the generator lock. Such rays do not have a manifold, so their deltas are
+         *          zero and their manifold index is zero. The record number is reported as
+         *          InitialCondition::getRayId(), and as the first manifold coordinate relative to the record count.
+         */
+        virtual std::uint64_t getRecordCount() const { return 0; }
+
+        /*! \brief Reads the ray \p record.
+         *  \param[out] ray_position initial position, in world coordinates.
+         *  \param[out] ray_velocity initial velocity.
+         *  \return weight of the ray.
+         *  \details Called concurrently from several threads.
+         */
+        virtual double read_record(std::uint64_t record, gen_vect& ray_position, gen_vect& ray_velocity) const;
+
         /*! generates a new state and normalizes the energy if required.
          *  \param pos relative position of the particle on the new manifold
          *  \param[out] state Target where to write the new state
@@ -241,9 +375,19 @@ namespace init_cond
         /// This function is called from InitialCondition::InitialCondition().
         void advance( InitialCondition& newCondition );
 
+        /// advance() for generators that read records. Does not lock the mutex.
+        void advanceRecord( InitialCondition& newCondition );
+
         /// helper function that updates the manifold position based on the manifold index.
         void updateManifoldPosition();
 
+        /// moves the lattice back to its first ray.
+        void resetLattice();
+
+        /// moves the lattice forward by \p count rays, without generating them. Returns the number of rays that were
+        /// skipped, which is less than \p count if the end of the lattice is reached.
+        std::uint64_t walkLattice(std::uint64_t count);
+
         // data
         // ----
         /// settings for IC generation.
@@ -259,9 +403,32 @@ namespace init_cond
         /// by updateManifoldPosition() from the data given in mManifoldIndex.
         manifold_pos mManifoldPosition;
 
+        /// if set, the manifold positions are taken from this sampler instead of mManifoldIndex.
+        std::shared_ptr<const ManifoldSampler> mSampler;
+        /// index of the next ray when using mSampler.
+        std::uint64_t mSampleIndex = 0;
+        /// index of the next ray when using mManifoldIndex.
+        std::uint64_t mLatticeRay = 0;
+
+        /// the shard of the rays that is generated, see setShard().
+        std::size_t mShardIndex = 0;
+        std::size_t mShardCount = 1;
+        /// range [mShardBegin, mShardEnd) of the rays of the shard.
+        std::uint64_t mShardBegin = 0;
+        std::uint64_t mShardEnd = std::numeric_limits<std::uint64_t>::max();
+
+        /// if set, the manifold positions and ray weights are decided by this refinement.
+        std::shared_ptr<ManifoldRefinement> mRefinement;
+
+        /// if set, the manifold positions are transformed to this distribution.
+        std::shared_ptr<const ImportanceDistribution> mImportance;
+
         /// this mutex is locked during the generation of an initial condition.
         std::mutex mIsGenerating;
 
+        /// first record that has not been claimed yet, for generators that read records.
+        std::atomic<std::uint64_t> mNextRecord{0};
+
         friend void InitialCondition::advance();
     };
 
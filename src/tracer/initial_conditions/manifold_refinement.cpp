@@ -0,0 +1,226 @@
+#include "manifold_refinement.hpp"
+#include "global.hpp"
+#include <cmath>
+#include <limits>
+#include <boost/numeric/conversion/cast.hpp>
+
+using namespace init_cond;
+
+constexpr std::size_t ManifoldRefinement::MAX_DIMENSION;
+
+ManifoldRefinement::ManifoldRefinement(std::size_t dimension, double threshold, unsigned max_level) :
+        mDimension(dimension),
+        mThreshold(threshold),
+        mMaxLevel(max_level)
+{
+    if(dimension == 0 || dimension > MAX_DIMENSION)
+        THROW_EXCEPTION(std::invalid_argument, "Refinement supports at most %1% manifold dimensions, got %2%",
+                        MAX_DIMENSION, dimension);
+    if(!(threshold > 0))
+        THROW_EXCEPTION(std::invalid_argument, "Refinement threshold has to be positive, got %1%", threshold);
+}
+
+std::size_t ManifoldRefinement::getDimension() const
+{
+    return mDimension;
+}
+
+double ManifoldRefinement::getThreshold() const
+{
+    return mThreshold;
+}
+
+unsigned ManifoldRefinement::getMaxLevel() const
+{
+    return mMaxLevel;
+}
+
+void ManifoldRefinement::start(std::size_t ray_count)
+{
+    mCoarseCells = std::max(1, boost::numeric_cast<int>( std::floor(std::pow(ray_count, 1.0 / mDimension)) ));
+
+    // the cell indices of the finest level have to fit into an int.
+    double finest = mCoarseCells * std::pow(3.0, mMaxLevel);
+    if(finest > std::numeric_limits<int>::max())
+        THROW_EXCEPTION(std::invalid_argument, "%1% refinement levels of %2% coarse cells exceed the index range",
+                        mMaxLevel, mCoarseCells);
+
+    mCells.clear();
+    mRays.clear();
+    mCellIndex.clear();
+    mPassCells.clear();
+    mNextRay = 0;
+    mPendingRays = 0;
+    mPassCount = 1;
+    mComplete = false;
+    mAborted = false;
+
+    std::array<int, MAX_DIMENSION> coords{};
+    std::size_t count = 1;
+    for(unsigned i = 0; i < mDimension; ++i)
+        count *= mCoarseCells;
+    for(std::size_t n = 0; n < count; ++n)
+    {
+        std::size_t rest = n;
+        for(unsigned i = 0; i < mDimension; ++i)
+        {
+            coords[i] = rest % mCoarseCells;
+            rest /= mCoarseCells;
+        }
+        addCell(0, coords, 1.0, true);
+    }
+}
+
+bool ManifoldRefinement::next(std::unique_lock<std::mutex>& lock, std::uint64_t& ray)
+{
+    while(mNextRay == mRays.size() || mAborted)
+    {
+        if(mComplete || mAborted)
+            return false;
+
+        if(mPendingRays > 0)
+        {
+            mPassFinished.wait(lock);
+        }
+        else if(!refine())
+        {
+            mComplete = true;
+            mPassFinished.notify_all();
+            return false;
+        }
+    }
+
+    ray = mNextRay++;
+    ++mPendingRays;
+    return true;
+}
+
+void ManifoldRefinement::abort()
+{
+    mAborted = true;
+    mPassFinished.notify_all();
+}
+
+void ManifoldRefinement::finish(std::uint64_t ray, const gen_vect& final_position)
+{
+    if(ray >= mNextRay || mRays[ray].finished)
+        THROW_EXCEPTION(std::logic_error, "Ray %1% is not being traced", ray);
+
+    Ray& finished = mRays[ray];
+    finished.finished = true;
+    if(!finished.is_correction)
+        mCells[finished.cell].final_position = final_position;
+
+    if(--mPendingRays == 0)
+        mPassFinished.notify_all();
+}
+
+void ManifoldRefinement::getPosition(std::uint64_t ray, manifold_pos& target) const
+{
+    const Cell& cell = mCells[mRays.at(ray).cell];
+    double cells_per_dim = mCoarseCells * std::pow(3.0, cell.level);
+    for(unsigned i = 0; i < mDimension; ++i)
+        target[i] = (cell.coords[i] + 0.5) / cells_per_dim;
+}
+
+const std::array<int, ManifoldRefinement::MAX_DIMENSION>& ManifoldRefinement::getCell(std::uint64_t ray) const
+{
+    return mCells[mRays.at(ray).cell].coords;
+}
+
+double ManifoldRefinement::getWeight(std::uint64_t ray) const
+{
+    return mRays.at(ray).weight;
+}
+
+bool ManifoldRefinement::isCorrection(std::uint64_t ray) const
+{
+    return mRays.at(ray).is_correction;
+}
+
+std::size_t ManifoldRefinement::getRayCount() const
+{
+    return mNextRay;
+}
+
+unsigned ManifoldRefinement::getPassCount() const
+{
+    return mPassCount;
+}
+
+bool ManifoldRefinement::refine()
+{
+    std::vector<std::size_t> refined;
+    for(std::size_t cell : mPassCells)
+    {
+        if(mCells[cell].level < mMaxLevel && diverges(mCells[cell]))
+            refined.push_back(cell);
+    }
+    mPassCells.clear();
+
+    if(refined.empty())
+        return false;
+
+    std::size_t children = 1;
+    for(unsigned i = 0; i < mDimension; ++i)
+        children *= 3;
+
+    for(std::size_t parent_id : refined)
+    {
+        // copy, adding cells may reallocate mCells
+        Cell parent = mCells[parent_id];
+        double child_weight = parent.weight / children;
+        mRays.push_back( Ray{parent_id, child_weight - parent.weight, true, false} );
+
+        std::array<int, MAX_DIMENSION> coords{};
+        for(std::size_t n = 0; n < children; ++n)
+        {
+            std::size_t rest = n;
+            bool is_center = true;
+            for(unsigned i = 0; i < mDimension; ++i)
+            {
+                int offset = rest % 3;
+                rest /= 3;
+                coords[i] = 3 * parent.coords[i] + offset;
+                is_center = is_center && offset == 1;
+            }
+
+            // the center child shares its ray with the parent
+            addCell(parent.level + 1, coords, child_weight, !is_center);
+            if(is_center)
+                mCells.back().final_position = parent.final_position;
+        }
+    }
+
+    ++mPassCount;
+    return true;
+}
+
+bool ManifoldRefinement::diverges(const Cell& cell) const
+{
+    std::array<int, MAX_DIMENSION> neighbour = cell.coords;
+    for(unsigned i = 0; i < mDimension; ++i)
+    {
+        for(int direction : {-1, 1})
+        {
+            neighbour[i] = cell.coords[i] + direction;
+            auto found = mCellIndex.find( std::make_pair(cell.level, neighbour) );
+            if(found != mCellIndex.end() &&
+               norm_2(mCells[found->second].final_position - cell.final_position) > mThreshold)
+                return true;
+        }
+        neighbour[i] = cell.coords[i];
+    }
+    return false;
+}
+
+void ManifoldRefinement::addCell(unsigned level, const std::array<int, MAX_DIMENSION>& coords, double weight,
+                                 bool traced)
+{
+    std::size_t id = mCells.size();
+    mCells.push_back( Cell{level, coords, weight, gen_vect()} );
+    mCellIndex[std::make_pair(level, coords)] = id;
+    mPassCells.push_back(id);
+    if(traced)
+        mRays.push_back( Ray{id, weight, false, false} );
+}
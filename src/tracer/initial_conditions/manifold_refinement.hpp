@@ -0,0 +1,135 @@
+#ifndef MANIFOLD_REFINEMENT_HPP_INCLUDED
+#define MANIFOLD_REFINEMENT_HPP_INCLUDED
+
+/// \file
+/// Adaptive subdivision of the initial manifold in regions where neighbouring rays diverge.
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "initial_conditions.hpp"
+
+namespace init_cond
+{
+    /*! \class ManifoldRefinement
+     *  \brief Places rays on an adaptively refined lattice of the initial manifold.
+     *  \details The rays are traced in passes. The first pass is a coarse lattice with about as many cells as
+     *          requested rays, one ray at the center of each cell. After a pass has been traced, every cell whose
+     *          ray ends further than the threshold away from the ray of a neighbouring cell of the same level is
+     *          split into 3^d children. The center child coincides with the parent, so only the 3^d - 1 others need
+     *          new rays. This is repeated until no cell diverges or the maximum level is reached.
+     *
+     *          Each ray carries the measure of its cell as weight, normalized such that a cell of the coarse lattice
+     *          has weight one. When a cell is split, the ray of the parent has already been recorded with the full
+     *          weight of the parent cell. Therefore, the parent ray is traced a second time with the negative
+     *          weight of the new children, which leaves exactly the weight of the center child. Only observers
+     *          that take InitialCondition::getWeight() into account give meaningful results. Observers that record
+     *          individual rays skip the correction rays (InitialCondition::isCorrection()), so they see every
+     *          trajectory once.
+     *
+     *          Since a pass can only be planned when all rays of the previous pass have finished, the consumer has
+     *          to report each finished ray through finish() before requesting the next one. The object is not
+     *          thread safe by itself, all calls have to be done while holding the mutex passed to next().
+     */
+    class ManifoldRefinement
+    {
+    public:
+        /// manifold positions are stored in gen_vect, so more dimensions are never needed.
+        static constexpr std::size_t MAX_DIMENSION = 3;
+
+        /*! \param dimension dimension of the manifold.
+         *  \param threshold distance (in world coordinates) between the final positions of neighbouring rays above
+         *         which a cell is refined.
+         *  \param max_level maximum number of subdivisions of a coarse cell.
+         *  \throw std::invalid_argument if the dimension is not supported or the threshold is not positive.
+         */
+        ManifoldRefinement(std::size_t dimension, double threshold, unsigned max_level);
+
+        std::size_t getDimension() const;
+        double getThreshold() const;
+        unsigned getMaxLevel() const;
+
+        /// discards all previous rays and starts a new refinement from a coarse lattice with
+        /// floor(ray_count^(1/d)) cells per dimension.
+        void start(std::size_t ray_count);
+
+        /*! \brief gets the id of the next ray.
+         *  \details If the current pass has been handed out completely, but some of its rays have not been
+         *          reported back by finish(), this waits on \p lock until they are.
+         *  \return false if the refinement is complete or has been aborted.
+         */
+        bool next(std::unique_lock<std::mutex>& lock, std::uint64_t& ray);
+
+        /// stops handing out rays, e.g. because a ray could not be traced and will never be reported to finish().
+        /// Wakes up the calls to next() that wait for the current pass, which return false from now on, until the
+        /// next start().
+        void abort();
+
+        /// reports the final position of ray \p ray, and wakes up calls to next() that wait for the current pass.
+        /// \throw std::logic_error if the ray is unknown or has already been reported.
+        void finish(std::uint64_t ray, const gen_vect& final_position);
+
+        /// writes the manifold coordinates of ray \p ray into \p target, in the open interval (0, 1).
+        void getPosition(std::uint64_t ray, manifold_pos& target) const;
+        /// gets the index of the cell of ray \p ray, in units of the cells of its level.
+        const std::array<int, MAX_DIMENSION>& getCell(std::uint64_t ray) const;
+        /// gets the weight of ray \p ray. This is negative for the rays that correct a refined parent.
+        double getWeight(std::uint64_t ray) const;
+        /// whether ray \p ray repeats the ray of a refined parent cell to correct its weight.
+        bool isCorrection(std::uint64_t ray) const;
+
+        /// number of rays that have been handed out, including the correction rays.
+        std::size_t getRayCount() const;
+        /// number of passes that have been started.
+        unsigned getPassCount() const;
+
+    private:
+        struct Cell
+        {
+            unsigned level;
+            std::array<int, MAX_DIMENSION> coords;
+            double weight;
+            gen_vect final_position;
+        };
+
+        struct Ray
+        {
+            std::size_t cell;
+            double weight;
+            bool is_correction;
+            bool finished;
+        };
+
+        /// checks the cells of the last pass and schedules the next one. Returns false if nothing was refined.
+        bool refine();
+        /// whether the final position of \p cell is further than the threshold from one of its neighbours.
+        bool diverges(const Cell& cell) const;
+        void addCell(unsigned level, const std::array<int, MAX_DIMENSION>& coords, double weight, bool traced);
+
+        // config
+        std::size_t mDimension;
+        double mThreshold;
+        unsigned mMaxLevel;
+        int mCoarseCells = 0;
+
+        // state
+        std::vector<Cell> mCells;
+        std::vector<Ray> mRays;
+        /// cells by level and index, to find the neighbours.
+        std::map<std::pair<unsigned, std::array<int, MAX_DIMENSION>>, std::size_t> mCellIndex;
+        /// cells created in the current pass. These are the candidates for the next refinement.
+        std::vector<std::size_t> mPassCells;
+        std::size_t mNextRay = 0;
+        std::size_t mPendingRays = 0;
+        unsigned mPassCount = 0;
+        bool mComplete = false;
+        bool mAborted = false;
+
+        std::condition_variable mPassFinished;
+    };
+}
+
+#endif // MANIFOLD_REFINEMENT_HPP_INCLUDED
@@ -0,0 +1,190 @@
+#include "manifold_sampler.hpp"
+#include "global.hpp"
+#include <cmath>
+
+using namespace init_cond;
+
+namespace
+{
+    /// splitmix64 finalizer, used to derive independent seeds and offsets from the user supplied seed.
+    std::uint64_t mix(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    std::uint32_t reverseBits(std::uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+        x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    /// Laine-Karras hash. Every bit only depends on the bits below it, so applied to the reversed bits this is
+    /// a nested uniform scramble: each bit is flipped depending on all more significant bits.
+    std::uint32_t laineKarras(std::uint32_t x, std::uint32_t seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    /// primitive polynomials (degree s, coefficients a) and initial direction numbers m, from Joe & Kuo,
+    /// new-joe-kuo-6.21201, for dimensions 2 and 3. The first dimension is the van der Corput sequence.
+    struct SobolPolynomial
+    {
+        unsigned s;
+        unsigned a;
+        std::uint32_t m[2];
+    };
+
+    const SobolPolynomial SOBOL_POLYNOMIALS[] = {
+            {1, 0, {1}},
+            {2, 1, {1, 3}}
+    };
+
+    std::vector<std::uint32_t> sobolDirections(std::size_t dimension)
+    {
+        std::vector<std::uint32_t> v(32);
+        if(dimension == 0)
+        {
+            for(unsigned k = 0; k < 32; ++k)
+                v[k] = 1u << (31 - k);
+            return v;
+        }
+
+        const SobolPolynomial& poly = SOBOL_POLYNOMIALS[dimension - 1];
+        for(unsigned k = 0; k < 32; ++k)
+        {
+            if(k < poly.s)
+            {
+                v[k] = poly.m[k] << (31 - k);
+                continue;
+            }
+
+            v[k] = v[k - poly.s] ^ (v[k - poly.s] >> poly.s);
+            for(unsigned i = 1; i < poly.s; ++i)
+            {
+                if((poly.a >> (poly.s - 1 - i)) & 1)
+                    v[k] ^= v[k - i];
+            }
+        }
+        return v;
+    }
+
+    /// converts the bits of a 32 bit fixed point number to a double in (0, 1).
+    double toUnitInterval(std::uint32_t x)
+    {
+        return (x + 0.5) / 4294967296.0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                  base class
+// ---------------------------------------------------------------------------------------------------------------------
+ManifoldSampler::ManifoldSampler(std::size_t dimension) : mDimension(dimension)
+{
+}
+
+std::size_t ManifoldSampler::getDimension() const
+{
+    return mDimension;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                  sobol sequence
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr std::size_t SobolSampler::MAX_DIMENSION;
+
+SobolSampler::SobolSampler(std::size_t dimension, bool scrambled, std::uint32_t seed) :
+    ManifoldSampler(dimension), mScrambled(scrambled)
+{
+    if(dimension > MAX_DIMENSION)
+        THROW_EXCEPTION(std::invalid_argument, "Sobol sequence supports at most %1% dimensions, got %2%",
+                        MAX_DIMENSION, dimension);
+
+    for(unsigned j = 0; j < dimension; ++j)
+    {
+        mDirections.push_back( sobolDirections(j) );
+        mScrambleSeeds.push_back( static_cast<std::uint32_t>(mix(seed + (std::uint64_t(j) << 32))) );
+    }
+}
+
+void SobolSampler::sample(std::uint64_t index, manifold_pos& target) const
+{
+    assert(target.size() == getDimension());
+    // the sequence has 2^32 distinct points, after that it repeats.
+    auto bits = static_cast<std::uint32_t>(index);
+    for(unsigned j = 0; j < mDirections.size(); ++j)
+    {
+        std::uint32_t x = 0;
+        // shift a copy, shifting by the full width of 32 bits would be undefined
+        std::uint32_t rest = bits;
+        for(unsigned k = 0; rest; rest >>= 1, ++k)
+        {
+            if(rest & 1)
+                x ^= mDirections[j][k];
+        }
+
+        if(mScrambled)
+            x = reverseBits(laineKarras(reverseBits(x), mScrambleSeeds[j]));
+        target[j] = toUnitInterval(x);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                  R_d sequence
+// ---------------------------------------------------------------------------------------------------------------------
+R2Sampler::R2Sampler(std::size_t dimension, bool shifted, std::uint32_t seed) :
+    ManifoldSampler(dimension)
+{
+    // fixed point iteration for x^(d+1) = x + 1
+    double phi = 2.0;
+    for(int i = 0; i < 40; ++i)
+        phi = std::pow(1.0 + phi, 1.0 / (dimension + 1));
+
+    for(unsigned j = 0; j < dimension; ++j)
+    {
+        double alpha = std::pow(1.0 / phi, j + 1);
+        mAlpha.push_back( static_cast<std::uint64_t>(std::ldexp(alpha, 64)) );
+        mOffset.push_back( shifted ? mix(seed + (std::uint64_t(j) << 32)) : std::uint64_t(1) << 63 );
+    }
+}
+
+void R2Sampler::sample(std::uint64_t index, manifold_pos& target) const
+{
+    assert(target.size() == getDimension());
+    for(unsigned j = 0; j < mAlpha.size(); ++j)
+    {
+        // unsigned overflow is the modulo 1 of the recurrence.
+        std::uint64_t x = mOffset[j] + index * mAlpha[j];
+        target[j] = ((x >> 11) + 0.5) / 9007199254740992.0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                  creation
+// ---------------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const ManifoldSampler> init_cond::createManifoldSampler(const std::string& name, std::size_t dimension,
+                                                                        std::uint32_t seed)
+{
+    if(name == "lattice")
+        return nullptr;
+    else if(name == "sobol")
+        return std::make_shared<SobolSampler>(dimension);
+    else if(name == "sobol_scrambled")
+        return std::make_shared<SobolSampler>(dimension, true, seed);
+    else if(name == "r2")
+        return std::make_shared<R2Sampler>(dimension);
+    else if(name == "r2_shifted")
+        return std::make_shared<R2Sampler>(dimension, true, seed);
+
+    THROW_EXCEPTION(std::invalid_argument, "Unknown manifold sampler '%1%'", name);
+}
@@ -0,0 +1,91 @@
+#ifndef MANIFOLD_SAMPLER_HPP_INCLUDED
+#define MANIFOLD_SAMPLER_HPP_INCLUDED
+
+/// \file
+/// Low discrepancy sequences for placing rays on the initial manifold.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "initial_conditions.hpp"
+
+namespace init_cond
+{
+    /*! \class ManifoldSampler
+     *  \brief Generates points in the unit cube that are used as manifold coordinates of the rays.
+     *  \details By default, the InitialConditionGenerator places the rays on a regular lattice. A ManifoldSampler
+     *          replaces that lattice by a sequence of points. Each point is a pure function of the ray index, so the
+     *          samplers are stateless and can be shared between threads.
+     *
+     *          For smooth observables, low discrepancy sequences converge faster than the lattice and do not alias with
+     *          periodic structures of the potential. The scrambled variants randomize the sequence (controlled by a
+     *          seed), which allows to estimate the error from independent repetitions.
+     */
+    class ManifoldSampler
+    {
+    public:
+        explicit ManifoldSampler(std::size_t dimension);
+        virtual ~ManifoldSampler() = default;
+
+        /// dimension of the generated points.
+        std::size_t getDimension() const;
+
+        /// writes the point with index \p index into \p target, which has to have getDimension() entries.
+        /// All coordinates are in the open interval (0, 1).
+        virtual void sample(std::uint64_t index, manifold_pos& target) const = 0;
+
+    private:
+        std::size_t mDimension;
+    };
+
+    /*! \class SobolSampler
+     *  \brief Sobol sequence with the direction numbers of Joe and Kuo, for up to SobolSampler::MAX_DIMENSION dimensions.
+     *  \details If scrambled, a nested uniform (Owen) scrambling is applied to each coordinate, using the hash based
+     *          construction of Laine and Karras with a separate seed per dimension.
+     */
+    class SobolSampler final : public ManifoldSampler
+    {
+    public:
+        /// manifold positions are stored in gen_vect, so more dimensions are never needed.
+        static constexpr std::size_t MAX_DIMENSION = 3;
+
+        SobolSampler(std::size_t dimension, bool scrambled = false, std::uint32_t seed = 0);
+
+        void sample(std::uint64_t index, manifold_pos& target) const override;
+
+    private:
+        std::vector<std::vector<std::uint32_t>> mDirections;
+        std::vector<std::uint32_t> mScrambleSeeds;
+        bool mScrambled;
+    };
+
+    /*! \class R2Sampler
+     *  \brief Additive recurrence based on the generalized golden ratio (Roberts' R_d sequence).
+     *  \details Point n is frac(s + n * alpha), where alpha_j = phi_d^-(j+1) and phi_d is the unique positive root of
+     *          x^(d+1) = x + 1. The unshifted sequence uses s = 1/2, the shifted variant a random offset derived from
+     *          the seed (a Cranley-Patterson rotation).
+     */
+    class R2Sampler final : public ManifoldSampler
+    {
+    public:
+        R2Sampler(std::size_t dimension, bool shifted = false, std::uint32_t seed = 0);
+
+        void sample(std::uint64_t index, manifold_pos& target) const override;
+
+    private:
+        // the recurrence is evaluated in 64 bit fixed point, so the points stay exact for arbitrarily many rays.
+        std::vector<std::uint64_t> mAlpha;
+        std::vector<std::uint64_t> mOffset;
+    };
+
+    /*! \brief creates a sampler from its name.
+     *  \param name One of "lattice", "sobol", "sobol_scrambled", "r2" or "r2_shifted". For "lattice", a null pointer
+     *              is returned, which makes the generator use its regular lattice.
+     *  \throw std::invalid_argument if \p name is unknown or the sampler does not support \p dimension dimensions.
+     */
+    std::shared_ptr<const ManifoldSampler> createManifoldSampler(const std::string& name, std::size_t dimension,
+                                                                 std::uint32_t seed = 0);
+}
+
+#endif // MANIFOLD_SAMPLER_HPP_INCLUDED
@@ -33,6 +33,7 @@ namespace init_cond
 
         void generate(gen_vect& ray_position, gen_vect& ray_velocity,
                       const manifold_pos& manifold_position) const override;
+        bool isGenerationReentrant() const override { return true; }
 
         // configuration
         void setInitialVelocity( gen_vect vel );
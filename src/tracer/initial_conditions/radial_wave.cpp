@@ -75,6 +75,14 @@ void RadialWave3D::init_generator(MultiIndex& manifold_index)
     std::cout << "azimuth range: " << range << "\n";
 }
 
+void RadialWave3D::warp_sample(manifold_pos& pos) const
+{
+    // the lattice rows get shorter towards the poles. For uniformly distributed directions, sin(theta) has to be
+    // uniformly distributed, instead of theta itself.
+    double theta = std::asin( 2 * pos[0] - 1 );
+    pos[0] = theta / pi + 0.5;
+}
+
 /// generate next IC
 void RadialWave3D::generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& params) const
 {
@@ -25,6 +25,7 @@ namespace init_cond
 
         /// generate next IC
         void generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& position) const override;
+        bool isGenerationReentrant() const override { return true; }
 
         void setOrigin(const gen_vect& pos);
         const gen_vect& getOrigin() const;
@@ -52,10 +53,15 @@ namespace init_cond
         explicit RadialWave3D(std::size_t dim);
 
         virtual void init_generator(MultiIndex& manifold_index);
+        void warp_sample(manifold_pos& pos) const override;
+        /// the rows of the lattice are equidistant in latitude, not in its sine.
+        bool hasUniformLattice() const override { return false; }
 
         void next_trajectory(const manifold_pos& pos, MultiIndex& index) override;
         /// generate next IC
         void generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& params) const override;
+        /// next_trajectory() only adjusts the lattice, generate() depends on the manifold position alone.
+        bool isGenerationReentrant() const override { return true; }
 
         void setOrigin(const gen_vect& pos);
         const gen_vect& getOrigin() const;
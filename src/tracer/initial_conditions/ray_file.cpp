@@ -0,0 +1,111 @@
+#include "ray_file.hpp"
+#include "fileIO.hpp"
+#include "global.hpp"
+#include <cstring>
+
+using namespace init_cond;
+
+namespace
+{
+    const char RAY_FILE_HEADER[] = "rays001\n";
+    /// header string and three integers
+    constexpr std::size_t RAY_FILE_DATA_OFFSET = 8 + 3 * sizeof(std::uint64_t);
+
+    std::uint64_t readHeaderInteger(const char* data, unsigned index)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, data + 8 + index * sizeof(value), sizeof(value));
+        return value;
+    }
+}
+
+RayFile::RayFile(std::size_t dim, const std::string& file_name) :
+        InitialConditionGenerator(dim, dim - 1, "file"),
+        mFile( new MappedFile(file_name) )
+{
+    if(mFile->size() < RAY_FILE_DATA_OFFSET || std::memcmp(mFile->data(), RAY_FILE_HEADER, 8) != 0)
+        THROW_EXCEPTION( std::runtime_error, "%1% is not a ray file", file_name );
+
+    std::uint64_t dimension = readHeaderInteger(mFile->data(), 0);
+    std::uint64_t weighted = readHeaderInteger(mFile->data(), 1);
+    mFileRecordCount = readHeaderInteger(mFile->data(), 2);
+    if(dimension != dim)
+        THROW_EXCEPTION( std::runtime_error, "ray file %1% contains %2% dimensional rays, expected %3%", file_name,
+                         dimension, dim );
+    if(weighted > 1)
+        THROW_EXCEPTION( std::runtime_error, "invalid weight flag %1% in ray file %2%", weighted, file_name );
+
+    if(mFileRecordCount == 0)
+        THROW_EXCEPTION( std::runtime_error, "ray file %1% contains no rays", file_name );
+
+    mWeighted = weighted == 1;
+    mRecordSize = (2 * dim + (mWeighted ? 1 : 0)) * sizeof(double);
+    if((mFile->size() - RAY_FILE_DATA_OFFSET) / mRecordSize < mFileRecordCount)
+        THROW_EXCEPTION( std::runtime_error, "ray file %1% is truncated: %2% bytes for %3% rays", file_name,
+                         mFile->size(), mFileRecordCount );
+
+    mRecords = mFile->data() + RAY_FILE_DATA_OFFSET;
+    mCount = mFileRecordCount;
+    mFile->adviseSequential();
+}
+
+RayFile::RayFile(std::size_t dim, const double* records, std::uint64_t count, bool weighted) :
+        InitialConditionGenerator(dim, dim - 1, "file"),
+        mRecords( reinterpret_cast<const char*>(records) ),
+        mRecordSize( (2 * dim + (weighted ? 1 : 0)) * sizeof(double) ),
+        mWeighted( weighted ),
+        mFileRecordCount( count ),
+        mCount( count )
+{
+    if(count == 0)
+        THROW_EXCEPTION( std::invalid_argument, "no rays given" );
+    if(!records)
+        THROW_EXCEPTION( std::invalid_argument, "%1% rays requested, but no records given", count );
+}
+
+RayFile::~RayFile() = default;
+
+void RayFile::selectRecords(std::uint64_t first, std::uint64_t count)
+{
+    if(count == 0)
+        THROW_EXCEPTION( std::invalid_argument, "no records selected, starting at record %1% of %2%", first,
+                         mFileRecordCount );
+    if(first > mFileRecordCount || count > mFileRecordCount - first)
+        THROW_EXCEPTION( std::out_of_range, "records %1% to %2% requested, but ray file contains %3%", first,
+                         first + count, mFileRecordCount );
+    mFirst = first;
+    mCount = count;
+}
+
+std::uint64_t RayFile::getFileRecordCount() const
+{
+    return mFileRecordCount;
+}
+
+bool RayFile::isWeighted() const
+{
+    return mWeighted;
+}
+
+void RayFile::generate(gen_vect&, gen_vect&, const manifold_pos&) const
+{
+    THROW_EXCEPTION( std::logic_error, "RayFile rays are read from records, not generated from the manifold." );
+}
+
+std::uint64_t RayFile::getRecordCount() const
+{
+    return mCount;
+}
+
+double RayFile::read_record(std::uint64_t record, gen_vect& ray_position, gen_vect& ray_velocity) const
+{
+    const char* source = mRecords + (mFirst + record) * mRecordSize;
+    const std::size_t vector_size = mWorldDimension * sizeof(double);
+    std::memcpy(&ray_position[0], source, vector_size);
+    std::memcpy(&ray_velocity[0], source + vector_size, vector_size);
+
+    double weight = 1.0;
+    if(mWeighted)
+        std::memcpy(&weight, source + 2 * vector_size, sizeof(weight));
+    return weight;
+}
@@ -0,0 +1,73 @@
+#ifndef RAY_FILE_HPP_INCLUDED
+#define RAY_FILE_HPP_INCLUDED
+
+#include "initial_conditions.hpp"
+#include <memory>
+#include <string>
+
+class MappedFile;
+
+namespace init_cond
+{
+    /*! \class RayFile
+     *  \brief Reads the initial rays from a binary file.
+     *  \details The file is memory mapped, so it may contain more rays than fit into memory. Its format is
+     *          \code
+     *              "rays001\n"
+     *              uint64 dimension
+     *              uint64 weighted     1 if the records contain a weight, otherwise 0.
+     *              uint64 count        number of records.
+     *              count records of    double position[dimension], double velocity[dimension], [double weight]
+     *          \endcode
+     *          Positions are given in world coordinates, i.e. the support and offset of the configuration are not
+     *          applied, but the energy is normalized if requested. The python class `branchedflowsim.io.RayFile`
+     *          writes these files, and can extract the rays from the output of a TrajectoryObserver.
+     *
+     *          The records can also be given in memory, which the python bindings use for numpy arrays.
+     *
+     *          The rays do not come from a manifold, so the deltas are zero and caustics cannot be detected.
+     *
+     *          Tests can be found in `tracer/test/ray_file_test.cpp`.
+     */
+    class RayFile final : public InitialConditionGenerator
+    {
+    public:
+        /// opens the ray file \p file_name for a \p dim dimensional world.
+        /// \throw std::runtime_error if the file cannot be read, or does not contain any rays of dimension \p dim.
+        RayFile(std::size_t dim, const std::string& file_name);
+        /// uses the \p count records at \p records, laid out as in a ray file, as rays for a \p dim dimensional
+        /// world. The records are not copied, so they have to outlive the generator.
+        /// \throw std::invalid_argument if there are no records.
+        RayFile(std::size_t dim, const double* records, std::uint64_t count, bool weighted);
+        ~RayFile();
+
+        /// restricts the rays to the \p count records starting with record \p first.
+        /// \throw std::invalid_argument if \p count is zero.
+        /// \throw std::out_of_range if the range exceeds the file.
+        void selectRecords(std::uint64_t first, std::uint64_t count);
+
+        /// number of records in the file.
+        std::uint64_t getFileRecordCount() const;
+
+        /// whether the records contain weights.
+        bool isWeighted() const;
+
+    private:
+        void generate(gen_vect& ray_position, gen_vect& ray_velocity, const manifold_pos& params) const override;
+        std::uint64_t getRecordCount() const override;
+        double read_record(std::uint64_t record, gen_vect& ray_position, gen_vect& ray_velocity) const override;
+
+        std::unique_ptr<MappedFile> mFile;
+        /// start of the first record in the file.
+        const char* mRecords = nullptr;
+        std::size_t mRecordSize = 0;
+        bool mWeighted = false;
+        std::uint64_t mFileRecordCount = 0;
+
+        /// selected range of records
+        std::uint64_t mFirst = 0;
+        std::uint64_t mCount = 0;
+    };
+}
+
+#endif // RAY_FILE_HPP_INCLUDED
@@ -1,6 +1,9 @@
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
 #include <string>
 #include <boost/lexical_cast.hpp>
 #include "fileIO.hpp"
@@ -8,15 +11,62 @@
 #include "trace_args.h"
 #include "tracer.hpp"
 #include "tracer_factory.h"
+#include "daemon.hpp"
 #include "initial_conditions_fwd.hpp"
 #include "observers/observer.hpp"
 #include "profiling.hpp"
+#include "thread_pool.hpp"
 #include <boost/exception/diagnostic_information.hpp>
 #include <chrono>
+#include <future>
+#include <memory>
 
 using namespace std;
 
-void trace( const std::shared_ptr<Tracer>& tracer );
+namespace
+{
+	/// tracer that is stopped by SIGTERM and SIGINT
+	std::atomic<Tracer*> stop_target{nullptr};
+
+	void stop_tracing(int signal)
+	{
+		// a second signal terminates immediately
+		std::signal( signal, SIG_DFL );
+		if( Tracer* tracer = stop_target.load() )
+			tracer->requestStop();
+	}
+
+	/// daemon that is stopped by SIGTERM and SIGINT
+	std::atomic<TraceDaemon*> stop_daemon{nullptr};
+
+	void stop_serving(int signal)
+	{
+		std::signal( signal, SIG_DFL );
+		if( TraceDaemon* daemon = stop_daemon.load() )
+			daemon->stop();
+	}
+
+	/// parses a shard given as "i/N" into the index i and the count N.
+	std::pair<std::size_t, std::size_t> parse_shard( const std::string& shard )
+	{
+		std::size_t slash = shard.find( '/' );
+		try
+		{
+			if( slash != std::string::npos )
+			{
+				std::size_t index = boost::lexical_cast<std::size_t>( shard.substr( 0, slash ) );
+				std::size_t count = boost::lexical_cast<std::size_t>( shard.substr( slash + 1 ) );
+				if( index < count )
+					return std::make_pair( index, count );
+			}
+		} catch( const boost::bad_lexical_cast& )
+		{
+		}
+		THROW_EXCEPTION( std::invalid_argument, "--shard expects i/N with 0 <= i < N, got %1%", shard );
+	}
+}
+
+void trace( const std::shared_ptr<Tracer>& tracer, std::ostream& info );
 void print_duration(std::ostream& stream, std::string intro, std::chrono::high_resolution_clock::time_point start)
 {
     auto dur = std::chrono::high_resolution_clock::now() - start;
@@ -30,18 +80,36 @@ int main(int argc, char* argv[])
 	try
 	{
 		parse_parameters(argc, argv);
+		if( !targs::profile_trace.empty() )
+			ProfileRecord::enable_tracing();
+		if( targs::hw_counters && !ProfileRecord::enable_hardware_counters() )
+			std::cerr << "hardware counters are not available, profiling wall time only (check /proc/sys/kernel/perf_event_paranoid).\n";
 
 		setMaximumMemoryAvailable( targs::memory_avail * 1024 * 1024 );
+		ThreadPool::configureGlobal( std::min( targs::thread_count, std::max( 1u, std::thread::hardware_concurrency() ) ),
+		                             targs::pin_threads );
 
 		/// \todo allow rand init
 		srand(0);
 
+		if( !targs::daemon_socket.empty() )
+		{
+			TraceDaemon daemon( targs::daemon_socket, targs::cache_memory * 1024 * 1024 );
+			stop_daemon = &daemon;
+			std::signal( SIGTERM, stop_serving );
+			std::signal( SIGINT, stop_serving );
+			daemon.run();
+			stop_daemon = nullptr;
+			return EXIT_SUCCESS;
+		}
+
 		// ugly and security risk
 		system(("mkdir -p " + targs::result_file).c_str());
 
 
 		// set all parameters in the tracer factory
 		auto start = std::chrono::high_resolution_clock::now();
+		std::unique_ptr<MemoryPhase> setup_phase(new MemoryPhase("setup"));
 		TracerFactory factory;
 		factory.loadFile( targs::potential_source_file );
 		factory.setPeriodicBondaries( targs::periodic );
@@ -55,6 +123,7 @@ int main(int argc, char* argv[])
 		factory.setErrorBounds( targs::abs_err_bound, targs::rel_err_bound );
 		factory.setEndTime( targs::end_time );
 		factory.setIntegrator( targs::integrator );
+		factory.setNumaPolicy( targs::numa_policy );
 		factory.setTimeStep( targs::time_step );
 
 		// save general data file
@@ -73,10 +142,29 @@ int main(int argc, char* argv[])
 		std::size_t total_particles = 0;
 		std::shared_ptr<Tracer> tracer = factory.createTracer( );
         print_duration(std::cout, "setup took ", start);
+		gdata << "# setup time [s] " << std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() << "\n";
+		setup_phase.reset();
+		if( getBytesInUse() > getMaximumMemoryAvailable() )
+		{
+			std::cerr << "memory use after setup (" << getBytesInUse() / 1024 / 1024 << " MB) already exceeds the "
+			          << "--memory limit, no optional memory will be allocated during tracing.\n";
+		}
 
-		trace( tracer );
+		trace( tracer, gdata );
 		total_particles = tracer->getTracedParticleCount();
 		gdata << "# particles " << total_particles << "\n";
+		gdata << "# peak memory [MB] " << getPeakResidentBytes() / 1048576.0 << "\n";
+
+		// profiling output
+		if( targs::print_profile )
+		{
+			ProfileRecord::print_profiling_data();
+			MemoryPhase::print_memory_phases(std::cout);
+		}
+		if( !targs::profile_trace.empty() )
+		{
+			writeFileAtomic(targs::profile_trace, [](std::ostream& out) { ProfileRecord::write_trace(out); });
+		}
 	} catch (std::exception& e)
 	{
 		std::cerr << boost::diagnostic_information(e) << "\n";
@@ -86,15 +174,58 @@ int main(int argc, char* argv[])
     return EXIT_SUCCESS;
 }
 
-void trace( const std::shared_ptr<Tracer>& tracer )
+void trace( const std::shared_ptr<Tracer>& tracer, std::ostream& info )
 {
 	// initial condition generator
 	auto generator = createInitialConditionGenerator( tracer->getDimension(), targs::incoming_wave );
 	auto start = std::chrono::high_resolution_clock::now();
     InitialConditionConfiguration config;
     config.setParticleCount(targs::NUM_OF_PARTICLES).setEnergyNormalization(!targs::no_norm_energy);
-	auto result = tracer->trace( generator, config);
+
+	std::string checkpoint_file = targs::result_file + "/checkpoint.dat";
+	tracer->setCheckpoint( checkpoint_file, targs::checkpoint_interval );
+	if( targs::resume )
+	{
+		if( std::ifstream(checkpoint_file) )
+			tracer->setResumeFile( checkpoint_file );
+		else
+			std::cout << "no checkpoint in " << targs::result_file << ", starting from the first ray.\n";
+	}
+
+	if( !targs::shard.empty() )
+	{
+		auto shard = parse_shard( targs::shard );
+		generator->setShard( shard.first, shard.second );
+		ShardResult description;
+		description.mShardIndex = shard.first;
+		description.mShardCount = shard.second;
+		description.mObserverConfig = targs::observers;
+		tracer->setShardFile( targs::result_file + "/shard.dat", std::move(description) );
+		info << "# shard " << targs::shard << "\n";
+	}
+
+	tracer->setTimeBudget( targs::time_budget );
+	tracer->setStatusFile( targs::result_file + "/status.json", targs::status_interval );
+	stop_target = tracer.get();
+	std::signal( SIGTERM, stop_tracing );
+	std::signal( SIGINT, stop_tracing );
+
+	TraceResult result;
+	{
+		MemoryPhase phase("trace");
+		result = tracer->trace( generator, config);
+	}
+	std::signal( SIGTERM, SIG_DFL );
+	std::signal( SIGINT, SIG_DFL );
+	stop_target = nullptr;
     print_duration(std::cout, "calculation took ", start);
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "integration steps: " << result.mStepCount << "\n";
+	info << "# integration steps " << result.mStepCount << "\n";
+	info << "# stopped early " << result.mStoppedEarly << "\n";
+	if( result.mStoppedEarly )
+		std::cout << "tracing was stopped early, the results contain " << result.mParticleCount << " rays.\n";
+	info << "# trace time [s] " << seconds << "\n";
 
 	std::cout << "maximum energy deviation: " <<  result.mMaximumEnergyDeviation * 100 << "% \n";
 	if(result.mMaximumEnergyDeviation > 1e-3) {
@@ -102,20 +233,16 @@ void trace( const std::shared_ptr<Tracer>& tracer )
 				  " low or its strength too high. The mean energy deviation was " << result.mMeanEnergyDeviation * 100
 				<< "%.\n";
 	}
-	for(const auto& o : tracer->getObservers())
+
+	start = std::chrono::high_resolution_clock::now();
+	bool saved;
 	{
-		try {
-			std::string filename = targs::result_file + "/" + o->filename();
-			std::fstream out(filename, std::fstream::out | std::fstream::binary);
-			if (!out.is_open()) {
-				THROW_EXCEPTION(std::runtime_error, "could not create data file %1% : %2%", filename,
-								std::strerror(errno));
-			} else {
-				o->save(out);
-			}
-		// catch the exception here, so in case one observer cannot be saved we still might save the others.
-		} catch (const std::exception& error) {
-			std::cerr << boost::diagnostic_information(error) << "\n";
-		}
+		MemoryPhase phase("save");
+		saved = tracer->saveObservers( targs::result_file );
 	}
+	// the checkpoint is only needed until the results are safely saved.
+	if( saved )
+		std::remove( checkpoint_file.c_str() );
+	print_duration(std::cout, "saving took ", start);
+	info << "# save time [s] " << std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() << "\n";
 }
@@ -0,0 +1,187 @@
+/*! \file merge.cpp
+	\brief Combines the results of the shards of a trace (see the `--shard` option of the tracer) into the results
+			of the complete trace.
+	\details The observers are recreated from the configuration stored in the shard files, the saved data of each
+			shard is restored into them and merged with ThreadLocalObserver::merge(), which uses the same combine()
+			logic as for the thread copies of a single trace. Finally, the observers are normalized with the total
+			number of particles of all shards and saved as the tracer would have done.
+*/
+
+#include "checkpoint.hpp"
+#include "fileIO.hpp"
+#include "potential.hpp"
+#include "tracer_factory.h"
+#include "observers/observer.hpp"
+#include "observers/energy_error_observer.hpp"
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace po = boost::program_options;
+
+namespace
+{
+	/// reads the shard file \p path, or the shard.dat in the result path \p path.
+	ShardResult load_shard( const std::string& path )
+	{
+		std::ifstream file( path + "/shard.dat", std::ios::in | std::ios::binary );
+		if( !file )
+			file.open( path, std::ios::in | std::ios::binary );
+		if( !file )
+			THROW_EXCEPTION( std::runtime_error, "Could not open shard file %1%", path );
+		return readShardResult( file );
+	}
+
+	/// checks that \p shard belongs to the same trace as \p first.
+	void check_compatible( const ShardResult& first, const ShardResult& shard )
+	{
+		if( shard.mShardCount != first.mShardCount )
+			THROW_EXCEPTION( std::runtime_error, "Shard %1% is one of %2% shards, expected %3%", shard.mShardIndex,
+							 shard.mShardCount, first.mShardCount );
+		if( shard.mExtents != first.mExtents || shard.mSupport != first.mSupport )
+			THROW_EXCEPTION( std::runtime_error, "Shard %1% was traced in a different potential", shard.mShardIndex );
+		if( shard.mObserverConfig != first.mObserverConfig )
+			THROW_EXCEPTION( std::runtime_error, "Shard %1% uses different observers", shard.mShardIndex );
+		if( shard.mState.mGeneratorType != first.mState.mGeneratorType ||
+			shard.mState.mRequestedParticles != first.mState.mRequestedParticles )
+			THROW_EXCEPTION( std::runtime_error, "Shard %1% was traced with %2% rays of the %3% generator",
+							 shard.mShardIndex, shard.mState.mRequestedParticles, shard.mState.mGeneratorType );
+	}
+
+	/// creates the observers of the trace, with the data of \p shard.
+	std::vector<std::shared_ptr<ThreadLocalObserver>> restore_observers( const TracerFactory& factory,
+																		   const ShardResult& shard )
+	{
+		// the energy error observer is always added by the tracer
+		std::vector<std::shared_ptr<Observer>> created = factory.createObservers();
+		created.push_back( std::make_shared<EnergyErrorObserver>() );
+
+		std::vector<std::shared_ptr<ThreadLocalObserver>> observers;
+		for( const auto& observer : created )
+		{
+			auto local = std::dynamic_pointer_cast<ThreadLocalObserver>( observer );
+			if( !local )
+				THROW_EXCEPTION( std::runtime_error, "Observer %1% cannot be merged", observer->filename() );
+
+			auto saved = std::find_if( shard.mState.mObservers.begin(), shard.mState.mObservers.end(),
+									   [&local](const std::pair<std::string, std::string>& entry)
+									   { return entry.first == local->filename(); } );
+			if( saved == shard.mState.mObservers.end() )
+				THROW_EXCEPTION( std::runtime_error, "Shard %1% contains no data for observer %2%", shard.mShardIndex,
+								 local->filename() );
+			std::istringstream data( saved->second );
+			local->deserialize( data );
+			if( !data || data.peek() != std::char_traits<char>::eof() )
+				THROW_EXCEPTION( std::runtime_error, "Data of observer %1% in shard %2% is corrupt", saved->first,
+								 shard.mShardIndex );
+			observers.push_back( std::move(local) );
+		}
+		return observers;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string result_path;
+	std::vector<std::string> shard_paths;
+	bool allow_missing = false;
+
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help,h", "Produce help message.")
+		("result-path,r", po::value<std::string>(&result_path)->default_value("result"), "Path to which the merged results are saved.")
+		("shards", po::value<std::vector<std::string>>(&shard_paths)->multitoken(), "Result paths of the shards, or their shard.dat files.")
+		("allow-missing", po::bool_switch(&allow_missing), "Merge the given shards even if some shards of the trace are missing.")
+	;
+	po::positional_options_description p;
+	p.add("shards", -1);
+
+	try
+	{
+		po::variables_map vm;
+		po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
+		po::notify(vm);
+		if( vm.count("help") || shard_paths.empty() )
+		{
+			std::cout << "usage: tracer_merge [options] shard...\n" << desc << "\n";
+			return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		std::vector<ShardResult> shards;
+		for( const auto& path : shard_paths )
+			shards.push_back( load_shard( path ) );
+
+		// the shards are merged in the order of their rays, so the renumbered trajectories follow that order
+		std::sort( shards.begin(), shards.end(), [](const ShardResult& a, const ShardResult& b)
+		{
+			return a.mShardIndex < b.mShardIndex;
+		} );
+		for( std::size_t i = 0; i < shards.size(); ++i )
+		{
+			check_compatible( shards.front(), shards[i] );
+			if( i > 0 && shards[i].mShardIndex == shards[i - 1].mShardIndex )
+				THROW_EXCEPTION( std::runtime_error, "Shard %1% is given twice", shards[i].mShardIndex );
+		}
+		if( shards.size() != shards.front().mShardCount )
+		{
+			if( !allow_missing )
+				THROW_EXCEPTION( std::runtime_error, "Got %1% of %2% shards", shards.size(), shards.front().mShardCount );
+			std::cerr << "merging " << shards.size() << " of " << shards.front().mShardCount << " shards\n";
+		}
+
+		TracerFactory factory;
+		factory.setPotential( Potential( shards.front().mExtents, shards.front().mSupport ) );
+		factory.setObserverConfig( shards.front().mObserverConfig );
+
+		auto observers = restore_observers( factory, shards.front() );
+		std::uint64_t rays = shards.front().mState.mRayCount;
+		std::uint64_t particles = shards.front().mState.mParticleCount;
+		std::uint64_t steps = shards.front().mState.mStepCount;
+		for( std::size_t i = 1; i < shards.size(); ++i )
+		{
+			auto added = restore_observers( factory, shards[i] );
+			for( std::size_t j = 0; j < observers.size(); ++j )
+				observers[j]->merge( *added[j], rays );
+			rays += shards[i].mState.mRayCount;
+			particles += shards[i].mState.mParticleCount;
+			steps += shards[i].mState.mStepCount;
+		}
+
+		system(("mkdir -p " + result_path).c_str());
+		bool success = true;
+		for( const auto& observer : observers )
+		{
+			observer->endTracing( particles );
+			try
+			{
+				writeFileAtomic( result_path + "/" + observer->filename(), [&observer](std::ostream& out) { observer->save(out); } );
+			} catch( const std::exception& error )
+			{
+				// the other observers might still be saved
+				std::cerr << boost::diagnostic_information(error) << "\n";
+				success = false;
+			}
+		}
+
+		std::fstream info(result_path + "/config.txt", std::fstream::out);
+		info << "# merged shards\n";
+		for( const auto& shard : shards )
+			info << shard.mShardIndex << "/" << shard.mShardCount << " ";
+		info << "\n\n# observers\n";
+		for( const auto& argument : shards.front().mObserverConfig )
+			info << argument << " ";
+		info << "\n\n# rays " << rays << "\n";
+		info << "# particles " << particles << "\n";
+		info << "# integration steps " << steps << "\n";
+		std::cout << "merged " << shards.size() << " shards with " << particles << " particles\n";
+		return success ? EXIT_SUCCESS : EXIT_FAILURE;
+	} catch( std::exception& e )
+	{
+		std::cerr << boost::diagnostic_information(e) << "\n";
+		return EXIT_FAILURE;
+	}
+}
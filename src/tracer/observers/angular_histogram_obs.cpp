@@ -12,7 +12,7 @@ AngularHistogramObserver::AngularHistogramObserver( std::vector<double> timeInte
     mBinCount = 2 * pi / mAngularBinSize;
     for(unsigned i = 0; i < mTimeIntervals.size(); ++i)
     {
-        mBinCounts.push_back( std::vector<std::size_t>( mBinCount, 0u ) );
+        mBinCounts.push_back( std::vector<double>( mBinCount, 0.0 ) );
     }
     
     mSumAngle.resize(mTimeIntervals.size(), 0.0);
@@ -35,11 +35,32 @@ void AngularHistogramObserver::combine(ThreadLocalObserver& other)
     }
 }
 
+void AngularHistogramObserver::serialize(std::ostream& target)
+{
+    writeInteger(target, mBinCounts.size());
+    writeInteger(target, mBinCount);
+    for(const auto& bins : mBinCounts)
+        writeFloats(target, bins);
+    writeFloats(target, mSumAngle);
+    writeFloats(target, mSumSquared);
+}
+
+void AngularHistogramObserver::deserialize(std::istream& source)
+{
+    readCheckpointSize(source, mBinCounts.size());
+    readCheckpointSize(source, mBinCount);
+    for(auto& bins : mBinCounts)
+        readFloats(source, bins.data(), bins.size());
+    readFloats(source, mSumAngle.data(), mSumAngle.size());
+    readFloats(source, mSumSquared.data(), mSumSquared.size());
+}
+
 void AngularHistogramObserver::startTrajectory( const InitialCondition& start, std::size_t )
 {
     mOldVelocity = start.getState().getVelocity();
     mLastObservedTime = 0;
     mOldTime = 0;
+    mWeight = start.getWeight();
 }
 
 bool AngularHistogramObserver::watch( const State& state, double t )
@@ -61,8 +82,8 @@ bool AngularHistogramObserver::watch( const State& state, double t )
                                             rtime);
         record( mBinCounts[mLastObservedTime], interpol );
         double angle = std::atan2(interpol[1], interpol[0]); // in [-pi, pi]
-        mSumAngle[mLastObservedTime] += angle;
-        mSumSquared[mLastObservedTime] += angle * angle;
+        mSumAngle[mLastObservedTime] += mWeight * angle;
+        mSumSquared[mLastObservedTime] += mWeight * angle * angle;
         ++mLastObservedTime;
         // finished after last time
         if( mLastObservedTime >= mTimeIntervals.size() )
@@ -77,7 +98,7 @@ bool AngularHistogramObserver::watch( const State& state, double t )
     return true;
 }
 
-void AngularHistogramObserver::record( std::vector<std::size_t>& histogram, const gen_vect& velocity )
+void AngularHistogramObserver::record( std::vector<double>& histogram, const gen_vect& velocity )
 {
     /// \todo this only makes sense for 2D?
     double angle = std::atan2(velocity[1], velocity[0]); // in [-pi, pi]
@@ -85,26 +106,26 @@ void AngularHistogramObserver::record( std::vector<std::size_t>& histogram, cons
     std::size_t index = pos_angle / mAngularBinSize;
     // make sure that we don't get an overflow due to a rounding problem
     if(index == histogram.size()) index = histogram.size() - 1;
-    histogram[index] += 1;
+    histogram[index] += mWeight;
 }
 
 void AngularHistogramObserver::save( std::ostream& save_file )
 {
     /*! Angular Histogram save file format.
-        Header: ang001\\n
+        Header: angh002\\n
         Data type     | Count | Meaning
         ---------     | ----- | -------
         Int [\#H]     | 1     | Number of histograms
         Int    [\#B]  | 1     | Number of bins per histogram
         Double        | \#H   | Histogram times
         Double        | \#B   | Bin angles (radians)
-        Double        | \#H   | Sum of angle
-        Double        | \#H   | Sum of angle squares
-        Int           | \#H * \#B | Angle counts
+        Double        | \#H   | Weighted sum of angle
+        Double        | \#H   | Weighted sum of angle squares
+        Double        | \#H * \#B | Weighted angle counts
     */
 
     // file header
-    save_file << "angh001\n";
+    save_file << "angh002\n";
     writeInteger(save_file, mBinCounts.size());
     writeInteger(save_file, mBinCounts.front().size());
     // write times
@@ -118,15 +139,21 @@ void AngularHistogramObserver::save( std::ostream& save_file )
     writeFloats(save_file, mSumAngle);
     writeFloats(save_file, mSumSquared);
 
-    for( auto& bins : mBinCounts ) 
+    for( auto& bins : mBinCounts )
     {
-        for( auto count : bins)    writeInteger(save_file, count);
+        writeFloats(save_file, bins);
     }
-    
-    
 }
 
 std::shared_ptr<ThreadLocalObserver> AngularHistogramObserver::clone() const
 {
     return std::make_shared<AngularHistogramObserver>( mTimeIntervals, mAngularBinSize, filename() );
 }
+
+std::vector<ResultArray> AngularHistogramObserver::getResultArrays() const
+{
+    std::vector<ResultArray> arrays{ResultArray("sum_angles", mSumAngle), ResultArray("sum_angles_squared", mSumSquared)};
+    for(std::size_t i = 0; i < mBinCounts.size(); ++i)
+        arrays.emplace_back("counts_" + std::to_string(i), mBinCounts[i]);
+    return arrays;
+}
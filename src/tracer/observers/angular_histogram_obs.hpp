@@ -19,13 +19,17 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save( std::ostream& target ) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
+    /// the sums of the angles and their squares, and the counts of each histogram as `counts_<i>`.
+    std::vector<ResultArray> getResultArrays() const override;
 
 private:
     // thread local specific functions
     std::shared_ptr<ThreadLocalObserver> clone() const override;
     void combine(ThreadLocalObserver& other) override;
 
-    void record( std::vector<std::size_t>& histogram, const gen_vect& velocity );
+    void record( std::vector<double>& histogram, const gen_vect& velocity );
 
     // config
     double mAngularBinSize;
@@ -33,12 +37,14 @@ private:
     std::vector<double> mTimeIntervals;
 
     // data
-    std::vector<std::vector<std::size_t>> mBinCounts;
+    /// weighted number of rays per bin
+    std::vector<std::vector<double>> mBinCounts;
     std::vector<double> mSumAngle;
     std::vector<double> mSumSquared;
     unsigned mLastObservedTime = 0;
     gen_vect mOldVelocity;
     double mOldTime;
+    double mWeight = 1.0;
 
 };
 
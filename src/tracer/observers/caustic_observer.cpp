@@ -51,6 +51,10 @@ void CausticObserver::startTrajectory( const InitialCondition& start, std::size_
 
 bool CausticObserver::watch( const State& state, double t )
 {
+    // a correction ray repeats a trajectory whose caustics have already been recorded
+    if( mCachedInitialCondition->isCorrection() )
+        return false;
+
     // calculate enclosed volume
     double signed_area = 0;
     if( mDimension == 2)
@@ -106,8 +110,39 @@ void CausticObserver::save(std::ostream& target)
     writeInteger(target, mDimension );
     writeInteger(target, mCausticPositions.size() );
 
+    BinaryWriter writer(target);
+    for(const auto& c : mCausticPositions)
+        c.write(writer);
+    writer.flush();
+}
+
+void CausticObserver::serialize(std::ostream& target)
+{
+    writeInteger(target, mParticleNumber );
+    writeInteger(target, mCausticPositions.size() );
+    BinaryWriter writer(target);
     for(const auto& c : mCausticPositions)
-        c.write(target);
+        c.write(writer);
+    writer.flush();
+}
+
+void CausticObserver::deserialize(std::istream& source)
+{
+    readInteger(source, mParticleNumber );
+    std::uint64_t count = readInteger(source);
+    mCausticPositions.clear();
+    for(std::uint64_t i = 0; i < count && source; ++i)
+    {
+        mCausticPositions.emplace_back( mDimension );
+        mCausticPositions.back().read( source );
+    }
+}
+
+void CausticObserver::shiftTrajectoryNumbers(std::size_t offset)
+{
+    for(auto& c : mCausticPositions)
+        c.setTrajectoryID( c.getTrajectoryID() + offset );
+    mParticleNumber += offset;
 }
 
 //
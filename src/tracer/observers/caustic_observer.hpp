@@ -25,12 +25,15 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
 
     const container_type& getCausticPositions() const;
 
 private:
     std::shared_ptr<ThreadLocalObserver> clone() const override;
     void combine(ThreadLocalObserver& other) override;
+    void shiftTrajectoryNumbers(std::size_t offset) override;
 
     // configuration
     bool mBreakOnFirst = false;
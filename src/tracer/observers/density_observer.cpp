@@ -3,6 +3,8 @@
 #include "fileIO.hpp"
 #include "density_worker.hpp"
 #include "initial_conditions/initial_conditions.hpp"
+#include <algorithm>
+#include <functional>
 
 // ---------------------------------------------------------------------------------------------------------
 
@@ -44,13 +46,15 @@ DensityObserver::DensityObserver( std::vector<std::size_t> size, std::vector<dou
     }
 }
 
-void DensityObserver::endTracing(std::size_t particle_count)
+void DensityObserver::endTracing(std::size_t)
 {
     // finalize the worker
     mWorker->reduce();
 
-    // scale numbers to particle count
-    scaleVectorBy( mWorker->getDensity(), 1.0 / particle_count );
+    // scale numbers to particle count. With weighted rays, the sum of the weights replaces the number of
+    // particles; for unit weights, these are identical.
+    if(mWeightSum != 0)
+        scaleVectorBy( mWorker->getDensity(), 1.0 / mWeightSum );
 }
 
 void DensityObserver::startTrajectory(const InitialCondition& incoming, std::size_t)
@@ -58,6 +62,7 @@ void DensityObserver::startTrajectory(const InitialCondition& incoming, std::siz
     mDotCache.clear();
     // remember starting point in case we need to re-center.
     mStartingPosition = incoming.getState().getPosition();
+    mTrajectoryWeight = incoming.getWeight();
 }
 
 void DensityObserver::endTrajectory(const State& final_state)
@@ -65,6 +70,7 @@ void DensityObserver::endTrajectory(const State& final_state)
     mWorker->push_trajectory( mDotCache );
     assert( mDotCache.size() == 0);    // get a new, empty cache
     mWorker->work();
+    mWeightSum += mTrajectoryWeight;
 }
 
 bool DensityObserver::watch( const State& state, double time )
@@ -91,7 +97,7 @@ bool DensityObserver::watch( const State& state, double time )
             return false;
     }
     // draw scaled line
-    float weight = mExtractFunction( state );
+    float weight = mExtractFunction( state ) * mTrajectoryWeight;
     if(time > mLastTime)
         addInterpolatedLine(mLastPosition, temp, (time - mLastTime)*weight );
 
@@ -116,9 +122,48 @@ void DensityObserver::save(std::ostream& target)
     target << "dens001\n";
     writeInteger(target, mDimension);
     writeFloats(target, mSupport);
+    getDensity().dump(target, mEncoding);
+}
+
+void DensityObserver::serialize(std::ostream& target)
+{
+    // the queued trajectories have to be drawn, so that the grid contains exactly the finished rays.
+    mWorker->flush();
+    writeFloat(target, mWeightSum);
     getDensity().dump(target);
 }
 
+void DensityObserver::deserialize(std::istream& source)
+{
+    readFloat(source, mWeightSum);
+    mWorker->getDensity().reload(source);
+}
+
+void DensityObserver::merge(ThreadLocalObserver& other, std::size_t ray_offset)
+{
+    // combine() only gathers the weights, as thread copies draw into the worker of their root
+    auto& source = dynamic_cast<DensityObserver&>(other);
+    mWorker->flush();
+    source.mWorker->flush();
+    auto& density = mWorker->getDensity();
+    const auto& added = source.mWorker->getDensity();
+    if(density.getExtents() != added.getExtents())
+        THROW_EXCEPTION(std::invalid_argument, "Cannot merge densities of different size into %1%", filename());
+    std::transform(density.begin(), density.end(), added.begin(), density.begin(), std::plus<float>());
+    ThreadLocalObserver::merge(other, ray_offset);
+}
+
+void DensityObserver::reportStatus(std::map<std::string, double>& status) const
+{
+    status["density_queue"] = mWorker->getQueueSize();
+    status["density_grids"] = mWorker->getGridCount();
+}
+
+std::vector<ResultArray> DensityObserver::getResultArrays() const
+{
+    return {ResultArray("density", getDensity())};
+}
+
 const DensityObserver::density_grid_type& DensityObserver::getDensity() const
 {
     return mWorker->getDensity();
@@ -130,9 +175,10 @@ std::shared_ptr<ThreadLocalObserver> DensityObserver::clone() const
                                               mCenterOnStart, mExtractFunction, mWorker );
 }
 
-void DensityObserver::combine( ThreadLocalObserver& )
+void DensityObserver::combine( ThreadLocalObserver& other )
 {
-
+    // the density itself is accumulated by the shared worker
+    mWeightSum += dynamic_cast<DensityObserver&>(other).mWeightSum;
 }
 
 // -----------------------------------------------------------------------------------------------------
@@ -35,10 +35,18 @@ public:
 
     // save to file
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
+    void merge(ThreadLocalObserver& other, std::size_t ray_offset) override;
+    void reportStatus(std::map<std::string, double>& status) const override;
+    std::vector<ResultArray> getResultArrays() const override;
 
     // info functions
     const density_grid_type& getDensity() const;
 
+    /// sets the format in which the density grid is saved.
+    void setEncoding( GridEncoding encoding ) { mEncoding = encoding; }
+
     // type to save interpolated dot info
     struct IPDot
     {
@@ -74,6 +82,12 @@ private:
     // set to true to make trajectories centered around their starting point.
     bool mCenterOnStart;
     gen_vect mStartingPosition;
+    // weight of the current trajectory, and sum of the weights of all finished trajectories.
+    // The density is normalized to this sum.
+    double mTrajectoryWeight = 1.0;
+    double mWeightSum = 0.0;
+    // format of the saved density grid
+    GridEncoding mEncoding = GridEncoding::RAW;
 
 // needs to be public so make_shared can access this
 public:
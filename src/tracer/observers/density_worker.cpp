@@ -1,5 +1,6 @@
 #include "density_worker.hpp"
 #include "interpolation.hpp"
+#include "numa.hpp"
 
 // Configuration constants
 const int INITIAL_TRAJECTORY_RESERVE = 1020;
@@ -13,13 +14,18 @@ DensityWorker::DensityWorker(std::vector<std::size_t> size) :
     mReusePool(0),
     mMutexCount(1),
     mFreeGrids(1),
-    mCanCreateGrid( true )
+    mCanCreateGrid( true ),
+    mMultipleNodes( getNumaNodeCount() > 1 ),
+    mNodesWithGrid( 0 )
 {
     assert( mQueue.is_lock_free() );
 
     // create first grid and mutex
     mDensities.push_back( grid_type(size, TransformationType::PERIODIC) );
     mWorkMutexes.emplace_back( );
+    mGridNodes.push_back( getCurrentNumaNode() );
+    if( mGridNodes.front() < 64 )
+        mNodesWithGrid = std::uint64_t(1) << mGridNodes.front();
 }
 
 DensityWorker::~DensityWorker()
@@ -102,8 +108,34 @@ void DensityWorker::work()
     if(mFreeGrids == 0)
         return;
 
+    if( mMultipleNodes )
+    {
+        // drawing into a grid on another node is slow, so each node gets its own grid if memory permits
+        int node = getCurrentNumaNode();
+        if( !hasGridOnNode( node ) && checkForDensMem() )
+        {
+            try
+            {
+                addNodeDensity( node );
+            } catch (std::bad_alloc& ex)
+            {
+                mCanCreateGrid = false;
+            }
+        }
+        if( drawQueued( node ) )
+            return;
+    }
+
+    drawQueued( -1 );
+}
+
+bool DensityWorker::drawQueued( int node )
+{
     for(int free_index = 0; free_index < mMutexCount; ++free_index)
     {
+        if( node >= 0 && mGridNodes[ free_index ] != node )
+            continue;
+
         // try to lock the mutex, and return if another thread is currently consuming trajectories
         std::unique_lock<std::mutex> lock(mWorkMutexes[ free_index ], std::try_to_lock);
         if(! lock.owns_lock() )
@@ -125,8 +157,9 @@ void DensityWorker::work()
 
         ++mFreeGrids;
 
-        return;
+        return true;
     }
+    return false;
 }
 
 DensityWorker::grid_type& DensityWorker::getDensity()
@@ -155,9 +188,26 @@ void DensityWorker::reduce()
     while(mDensities.size() > 1)
         mDensities.pop_back();
     mWorkMutexes.resize(1);
+    mGridNodes.resize(1);
+    mNodesWithGrid = mGridNodes.front() < 64 ? std::uint64_t(1) << mGridNodes.front() : 0;
     mMutexCount = 1;
 }
 
+void DensityWorker::flush()
+{
+    trajectory_type* trajectory = nullptr;
+    while( mQueue.pop(trajectory) )
+    {
+        --mQueueSize;
+        drawTrajectory( mDensities.front(), *trajectory );
+        trajectory->clear();
+        mReusePool.push(trajectory);
+    }
+
+    reduce();
+    mFreeGrids = 1;
+}
+
 void DensityWorker::addLocalDensity()
 {
     int old_count = mMutexCount;
@@ -169,22 +219,44 @@ void DensityWorker::addLocalDensity()
         /// \todo if it fails, the maxQueueCount size should be left unaffected!
 
 
+    appendGrid( getCurrentNumaNode() );
+}
+
+void DensityWorker::addNodeDensity( int node )
+{
+    std::lock_guard<std::mutex> lock(mAddDensityMutex);
+    if( hasGridOnNode( node ) || !checkForDensMem() )
+        return;
+    appendGrid( node );
+}
+
+void DensityWorker::appendGrid( int node )
+{
     // this might allocate a lot of memory, so chances are that it could fire a bad_alloc exception
     // since push_back is exception save, the mutex will be unlocked and the function will exit with that
     // exception, as desired, so no exception handling needed here
     mDensities.push_back( grid_type( mDensities.front().getExtents(), TransformationType::PERIODIC) );
     mWorkMutexes.emplace_back( );
+    mGridNodes.push_back( node );
+    if( node < 64 )
+        mNodesWithGrid |= std::uint64_t(1) << node;
     ++mMutexCount;    // it is important that this happens after we created the new mutex
     ++mFreeGrids;
 }
 
+bool DensityWorker::hasGridOnNode( int node ) const
+{
+    // nodes beyond the mask are never given a grid of their own
+    return node >= 64 || (mNodesWithGrid & (std::uint64_t(1) << node)) != 0;
+}
+
 bool DensityWorker::checkForDensMem()
 {
     // early out
     if(!mCanCreateGrid)
         return false;
 
-    // estimate usage
+    // estimate usage of the whole process, including queued trajectories and other observers' buffers
     std::size_t memuse = getBytesInUse();
     // estimate additional size of a new grid
     // safe_product not really necessary, but convenient for code readability
@@ -5,6 +5,7 @@
 #include <boost/lockfree/queue.hpp>
 #include <thread>
 #include <atomic>
+#include <cstdint>
 #include <deque>
 
 // helper worker class
@@ -27,9 +28,18 @@ public:
     // this collects all density instances into one
     void reduce();
 
+    /// draws all queued trajectories and then combines the density instances. Must not be called
+    /// while other threads push or work on trajectories.
+    void flush();
+
     void push_trajectory( trajectory_type& trajectory);
     /// this function consumes one trajectory from the queue
     void work();
+
+    /// number of trajectories that wait to be drawn.
+    int getQueueSize() const { return mQueueSize; }
+    /// number of density grids the trajectories are drawn to.
+    int getGridCount() const { return mMutexCount; }
 private:
     /*! adds a new thread local density object and corresponding mutex, if requesting more
         memory is allowed.
@@ -38,6 +48,20 @@ private:
     */
     void addLocalDensity() noexcept(false);
 
+    /// adds a grid for NUMA node \p node, which is allocated by the calling thread, unless that node already has one.
+    /// \exception std::bad_alloc, if no new grid could be created
+    void addNodeDensity( int node ) noexcept(false);
+
+    /// appends a grid that belongs to \p node. Requires mAddDensityMutex to be locked.
+    void appendGrid( int node );
+
+    /// whether one of the grids is located on NUMA node \p node.
+    bool hasGridOnNode( int node ) const;
+
+    /// consumes queued trajectories with the first free grid, considering only grids on \p node unless it is
+    /// negative. Returns whether a grid was found.
+    bool drawQueued( int node );
+
     /// this function checks if the system is allowed to allocate more memory for
     /// an additional memory grid.
     bool checkForDensMem();
@@ -59,6 +83,8 @@ private:
     std::deque<grid_type> mDensities;
     // ...and corresponding mutexes
     std::deque<std::mutex> mWorkMutexes;
+    // ...and the NUMA nodes of the threads that allocated them
+    std::deque<int> mGridNodes;
     std::mutex mAddDensityMutex;    //!< this mutex is locked whenever the above containers are modified
 
     /// since std::deque is not thread safe, we use this variable to keep track of
@@ -72,6 +98,10 @@ private:
     // this variable tracks whether new local observers can be added. it is assumed that once the creation of one
     // fails due to a bad_alloc, system memory is used up and density grids can no longer be created
     std::atomic<bool> mCanCreateGrid;
+
+    // on machines with several NUMA nodes, threads draw to grids on their own node if possible
+    const bool mMultipleNodes;
+    std::atomic<std::uint64_t> mNodesWithGrid;    //!< bit \a n is set if a grid was allocated on node \a n
 };
 
 #endif // DENSITY_WORKER_HPP_INCLUDED
@@ -3,6 +3,7 @@
 //
 
 #include "energy_error_observer.hpp"
+#include "fileIO.hpp"
 #include "initial_conditions/initial_conditions.hpp"
 #include "dynamics/ray_dynamics.hpp"
 
@@ -69,3 +70,17 @@ void EnergyErrorObserver::startTracing()
 double EnergyErrorObserver::getMeanError() const {
     return mSum / mCount;
 }
+
+void EnergyErrorObserver::serialize(std::ostream& target)
+{
+    writeInteger(target, mCount);
+    writeFloat(target, mSum);
+    writeFloat(target, mMax);
+}
+
+void EnergyErrorObserver::deserialize(std::istream& source)
+{
+    readInteger(source, mCount);
+    readFloat(source, mSum);
+    readFloat(source, mMax);
+}
@@ -22,6 +22,8 @@ public:
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void endTrajectory(const State& final_state) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
 
     double getMaximumError() const;
     double getMeanError() const;
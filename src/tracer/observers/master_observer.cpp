@@ -3,6 +3,7 @@
 #include "ode_state.hpp"
 #include "dynamics/ray_dynamics.hpp"
 #include "initial_conditions/initial_conditions.hpp"
+#include <algorithm>
 #include <mutex>
 
 std::atomic<std::size_t> MasterObserver::mParticleCount;
@@ -10,7 +11,8 @@ std::atomic<std::size_t> MasterObserver::mParticleNumber;
 
 MasterObserver::MasterObserver( int dim, std::shared_ptr<const RayDynamics> dynamics ): 
     mDimension(dim), 
-    mDynamics( std::move(dynamics) )
+    mDynamics( std::move(dynamics) ),
+    mRayStatistics( std::make_shared<RayStatistics>() )
 {
 }
 
@@ -48,7 +50,7 @@ void MasterObserver::startTracing()
     /// \todo preallocate?
     for( const auto& f : mWatches )
     {
-        f->init(mDynamics);
+        f->init(mDynamics, mRayStatistics);
         f->startTracing();
     }
 }
@@ -157,7 +159,7 @@ MasterObserver MasterObserver::clone() const
     {
         if(!w->is_ready())
         {
-            w->init(mDynamics);
+            w->init(mDynamics, ob.mRayStatistics);
         }
     }
 
@@ -167,11 +169,31 @@ MasterObserver MasterObserver::clone() const
     return ob;
 }
 
+void MasterObserver::combineLocalWatches()
+{
+    for( auto& local : mLocalWatches )
+    {
+        if( !local->is_slave() )
+            continue;
+
+        auto fresh = local->restart();
+        fresh->init(mDynamics, mRayStatistics);
+        std::replace( mWatches.begin(), mWatches.end(), watch_type(local), watch_type(fresh) );
+        local = std::move(fresh);
+    }
+}
+
 const std::vector<MasterObserver::watch_type>& MasterObserver::getObservers() const
 {
     return mWatches;
 }
 
+void MasterObserver::restoreParticleCounts( std::size_t traced, std::size_t started )
+{
+    mParticleCount = traced;
+    mParticleNumber = started;
+}
+
 std::size_t MasterObserver::getTracedParticleCount() const
 {
     return mParticleCount;
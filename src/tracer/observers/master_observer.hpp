@@ -4,6 +4,7 @@
 #include "vector.hpp"
 #include "state.hpp"
 #include "initial_conditions_fwd.hpp"
+#include "ray_statistics.hpp"
 #include <cmath>
 #include <vector>
 #include <atomic>
@@ -58,8 +59,20 @@ public:
     /// returns number of particles traced
     std::size_t getTracedParticleCount() const;
 
+    /// sets the number of traced and of started particles, when tracing continues from a checkpoint.
+    /// Has to be called after startTracing().
+    static void restoreParticleCounts( std::size_t traced, std::size_t started );
+
+    /// \brief combines the data of the thread local watches into their roots, and continues with fresh copies.
+    /// \details Must not be called during a trajectory.
+    void combineLocalWatches();
+
     /// returns the current trajectory number
     std::size_t getCurrentTrajectory() const { return mCurrentTrajectoryNum; };
+
+    /// integration statistics of the current trajectory. These are filled in by the tracer and
+    /// passed on to the observers.
+    RayStatistics& getRayStatistics() { return *mRayStatistics; }
 private:
     // count particles
     static std::atomic<std::size_t> mParticleCount;  // incremented for each finished, valid trajectory
@@ -92,6 +105,8 @@ private:
     std::vector<TS> mCurrentTrajectory;
     std::size_t mCurrentTrajectoryNum;
     std::shared_ptr<const RayDynamics> mDynamics;
+    // kept on the heap, so observers keep a valid pointer when the master observer is moved.
+    std::shared_ptr<RayStatistics> mRayStatistics;
 };
 
 #endif // OBSERVER_HPP_INCLUDED
@@ -1,9 +1,22 @@
 #include "observer.hpp"
 #include "global.hpp"
+#include "fileIO.hpp"
+#include "dynamic_grid_base.hpp"
 #include <fstream>
 #include <cstring>
 
 
+ResultArray::ResultArray(std::string name, const DynamicGridBase& grid) :
+    mName( std::move(name) ), mData( grid.getContainer().getStartingAddress() ), mType( grid.getContainer().getType() ),
+    mShape( grid.getExtents().begin(), grid.getExtents().end() )
+{
+}
+
+ResultArray::ResultArray(std::string name, const std::vector<double>& data) :
+    mName( std::move(name) ), mData( data.data() ), mType( typeid(double) ), mShape{ data.size() }
+{
+}
+
 Observer::Observer(std::string file_name) : mFileName( std::move(file_name) )
 {
 }
@@ -18,9 +31,10 @@ const std::string Observer::filename() const {
     return mFileName;
 }
 
-void Observer::init(std::shared_ptr<const RayDynamics> dynamics)
+void Observer::init(std::shared_ptr<const RayDynamics> dynamics, std::shared_ptr<const RayStatistics> statistics)
 {
     mDynamics = std::move(dynamics);
+    mRayStatistics = std::move(statistics);
     mIsInitialized = true;
 }
 
@@ -28,6 +42,24 @@ bool Observer::is_ready() const {
     return mIsInitialized;
 }
 
+void Observer::serialize(std::ostream&)
+{
+    THROW_EXCEPTION(std::logic_error, "Observer %1% does not support checkpoints", mFileName);
+}
+
+void Observer::deserialize(std::istream&)
+{
+    THROW_EXCEPTION(std::logic_error, "Observer %1% does not support checkpoints", mFileName);
+}
+
+void Observer::readCheckpointSize(std::istream& source, std::size_t expected) const
+{
+    std::uint64_t size = readInteger(source);
+    if( size != expected )
+        THROW_EXCEPTION(std::runtime_error, "Checkpoint of observer %1% has size %2%, but %3% is configured",
+                        mFileName, size, expected);
+}
+
 // ---------------------------------------------------------------------------------------------------
 //                                 Thread Local Observer
 // ---------------------------------------------------------------------------------------------------
@@ -81,6 +113,22 @@ void ThreadLocalObserver::reduce(  )
     }
 }
 
+void ThreadLocalObserver::merge( ThreadLocalObserver& other, std::size_t ray_offset )
+{
+    other.shiftTrajectoryNumbers( ray_offset );
+    combine( other );
+}
+
+std::shared_ptr<ThreadLocalObserver> ThreadLocalObserver::restart()
+{
+    auto root = mRootObserver;
+    if( !root )
+        THROW_EXCEPTION(std::logic_error, "Observer %1% is not a thread copy", mFileName);
+
+    reduce();
+    return std::static_pointer_cast<ThreadLocalObserver>( root->makeThreadCopy() );
+}
+
 bool ThreadLocalObserver::is_root() const {
     return (bool)mRootMutex;
 }
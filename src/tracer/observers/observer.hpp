@@ -9,12 +9,31 @@
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <iosfwd>
+#include <map>
 #include <mutex>
+#include <typeindex>
+#include <vector>
 #include "state.hpp"
 #include "initial_conditions_fwd.hpp"
 
 class MasterObserver;
 class RayDynamics;
+class DynamicGridBase;
+struct RayStatistics;
+
+/// a result that an observer keeps as an array in memory, see Observer::getResultArrays().
+struct ResultArray
+{
+    /// describes the data of \p grid.
+    ResultArray( std::string name, const DynamicGridBase& grid );
+    /// describes the one dimensional array \p data.
+    ResultArray( std::string name, const std::vector<double>& data );
+
+    std::string mName;                  //!< name of the result, as in the python result class
+    const void* mData;                  //!< the first element, the elements follow in row major order
+    std::type_index mType;              //!< type of the elements
+    std::vector<std::size_t> mShape;
+};
 
 /*! \class Observer
     \brief Base class for objects that track tracing results.
@@ -33,8 +52,10 @@ public:
     /// \return True, if the observer wants further data points, false if it is finished.
     virtual bool watch(const State& state, double t) = 0;
 
-    /// Initializes the Observer before tracing.
-    void init(std::shared_ptr<const RayDynamics> dynamics);
+    /// Initializes the Observer before tracing. \p statistics points to the integration statistics
+    /// of the ray that is currently traced by the thread this observer belongs to. They are only
+    /// meaningful for thread local observers, as shared observers are called after the integration.
+    void init(std::shared_ptr<const RayDynamics> dynamics, std::shared_ptr<const RayStatistics> statistics = nullptr);
     /// Returns true if the observer has been initialized.
     bool is_ready() const;
 
@@ -62,16 +83,40 @@ public:
     /// \brief called to save the gathered results into the `target` stream. Should be in binary mode!
     virtual void save( std::ostream& target ) = 0;
 
+    /// \brief writes the data gathered so far into \p target, so that tracing can be resumed from a checkpoint.
+    /// \details Only called for the original observers, while no rays are traced and after the thread copies have
+    ///          been combined. Also used to save the results of a shard before they are normalized.
+    /// \throw std::logic_error if the observer does not support checkpoints.
+    virtual void serialize( std::ostream& target );
+
+    /// \brief restores the data written by serialize(). Called after startTracing(), before any ray is traced.
+    virtual void deserialize( std::istream& source );
+
+    /// \brief adds live information about the observer, such as queue lengths, to \p status for progress reports.
+    /// \details Called for the original observers while tracing is running, so only data that is safe to read
+    ///          concurrently may be reported. Keys should start with the name of the observer.
+    virtual void reportStatus( std::map<std::string, double>& /*status*/ ) const {};
+
+    /// \brief the results that this observer keeps as arrays in memory, so that they can be accessed without saving
+    ///        them, e.g. from python. The arrays stay valid until the observer is changed or destroyed.
+    /// \details Only meaningful for the original observers after tracing has ended. Empty by default.
+    virtual std::vector<ResultArray> getResultArrays() const { return {}; }
+
     /// \brief observer pointer for a new thread
     /// \details returns an observer pointer to an observer for a new thread. If the Observer type
     ///            can sensible be copied, returns a copy, otherwise, a pointer to this Observer.
     ///            the behaviour is implemented in the ThreadLocalObserver and ThreadSharedObserver classes.
     virtual std::shared_ptr<Observer> makeThreadCopy() = 0;
 protected:
+    /// reads a size that serialize() saved along with the data, and checks that it matches the configuration of
+    /// this observer. \throw std::runtime_error if it does not.
+    void readCheckpointSize( std::istream& source, std::size_t expected ) const;
+
     std::string mFileName;
 
     bool mIsInitialized = false;
     std::shared_ptr<const RayDynamics> mDynamics;
+    std::shared_ptr<const RayStatistics> mRayStatistics;
 };
 
 /*! \brief base class for thread local observers.
@@ -91,6 +136,13 @@ public:
     */
     void reduce();
 
+    /*! \brief combines the results gathered so far into the root object, and returns a fresh copy of the root that
+               continues in place of this observer.
+        \details Used to get a consistent state of the root observer in the middle of tracing.
+        \throw std::logic_error if this is not a thread copy.
+    */
+    std::shared_ptr<ThreadLocalObserver> restart();
+
     /*!
      * Returns whether this observer is "slaved" to a root observer. In that case you need to call
      * `reduce()` before deleting this observer.
@@ -102,6 +154,13 @@ public:
      */
     bool is_root() const;
 
+    /*! \brief adds the results of \p other, an observer with the same settings that has traced different rays.
+        \details Used to merge the shards of a trace that was split over several processes. The trajectory numbers of
+                 \p other are increased by \p ray_offset to keep them unique, then the data is combined as for a
+                 thread copy. \p other must not be used afterwards.
+    */
+    virtual void merge( ThreadLocalObserver& other, std::size_t ray_offset );
+
     std::shared_ptr<Observer> makeThreadCopy() final;
 private:
     /*! this variable points to the root observer for each clone, and to null
@@ -121,6 +180,9 @@ private:
     /// combine data from \p other into this!
     virtual void combine( ThreadLocalObserver& other ) = 0;
 
+    /// adds \p offset to the numbers of the trajectories whose data is stored individually. See merge().
+    virtual void shiftTrajectoryNumbers( std::size_t /*offset*/ ) {}
+
     /// this variable contains the mutex for protecting access to
     boost::optional<std::mutex> mRootMutex;
 };
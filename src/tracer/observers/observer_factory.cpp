@@ -9,6 +9,7 @@
 #include "potential.hpp"
 #include "factory/builder_base.hpp"
 #include "radial_density_observer.hpp"
+#include "ray_cost_observer.hpp"
 #include <fstream>
 
 
@@ -103,6 +104,9 @@ namespace {
                    )
                    << args::ArgumentSpec("file_name").optional().store(file_name).description(
                               "Name of the file in which the density will be saved."
+                   )
+                   << args::ArgumentSpec("compress").store_constant(compress, true).optional().description(
+                              "passing compress saves the density grid in compressed form."
                    );
         }
         
@@ -156,10 +160,15 @@ namespace {
              *  extractor is still badly specified.
              */
 
-            return std::make_shared<DensityObserver>(size, support, std::move(file_name), center, extractor_fn);
+            auto observer = std::make_shared<DensityObserver>(size, support, std::move(file_name), center, extractor_fn);
+            if (compress) {
+                observer->setEncoding(GridEncoding::COMPRESSED);
+            }
+            return observer;
         }
         
         bool center = false;
+        bool compress = false;
         std::vector<std::size_t> size;
         std::vector<double> support;
         std::vector<std::string> extractor = {"dens"};
@@ -323,6 +332,37 @@ namespace {
         std::vector<double> radii;
         std::string file_name = "angular_density.dat";
     };
+
+    class RayCostObserverBuilder : public ObserverBuilder {
+    public:
+        RayCostObserverBuilder() : ObserverBuilder("ray_cost", false)
+        {
+            BuilderBaseType::args().description("records the integration cost of the rays: histograms of steps, "
+                                                "rejected steps, rhs evaluations, minimum time step and wall time per ray, "
+                                                "and maps of where the integration steps are spent.");
+            BuilderBaseType::args() << args::ArgumentSpec("size").alias("s").store_many(size).optional().description(
+                    "'s'|'size' Int|Int...\n"
+                    "Resolution of the cost maps. Defaults to the resolution of the potential. "
+                    "If only a single number is supplied, this is used for all dimensions.")
+                                    << args::ArgumentSpec("file_name").optional().store(file_name).description(
+                                            "Name of the file in which the ray costs will be saved.");
+        }
+    private:
+        std::shared_ptr<Observer> create(const Potential& potential) final {
+            if (size.empty()) {
+                size = potential.getExtents();
+            } else if (size.size() == 1) {
+                size.resize(potential.getDimension(), size.front());
+            }
+            if (size.size() != potential.getDimension()) {
+                THROW_EXCEPTION(std::runtime_error, "invalid size specified for ray cost observer");
+            }
+            return std::make_shared<RayCostObserver>(size, potential.getSupport(), std::move(file_name));
+        }
+
+        std::vector<std::size_t> size;
+        std::string file_name = "ray_cost.dat";
+    };
 }
 
 ObserverFactory& getObserverFactory() {
@@ -337,6 +377,7 @@ ObserverFactory& getObserverFactory() {
         factory.add_builder<VelHistObserverBuilder>();
         factory.add_builder<TrajectoryObserverBuilder>();
         factory.add_builder<RadialDensityObserverFactory>();
+        factory.add_builder<RayCostObserverBuilder>();
         init = true;
     }
     return factory;
@@ -35,7 +35,7 @@ RadialDensityObserver::RadialDensityObserver(int resolution, std::vector<double>
         // and initialize it to zero.
         for(auto& v : mCounts.back())
         {
-            v = 0u;
+            v = 0.0;
         }
     }
 }
@@ -46,6 +46,7 @@ void RadialDensityObserver::startTrajectory( const InitialCondition& init, std::
     mLastPosition = gen_vect(2);
     mLastRadius = 0.0;
     mLastRadiusIndex = 0;
+    mWeight = init.getWeight();
 }
 
 bool RadialDensityObserver::watch( const State& state, double t )
@@ -61,7 +62,7 @@ bool RadialDensityObserver::watch( const State& state, double t )
 
         double angle = std::atan2(interpol[1], interpol[0]); // in (-pi, pi)
         double bin = (angle / (2*pi) + 0.5) * mResolution;
-        mCounts[mLastRadiusIndex][std::floor(bin)] += 1;
+        mCounts[mLastRadiusIndex][std::floor(bin)] += mWeight;
         if(mLastRadiusIndex == mRadii.size() - 1)
             return false;
         else
@@ -82,10 +83,22 @@ void RadialDensityObserver::combine(ThreadLocalObserver& other) {
     auto& source = dynamic_cast<RadialDensityObserver&>(other);
     for(unsigned i = 0; i < mCounts.size(); ++i) {
         std::transform(mCounts[i].begin(), mCounts[i].end(), source.mCounts[i].begin(), mCounts[i].begin(),
-                       std::plus<std::uint32_t>());
+                       std::plus<double>());
     }
 }
 
+void RadialDensityObserver::serialize(std::ostream& target) {
+    writeInteger(target, mCounts.size());
+    for(const auto& counts : mCounts)
+        counts.dump(target);
+}
+
+void RadialDensityObserver::deserialize(std::istream& source) {
+    readCheckpointSize(source, mCounts.size());
+    for(auto& counts : mCounts)
+        counts.reload(source);
+}
+
 void RadialDensityObserver::save(std::ostream& target) {
 /*! Angular Histogram save file format.
         Header: rade001\\n
@@ -22,6 +22,8 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
 
 private:
     std::shared_ptr<ThreadLocalObserver> clone() const override;
@@ -38,7 +40,10 @@ private:
     double mLastRadius = 0;
     std::size_t mLastRadiusIndex = 0;
 
-    std::vector<DynamicGrid<std::uint32_t>> mCounts;
+    double mWeight = 1.0;
+
+    /// weighted number of rays per angular bin, for each radius
+    std::vector<DynamicGrid<double>> mCounts;
 };
 
 
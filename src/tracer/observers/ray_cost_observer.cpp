@@ -0,0 +1,192 @@
+#include "ray_cost_observer.hpp"
+#include "interpolation.hpp"
+#include "fileIO.hpp"
+#include "global.hpp"
+#include "ray_statistics.hpp"
+#include "initial_conditions/initial_conditions.hpp"
+#include <algorithm>
+#include <cmath>
+
+constexpr std::size_t RayCostObserver::HISTOGRAM_BINS;
+constexpr int RayCostObserver::HISTOGRAM_MIN_EXPONENT;
+
+RayCostObserver::RayCostObserver( std::vector<std::size_t> size, std::vector<double> support, std::string file_name ) :
+        ThreadLocalObserver( std::move(file_name) ),
+        mDimension( size.size() ),
+        mSupport( std::move(support) ),
+        mScalingFactor( size.size() ),
+        mLastPosition( size.size() ),
+        mStepMap( size, TransformationType::PERIODIC ),
+        mRejectedMap( size, TransformationType::PERIODIC ),
+        mRhsMap( size, TransformationType::PERIODIC )
+{
+    assert( mSupport.size() == mDimension );
+    for(unsigned i = 0; i < mDimension; ++i)
+        mScalingFactor[i] = size[i] / mSupport[i];
+
+    for(auto& histogram : mHistograms)
+        histogram.assign( HISTOGRAM_BINS, 0 );
+    mTotals.fill( 0.0 );
+}
+
+void RayCostObserver::startTracing()
+{
+    if(!mRayStatistics)
+        THROW_EXCEPTION(std::logic_error, "The ray cost observer requires integration statistics from the tracer.");
+}
+
+void RayCostObserver::startTrajectory( const InitialCondition& start, std::size_t )
+{
+    mLastPosition = start.getState().getPosition();
+    mLastAccepted = 0;
+    mLastRejected = 0;
+    mLastRhs = 0;
+}
+
+bool RayCostObserver::watch( const State& state, double )
+{
+    const RayStatistics& statistics = *mRayStatistics;
+    const gen_vect& position = state.getPosition();
+
+    // the work since the last observation point is drawn at the center of the segment the ray moved along.
+    gen_vect center( mDimension );
+    for(unsigned i = 0; i < mDimension; ++i)
+    {
+        if(position[i] < 0 || position[i] >= mSupport[i])
+            return false;
+        center[i] = (position[i] + mLastPosition[i]) / 2 * mScalingFactor[i];
+    }
+
+    std::size_t accepted = statistics.mAcceptedSteps - mLastAccepted;
+    if(accepted > 0)
+    {
+        drawInterpolatedDot( mStepMap, center, accepted );
+        drawInterpolatedDot( mRejectedMap, center, statistics.mRejectedSteps - mLastRejected );
+        drawInterpolatedDot( mRhsMap, center, statistics.mRhsEvaluations - mLastRhs );
+    }
+
+    mLastPosition = position;
+    mLastAccepted = statistics.mAcceptedSteps;
+    mLastRejected = statistics.mRejectedSteps;
+    mLastRhs = statistics.mRhsEvaluations;
+    return true;
+}
+
+void RayCostObserver::endTrajectory( const State& )
+{
+    const RayStatistics& statistics = *mRayStatistics;
+    // rays that did not take a single step have no minimum step size
+    double min_dt = std::isfinite(statistics.mMinTimeStep) ? statistics.mMinTimeStep : 0.0;
+
+    std::array<double, QUANTITY_COUNT> values;
+    values[ACCEPTED_STEPS] = statistics.mAcceptedSteps;
+    values[REJECTED_STEPS] = statistics.mRejectedSteps;
+    values[RHS_EVALUATIONS] = statistics.mRhsEvaluations;
+    values[MIN_TIME_STEP] = min_dt;
+    values[WALL_TIME] = statistics.mWallTime;
+
+    for(unsigned q = 0; q < QUANTITY_COUNT; ++q)
+    {
+        mHistograms[q][getHistogramBin(values[q])] += 1;
+        mTotals[q] += values[q];
+    }
+    ++mRayCount;
+}
+
+std::size_t RayCostObserver::getHistogramBin( double value )
+{
+    if(!(value >= std::ldexp(1.0, HISTOGRAM_MIN_EXPONENT)))
+        return 0;
+    int exponent = std::ilogb( value ) - HISTOGRAM_MIN_EXPONENT + 1;
+    return std::min( (std::size_t)exponent, HISTOGRAM_BINS - 1 );
+}
+
+void RayCostObserver::save( std::ostream& target )
+{
+    /*! Ray cost save file format.
+        Header: rcst001\\n
+        Data type   | Count     | Meaning
+        ---------   | -----     | -------
+        Int [D]     | 1         | Number of dimensions
+        Double      | D         | support
+        Int         | 1         | Number of rays
+        Int [\#B]   | 1         | Number of histogram bins
+        Double      | \#B       | Lower bin edges
+        Double      | 5         | Sum over all rays of: accepted steps, rejected steps, rhs evaluations, min dt, wall time
+        Int         | 5 * \#B   | Histograms of these quantities, in the same order
+        Grid[Float] | 1         | accepted steps per cell
+        Grid[Float] | 1         | rejected steps per cell
+        Grid[Float] | 1         | rhs evaluations per cell
+    */
+
+    target << "rcst001\n";
+    writeInteger(target, mDimension);
+    writeFloats(target, mSupport);
+    writeInteger(target, mRayCount);
+    writeInteger(target, HISTOGRAM_BINS);
+    writeFloat(target, 0.0);
+    for(unsigned i = 1; i < HISTOGRAM_BINS; ++i)
+        writeFloat(target, std::ldexp(1.0, HISTOGRAM_MIN_EXPONENT + (int)i - 1));
+    writeFloats(target, mTotals);
+
+    BinaryWriter writer(target);
+    for(const auto& histogram : mHistograms)
+        writer.putIntegers(histogram);
+    writer.flush();
+
+    mStepMap.dump(target);
+    mRejectedMap.dump(target);
+    mRhsMap.dump(target);
+}
+
+std::shared_ptr<ThreadLocalObserver> RayCostObserver::clone() const
+{
+    return std::make_shared<RayCostObserver>( mStepMap.getExtents(), mSupport, filename() );
+}
+
+void RayCostObserver::serialize( std::ostream& target )
+{
+    writeInteger(target, mRayCount);
+    writeInteger(target, HISTOGRAM_BINS);
+    for(const auto& histogram : mHistograms)
+        writeIntegers(target, histogram);
+    writeFloats(target, mTotals);
+    mStepMap.dump(target);
+    mRejectedMap.dump(target);
+    mRhsMap.dump(target);
+}
+
+void RayCostObserver::deserialize( std::istream& source )
+{
+    readInteger(source, mRayCount);
+    readCheckpointSize(source, HISTOGRAM_BINS);
+    for(auto& histogram : mHistograms)
+        readIntegers(source, histogram.data(), histogram.size());
+    readFloats(source, mTotals.data(), mTotals.size());
+    mStepMap.reload(source);
+    mRejectedMap.reload(source);
+    mRhsMap.reload(source);
+}
+
+void RayCostObserver::combine( ThreadLocalObserver& other )
+{
+    auto& data = dynamic_cast<RayCostObserver&>( other );
+    mRayCount += data.mRayCount;
+    for(unsigned q = 0; q < QUANTITY_COUNT; ++q)
+    {
+        std::transform(mHistograms[q].begin(), mHistograms[q].end(), data.mHistograms[q].begin(),
+                       mHistograms[q].begin(), std::plus<std::size_t>());
+        mTotals[q] += data.mTotals[q];
+    }
+
+    std::transform(mStepMap.begin(), mStepMap.end(), data.mStepMap.begin(), mStepMap.begin(), std::plus<float>());
+    std::transform(mRejectedMap.begin(), mRejectedMap.end(), data.mRejectedMap.begin(), mRejectedMap.begin(),
+                   std::plus<float>());
+    std::transform(mRhsMap.begin(), mRhsMap.end(), data.mRhsMap.begin(), mRhsMap.begin(), std::plus<float>());
+}
+
+std::vector<ResultArray> RayCostObserver::getResultArrays() const
+{
+    return {ResultArray("step_map", mStepMap), ResultArray("rejected_step_map", mRejectedMap),
+            ResultArray("rhs_evaluation_map", mRhsMap)};
+}
@@ -0,0 +1,78 @@
+#ifndef RAY_COST_OBSERVER_HPP_INCLUDED
+#define RAY_COST_OBSERVER_HPP_INCLUDED
+
+#include "dynamic_grid.hpp"
+#include "vector.hpp"
+#include "observer.hpp"
+#include <array>
+
+/*! \brief Observer that records how expensive the integration of the rays is.
+    \details Uses the RayStatistics the tracer collects for each ray. Two kinds of data are recorded:
+            For each ray, the accepted and rejected steps, the evaluations of the equations of motion,
+            the smallest accepted time step and the wall time are binned into logarithmic histograms.
+            Additionally, the work done between two observation points is deposited at the position of the
+            ray, which results in maps of the number of steps, rejected steps and rhs evaluations per grid cell.
+            Dividing these by the accepted steps map gives the cost per step in each region of the potential.
+*/
+class RayCostObserver final: public ThreadLocalObserver
+{
+public:
+    /// the per-ray quantities for which histograms are recorded, in the order in which they are saved.
+    enum Quantity { ACCEPTED_STEPS, REJECTED_STEPS, RHS_EVALUATIONS, MIN_TIME_STEP, WALL_TIME, QUANTITY_COUNT };
+
+    /// number of histogram bins. Bin 0 counts all values below 2^HISTOGRAM_MIN_EXPONENT (including zero),
+    /// bin i > 0 the values in [2^(HISTOGRAM_MIN_EXPONENT+i-1), 2^(HISTOGRAM_MIN_EXPONENT+i)).
+    static constexpr std::size_t HISTOGRAM_BINS = 81;
+    static constexpr int HISTOGRAM_MIN_EXPONENT = -40;
+
+    /// create an observer and specify the size and support of the cost maps.
+    RayCostObserver( std::vector<std::size_t> size, std::vector<double> support,
+                     std::string file_name = "ray_cost.dat" );
+
+    // standard observer functions
+    // for documentation look at observer.hpp
+    void startTracing() override;
+    bool watch( const State& state, double t ) override;
+    void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
+    void endTrajectory(const State& final_state) override;
+    void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
+    std::vector<ResultArray> getResultArrays() const override;
+
+    // info functions
+    std::size_t getRayCount() const { return mRayCount; }
+    const std::vector<std::size_t>& getHistogram( Quantity quantity ) const { return mHistograms[quantity]; }
+    const DynamicGrid<float>& getStepMap() const { return mStepMap; }
+    const DynamicGrid<float>& getRejectedStepMap() const { return mRejectedMap; }
+    const DynamicGrid<float>& getRhsEvaluationMap() const { return mRhsMap; }
+
+    /// index of the histogram bin for \p value.
+    static std::size_t getHistogramBin( double value );
+
+private:
+    // thread local specific functions
+    std::shared_ptr<ThreadLocalObserver> clone() const override;
+    void combine(ThreadLocalObserver& other) override;
+
+    // config
+    std::size_t mDimension;
+    std::vector<double> mSupport;
+    std::vector<double> mScalingFactor;
+
+    // state of the current trajectory
+    gen_vect mLastPosition;
+    std::size_t mLastAccepted = 0;
+    std::size_t mLastRejected = 0;
+    std::size_t mLastRhs = 0;
+
+    // data
+    std::size_t mRayCount = 0;
+    std::array<std::vector<std::size_t>, QUANTITY_COUNT> mHistograms;
+    std::array<double, QUANTITY_COUNT> mTotals;
+    DynamicGrid<float> mStepMap;
+    DynamicGrid<float> mRejectedMap;
+    DynamicGrid<float> mRhsMap;
+};
+
+#endif // RAY_COST_OBSERVER_HPP_INCLUDED
@@ -3,6 +3,8 @@
 //
 
 #include "observers/observer.hpp"
+#include "observers/master_observer.hpp"
+#include "observers/ray_cost_observer.hpp"
 #include <boost/test/unit_test.hpp>
 #include "test_helpers.hpp"
 
@@ -97,6 +99,33 @@ BOOST_AUTO_TEST_SUITE(observer_test)
         BOOST_CHECK_EQUAL(test->combined, 1);
     }
 
+    /*
+     * Restarting a thread copy combines its data into the root, and gives a new thread copy of the same root.
+     * The master observer uses this to combine all thread local observers for a checkpoint.
+     */
+    BOOST_AUTO_TEST_CASE(thread_local_observer_restart) {
+        auto test = std::make_shared<TestThreadLocalObserver>("file_name");
+        BOOST_CHECK_THROW(test->restart(), std::logic_error);
+
+        auto copy = std::dynamic_pointer_cast<ThreadLocalObserver>(test->makeThreadCopy());
+        auto fresh = copy->restart();
+        BOOST_CHECK_EQUAL(test->combined, 1);
+        BOOST_CHECK(!copy->is_slave());
+        BOOST_CHECK(fresh->is_slave());
+        fresh->reduce();
+        BOOST_CHECK_EQUAL(test->combined, 2);
+
+        MasterObserver master(2, nullptr);
+        master.addObserverObject(test);
+        master.startTracing();
+        MasterObserver thread(master.clone());
+        auto before = thread.getObservers().at(0);
+        thread.combineLocalWatches();
+        BOOST_CHECK_EQUAL(test->combined, 3);
+        BOOST_CHECK(thread.getObservers().at(0) != before);
+        BOOST_CHECK(thread.getObservers().at(0)->is_ready());
+    }
+
     // -----------------------------------------------------------------------------------------------------------------
 
     class TestThreadSharedObserver : public ThreadSharedObserver
@@ -130,6 +159,56 @@ BOOST_AUTO_TEST_SUITE(observer_test)
         BOOST_CHECK(m1 == m2);
     }
 
+    // -----------------------------------------------------------------------------------------------------------------
+
+    class StatisticsObserver : public ThreadLocalObserver
+    {
+    public:
+        StatisticsObserver() : ThreadLocalObserver("statistics") {}
+        bool watch(const State&, double) override { return false; }
+        void startTrajectory(const InitialCondition&, std::size_t) override {}
+        void save( std::ostream& ) override { };
+        const RayStatistics* statistics() const { return mRayStatistics.get(); }
+    private:
+        std::shared_ptr<ThreadLocalObserver> clone() const override { return std::make_shared<StatisticsObserver>(); }
+        void combine( ThreadLocalObserver& ) override { }
+    };
+
+    /*
+     * Each thread's master observer has its own ray statistics, and the thread copies of
+     * the observers have to see the statistics of their thread.
+     */
+    BOOST_AUTO_TEST_CASE(ray_statistics_per_thread) {
+        auto observer = std::make_shared<StatisticsObserver>();
+        MasterObserver master(2, nullptr);
+        master.addObserverObject(observer);
+        master.startTracing();
+        BOOST_CHECK(observer->statistics() == &master.getRayStatistics());
+
+        MasterObserver thread(master.clone());
+        auto copy = std::dynamic_pointer_cast<StatisticsObserver>(thread.getObservers().at(0));
+        BOOST_REQUIRE(copy);
+        BOOST_CHECK(copy->statistics() == &thread.getRayStatistics());
+
+        thread.getRayStatistics().mRejectedSteps = 5;
+        BOOST_CHECK_EQUAL(copy->statistics()->mRejectedSteps, 5u);
+        BOOST_CHECK_EQUAL(master.getRayStatistics().mRejectedSteps, 0u);
+    }
+
+    /*
+     * Bin 0 collects everything below the smallest edge, the last bin everything above the largest.
+     */
+    BOOST_AUTO_TEST_CASE(ray_cost_histogram_bins) {
+        const int min_exp = RayCostObserver::HISTOGRAM_MIN_EXPONENT;
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(0.0), 0u);
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(std::ldexp(1.0, min_exp - 1)), 0u);
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(std::ldexp(1.0, min_exp)), 1u);
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(1.0), (std::size_t)(1 - min_exp));
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(1.5), (std::size_t)(1 - min_exp));
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(2.0), (std::size_t)(2 - min_exp));
+        BOOST_CHECK_EQUAL(RayCostObserver::getHistogramBin(1e300), RayCostObserver::HISTOGRAM_BINS - 1);
+    }
+
 
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
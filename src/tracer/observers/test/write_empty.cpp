@@ -7,6 +7,7 @@
 #include <observers/density_observer.hpp>
 #include <observers/energy_error_observer.hpp>
 #include <observers/radial_density_observer.hpp>
+#include <observers/ray_cost_observer.hpp>
 #include <observers/trajectory_observer.hpp>
 #include <observers/velocity_transition_observer.hpp>
 #include <observers/velocity_histogram_observer.hpp>
@@ -41,6 +42,9 @@ int main()
     RadialDensityObserver r_obs(128, radii);
     save_observer(r_obs);
 
+    RayCostObserver rc_obs(size, support);
+    save_observer(rc_obs);
+
     TrajectoryObserver t_obs(1.0);
     save_observer(t_obs);
 
@@ -1,4 +1,5 @@
 #include "trajectory_observer.hpp"
+#include "initial_conditions/initial_conditions.hpp"
 #include "fileIO.hpp"
 
 
@@ -22,14 +23,19 @@ void TrajectoryObserver::combine(ThreadLocalObserver& other)
     mParticleNumber = std::max(mParticleNumber, data.mParticleNumber);
 }
 
-void TrajectoryObserver::startTrajectory( const InitialCondition&, std::size_t trajectory )
+void TrajectoryObserver::startTrajectory( const InitialCondition& start, std::size_t trajectory )
 {
     mLastTime = -1; // set to -1, so t=0 gets recorded
     mParticleNumber = trajectory;
+    // a correction ray repeats a trajectory that has already been recorded
+    mSkipTrajectory = start.isCorrection();
 }
 
 bool TrajectoryObserver::watch( const State& state, double t )
 {
+    if( mSkipTrajectory )
+        return false;
+
     if( t > mLastTime + mInterval )
     {
         mTrajectorySamples.emplace_back( mParticleNumber, state.getPosition(),
@@ -53,14 +59,56 @@ void TrajectoryObserver::save(std::ostream& target)
 
     std::cout << "SAVING " << mTrajectorySamples.size() << " trajectory points\n";
 
+    BinaryWriter writer(target);
     for(const auto& c : mTrajectorySamples)
     {
-        writeInteger(target, c.trajectory );
+        writer.putInteger( c.trajectory );
         // write position
-        writeFloats(target, c.pos);
-        writeFloats(target, c.vel);
-        writeFloat(target, c.time );
+        writer.putVec( c.pos );
+        writer.putVec( c.vel );
+        writer.putFloat( c.time );
+    }
+    writer.flush();
+}
+
+void TrajectoryObserver::serialize(std::ostream& target)
+{
+    writeInteger(target, mParticleNumber );
+    writeInteger(target, mTrajectorySamples.size() );
+    writeInteger(target, mTrajectorySamples.empty() ? 0 : mTrajectorySamples.front().pos.size() );
+    BinaryWriter writer(target);
+    for(const auto& c : mTrajectorySamples)
+    {
+        writer.putInteger( c.trajectory );
+        writer.putVec( c.pos );
+        writer.putVec( c.vel );
+        writer.putFloat( c.time );
     }
+    writer.flush();
+}
+
+void TrajectoryObserver::deserialize(std::istream& source)
+{
+    readInteger(source, mParticleNumber );
+    std::uint64_t count = readInteger(source);
+    std::size_t dimension = readInteger(source);
+    mTrajectorySamples.clear();
+    gen_vect pos( dimension );
+    gen_vect vel( dimension );
+    for(std::uint64_t i = 0; i < count && source; ++i)
+    {
+        std::uint64_t trajectory = readInteger(source);
+        readVec(source, pos);
+        readVec(source, vel);
+        mTrajectorySamples.emplace_back( trajectory, pos, vel, readFloat(source) );
+    }
+}
+
+void TrajectoryObserver::shiftTrajectoryNumbers(std::size_t offset)
+{
+    for(auto& sample : mTrajectorySamples)
+        sample.trajectory += offset;
+    mParticleNumber += offset;
 }
 
 std::shared_ptr<ThreadLocalObserver> TrajectoryObserver::clone() const
@@ -40,10 +40,13 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
 
 private:
     std::shared_ptr<ThreadLocalObserver> clone() const override;
     void combine(ThreadLocalObserver& other) override;
+    void shiftTrajectoryNumbers(std::size_t offset) override;
 
     // configuration
     double mInterval = 0.01;
@@ -51,6 +54,7 @@ private:
     // cache
     double mLastTime = 0;
     std::size_t mParticleNumber = 0;
+    bool mSkipTrajectory = false;
 
     // generated results
     container_type mTrajectorySamples;
@@ -14,7 +14,7 @@ VelocityHistogram::VelocityHistogram(std::size_t dimension, std::size_t bin_coun
 {
 }
 
-void VelocityHistogram::record(const gen_vect& velocity)
+void VelocityHistogram::record(const gen_vect& velocity, double weight)
 {
     // remember data dimension is simulation dimension minus one.
     if(mData.getDimension() == 1)
@@ -22,7 +22,7 @@ void VelocityHistogram::record(const gen_vect& velocity)
         double vel = (boost::algorithm::clamp(velocity[1] / mRange, -1.0, 1.0) + 1) / 2;
         std::array<int, 1> index_v;
         index_v[0] = static_cast<int>(std::round(vel * (mBinCount - 1)));
-        mData(index_v) += 1;
+        mData(index_v) += weight;
     } else if(mData.getDimension() == 2)
     {
         double vel1 = (boost::algorithm::clamp(velocity[1] / mRange, -1.0, 1.0) + 1) / 2;
@@ -30,7 +30,7 @@ void VelocityHistogram::record(const gen_vect& velocity)
         std::array<int, 2> index_v;
         index_v[0] = static_cast<int>(std::round(vel1 * (mBinCount - 1)));
         index_v[1] = static_cast<int>(std::round(vel2 * (mBinCount - 1)));
-        mData(index_v) += 1;
+        mData(index_v) += weight;
     }
 }
 
@@ -54,15 +54,30 @@ void VelocityHistogramObserver::combine(ThreadLocalObserver& other)
         auto& count = mBinCounts[i].getData();
         auto& o_count = data.mBinCounts[i].data();
         // add the counts
-        std::transform(count.begin(), count.end(), o_count.begin(), count.begin(), std::plus<std::size_t>());
+        std::transform(count.begin(), count.end(), o_count.begin(), count.begin(), std::plus<double>());
     }
 }
 
+void VelocityHistogramObserver::serialize(std::ostream& target)
+{
+    writeInteger(target, mBinCounts.size());
+    for(const auto& histogram : mBinCounts)
+        histogram.data().dump(target);
+}
+
+void VelocityHistogramObserver::deserialize(std::istream& source)
+{
+    readCheckpointSize(source, mBinCounts.size());
+    for(auto& histogram : mBinCounts)
+        histogram.getData().reload(source);
+}
+
 void VelocityHistogramObserver::startTrajectory( const InitialCondition& start, std::size_t )
 {
     mOldVelocity = start.getState().getVelocity();
     mLastObservedTime = 0;
     mOldTime = 0;
+    mWeight = start.getWeight();
 }
 
 
@@ -83,7 +98,7 @@ bool VelocityHistogramObserver::watch( const State& state, double t )
         auto interpol = interpolate_linear_1d(mOldVelocity,
                                               state.getVelocity(),
                                               rtime);
-        mBinCounts[mLastObservedTime].record(interpol);
+        mBinCounts[mLastObservedTime].record(interpol, mWeight);
         ++mLastObservedTime;
         // finished after last time
         if( mLastObservedTime >= mTimeIntervals.size() )
@@ -110,7 +125,7 @@ void VelocityHistogramObserver::save(std::ostream& target)
         Int [D]   | 1     | Number of dimensions
         Double    | H     | Histogram times
         Double    | B     | bin center velocities
-        Int       | H * B ^ (D-1)| Angle counts
+        Grid[Double] | H     | Weighted velocity counts, B ^ (D-1) entries each
     */
 
     // file header
@@ -138,3 +153,11 @@ std::shared_ptr<ThreadLocalObserver> VelocityHistogramObserver::clone() const
 {
     return std::make_shared<VelocityHistogramObserver>( mDimension, mTimeIntervals, mBinCount, filename() );
 }
+
+std::vector<ResultArray> VelocityHistogramObserver::getResultArrays() const
+{
+    std::vector<ResultArray> arrays;
+    for(std::size_t i = 0; i < mBinCounts.size(); ++i)
+        arrays.emplace_back("counts_" + std::to_string(i), mBinCounts[i].data());
+    return arrays;
+}
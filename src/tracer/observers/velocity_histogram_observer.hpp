@@ -11,11 +11,12 @@
 
 class VelocityHistogram
 {
-    using histogram_t = DynamicGrid<std::size_t>;
+    using histogram_t = DynamicGrid<double>;
 public:
     VelocityHistogram(std::size_t dimension, std::size_t bin_count, double range);
 
-    void record(const gen_vect& velocity);
+    /// adds \p weight to the bin of \p velocity.
+    void record(const gen_vect& velocity, double weight);
     const histogram_t& data() const { return mData; }
     histogram_t& getData() { return mData; }
 private:
@@ -39,6 +40,10 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
+    /// the counts of each histogram, as `counts_<i>`.
+    std::vector<ResultArray> getResultArrays() const override;
 
 private:
     // thread local specific functions
@@ -56,6 +61,7 @@ private:
     unsigned mLastObservedTime = 0;
     gen_vect mOldVelocity;
     double mOldTime;
+    double mWeight = 1.0;
 };
 
 
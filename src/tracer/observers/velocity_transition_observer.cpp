@@ -46,7 +46,7 @@ int to_index(double value, std::size_t bin_count)
     return static_cast<int>(std::round(v * (bin_count - 1)));
 }
 
-void VelocityTransitionData::record(const gen_vect& old_velocity, const gen_vect& velocity)
+void VelocityTransitionData::record(const gen_vect& old_velocity, const gen_vect& velocity, double weight)
 {
     boost::numeric::ublas::c_vector<int, 6> index(old_velocity.size() + velocity.size());
     for(unsigned i = 0; i < old_velocity.size(); ++i)
@@ -68,7 +68,7 @@ void VelocityTransitionData::record(const gen_vect& old_velocity, const gen_vect
         }
     }
 
-    mData(index) += 1;
+    mData(index) += weight;
 }
 
 
@@ -92,6 +92,7 @@ void VelocityTransitionObserver::startTrajectory( const InitialCondition& start,
     mStartTransitionTime = mEndRecordingTime;
     mLastStepTime = 0;
     mLastStepVelocity = start.getState().getVelocity();
+    mWeight = start.getWeight();
 }
 
 
@@ -133,7 +134,7 @@ bool VelocityTransitionObserver::watch( const State& state, double t )
         double r = record_step / time_step;
 
         auto interpol = interpolate_linear_1d(mLastStepVelocity, state.getVelocity(), r);
-        mBinCounts.record(mOldVelocity, interpol);
+        mBinCounts.record(mOldVelocity, interpol, mWeight);
         mStartTransitionTime += mTimeInterval;
         mOldVelocity = interpol;
     }
@@ -145,6 +146,16 @@ bool VelocityTransitionObserver::watch( const State& state, double t )
 }
 
 
+void VelocityTransitionObserver::serialize(std::ostream& target)
+{
+    mBinCounts.data().dump(target);
+}
+
+void VelocityTransitionObserver::deserialize(std::istream& source)
+{
+    mBinCounts.getData().reload(source);
+}
+
 void VelocityTransitionObserver::save(std::ostream& target)
 {
     /*! Angular Velocity histogram save file format.
@@ -155,7 +166,7 @@ void VelocityTransitionObserver::save(std::ostream& target)
         Int [D]     | 1     | Number of dimensions
         Double      | 1     | Time interval
         Double      | B     | bin center velocities
-        Grid[UInt32]| B ^ (D-1)| grids with transition data
+        Grid[Double]| B ^ (D-1)| grids with weighted transition counts
     */
 
     // file header
@@ -11,13 +11,15 @@
 
 class VelocityTransitionData
 {
-    using histogram_t = DynamicGrid<std::uint32_t>;
+    using histogram_t = DynamicGrid<double>;
 public:
     VelocityTransitionData(std::size_t dimension, std::size_t bin_count, double range,
                        std::vector<bool> in, std::vector<bool> out, bool increments);
 
-    void record(const gen_vect& old_velocity, const gen_vect& velocity);
+    /// adds \p weight to the bin of the transition from \p old_velocity to \p velocity.
+    void record(const gen_vect& old_velocity, const gen_vect& velocity, double weight);
     const histogram_t& data() const { return mData; }
+    histogram_t& getData() { return mData; }
     const std::vector<double>& bin_centers() const { return mBinCenters; };
 private:
     std::size_t mDimension;
@@ -42,6 +44,8 @@ public:
     bool watch( const State& state, double t ) override;
     void startTrajectory(const InitialCondition& start, std::size_t trajectory) override;
     void save(std::ostream& target) override;
+    void serialize(std::ostream& target) override;
+    void deserialize(std::istream& source) override;
 
 private:
     // config
@@ -56,6 +60,7 @@ private:
     // caching on a single ray
     double mLastStepTime = 0.0;
     gen_vect mLastStepVelocity;
+    double mWeight = 1.0;
 
     // data
     VelocityTransitionData mBinCounts;
@@ -76,6 +76,10 @@ void WavefrontObserver::save(std::ostream& target)
 
 bool WavefrontObserver::watch(const State& state, double t)
 {
+    // a correction ray repeats a trajectory that is already part of the wavefront
+    if( mCachedInitialCondition->isCorrection() )
+        return false;
+
     if( t > mStopTime )
     {
         pos_t new_pos;
@@ -0,0 +1,25 @@
+#ifndef RAY_STATISTICS_HPP_INCLUDED
+#define RAY_STATISTICS_HPP_INCLUDED
+
+#include <cstddef>
+#include <limits>
+
+/*! \struct RayStatistics
+	\brief Integration statistics of a single ray.
+	\details The tracer resets these counters when a trajectory is started and updates them while integrating,
+			so observers that are called during the integration (i.e. thread local observers) see the values
+			accumulated up to the current observation point. The wall time is only known once the integration
+			of the ray has finished, and is set before Observer::endTrajectory is called.
+*/
+struct RayStatistics
+{
+	std::size_t mAcceptedSteps = 0;		//!< integrator steps that were accepted
+	std::size_t mRejectedSteps = 0;		//!< steps rejected by the error control, always 0 for fixed step integrators
+	std::size_t mRhsEvaluations = 0;	//!< evaluations of the equations of motion
+	double mMinTimeStep = std::numeric_limits<double>::infinity();	//!< smallest accepted step size
+	double mWallTime = 0;				//!< time spent integrating the ray (including observers) in seconds
+
+	void reset() { *this = RayStatistics(); }
+};
+
+#endif // RAY_STATISTICS_HPP_INCLUDED
@@ -0,0 +1,96 @@
+#include "tracer_c_api.h"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// a flat 16x16 potential with first derivatives, set from arrays.
+    bfs_potential* makeFlatPotential()
+    {
+        std::size_t extents[] = {16, 16};
+        double support[] = {1.0, 1.0};
+        bfs_potential* potential = bfs_potential_new(2, extents, support);
+        BOOST_REQUIRE(potential);
+        std::vector<double> zeros(16 * 16, 0.0);
+        int dx[] = {1, 0};
+        int dy[] = {0, 1};
+        BOOST_REQUIRE(bfs_potential_set_grid(potential, nullptr, zeros.data()));
+        BOOST_REQUIRE(bfs_potential_set_grid(potential, dx, zeros.data()));
+        BOOST_REQUIRE(bfs_potential_set_grid(potential, dy, zeros.data()));
+        return potential;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(c_api)
+
+    BOOST_AUTO_TEST_CASE(density)
+    {
+        bfs_potential* potential = makeFlatPotential();
+        BOOST_CHECK_EQUAL(bfs_potential_dimension(potential), 2);
+        bfs_trace* trace = bfs_trace_run(potential, "-n 50 -t 1 --observers density size 8 8", nullptr, 0, 0);
+        BOOST_REQUIRE_MESSAGE(trace, bfs_last_error());
+        // the trace keeps the potential alive
+        bfs_potential_free(potential);
+        BOOST_CHECK_EQUAL(bfs_trace_particle_count(trace), 50);
+
+        std::size_t density = bfs_trace_observer_count(trace);
+        for(std::size_t i = 0; i < bfs_trace_observer_count(trace); ++i)
+            if(std::strcmp(bfs_trace_observer_file(trace, i), "density.dat") == 0)
+                density = i;
+        BOOST_REQUIRE_LT(density, bfs_trace_observer_count(trace));
+        BOOST_CHECK(bfs_trace_observer_file(trace, bfs_trace_observer_count(trace)) == nullptr);
+        BOOST_REQUIRE_EQUAL(bfs_trace_array_count(trace, density), 1);
+
+        bfs_array array;
+        BOOST_REQUIRE(bfs_trace_array(trace, density, 0, &array));
+        BOOST_CHECK_EQUAL(array.name, "density");
+        BOOST_CHECK_EQUAL(array.type, BFS_FLOAT32);
+        BOOST_REQUIRE_EQUAL(array.rank, 2);
+        BOOST_CHECK_EQUAL(array.shape[0], 8);
+        BOOST_CHECK_EQUAL(array.shape[1], 8);
+        auto data = static_cast<const float*>(array.data);
+        BOOST_CHECK_GT(std::accumulate(data, data + 64, 0.0), 0.0);
+
+        BOOST_CHECK(!bfs_trace_array(trace, density, 1, &array));
+        BOOST_CHECK(std::strlen(bfs_last_error()) > 0);
+
+        BOOST_CHECK(bfs_trace_save(trace, "."));
+        BOOST_CHECK(std::ifstream("density.dat"));
+        std::remove("density.dat");
+        std::remove("energy.json");
+        bfs_trace_free(trace);
+    }
+
+    BOOST_AUTO_TEST_CASE(rays)
+    {
+        bfs_potential* potential = makeFlatPotential();
+        // three weighted rays that move along x
+        std::vector<double> rays{0.1, 0.2, 1.0, 0.0, 1.0,
+                                 0.1, 0.5, 1.0, 0.0, 2.0,
+                                 0.1, 0.8, 1.0, 0.0, 0.5};
+        bfs_trace* trace = bfs_trace_run(potential, "-t 1 --observers density size 8 8", rays.data(), 3, 1);
+        BOOST_REQUIRE_MESSAGE(trace, bfs_last_error());
+        BOOST_CHECK_EQUAL(bfs_trace_particle_count(trace), 3);
+        bfs_trace_free(trace);
+        bfs_potential_free(potential);
+    }
+
+    BOOST_AUTO_TEST_CASE(errors)
+    {
+        BOOST_CHECK(bfs_potential_load("tmp.does_not_exist") == nullptr);
+        BOOST_CHECK(std::string(bfs_last_error()).find("tmp.does_not_exist") != std::string::npos);
+
+        bfs_potential* potential = makeFlatPotential();
+        BOOST_CHECK(bfs_trace_run(potential, "--observers nonsense", nullptr, 0, 0) == nullptr);
+        BOOST_CHECK(std::strlen(bfs_last_error()) > 0);
+        // the potential is given in memory
+        BOOST_CHECK(bfs_trace_run(potential, "pot.dat", nullptr, 0, 0) == nullptr);
+        bfs_potential_free(potential);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,418 @@
+#include "checkpoint.hpp"
+#include "tracer.hpp"
+#include "dynamics/sound.hpp"
+#include "observers/density_observer.hpp"
+#include "observers/trajectory_observer.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    /// potential for sound in a medium that moves with a velocity gradient, so that the rays are curved.
+    Potential makePotential()
+    {
+        Potential potential(2, 1, 64);
+        default_grid g(2, 64);
+        g.setAccessMode(TransformationType::PERIODIC);
+        for(auto& data : g)
+            data = 0;
+        potential.setDerivative(std::vector<int>{0,0}, g.clone(), "velocity1");
+        potential.setDerivative(std::vector<int>{1,0}, g.clone(), "velocity1");
+        potential.setDerivative(std::vector<int>{0,1}, g.clone(), "velocity1");
+        potential.setDerivative(std::vector<int>{1,0}, g.clone(), "velocity0");
+        for(auto& data : g)
+            data = 1;
+        potential.setDerivative(std::vector<int>{0,1}, g.clone(), "velocity0");
+        for(auto ind = g.getIndex(); ind.valid(); ++ind)
+            g(ind) = ind[1] / 64.;
+        potential.setDerivative(std::vector<int>{0,0}, g.clone(), "velocity0");
+        return potential;
+    }
+
+    /// observer that copies the checkpoint file when the ray \p ray ends, i.e. the checkpoint that was written
+    /// before this ray was finished.
+    class CheckpointCopyObserver final : public ThreadLocalObserver
+    {
+    public:
+        CheckpointCopyObserver(std::size_t ray, std::string source, std::string target) :
+                ThreadLocalObserver("copy"), mRay(ray), mSource(std::move(source)), mTarget(std::move(target)) {}
+        bool watch(const State&, double) override { return false; }
+        void startTrajectory(const InitialCondition&, std::size_t trajectory) override { mTrajectory = trajectory; }
+        void endTrajectory(const State&) override
+        {
+            if(mTrajectory != mRay)
+                return;
+            std::ifstream source(mSource, std::ios::binary);
+            if(!source)
+                return;
+            std::ofstream target(mTarget, std::ios::binary);
+            target << source.rdbuf();
+        }
+        void save(std::ostream&) override { }
+        void serialize(std::ostream&) override { }
+        void deserialize(std::istream&) override { }
+    private:
+        std::shared_ptr<ThreadLocalObserver> clone() const override
+        {
+            return std::make_shared<CheckpointCopyObserver>(mRay, mSource, mTarget);
+        }
+        void combine(ThreadLocalObserver&) override { }
+
+        std::size_t mRay;
+        std::size_t mTrajectory = 0;
+        std::string mSource;
+        std::string mTarget;
+    };
+
+    /// observer that requests the tracer to stop when the ray \p ray ends.
+    class StopObserver final : public ThreadLocalObserver
+    {
+    public:
+        StopObserver(Tracer& tracer, std::size_t ray) : ThreadLocalObserver("stop"), mTracer(tracer), mRay(ray) {}
+        bool watch(const State&, double) override { return false; }
+        void startTrajectory(const InitialCondition&, std::size_t trajectory) override { mTrajectory = trajectory; }
+        void endTrajectory(const State&) override
+        {
+            if(mTrajectory == mRay)
+                mTracer.requestStop();
+        }
+        void save(std::ostream&) override { }
+    private:
+        std::shared_ptr<ThreadLocalObserver> clone() const override
+        {
+            return std::make_shared<StopObserver>(mTracer, mRay);
+        }
+        void combine(ThreadLocalObserver&) override { }
+
+        Tracer& mTracer;
+        std::size_t mRay;
+        std::size_t mTrajectory = 0;
+    };
+
+    struct TraceSetup
+    {
+        TraceSetup() : potential(makePotential()),
+                       tracer(potential, std::make_shared<Sound>(potential, false, false)),
+                       density(std::make_shared<DensityObserver>(std::vector<std::size_t>{32, 32},
+                                                                 potential.getSupport(), "density.dat"))
+        {
+            tracer.setMaxThreads(1);
+            tracer.addObserver(density);
+            tracer.addObserver(std::make_shared<CheckpointCopyObserver>(150, "tmp.checkpoint", "tmp.partial"));
+        }
+
+        TraceResult run(std::size_t particles = 300)
+        {
+            auto generator = createInitialConditionGenerator(2, std::vector<std::string>{"planar"});
+            init_cond::InitialConditionConfiguration config;
+            config.setParticleCount(particles).setEnergyNormalization(true);
+            return tracer.trace(generator, config);
+        }
+
+        std::size_t trace(std::size_t particles = 300)
+        {
+            return run(particles).mParticleCount;
+        }
+
+        Potential potential;
+        Tracer tracer;
+        std::shared_ptr<DensityObserver> density;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(checkpoint)
+
+    BOOST_AUTO_TEST_CASE(file_roundtrip)
+    {
+        Checkpoint checkpoint;
+        checkpoint.mGeneratorType = "planar";
+        checkpoint.mRequestedParticles = 1000;
+        checkpoint.mRayCount = 400;
+        checkpoint.mParticleCount = 398;
+        checkpoint.mStepCount = 123456;
+        checkpoint.mObservers.emplace_back("density.dat", std::string("\0data\n", 6));
+        checkpoint.mObservers.emplace_back("energy.json", "");
+
+        std::stringstream stream;
+        writeCheckpoint(stream, checkpoint);
+        std::string data = stream.str();
+        Checkpoint loaded = readCheckpoint(stream);
+        BOOST_CHECK_EQUAL(loaded.mGeneratorType, "planar");
+        BOOST_CHECK_EQUAL(loaded.mRequestedParticles, 1000);
+        BOOST_CHECK_EQUAL(loaded.mRayCount, 400);
+        BOOST_CHECK_EQUAL(loaded.mParticleCount, 398);
+        BOOST_CHECK_EQUAL(loaded.mStepCount, 123456);
+        BOOST_CHECK(loaded.mObservers == checkpoint.mObservers);
+
+        std::stringstream truncated(data.substr(0, data.size() - 3));
+        BOOST_CHECK_THROW(readCheckpoint(truncated), std::runtime_error);
+        std::stringstream other("traj001\n");
+        BOOST_CHECK_THROW(readCheckpoint(other), std::runtime_error);
+    }
+
+    /// observers that are serialized directly into the file give the same file as their buffered data.
+    BOOST_AUTO_TEST_CASE(streamed_observers)
+    {
+        Checkpoint checkpoint;
+        checkpoint.mGeneratorType = "planar";
+        checkpoint.mRayCount = 400;
+        checkpoint.mObservers.emplace_back("density.dat", std::string("\0data\n", 6));
+        checkpoint.mObservers.emplace_back("energy.json", "");
+
+        std::vector<ObserverWriter> writers;
+        for(const auto& observer : checkpoint.mObservers)
+        {
+            std::string data = observer.second;
+            writers.emplace_back(observer.first, [data](std::ostream& out) { out << data; });
+        }
+
+        std::stringstream buffered;
+        writeCheckpoint(buffered, checkpoint);
+        Checkpoint info = checkpoint;
+        info.mObservers.clear();
+        std::stringstream streamed;
+        writeCheckpoint(streamed, info, writers);
+        BOOST_CHECK(streamed.str() == buffered.str());
+
+        ShardResult shard;
+        shard.mExtents = {64, 32};
+        shard.mSupport = {1.0, 0.5};
+        shard.mState = checkpoint;
+        std::stringstream buffered_shard;
+        writeShardResult(buffered_shard, shard);
+        shard.mState.mObservers.clear();
+        std::stringstream streamed_shard;
+        writeShardResult(streamed_shard, shard, writers);
+        BOOST_CHECK(streamed_shard.str() == buffered_shard.str());
+    }
+
+    /*
+     * A trace that is resumed from a checkpoint in the middle gives the same result as the uninterrupted trace.
+     * Checkpoints are written after every ray, and the one before ray 150 ends is kept for resuming.
+     */
+    BOOST_AUTO_TEST_CASE(resume)
+    {
+        TraceSetup reference;
+        std::size_t particles = reference.trace();
+
+        TraceSetup interrupted;
+        interrupted.tracer.setCheckpoint("tmp.checkpoint", 1e-9);
+        interrupted.trace();
+        std::ifstream partial_file("tmp.partial", std::ios::binary);
+        BOOST_REQUIRE(partial_file);
+        Checkpoint partial = readCheckpoint(partial_file);
+        BOOST_CHECK_EQUAL(partial.mRayCount, 149);
+        std::remove("tmp.checkpoint");
+
+        TraceSetup resumed;
+        resumed.tracer.setResumeFile("tmp.partial");
+        BOOST_CHECK_EQUAL(resumed.trace(), particles);
+
+        const auto& expected = reference.density->getDensity();
+        const auto& result = resumed.density->getDensity();
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.end());
+
+        // the checkpoint only fits a trace with the same configuration
+        TraceSetup mismatch;
+        mismatch.tracer.setResumeFile("tmp.partial");
+        BOOST_CHECK_THROW(mismatch.trace(200), std::runtime_error);
+
+        std::remove("tmp.partial");
+    }
+
+    /// observers that cannot be serialized prevent checkpoints, but tracing continues without checkpoints.
+    BOOST_AUTO_TEST_CASE(unsupported_observer)
+    {
+        TraceSetup setup;
+        // the stop observer does not implement serialize(), and its ray is never reached
+        setup.tracer.addObserver(std::make_shared<StopObserver>(setup.tracer, 1000));
+        setup.tracer.setCheckpoint("tmp.checkpoint", 1e-9);
+        BOOST_CHECK_EQUAL(setup.trace(), 300);
+        BOOST_CHECK(!std::ifstream("tmp.checkpoint"));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(shard)
+
+    BOOST_AUTO_TEST_CASE(file_roundtrip)
+    {
+        ShardResult shard;
+        shard.mShardIndex = 2;
+        shard.mShardCount = 3;
+        shard.mFirstRay = 667;
+        shard.mExtents = {64, 32};
+        shard.mSupport = {1.0, 0.5};
+        shard.mObserverConfig = {"density", "size", "32", "32"};
+        shard.mState.mGeneratorType = "planar";
+        shard.mState.mRayCount = 333;
+        shard.mState.mObservers.emplace_back("density.dat", "data");
+
+        std::stringstream stream;
+        writeShardResult(stream, shard);
+        std::string data = stream.str();
+        ShardResult loaded = readShardResult(stream);
+        BOOST_CHECK_EQUAL(loaded.mShardIndex, 2);
+        BOOST_CHECK_EQUAL(loaded.mShardCount, 3);
+        BOOST_CHECK_EQUAL(loaded.mFirstRay, 667);
+        BOOST_CHECK(loaded.mExtents == shard.mExtents);
+        BOOST_CHECK(loaded.mSupport == shard.mSupport);
+        BOOST_CHECK(loaded.mObserverConfig == shard.mObserverConfig);
+        BOOST_CHECK_EQUAL(loaded.mState.mGeneratorType, "planar");
+        BOOST_CHECK_EQUAL(loaded.mState.mRayCount, 333);
+        BOOST_CHECK(loaded.mState.mObservers == shard.mState.mObservers);
+
+        std::stringstream truncated(data.substr(0, data.size() - 3));
+        BOOST_CHECK_THROW(readShardResult(truncated), std::runtime_error);
+    }
+
+    /*
+     * Merging the saved observers of all shards of a trace gives the results of the unsharded trace. The trajectories
+     * of the later shards are renumbered, so the saved trajectories are identical.
+     */
+    BOOST_AUTO_TEST_CASE(merge)
+    {
+        Potential potential = makePotential();
+        auto create_observers = [&potential]() {
+            return std::vector<std::shared_ptr<ThreadLocalObserver>>{
+                std::make_shared<DensityObserver>(std::vector<std::size_t>{32, 32}, potential.getSupport(),
+                                                  "density.dat"),
+                std::make_shared<TrajectoryObserver>(0.1)
+            };
+        };
+        auto trace = [&](const std::vector<std::shared_ptr<ThreadLocalObserver>>& observers, std::size_t shard) {
+            Tracer tracer(potential, std::make_shared<Sound>(potential, false, false));
+            tracer.setMaxThreads(1);
+            for(const auto& observer : observers)
+                tracer.addObserver(observer);
+            auto generator = createInitialConditionGenerator(2, std::vector<std::string>{"planar"});
+            if(shard < 2)
+            {
+                generator->setShard(shard, 2);
+                ShardResult description;
+                description.mShardIndex = shard;
+                description.mShardCount = 2;
+                tracer.setShardFile("tmp.shard" + std::to_string(shard), description);
+            }
+            init_cond::InitialConditionConfiguration config;
+            config.setParticleCount(200).setEnergyNormalization(true);
+            return tracer.trace(generator, config);
+        };
+
+        auto reference = create_observers();
+        std::size_t particles = trace(reference, 2).mParticleCount;
+        trace(create_observers(), 0);
+        trace(create_observers(), 1);
+
+        auto restore = [&](std::size_t shard) {
+            std::ifstream file("tmp.shard" + std::to_string(shard), std::ios::binary);
+            ShardResult result = readShardResult(file);
+            BOOST_CHECK_EQUAL(result.mShardIndex, shard);
+            BOOST_CHECK_EQUAL(result.mFirstRay, 100 * shard);
+            BOOST_CHECK_EQUAL(result.mState.mRayCount, 100);
+            auto observers = create_observers();
+            for(const auto& observer : observers)
+            {
+                auto saved = std::find_if(result.mState.mObservers.begin(), result.mState.mObservers.end(),
+                                          [&](const std::pair<std::string, std::string>& entry)
+                                          { return entry.first == observer->filename(); });
+                BOOST_REQUIRE(saved != result.mState.mObservers.end());
+                std::istringstream data(saved->second);
+                observer->deserialize(data);
+            }
+            return std::make_pair(observers, result.mState.mParticleCount);
+        };
+        auto merged = restore(0);
+        auto second = restore(1);
+        BOOST_CHECK_EQUAL(merged.second + second.second, particles);
+        for(std::size_t i = 0; i < merged.first.size(); ++i)
+        {
+            merged.first[i]->merge(*second.first[i], 100);
+            merged.first[i]->endTracing(particles);
+        }
+
+        const auto& expected = std::dynamic_pointer_cast<DensityObserver>(reference[0])->getDensity();
+        const auto& result = std::dynamic_pointer_cast<DensityObserver>(merged.first[0])->getDensity();
+        for(auto ind = expected.getIndex(); ind.valid(); ++ind)
+            BOOST_CHECK_CLOSE(result(ind), expected(ind), 1e-3);
+
+        std::stringstream expected_trajectories;
+        std::stringstream merged_trajectories;
+        reference[1]->save(expected_trajectories);
+        merged.first[1]->save(merged_trajectories);
+        BOOST_CHECK(expected_trajectories.str() == merged_trajectories.str());
+
+        std::remove("tmp.shard0");
+        std::remove("tmp.shard1");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(time_budget)
+
+    /// a stopped trace finishes the current ray and reports the rays it has actually traced.
+    BOOST_AUTO_TEST_CASE(request_stop)
+    {
+        TraceSetup setup;
+        setup.tracer.addObserver(std::make_shared<StopObserver>(setup.tracer, 100));
+        TraceResult result = setup.run();
+        BOOST_CHECK(result.mStoppedEarly);
+        BOOST_CHECK_EQUAL(result.mParticleCount, 100);
+        BOOST_CHECK_EQUAL(setup.tracer.getTracedParticleCount(), 100);
+
+        // the stop does not carry over to the next trace
+        TraceSetup other;
+        BOOST_CHECK(!other.run().mStoppedEarly);
+    }
+
+    BOOST_AUTO_TEST_CASE(budget)
+    {
+        TraceSetup setup;
+        BOOST_CHECK_THROW(setup.tracer.setTimeBudget(-1), std::invalid_argument);
+        setup.tracer.setTimeBudget(1e-9);
+        TraceResult result = setup.run();
+        BOOST_CHECK(result.mStoppedEarly);
+        BOOST_CHECK_EQUAL(result.mParticleCount, 1);
+
+        TraceSetup unlimited;
+        unlimited.tracer.setTimeBudget(0);
+        result = unlimited.run();
+        BOOST_CHECK(!result.mStoppedEarly);
+        BOOST_CHECK_EQUAL(result.mParticleCount, 300);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(status)
+
+    BOOST_AUTO_TEST_CASE(status_file)
+    {
+        TraceSetup setup;
+        BOOST_CHECK_THROW(setup.tracer.setStatusFile("tmp.status", -1), std::invalid_argument);
+        setup.tracer.setStatusFile("tmp.status", 1e-3);
+        setup.run();
+
+        TraceStatus status = setup.tracer.getStatus();
+        BOOST_CHECK_EQUAL(status.mTracedRays, 300);
+        BOOST_CHECK_EQUAL(status.mRequestedRays, 300);
+        BOOST_CHECK_GT(status.mStepRate, 0);
+        BOOST_CHECK_GE(status.mRejectedStepRatio, 0);
+        BOOST_CHECK_LT(status.mRejectedStepRatio, 1);
+        BOOST_CHECK_EQUAL(status.mRemainingTime, 0);
+        BOOST_CHECK_EQUAL(status.mObserverStatus.count("density_queue"), 1);
+
+        // the final status is written after tracing has finished
+        std::ifstream file("tmp.status");
+        BOOST_REQUIRE(file);
+        std::stringstream content;
+        content << file.rdbuf();
+        BOOST_CHECK_NE(content.str().find("\"state\": \"finished\""), std::string::npos);
+        BOOST_CHECK_NE(content.str().find("\"rays\": 300,"), std::string::npos);
+        BOOST_CHECK_NE(content.str().find("\"density_queue\": 0"), std::string::npos);
+        std::remove("tmp.status");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+#include "daemon.hpp"
+#include "potential.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    /// a flat potential with first derivatives, as needed by the particle_potential dynamics.
+    Potential makeFlatPotential(std::size_t size = 32)
+    {
+        Potential potential(2, 1, size);
+        default_grid g(2, size);
+        for(auto& data : g)
+            data = 0;
+        potential.setPotential(g.clone());
+        potential.setDerivative(std::vector<int>{1,0}, g.clone());
+        potential.setDerivative(std::vector<int>{0,1}, g.clone());
+        return potential;
+    }
+
+    /// sends \p request to the daemon listening on \p path, retrying until the daemon has opened its socket.
+    std::string sendRequest(const std::string& path, const std::string& request)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path.c_str());
+        for(int attempt = 0; attempt < 100; ++attempt)
+        {
+            int client = socket(AF_UNIX, SOCK_STREAM, 0);
+            if(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+            {
+                close(client);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                continue;
+            }
+            std::string line = request + "\n";
+            BOOST_REQUIRE_EQUAL(send(client, line.data(), line.size(), 0), (ssize_t)line.size());
+            std::string answer;
+            char buffer[256];
+            ssize_t count;
+            while((count = recv(client, buffer, sizeof(buffer), 0)) > 0)
+                answer.append(buffer, count);
+            close(client);
+            return answer;
+        }
+        BOOST_FAIL("could not connect to the daemon");
+        return "";
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(daemon_test)
+
+    BOOST_AUTO_TEST_CASE(parse_job)
+    {
+        TraceJob job = parseTraceJob("pot.dat -n 500 -s 0.25 -r \"some path\" --incoming planar vx 1 "
+                                     "--observers density size 16 16 caustics --periodic -e 2.5 --threads 3");
+        BOOST_CHECK_EQUAL(job.mPotentialFile, "pot.dat");
+        BOOST_CHECK_EQUAL(job.mParticleCount, 500);
+        BOOST_CHECK(job.mOverrideStrength);
+        BOOST_CHECK_EQUAL(job.mStrength, 0.25);
+        BOOST_CHECK_EQUAL(job.mResultPath, "some path");
+        BOOST_CHECK((job.mIncoming == std::vector<std::string>{"planar", "vx", "1"}));
+        BOOST_CHECK((job.mObservers == std::vector<std::string>{"density", "size", "16", "16", "caustics"}));
+        BOOST_CHECK(job.mPeriodic);
+        BOOST_CHECK_EQUAL(job.mEndTime, 2.5);
+        BOOST_CHECK_EQUAL(job.mThreads, 3);
+        BOOST_CHECK(job.mNormalizeEnergy);
+
+        TraceJob defaults = parseTraceJob("pot.dat");
+        BOOST_CHECK(!defaults.mOverrideStrength);
+        BOOST_CHECK((defaults.mDynamics == std::vector<std::string>{"particle_potential"}));
+
+        BOOST_CHECK_THROW(parseTraceJob("-n 100"), std::invalid_argument);
+        BOOST_CHECK_THROW(parseTraceJob("pot.dat --resume"), std::invalid_argument);
+    }
+
+    BOOST_AUTO_TEST_CASE(cache)
+    {
+        std::size_t loads = 0;
+        auto loader = [&loads](const std::string&) { ++loads; return makeFlatPotential(); };
+        std::size_t bytes = makeFlatPotential().getMemorySize();
+        PotentialCache cache(2 * bytes, loader);
+
+        auto first = cache.get("a", false, 0).mPotential;
+        BOOST_CHECK_EQUAL(cache.get("a", false, 0).mPotential, first);
+        BOOST_CHECK_EQUAL(loads, 1);
+        BOOST_CHECK_EQUAL(cache.getHits(), 1);
+        BOOST_CHECK_EQUAL(cache.getBytes(), bytes);
+
+        // the strength is applied to the grids, so each strength is a potential of its own
+        BOOST_CHECK_EQUAL(cache.get("a", true, 0.5).mPotential->getStrength(), 0.5);
+        BOOST_CHECK_EQUAL(loads, 2);
+
+        // "a" has been used more recently than "a" with strength 0.5, so the latter is evicted
+        cache.get("a", false, 0);
+        cache.get("b", false, 0);
+        BOOST_CHECK_EQUAL(cache.size(), 2);
+        BOOST_CHECK_EQUAL(cache.getBytes(), 2 * bytes);
+        cache.get("a", false, 0);
+        BOOST_CHECK_EQUAL(loads, 3);
+        cache.get("a", true, 0.5);
+        BOOST_CHECK_EQUAL(loads, 4);
+        BOOST_CHECK_EQUAL(cache.getMisses(), 4);
+
+        // a single potential is kept even if it exceeds the limit
+        PotentialCache small(1, loader);
+        small.get("a", false, 0);
+        BOOST_CHECK_EQUAL(small.size(), 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(jobs)
+    {
+        std::size_t loads = 0;
+        TraceDaemon daemon("tmp.daemon", 1 << 30, [&loads](const std::string&) { ++loads; return makeFlatPotential(); });
+
+        std::string job = "pot.dat -t 1 -r tmp_daemon_result --observers density size 16 16";
+        BOOST_CHECK_EQUAL(daemon.handleRequest(job + " -n 50").substr(0, 6), "ok 50 ");
+        BOOST_CHECK(std::ifstream("tmp_daemon_result/density.dat"));
+        BOOST_CHECK(std::ifstream("tmp_daemon_result/config.txt"));
+
+        // the second job reuses the potential and its dynamics
+        BOOST_CHECK_EQUAL(daemon.handleRequest(job + " -n 20").substr(0, 6), "ok 20 ");
+        BOOST_CHECK_EQUAL(loads, 1);
+        BOOST_CHECK_EQUAL(daemon.getCache().getHits(), 1);
+
+        BOOST_CHECK_EQUAL(daemon.handleRequest("pot.dat --observers nonsense").substr(0, 6), "error ");
+        BOOST_CHECK_EQUAL(daemon.handleRequest("").substr(0, 6), "error ");
+
+        for(const char* file : {"density.dat", "energy.json", "config.txt"})
+            std::remove((std::string("tmp_daemon_result/") + file).c_str());
+        rmdir("tmp_daemon_result");
+    }
+
+    BOOST_AUTO_TEST_CASE(socket)
+    {
+        TraceDaemon daemon("tmp.daemon", 1 << 30, [](const std::string&) { return makeFlatPotential(); });
+        std::thread server([&daemon]() { daemon.run(); });
+
+        std::string answer = sendRequest("tmp.daemon", "pot.dat -n 10 -t 1 -r tmp_daemon_socket --observers density size 8 8");
+        BOOST_CHECK_EQUAL(answer.substr(0, 6), "ok 10 ");
+        BOOST_CHECK_EQUAL(answer.back(), '\n');
+        BOOST_CHECK_EQUAL(sendRequest("tmp.daemon", "shutdown"), "ok shutdown\n");
+        server.join();
+
+        // the socket is removed once the daemon has stopped
+        BOOST_CHECK(access("tmp.daemon", F_OK) != 0);
+        for(const char* file : {"density.dat", "energy.json", "config.txt"})
+            std::remove((std::string("tmp_daemon_socket/") + file).c_str());
+        rmdir("tmp_daemon_socket");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
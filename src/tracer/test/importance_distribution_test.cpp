@@ -0,0 +1,114 @@
+#include "initial_conditions/importance_distribution.hpp"
+#include "initial_conditions/manifold_sampler.hpp"
+#include "initial_conditions/radial_wave.hpp"
+#include "global.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+
+using zero_vec = boost::numeric::ublas::zero_vector<double>;
+
+using namespace init_cond;
+
+BOOST_AUTO_TEST_SUITE(importance_distribution)
+
+    BOOST_AUTO_TEST_CASE(uniform)
+    {
+        ImportanceDistribution uniform(2, [](const manifold_pos&) { return 3.0; });
+        manifold_pos p(2);
+        p[0] = 0.3;
+        p[1] = 0.71;
+        BOOST_CHECK_CLOSE(uniform.transform(p), 1.0, 1e-10);
+        BOOST_CHECK_CLOSE(p[0], 0.3, 1e-8);
+        BOOST_CHECK_CLOSE(p[1], 0.71, 1e-8);
+    }
+
+    /*
+     * For the density 2x, the inverse CDF is sqrt(u) and the weight 1 / 2x. The tabulation
+     * introduces an error of the order of the cell size.
+     */
+    BOOST_AUTO_TEST_CASE(linear_density)
+    {
+        ImportanceDistribution linear(1, [](const manifold_pos& p) { return p[0]; });
+        manifold_pos p(1);
+        for(double u : {0.01, 0.25, 0.5, 0.9})
+        {
+            p[0] = u;
+            double weight = linear.transform(p);
+            BOOST_CHECK_CLOSE(p[0], std::sqrt(u), 0.1);
+            BOOST_CHECK_CLOSE(weight, 1 / (2 * p[0]), 1.0);
+            BOOST_CHECK_CLOSE(linear.getDensity(p), 1 / weight, 1e-10);
+        }
+    }
+
+    /*
+     * The weighted average over importance sampled points is an estimate of the uniform average.
+     */
+    BOOST_AUTO_TEST_CASE(unbiased)
+    {
+        auto distribution = createImportanceDistribution("0.2 + math.exp(-((u - 0.3) / 0.2)^2) * (1 + v)", 2);
+        SobolSampler sobol(2);
+        manifold_pos p(2);
+        const std::size_t count = 1 << 14;
+        double sum = 0, weight_sum = 0;
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            sobol.sample(i, p);
+            double weight = distribution->transform(p);
+            sum += weight * p[0] * p[1];
+            weight_sum += weight;
+        }
+        BOOST_CHECK_CLOSE(weight_sum / count, 1.0, 1.0);
+        BOOST_CHECK_CLOSE(sum / count, 0.25, 1.0);
+    }
+
+    BOOST_AUTO_TEST_CASE(invalid)
+    {
+        BOOST_CHECK_THROW(createImportanceDistribution("u -", 1), std::invalid_argument);
+        BOOST_CHECK_THROW(createImportanceDistribution("u > 0.5", 1), std::invalid_argument);
+        BOOST_CHECK_THROW(createImportanceDistribution("u - 0.5", 1), std::invalid_argument);
+        BOOST_CHECK_THROW(createImportanceDistribution("0", 1), std::invalid_argument);
+        BOOST_CHECK_THROW(createImportanceDistribution("1", 4), std::invalid_argument);
+    }
+
+    /*
+     * A narrow beam from a radial wave: all rays start in the beam, with the weight of the
+     * fraction of the full circle they represent.
+     */
+    BOOST_AUTO_TEST_CASE(radial_beam)
+    {
+        RadialWave2D wave(2);
+        BOOST_CHECK_THROW(wave.setImportance(createImportanceDistribution("1", 2)), std::invalid_argument);
+        wave.setImportance(createImportanceDistribution("(u > 0.2 and u < 0.25) and 1 or 0", 1));
+
+        InitialConditionConfiguration config;
+        config.setParticleCount(1000).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0}).setOffset(zero_vec(2));
+        wave.init(config);
+
+        std::size_t count = 0;
+        for(auto ic = wave.next(); ic; ++ic)
+        {
+            // the edges of the beam are rounded to the tabulation grid
+            double u = std::atan2(ic.getState().getVelocity()[0], ic.getState().getVelocity()[1]) / (2 * pi);
+            BOOST_CHECK(u >= 0.2 - 1.0 / 4096 && u <= 0.25 + 1.0 / 4096);
+            BOOST_CHECK_CLOSE(ic.getWeight(), 0.05, 0.1);
+            ++count;
+        }
+        BOOST_CHECK_EQUAL(count, 1000);
+    }
+
+    /// the lattice of the 3d radial wave is not uniform, so it cannot be importance sampled.
+    BOOST_AUTO_TEST_CASE(requires_uniform_lattice)
+    {
+        RadialWave3D wave(3);
+        wave.setImportance(createImportanceDistribution("1 + u", 2));
+        InitialConditionConfiguration config;
+        config.setParticleCount(100).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0, 1.0}).setOffset(zero_vec(3));
+        BOOST_CHECK_THROW(wave.init(config), std::logic_error);
+
+        wave.setSampler(std::make_shared<SobolSampler>(2));
+        wave.init(config);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,10 +3,15 @@
 //
 
 #include "initial_conditions/initial_conditions.hpp"
+#include "initial_conditions/generic_form.hpp"
+#include "initial_conditions/manifold_sampler.hpp"
+#include "initial_conditions/radial_wave.hpp"
 #include "dynamics/ParticleInScaledPotential.hpp"
 #include <boost/test/unit_test.hpp>
 #include <fstream>
 #include <future>
+#include <map>
+#include <thread>
 #include "test_helpers.hpp"
 
 using namespace init_cond;
@@ -392,4 +397,131 @@ BOOST_AUTO_TEST_SUITE(init_condition_tests)
         }
     }
 
+    /*
+     * The generic generator evaluates lua code outside of the generator lock. Concurrent threads
+     * have to produce the same initial conditions as a single one.
+     */
+    BOOST_AUTO_TEST_CASE(generic_concurrent)
+    {
+        GenericCaustic2D generator(3, 0.1, 1.0);
+        generator.setFunction("0.1 * u * u + 0.05 * math.sin(3 * v)");
+        InitialConditionConfiguration config;
+        config.setEnergyNormalization(false).setParticleCount(400).setSupport(std::vector<double>{1.0, 1.0, 1.0})
+              .setOffset(zero_vec(3));
+
+        using result_map = std::map<std::pair<int, int>, std::vector<double>>;
+        auto collect = [&]() {
+            result_map result;
+            for(auto ic = generator.next(); ic; ++ic) {
+                std::vector<double> values;
+                for(unsigned i = 0; i < 3; ++i) {
+                    values.push_back(ic.getState().getPosition()[i]);
+                    values.push_back(ic.getState().getVelocity()[i]);
+                    values.push_back(ic.getDelta(1).getVelocity()[i]);
+                }
+                result[std::make_pair(ic.getManifoldIndex()[0], ic.getManifoldIndex()[1])] = values;
+            }
+            return result;
+        };
+
+        generator.init(config);
+        result_map reference = collect();
+        BOOST_REQUIRE_EQUAL(reference.size(), 400);
+
+        generator.init(config);
+        std::vector<std::future<result_map>> results;
+        for(int i = 0; i < 4; ++i) {
+            results.emplace_back(std::async(std::launch::async, collect));
+        }
+
+        std::size_t count = 0;
+        for(auto& res: results) {
+            for(auto& ray : res.get()) {
+                BOOST_REQUIRE(reference.count(ray.first) == 1);
+                BOOST_CHECK(ray.second == reference.at(ray.first));
+                ++count;
+            }
+        }
+        BOOST_CHECK_EQUAL(count, 400);
+    }
+
+    /*
+     * Skipping rays continues the iteration exactly where a complete iteration would be after that many rays. The
+     * 3d radial wave adapts its lattice during iteration, so this also checks that skip() walks the lattice.
+     */
+    BOOST_AUTO_TEST_CASE(skip)
+    {
+        auto check_skip = [](std::function<std::shared_ptr<InitialConditionGenerator>()> create,
+                             std::size_t world_dimension) {
+            InitialConditionConfiguration config;
+            config.setEnergyNormalization(false).setParticleCount(500)
+                  .setSupport(std::vector<double>(world_dimension, 1.0)).setOffset(zero_vec(world_dimension));
+
+            auto generator = create();
+            generator->init(config);
+            // sampled rays are identified by their ray id, lattice rays by their manifold index
+            std::vector<std::pair<std::vector<int>, std::uint64_t>> reference;
+            for(auto ic = generator->next(); ic; ++ic)
+                reference.emplace_back(ic.getManifoldIndex(), ic.getRayId());
+            BOOST_REQUIRE_GT(reference.size(), 200);
+
+            generator = create();
+            generator->init(config);
+            generator->skip(200);
+            std::vector<std::pair<std::vector<int>, std::uint64_t>> rest;
+            for(auto ic = generator->next(); ic; ++ic)
+                rest.emplace_back(ic.getManifoldIndex(), ic.getRayId());
+            BOOST_REQUIRE_EQUAL(rest.size(), reference.size() - 200);
+            BOOST_CHECK(std::equal(rest.begin(), rest.end(), reference.begin() + 200));
+        };
+
+        check_skip([]() { return std::make_shared<RadialWave3D>(3); }, 3);
+        check_skip([]() {
+            auto sampled = std::make_shared<DummyICGenerator>(2, 2, DummyICMode::IDENTITY);
+            sampled->setSampler(createManifoldSampler("sobol", 2));
+            return sampled;
+        }, 2);
+    }
+
+    /// the shards of a generator together produce each ray of the unsharded generator exactly once, in order.
+    BOOST_AUTO_TEST_CASE(shard)
+    {
+        auto check_shards = [](std::function<std::shared_ptr<InitialConditionGenerator>()> create,
+                               std::size_t world_dimension, std::size_t shards) {
+            InitialConditionConfiguration config;
+            config.setEnergyNormalization(false).setParticleCount(500)
+                  .setSupport(std::vector<double>(world_dimension, 1.0)).setOffset(zero_vec(world_dimension));
+
+            auto generator = create();
+            generator->init(config);
+            // sampled rays are identified by their ray id, lattice rays by their manifold index
+            std::vector<std::pair<std::vector<int>, std::uint64_t>> reference;
+            for(auto ic = generator->next(); ic; ++ic)
+                reference.emplace_back(ic.getManifoldIndex(), ic.getRayId());
+
+            std::vector<std::pair<std::vector<int>, std::uint64_t>> combined;
+            for(std::size_t i = 0; i < shards; ++i)
+            {
+                generator = create();
+                generator->setShard(i, shards);
+                generator->init(config);
+                BOOST_CHECK_EQUAL(generator->getShardBegin(), combined.size());
+                for(auto ic = generator->next(); ic; ++ic)
+                    combined.emplace_back(ic.getManifoldIndex(), ic.getRayId());
+            }
+            BOOST_REQUIRE_EQUAL(combined.size(), reference.size());
+            BOOST_CHECK(std::equal(combined.begin(), combined.end(), reference.begin()));
+        };
+
+        check_shards([]() { return std::make_shared<RadialWave3D>(3); }, 3, 3);
+        check_shards([]() {
+            auto sampled = std::make_shared<DummyICGenerator>(2, 2, DummyICMode::IDENTITY);
+            sampled->setSampler(createManifoldSampler("sobol", 2));
+            return sampled;
+        }, 2, 4);
+
+        DummyICGenerator generator(2, 2, DummyICMode::IDENTITY);
+        BOOST_CHECK_THROW(generator.setShard(2, 2), std::invalid_argument);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,243 @@
+#include "initial_conditions/manifold_refinement.hpp"
+#include "initial_conditions/manifold_sampler.hpp"
+#include "initial_conditions/planar_wave.hpp"
+#include "dynamics/ParticleInPotentialDynamics.hpp"
+#include "observers/observer.hpp"
+#include "tracer.hpp"
+#include "potential.hpp"
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <thread>
+
+using zero_vec = boost::numeric::ublas::zero_vector<double>;
+
+using namespace init_cond;
+
+namespace
+{
+    /// observer that throws when trajectory \p ray ends.
+    class ThrowingObserver final : public ThreadLocalObserver
+    {
+    public:
+        explicit ThrowingObserver(std::size_t ray) : ThreadLocalObserver("throw"), mRay(ray) {}
+        bool watch(const State&, double) override { return false; }
+        void startTrajectory(const InitialCondition&, std::size_t trajectory) override { mTrajectory = trajectory; }
+        void endTrajectory(const State&) override
+        {
+            if(mTrajectory == mRay)
+                throw std::runtime_error("observer failed");
+        }
+        void save(std::ostream&) override { }
+    private:
+        std::shared_ptr<ThreadLocalObserver> clone() const override
+        {
+            return std::make_shared<ThrowingObserver>(mRay);
+        }
+        void combine(ThreadLocalObserver&) override { }
+
+        std::size_t mRay;
+        std::size_t mTrajectory = 0;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(manifold_refinement)
+
+    /// traces all rays of \p refinement, letting each ray end at \p end(x) for manifold coordinate x.
+    /// Returns the weighted sum of \p integrand over the rays.
+    template<class F, class G>
+    double traceAll(ManifoldRefinement& refinement, F end, G integrand)
+    {
+        std::mutex mutex;
+        std::unique_lock<std::mutex> lock(mutex);
+        manifold_pos pos(refinement.getDimension());
+        gen_vect final_position(1);
+        std::uint64_t ray;
+        double sum = 0;
+        while(refinement.next(lock, ray))
+        {
+            refinement.getPosition(ray, pos);
+            sum += refinement.getWeight(ray) * integrand(pos);
+            final_position[0] = end(pos);
+            refinement.finish(ray, final_position);
+        }
+        return sum;
+    }
+
+    BOOST_AUTO_TEST_CASE(smooth_manifold)
+    {
+        // neighbouring rays end 1/10 apart, which is below the threshold
+        ManifoldRefinement refinement(2, 0.2, 3);
+        refinement.start(100);
+        double weight = traceAll(refinement, [](const manifold_pos& p) { return p[0]; },
+                                 [](const manifold_pos&) { return 1.0; });
+
+        BOOST_CHECK_EQUAL(refinement.getRayCount(), 100);
+        BOOST_CHECK_EQUAL(refinement.getPassCount(), 1);
+        BOOST_CHECK_CLOSE(weight, 100, 1e-10);
+    }
+
+    /*
+     * A discontinuity at 0.43 is refined on both sides up to the maximum level. The weights still
+     * form a partition of the manifold, so the midpoint rule stays exact for linear functions.
+     */
+    BOOST_AUTO_TEST_CASE(discontinuity)
+    {
+        ManifoldRefinement refinement(1, 0.5, 2);
+        refinement.start(10);
+        auto step = [](const manifold_pos& p) { return p[0] < 0.43 ? 0.0 : 1.0; };
+
+        double weight = traceAll(refinement, step, [](const manifold_pos&) { return 1.0; });
+        BOOST_CHECK_CLOSE(weight, 10, 1e-10);
+        BOOST_CHECK_EQUAL(refinement.getPassCount(), 3);
+        // 10 coarse rays; cells 3 and 4 are split into 2 new rays + 1 correction each; at level 1, only the
+        // two cells adjacent to the jump diverge.
+        BOOST_CHECK_EQUAL(refinement.getRayCount(), 10 + 2 * 3 + 2 * 3);
+
+        refinement.start(10);
+        double mean = traceAll(refinement, step, [](const manifold_pos& p) { return p[0]; });
+        BOOST_CHECK_CLOSE(mean / 10, 0.5, 1e-10);
+    }
+
+    BOOST_AUTO_TEST_CASE(invalid)
+    {
+        BOOST_CHECK_THROW(ManifoldRefinement(4, 0.1, 2), std::invalid_argument);
+        BOOST_CHECK_THROW(ManifoldRefinement(1, 0.0, 2), std::invalid_argument);
+        BOOST_CHECK_THROW(ManifoldRefinement(1, 0.1, 30).start(100), std::invalid_argument);
+
+        ManifoldRefinement refinement(1, 0.1, 2);
+        refinement.start(10);
+        std::mutex mutex;
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t ray;
+        refinement.next(lock, ray);
+        refinement.finish(ray, gen_vect(1));
+        BOOST_CHECK_THROW(refinement.finish(ray, gen_vect(1)), std::logic_error);
+    }
+
+    /*
+     * Several threads iterate over a refining generator concurrently. The passes have to be synchronized,
+     * and the weights of all rays have to add up to the coarse lattice.
+     */
+    BOOST_AUTO_TEST_CASE(concurrent_generator)
+    {
+        PlanarWave wave(2, 1);
+        BOOST_CHECK_THROW(wave.setRefinement(std::make_shared<ManifoldRefinement>(2, 0.1, 2)), std::invalid_argument);
+        auto refinement = std::make_shared<ManifoldRefinement>(1, 0.5, 3);
+        wave.setRefinement(refinement);
+
+        InitialConditionConfiguration config;
+        config.setParticleCount(50).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0}).setOffset(zero_vec(2));
+        wave.init(config);
+
+        std::atomic<std::size_t> rays{0};
+        std::mutex sum_mutex;
+        double weight_sum = 0;
+        auto worker = [&]()
+        {
+            State final_state(2);
+            for(auto ic = wave.next(); ic; ++ic)
+            {
+                double y = ic.getState().getPosition()[1];
+                final_state.editPos()[0] = 0;
+                final_state.editPos()[1] = y < 0.3 ? 0.0 : 1.0;
+                {
+                    std::lock_guard<std::mutex> lock(sum_mutex);
+                    weight_sum += ic.getWeight();
+                }
+                ++rays;
+                std::this_thread::yield();
+                wave.finishTrajectory(ic, final_state);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 4; ++i)
+            threads.emplace_back(worker);
+        for(auto& t : threads)
+            t.join();
+
+        BOOST_CHECK_EQUAL(rays, refinement->getRayCount());
+        BOOST_CHECK_EQUAL(refinement->getPassCount(), 4);
+        BOOST_CHECK_CLOSE(weight_sum, 50, 1e-10);
+
+        // the sampler and the refinement exclude each other
+        wave.setSampler(createManifoldSampler("sobol", 1));
+        BOOST_CHECK_THROW(wave.init(config), std::logic_error);
+    }
+
+    /*
+     * If a thread fails in the middle of a pass, its ray is never finished. Aborting the generator releases the
+     * threads that wait for the pass, until the refinement is started again.
+     */
+    BOOST_AUTO_TEST_CASE(abort)
+    {
+        PlanarWave wave(2, 1);
+        auto refinement = std::make_shared<ManifoldRefinement>(1, 0.5, 3);
+        wave.setRefinement(refinement);
+        InitialConditionConfiguration config;
+        config.setParticleCount(50).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0}).setOffset(zero_vec(2));
+        wave.init(config);
+
+        std::atomic<std::size_t> rays{0};
+        auto worker = [&]()
+        {
+            State final_state(2);
+            try
+            {
+                for(auto ic = wave.next(); ic; ++ic)
+                {
+                    if(++rays == 10)
+                        throw std::runtime_error("ray failed");
+                    wave.finishTrajectory(ic, final_state);
+                }
+            } catch(std::runtime_error&)
+            {
+                wave.abort();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 4; ++i)
+            threads.emplace_back(worker);
+        for(auto& t : threads)
+            t.join();
+
+        BOOST_CHECK(!wave.next());
+        BOOST_CHECK_LE(rays, 50);
+
+        std::mutex mutex;
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t ray;
+        BOOST_CHECK(!refinement->next(lock, ray));
+        refinement->start(50);
+        BOOST_CHECK(refinement->next(lock, ray));
+    }
+
+    /*
+     * The same within the tracer: an observer that throws must not leave the other tracing threads waiting for the
+     * failed ray forever, and the error has to reach the caller.
+     */
+    BOOST_AUTO_TEST_CASE(failing_ray)
+    {
+        Potential potential(2, 1, 32);
+        default_grid g(2, 32);
+        for(auto& data : g)
+            data = 0;
+        potential.setPotential(g.clone());
+        potential.setDerivative(std::vector<int>{1,0}, g.clone());
+        potential.setDerivative(std::vector<int>{0,1}, g.clone());
+
+        Tracer tracer(potential, std::make_shared<ParticleInPotentialDynamics>(potential, false, false));
+        tracer.setMaxThreads(4);
+        tracer.addObserver(std::make_shared<ThrowingObserver>(5));
+
+        InitCondGenPtr wave = std::make_shared<PlanarWave>(2, 1);
+        wave->setRefinement(std::make_shared<ManifoldRefinement>(1, 0.1, 2));
+        InitialConditionConfiguration config;
+        config.setParticleCount(20);
+        BOOST_CHECK_THROW(tracer.trace(wave, config), std::runtime_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,179 @@
+#include "initial_conditions/manifold_sampler.hpp"
+#include "initial_conditions/planar_wave.hpp"
+#include "initial_conditions/radial_wave.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <set>
+
+using zero_vec = boost::numeric::ublas::zero_vector<double>;
+
+using namespace init_cond;
+
+BOOST_AUTO_TEST_SUITE(manifold_sampler)
+
+    /// checks that the first 2^log_count points of \p sampler form a (0, m, 2)-net in the first two dimensions:
+    /// every elementary interval of volume 2^-m contains exactly one point.
+    void checkNetProperty(const ManifoldSampler& sampler, unsigned log_count)
+    {
+        std::size_t count = std::size_t(1) << log_count;
+        std::vector<manifold_pos> points(count, manifold_pos(sampler.getDimension()));
+        for(std::size_t i = 0; i < count; ++i)
+            sampler.sample(i, points[i]);
+
+        for(unsigned bits_x = 0; bits_x <= log_count; ++bits_x)
+        {
+            std::size_t cells_x = std::size_t(1) << bits_x;
+            std::size_t cells_y = count / cells_x;
+            std::set<std::size_t> occupied;
+            for(const auto& p : points)
+            {
+                occupied.insert( std::size_t(p[0] * cells_x) * cells_y + std::size_t(p[1] * cells_y) );
+            }
+            BOOST_CHECK_EQUAL(occupied.size(), count);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(sobol_first_points)
+    {
+        SobolSampler sobol(2);
+        manifold_pos p(2);
+        sobol.sample(1, p);
+        BOOST_CHECK_CLOSE(p[0], 0.5, 1e-6);
+        BOOST_CHECK_CLOSE(p[1], 0.5, 1e-6);
+        sobol.sample(2, p);
+        BOOST_CHECK_CLOSE(p[0], 0.25, 1e-6);
+        BOOST_CHECK_CLOSE(p[1], 0.75, 1e-6);
+
+        // no point lies on the boundary
+        sobol.sample(0, p);
+        BOOST_CHECK(p[0] > 0 && p[1] > 0);
+
+        // the highest bit of the index is used, and the sequence repeats after 2^32 points
+        manifold_pos q(2);
+        sobol.sample(std::uint64_t(1) << 31, q);
+        BOOST_CHECK(q[0] > 0 && q[0] < 1 && q[0] != p[0]);
+        sobol.sample((std::uint64_t(1) << 32) + 2, p);
+        BOOST_CHECK_CLOSE(p[0], 0.25, 1e-6);
+    }
+
+    BOOST_AUTO_TEST_CASE(sobol_is_net)
+    {
+        checkNetProperty(SobolSampler(2), 10);
+        // nested uniform scrambling preserves the net property
+        checkNetProperty(SobolSampler(2, true, 5), 10);
+    }
+
+    /*
+     * Each single coordinate of the Sobol sequence is a permuted van der Corput sequence, so the first 2^m
+     * points stratify [0, 1] into 2^m intervals in every dimension.
+     */
+    BOOST_AUTO_TEST_CASE(sobol_one_dimensional_projections)
+    {
+        const std::size_t count = 256;
+        for(bool scrambled : {false, true})
+        {
+            SobolSampler sobol(SobolSampler::MAX_DIMENSION, scrambled, 17);
+            std::vector<std::set<std::size_t>> occupied(SobolSampler::MAX_DIMENSION);
+            manifold_pos p(SobolSampler::MAX_DIMENSION);
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                sobol.sample(i, p);
+                for(unsigned j = 0; j < p.size(); ++j)
+                    occupied[j].insert( std::size_t(p[j] * count) );
+            }
+            for(const auto& o : occupied)
+                BOOST_CHECK_EQUAL(o.size(), count);
+        }
+
+        BOOST_CHECK_THROW(SobolSampler(SobolSampler::MAX_DIMENSION + 1), std::invalid_argument);
+    }
+
+    BOOST_AUTO_TEST_CASE(seeds)
+    {
+        manifold_pos a(2), b(2);
+        SobolSampler(2, true, 1).sample(3, a);
+        SobolSampler(2, true, 1).sample(3, b);
+        BOOST_CHECK_EQUAL(a[0], b[0]);
+        SobolSampler(2, true, 2).sample(3, b);
+        BOOST_CHECK_NE(a[0], b[0]);
+
+        R2Sampler(2, true, 1).sample(3, a);
+        R2Sampler(2, true, 2).sample(3, b);
+        BOOST_CHECK_NE(a[0], b[0]);
+    }
+
+    BOOST_AUTO_TEST_CASE(r2_sequence)
+    {
+        R2Sampler r2(2);
+        manifold_pos p(2);
+        r2.sample(0, p);
+        BOOST_CHECK_CLOSE(p[0], 0.5, 1e-6);
+        BOOST_CHECK_CLOSE(p[1], 0.5, 1e-6);
+
+        // phi_2 = 1.3247..., the plastic number
+        r2.sample(1, p);
+        BOOST_CHECK_CLOSE(p[0], std::fmod(0.5 + 1 / 1.32471795724474602596, 1.0), 1e-6);
+        BOOST_CHECK_CLOSE(p[1], std::fmod(0.5 + 1 / (1.32471795724474602596 * 1.32471795724474602596), 1.0), 1e-6);
+
+        // exact for very large indices
+        r2.sample(std::uint64_t(1) << 40, p);
+        BOOST_CHECK(p[0] > 0 && p[0] < 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(factory)
+    {
+        BOOST_CHECK(!createManifoldSampler("lattice", 2));
+        BOOST_CHECK_EQUAL(createManifoldSampler("sobol", 2)->getDimension(), 2);
+        BOOST_CHECK_EQUAL(createManifoldSampler("r2_shifted", 1, 4)->getDimension(), 1);
+        BOOST_CHECK_THROW(createManifoldSampler("halton", 2), std::invalid_argument);
+    }
+
+    /*
+     * With a sampler, the generator produces exactly the requested number of rays, and the
+     * ray id reports the ray index.
+     */
+    BOOST_AUTO_TEST_CASE(generator_ray_count)
+    {
+        PlanarWave wave(2, 1);
+        BOOST_CHECK_THROW(wave.setSampler(std::make_shared<SobolSampler>(2)), std::invalid_argument);
+        wave.setSampler(std::make_shared<SobolSampler>(1));
+
+        InitialConditionConfiguration config;
+        config.setParticleCount(1000).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0}).setOffset(zero_vec(2));
+        wave.init(config);
+
+        std::size_t count = 0;
+        for(auto ic = wave.next(); ic; ++ic)
+        {
+            BOOST_CHECK_EQUAL(ic.getRayId(), count);
+            BOOST_CHECK(ic.getState().getPosition()[1] > 0 && ic.getState().getPosition()[1] < 1);
+            ++count;
+        }
+        BOOST_CHECK_EQUAL(count, 1000);
+    }
+
+    /*
+     * The sampled 3d radial wave has to be uniform on the sphere, like the lattice: <v_z^2> = 1/3.
+     */
+    BOOST_AUTO_TEST_CASE(radial_3d_uniform)
+    {
+        RadialWave3D wave(3);
+        wave.setSampler(std::make_shared<SobolSampler>(2));
+        InitialConditionConfiguration config;
+        config.setParticleCount(4096).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{1.0, 1.0, 1.0}).setOffset(zero_vec(3));
+        wave.init(config);
+
+        double sum_z = 0, sum_zz = 0;
+        for(auto ic = wave.next(); ic; ++ic)
+        {
+            double z = ic.getState().getVelocity()[2];
+            sum_z += z;
+            sum_zz += z * z;
+        }
+        BOOST_CHECK_SMALL(sum_z / 4096, 1e-3);
+        BOOST_CHECK_CLOSE(sum_zz / 4096, 1.0 / 3.0, 0.5);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+#include "initial_conditions/ray_file.hpp"
+#include "initial_conditions/manifold_sampler.hpp"
+#include "fileIO.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <future>
+
+using zero_vec = boost::numeric::ublas::zero_vector<double>;
+
+using namespace init_cond;
+
+BOOST_AUTO_TEST_SUITE(ray_file)
+
+    /// writes \p count two dimensional rays, ray i starting at (i, 2i) with velocity (1, -i) and weight i / 2.
+    void writeRays(const std::string& file_name, std::size_t count, bool weighted, const char* header = "rays001\n")
+    {
+        std::fstream out(file_name, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+        out << header;
+        writeInteger(out, 2);
+        writeInteger(out, weighted ? 1 : 0);
+        writeInteger(out, count);
+        BinaryWriter writer(out);
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            writer.putFloats(std::vector<double>{double(i), 2.0 * i, 1.0, -double(i)});
+            if(weighted)
+                writer.putFloat(i / 2.0);
+        }
+    }
+
+    InitialConditionConfiguration config()
+    {
+        InitialConditionConfiguration config;
+        config.setParticleCount(1).setEnergyNormalization(false)
+                .setSupport(std::vector<double>{2.0, 2.0}).setOffset(boost::numeric::ublas::scalar_vector<double>(2, 1.0));
+        return config;
+    }
+
+    BOOST_AUTO_TEST_CASE(read_rays)
+    {
+        writeRays("tmp.rays", 10, true);
+        RayFile rays(2, "tmp.rays");
+        BOOST_CHECK_EQUAL(rays.getFileRecordCount(), 10);
+        BOOST_CHECK(rays.isWeighted());
+        rays.selectRecords(3, 5);
+        rays.init(config());
+
+        // positions are not scaled or offset
+        std::size_t record = 3;
+        for(auto ic = rays.next(); ic; ++ic, ++record)
+        {
+            BOOST_CHECK_EQUAL(ic.getState().getPosition()[0], record);
+            BOOST_CHECK_EQUAL(ic.getState().getPosition()[1], 2.0 * record);
+            BOOST_CHECK_EQUAL(ic.getState().getVelocity()[0], 1.0);
+            BOOST_CHECK_EQUAL(ic.getState().getVelocity()[1], -double(record));
+            BOOST_CHECK_EQUAL(ic.getWeight(), record / 2.0);
+            BOOST_CHECK_EQUAL(ic.getRayId(), record - 3);
+            BOOST_CHECK_EQUAL(norm_2(ic.getDelta(0).getPosition()), 0.0);
+            BOOST_CHECK_EQUAL(norm_2(ic.getDelta(0).getVelocity()), 0.0);
+        }
+        BOOST_CHECK_EQUAL(record, 8);
+        BOOST_CHECK_THROW(rays.selectRecords(5, 6), std::out_of_range);
+        BOOST_CHECK_THROW(rays.selectRecords(10, 0), std::invalid_argument);
+
+        writeRays("tmp.rays", 4, false);
+        RayFile unweighted(2, "tmp.rays");
+        unweighted.init(config());
+        for(auto ic = unweighted.next(); ic; ++ic)
+            BOOST_CHECK_EQUAL(ic.getWeight(), 1.0);
+
+        // the rays cannot be placed on the manifold
+        unweighted.setSampler(createManifoldSampler("sobol", 1));
+        BOOST_CHECK_THROW(unweighted.init(config()), std::logic_error);
+        std::remove("tmp.rays");
+    }
+
+    BOOST_AUTO_TEST_CASE(invalid_files)
+    {
+        BOOST_CHECK_THROW(RayFile(2, "tmp.does_not_exist"), std::runtime_error);
+
+        writeRays("tmp.rays", 4, false, "traj001\n");
+        BOOST_CHECK_THROW(RayFile(2, "tmp.rays"), std::runtime_error);
+
+        writeRays("tmp.rays", 4, false);
+        BOOST_CHECK_THROW(RayFile(3, "tmp.rays"), std::runtime_error);
+
+        // claims more records than it contains
+        {
+            std::fstream out("tmp.rays", std::fstream::in | std::fstream::out | std::fstream::binary);
+            out.seekp(24);
+            writeInteger(out, 5);
+        }
+        BOOST_CHECK_THROW(RayFile(2, "tmp.rays"), std::runtime_error);
+
+        writeRays("tmp.rays", 0, false);
+        BOOST_CHECK_THROW(RayFile(2, "tmp.rays"), std::runtime_error);
+        std::remove("tmp.rays");
+    }
+
+    BOOST_AUTO_TEST_CASE(memory)
+    {
+        std::vector<double> records{0.5, 1.0, 1.0, 0.0, 2.0,
+                                    1.5, 0.5, 0.0, -1.0, 0.25};
+        RayFile rays(2, records.data(), 2, true);
+        BOOST_CHECK_EQUAL(rays.getFileRecordCount(), 2);
+        rays.selectRecords(1, 1);
+        rays.init(config());
+        auto ic = rays.next();
+        BOOST_CHECK_EQUAL(ic.getState().getPosition()[0], 1.5);
+        BOOST_CHECK_EQUAL(ic.getState().getVelocity()[1], -1.0);
+        BOOST_CHECK_EQUAL(ic.getWeight(), 0.25);
+        BOOST_CHECK(!++ic);
+
+        BOOST_CHECK_THROW(RayFile(2, nullptr, 1, false), std::invalid_argument);
+        BOOST_CHECK_THROW(RayFile(2, records.data(), 0, false), std::invalid_argument);
+    }
+
+    /// several threads claim the records concurrently, each record has to be traced exactly once.
+    BOOST_AUTO_TEST_CASE(concurrent)
+    {
+        const std::size_t count = 5000;
+        writeRays("tmp.rays", count, false);
+        RayFile rays(2, "tmp.rays");
+        rays.init(config());
+
+        auto collect = [&]() {
+            std::vector<unsigned> counter(count);
+            for(auto ic = rays.next(); ic; ++ic)
+                counter.at(static_cast<std::size_t>(ic.getState().getPosition()[0])) += 1;
+            return counter;
+        };
+
+        std::vector<std::future<std::vector<unsigned>>> results;
+        for(int i = 0; i < 4; ++i)
+            results.emplace_back(std::async(std::launch::async, collect));
+
+        std::vector<unsigned> counter(count);
+        for(auto& res : results)
+        {
+            auto result = res.get();
+            std::transform(result.begin(), result.end(), counter.begin(), counter.begin(), std::plus<unsigned>());
+        }
+        BOOST_CHECK(std::all_of(counter.begin(), counter.end(), [](unsigned c) { return c == 1; }));
+        std::remove("tmp.rays");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 #include "initial_conditions/initial_conditions.hpp"
 #include "dynamics/sound.hpp"
 #include "observers/observer.hpp"
+#include "ode_state.hpp"
 #define BOOST_TEST_MODULE sound_test
 #include <boost/test/unit_test.hpp>
 
@@ -64,7 +65,8 @@ std::shared_ptr<ThreadLocalObserver> CheckSoundObserver::clone() const
 
 BOOST_AUTO_TEST_SUITE(sound_trace_tests)
 
-BOOST_AUTO_TEST_CASE(gradient)
+/// potential with a velocity field v = (y, 0), for which CheckSoundObserver knows the analytic solution.
+Potential makeShearPotential()
 {
     Potential potential(2, 1, 256);
     default_grid g(2, 256);
@@ -83,7 +85,12 @@ BOOST_AUTO_TEST_CASE(gradient)
         g(ind) = ind[1] / 256.;
     }
     potential.setDerivative(std::vector<int>{0,0}, g.clone(), "velocity0");
-    
+    return potential;
+}
+
+BOOST_AUTO_TEST_CASE(gradient)
+{
+    Potential potential = makeShearPotential();
 	std::unique_ptr<RayDynamics> dynamics(new Sound(potential, false, false));
 	auto tracer = std::make_shared<Tracer>( potential, std::move(dynamics));
 	tracer->setMaxThreads(1);
@@ -97,4 +104,35 @@ BOOST_AUTO_TEST_CASE(gradient)
 	std::cout << "FINNISHED\n";
 }
 
+BOOST_AUTO_TEST_CASE(replicate)
+{
+    Potential potential = makeShearPotential();
+    Sound original(potential, false, false);
+    auto replica = original.replicate();
+    BOOST_REQUIRE( replica );
+
+    GState state(2, false);
+    state.position()[0] = 0.3;
+    state.position()[1] = 0.6;
+    state.velocity()[0] = 1;
+    state.velocity()[1] = 0.5;
+    GState d_original(2, false);
+    GState d_replica(2, false);
+    original.stateUpdate(state, d_original, 0);
+    replica->stateUpdate(state, d_replica, 0);
+    for(int i = 0; i < 2; ++i)
+    {
+        BOOST_CHECK_EQUAL( d_original.position()[i], d_replica.position()[i] );
+        BOOST_CHECK_EQUAL( d_original.velocity()[i], d_replica.velocity()[i] );
+    }
+
+    // the replica has its own copy of the grids
+    auto velocity = potential.getPotential("velocity0").shallow_copy();
+    for(auto& data : velocity)
+        data = 0;
+    original.stateUpdate(state, d_original, 0);
+    replica->stateUpdate(state, d_replica, 0);
+    BOOST_CHECK_NE( d_original.position()[0], d_replica.position()[0] );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,18 @@ namespace targs
 	std::size_t memory_avail = -1;
 	bool periodic = false;
 	std::string integrator;
+	bool print_profile = false;
+	std::string profile_trace;
+	bool hw_counters = false;
+	double checkpoint_interval = 0;
+	bool resume = false;
+	double time_budget = 0;
+	double status_interval = 0;
+	bool pin_threads = false;
+	std::string numa_policy;
+	std::string shard;
+	std::string daemon_socket;
+	std::size_t cache_memory = 0;
 
 	void parse_parameters(int argc, char* argv[])
 	{
@@ -51,9 +63,21 @@ namespace targs
 			("result-path,r", po::value<std::string>(&result_file)->default_value("result"), "Target file path")
 			("no-norm-energy", po::bool_switch(&no_norm_energy)->default_value(false), "Do not normalize the particles starting energy.")
 			("threads,t", po::value<unsigned>(&thread_count)->default_value(-1), "Maximum number of threads to use for computation.")
-			("memory", po::value<std::size_t>(&memory_avail)->default_value( memory_avail ), "Maximum memory the programme is allowed to use, in MB.")
+			("pin-threads", po::bool_switch(&pin_threads), "Bind each worker thread to its own core.")
+			("numa", po::value<std::string>(&numa_policy)->default_value( "off" ), "Placement of the potential on machines with several NUMA nodes. One of (off, interleave, replicate): interleave spreads its pages over all nodes, replicate gives each node its own copy. Use together with --pin-threads, so that threads stay on their node.")
+			("memory", po::value<std::size_t>(&memory_avail)->default_value( memory_avail ), "Maximum memory the programme is allowed to use, in MB. Optional allocations (e.g. additional density grids) are only made while the resident memory of the process stays below this limit.")
 			("integrator", po::value<std::string>(&integrator)->default_value( "adaptive" ), "The integrator to use. One of (adaptive, euler)")
 			("time-step", po::value<double>(&time_step), "The time step for the integrator.")
+			("print-profile", po::bool_switch(&print_profile), "Prints profiling information after tracing is finished.")
+			("profile-trace", po::value<std::string>(&profile_trace), "Write a trace of all profiled scopes in chrome trace event format (json) to this file.")
+			("checkpoint-interval", po::value<double>(&checkpoint_interval)->default_value(checkpoint_interval), "Save a checkpoint to checkpoint.dat in the result path every this many seconds. 0 disables checkpoints.")
+			("resume", po::bool_switch(&resume), "Continue tracing from the checkpoint in the result path, if there is one. Requires the same command line as the interrupted run.")
+			("time-budget", po::value<double>(&time_budget)->default_value(time_budget), "Stop starting new rays after this many seconds and save the results of the rays traced so far. SIGTERM and SIGINT stop tracing in the same way. 0 means no limit.")
+			("status-interval", po::value<double>(&status_interval)->default_value(status_interval), "Rewrite status.json in the result path every this many seconds with the progress, throughput and memory use of the trace. 0 disables the status file.")
+			("shard", po::value<std::string>(&shard), "Trace only part i of N of the rays, given as i/N with 0 <= i < N, and additionally save the unnormalized results to shard.dat in the result path. The shards can be combined with tracer_merge.")
+			("daemon", po::value<std::string>(&daemon_socket), "Instead of tracing, serve trace jobs on this unix socket. Each connection sends one line with the arguments of a tracer call, the potential stays loaded for the following jobs.")
+			("cache-memory", po::value<std::size_t>(&cache_memory)->default_value( memory_avail / 2 ), "Maximum memory of the potentials kept loaded by --daemon, in MB. The least recently used potentials are unloaded first.")
+			("hw-counters", po::bool_switch(&hw_counters), "Record cycles, instructions, cache and TLB misses for all profiled scopes. Requires perf_event support by the kernel.")
 		;
 
 		po::positional_options_description p;
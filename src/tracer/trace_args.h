@@ -20,6 +20,18 @@ namespace targs
 	extern unsigned thread_count;
 	extern std::size_t memory_avail;
 	extern std::string integrator;
+	extern bool print_profile;
+	extern std::string profile_trace;
+	extern bool hw_counters;
+	extern double checkpoint_interval;
+	extern bool resume;
+	extern double time_budget;
+	extern double status_interval;
+	extern bool pin_threads;
+	extern std::string numa_policy;
+	extern std::string shard;
+	extern std::string daemon_socket;
+	extern std::size_t cache_memory;
 }
 
 void parse_parameters(int argc, char* argv[]);
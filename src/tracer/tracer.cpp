@@ -2,21 +2,136 @@
 #include "initial_conditions/initial_conditions.hpp"
 #include "ode_state.hpp"
 #include "dynamics/ray_dynamics.hpp"
+#include "checkpoint.hpp"
+#include "fileIO.hpp"
+#include "thread_pool.hpp"
+#include "numa.hpp"
 #include <future>
 #include <chrono>
+#include <fstream>
+#include <sstream>
 
 #include <boost/numeric/odeint/integrate/integrate_const.hpp>
 #include <boost/numeric/odeint/stepper/runge_kutta4.hpp>
 #include <boost/numeric/odeint/stepper/runge_kutta_cash_karp54.hpp>
 #include <boost/numeric/odeint/stepper/controlled_runge_kutta.hpp>
 
+#include <boost/exception/diagnostic_information.hpp>
 #include <boost/range/combine.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/numeric/odeint/stepper/euler.hpp>
 #include "observers/energy_error_observer.hpp"
+#include "profiling.hpp"
+#include "ray_statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <type_traits>
 #include <utility>
 
+namespace
+{
+	/*! \brief Stepper adapter that records accepted and rejected steps in a RayStatistics object.
+		\details Forwards to the wrapped odeint stepper. Supports controlled steppers (try_step) and
+				basic steppers (do_step), for which every step counts as accepted.
+	*/
+	template<class Stepper>
+	class CountingStepper
+	{
+	public:
+		typedef typename Stepper::state_type state_type;
+		typedef typename Stepper::value_type value_type;
+		typedef typename Stepper::deriv_type deriv_type;
+		typedef typename Stepper::time_type time_type;
+		typedef typename Stepper::stepper_category stepper_category;
+
+		CountingStepper( Stepper& stepper, RayStatistics& statistics ) : mStepper( stepper ), mStatistics( statistics )
+		{
+		}
+
+		/// has to be called before a new ray is integrated.
+		void startTrajectory()
+		{
+			mProposedStep = 0;
+		}
+
+		template<class System, class StateInOut>
+		boost::numeric::odeint::controlled_step_result try_step( System system, StateInOut& x, time_type& t, time_type& dt )
+		{
+			// integrate_const shortens the last step before each observation point. Such steps do not tell us
+			// anything about the step size required by the error control, so they do not count for the minimum.
+			bool shortened = dt < mProposedStep;
+			time_type start = t;
+			auto result = mStepper.try_step( system, x, t, dt );
+			if( result == boost::numeric::odeint::success )
+			{
+				++mStatistics.mAcceptedSteps;
+				if( !shortened )
+					mStatistics.mMinTimeStep = std::min( mStatistics.mMinTimeStep, t - start );
+			}
+			else
+			{
+				++mStatistics.mRejectedSteps;
+			}
+			mProposedStep = dt;
+			return result;
+		}
+
+		template<class System, class StateInOut>
+		void do_step( System system, StateInOut& x, time_type t, time_type dt )
+		{
+			mStepper.do_step( system, x, t, dt );
+			++mStatistics.mAcceptedSteps;
+			mStatistics.mMinTimeStep = std::min( mStatistics.mMinTimeStep, dt );
+		}
+
+	private:
+		Stepper& mStepper;
+		RayStatistics& mStatistics;
+		time_type mProposedStep = 0;
+	};
+
+	/// writes a number as json. Non-finite numbers are not valid json and are written as null.
+	void writeJsonNumber( std::ostream& out, double value )
+	{
+		if( std::isfinite( value ) )
+			out << value;
+		else
+			out << "null";
+	}
+
+	/// writes \p status as a json object, so it can be polled by job monitoring tools.
+	void writeStatusJson( std::ostream& out, const TraceStatus& status, const char* state )
+	{
+		auto now = std::chrono::system_clock::now().time_since_epoch();
+		out.precision( 10 );
+		out << "{\n";
+		out << "  \"state\": \"" << state << "\",\n";
+		out << "  \"time\": " << std::chrono::duration<double>( now ).count() << ",\n";
+		out << "  \"rays\": " << status.mTracedRays << ",\n";
+		out << "  \"requested_rays\": " << status.mRequestedRays << ",\n";
+		out << "  \"elapsed\": "; writeJsonNumber( out, status.mElapsedTime ); out << ",\n";
+		out << "  \"rays_per_second\": "; writeJsonNumber( out, status.mRayRate ); out << ",\n";
+		out << "  \"steps_per_second\": "; writeJsonNumber( out, status.mStepRate ); out << ",\n";
+		out << "  \"rejected_step_ratio\": "; writeJsonNumber( out, status.mRejectedStepRatio ); out << ",\n";
+		out << "  \"remaining\": ";
+		writeJsonNumber( out, status.mRemainingTime >= 0 ? status.mRemainingTime : NAN );
+		out << ",\n";
+		out << "  \"bytes_in_use\": " << status.mBytesInUse << ",\n";
+		out << "  \"resident_bytes\": " << status.mResidentBytes << ",\n";
+		out << "  \"observers\": {";
+		const char* separator = "\n";
+		for( const auto& entry : status.mObserverStatus )
+		{
+			out << separator << "    \"" << entry.first << "\": ";
+			writeJsonNumber( out, entry.second );
+			separator = ",\n";
+		}
+		out << "\n  }\n}\n";
+	}
+}
+
 Tracer::Tracer( const Potential& pot, std::shared_ptr<RayDynamics> dynamics ) :
 	mDimension( pot.getDimension() ),
 	mSupport( pot.getSupport() ),
@@ -59,6 +174,7 @@ void Tracer::addObserver( obs_type observer )
 
 TraceResult Tracer::trace(InitCondGenPtr& incoming_wave, InitialConditionConfiguration config)
 {
+	PROFILE_BLOCK("trace");
 	// fix coordinate transformation for initial condition
 	auto support = mSupport;
 	gen_vect offset(mDimension);
@@ -73,30 +189,122 @@ TraceResult Tracer::trace(InitCondGenPtr& incoming_wave, InitialConditionConfigu
 	// set up master observer
 	mMasterObserver.setPeriodicBoundaries( mDynamics->hasPeriodicBoundary() );
 	mMasterObserver.startTracing( );
+	mStepCount = 0;
+	mFinishedRays = 0;
+	mGeneratorType = incoming_wave->getGeneratorType();
+	mRequestedParticles = config.getParticleCount();
+	if( !mResumeFile.empty() )
+		resume( *incoming_wave );
+
+	mTraceStart = std::chrono::steady_clock::now();
+	mDeadline = mTraceStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(mTimeBudget) );
+	mResumedParticles = getTracedParticleCount();
+	mStopAnnounced = false;
+	if( mTimeBudget > 0 && !incoming_wave->hasUniformPrefixes() )
+	{
+		std::cerr << "the " << mGeneratorType << " generator fills the manifold one row after the other, so the rays "
+				  << "traced within the time budget might not cover all of it. Use a sampler (e.g. sobol) instead.\n";
+	}
 
-	unsigned int threadcount = std::min(mMaxThreads, (std::size_t)std::thread::hardware_concurrency());
+	auto& pool = ThreadPool::global();
+	unsigned int threadcount = std::min(mMaxThreads, pool.getConcurrency());
 	#ifndef NDEBUG
 	std::cout << "distribute computation to " << threadcount << " threads\n";
 	#endif
 
-	std::vector<std::future<void>> threads;
-	auto tf = [this](InitCondGenPtr w, bool is_printer)
+	mCheckpointing = mCheckpointInterval > 0;
+	if( mCheckpointing && !incoming_wave->isResumable() )
 	{
-		return this->traceThreadFunction( std::move(w), is_printer );
-	};
+		std::cerr << "the rays of the " << mGeneratorType << " generator cannot be resumed, no checkpoints are written.\n";
+		mCheckpointing = false;
+	}
+	mCheckpointRequested = false;
+	mNextCheckpoint = ( std::chrono::steady_clock::now() +
+						std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+								std::chrono::duration<double>(mCheckpointInterval) ) ).time_since_epoch().count();
+	// the threads register for checkpoints when they start. One that starts late has not claimed any ray yet, so
+	// the checkpoints it misses still cover a prefix of the rays.
+	mActiveThreads = 0;
+	mWaitingThreads = 0;
+
+	mAcceptedSteps = 0;
+	mRejectedSteps = 0;
+	mWritingStatus = mStatusInterval > 0;
+	mTracingDone = false;
+	// stops the status thread even if a tracing thread fails
+	struct StatusThread
+	{
+		Tracer& tracer;
+		std::future<void> thread;
+		void stop()
+		{
+			if( !thread.valid() )
+				return;
+			{
+				std::lock_guard<std::mutex> lock( tracer.mStatusMutex );
+				tracer.mTracingDone = true;
+			}
+			tracer.mStatusCondition.notify_all();
+			thread.get();
+		}
+		~StatusThread() { stop(); }
+	} status_thread{*this, {}};
+	if( mWritingStatus )
+		status_thread.thread = std::async( std::launch::async, [this]() { statusThreadFunction(); } );
 
+	std::vector<std::future<void>> threads;
 	for(unsigned i = 0; i < threadcount; ++i)
 	{
 		// start threads, only thread zero prints progress
-		threads.push_back( std::async ( std::launch::async, tf, incoming_wave, i == 0) );
+		bool is_printer = i == 0;
+		threads.push_back( pool.submit( [this, incoming_wave, is_printer]()
+		{
+			traceThreadFunction( incoming_wave, is_printer );
+		} ) );
 	}
 
+	// all threads have to finish before an error is propagated, as they use the observers
+	std::exception_ptr error;
 	for( auto& f : threads)
-		f.get();
+	{
+		try {
+			pool.wait( f );
+		} catch( ... ) {
+			if( !error )
+				error = std::current_exception();
+		}
+	}
+	if( error )
+		std::rethrow_exception( error );
+	status_thread.stop();
+
+	// the shard is saved before finishTracing(), which normalizes the observers
+	if( !mShardFile.empty() )
+	{
+		mShard.mFirstRay = incoming_wave->getShardBegin();
+		mShard.mExtents.assign( mExtents.begin(), mExtents.end() );
+		mShard.mSupport = mSupport;
+		try
+		{
+			mShard.mState = makeCheckpoint();
+			auto observers = getObserverWriters();
+			writeFileAtomic( mShardFile, [&](std::ostream& out) { writeShardResult( out, mShard, observers ); } );
+		} catch( const std::exception& error )
+		{
+			// the results of the shard are still saved as usual, they just cannot be merged
+			std::cerr << "could not write the shard results: " << error.what() << "\n";
+		}
+	}
 
 	mMasterObserver.finishTracing();
+	// a stop only applies to the current trace
+	bool stopped = mStopRequested.exchange( false );
+	if( mWritingStatus )
+		writeStatusFile( stopped ? "stopped" : "finished" );
 
-	return TraceResult{mEnergyErrorObs->getMaximumError(), mEnergyErrorObs->getMeanError(), getTracedParticleCount()};
+	return TraceResult{mEnergyErrorObs->getMaximumError(), mEnergyErrorObs->getMeanError(), getTracedParticleCount(),
+					   mStepCount, stopped};
 }
 
 void Tracer::traceThreadFunction( InitCondGenPtr incoming_wave, bool printer )
@@ -130,48 +338,350 @@ void Tracer::traceThreadFunction( InitCondGenPtr incoming_wave, bool printer )
 template<class T>
 void Tracer::traceThreadFunction_imp( T&& stepper, InitCondGenPtr incoming_wave, bool printer )
 {
+	PROFILE_BLOCK("trace thread");
+	// declared before the thread observer, so the thread only leaves the checkpoint barrier after its observers
+	// have been reduced.
+	struct BarrierRegistration
+	{
+		Tracer& tracer;
+		explicit BarrierRegistration( Tracer& t ) : tracer( t ) { tracer.enterCheckpointBarrier(); }
+		~BarrierRegistration() { tracer.leaveCheckpointBarrier(); }
+	} registration{*this};
+
 	MasterObserver thread_observer( mMasterObserver.clone() );
+	// a ray that fails is never reported as finished. A refinement would then wait for it forever in the other
+	// threads, so they are released before the error is propagated.
+	struct AbortOnError
+	{
+		init_cond::InitialConditionGenerator& generator;
+		~AbortOnError() { if( std::uncaught_exception() ) generator.abort(); }
+	} abort_on_error{*incoming_wave};
 	InitialCondition incoming = incoming_wave->next();
 
-	GState p(mDimension, mDynamics->hasMonodromy());
+	RayStatistics& statistics = thread_observer.getRayStatistics();
+	CountingStepper<typename std::decay<T>::type> counting_stepper( stepper, statistics );
+	std::shared_ptr<const RayDynamics> dynamics = getLocalDynamics();
+	auto system = [&dynamics, &statistics](const GState& s, GState& d, double t)
+	{
+		++statistics.mRhsEvaluations;
+		dynamics->stateUpdate(s, d, t);
+	};
+
+	GState p(mDimension, dynamics->hasMonodromy());
 	auto last_time = std::chrono::steady_clock::now();
 
+	// count steps and rays locally and publish once, so the shared counters are not contended
+	std::size_t steps = 0;
+	std::size_t rays = 0;
+	auto observer = [&thread_observer, &steps](const GState& state, double t)
+	{
+		++steps;
+		thread_observer(state, t);
+	};
+
 	for(std::size_t i = 0; incoming; ++i, ++incoming)
 	{
 		
 		if(printer && (std::chrono::steady_clock::now() - last_time) > std::chrono::seconds(10))
 		{
 		    last_time = std::chrono::steady_clock::now();
-			std::cout << "integrate " << thread_observer.getTracedParticleCount() <<  " \n";
+			printProgress();
 		}
 		
 		// generate initial condition and set up state
 		p.position() = incoming.getState().getPosition();
 		p.velocity() = incoming.getState().getVelocity();
-		if( mDynamics->hasMonodromy() )
+		if( dynamics->hasMonodromy() )
 			p.init_monodromy();
 
 		// notify the observer
+		statistics.reset();
+		counting_stepper.startTrajectory();
 		thread_observer.startTrajectory( incoming );
+		auto ray_start = std::chrono::steady_clock::now();
 
 		try
 		{
 			/// \todo this can return... do we want to do sth with the return value?
 			boost::numeric::odeint::integrate_const(
-					std::ref(stepper),
-					[this](const GState& s, GState& d, double t) { mDynamics->stateUpdate(s, d, t); },
+					std::ref(counting_stepper),
+					system,
 					p,
 					0.0, 				// start time
 					mEndTime, 			// end time
 					mInitialDeltaT, 	// initial time step
-					std::ref(thread_observer)
+					observer
 			);
 		} catch(int& i) {};
 
+		statistics.mWallTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - ray_start ).count();
+		mAcceptedSteps.fetch_add( statistics.mAcceptedSteps, std::memory_order_relaxed );
+		mRejectedSteps.fetch_add( statistics.mRejectedSteps, std::memory_order_relaxed );
 		thread_observer.finishTrajectory( incoming );
+		incoming_wave->finishTrajectory( incoming, State(p) );
+		++rays;
+
+		// the finished rays are only a prefix of all rays if no thread holds records that it has not traced yet.
+		if( !incoming.hasPendingRecords() )
+		{
+			checkpointBarrier( thread_observer, steps, rays );
+			// stop before the next ray is claimed, so every claimed ray (or block of records) is traced completely
+			if( shouldStop() )
+				break;
+		}
+	}
+
+	mStepCount += steps;
+	mFinishedRays += rays;
+}
+
+bool Tracer::shouldStop()
+{
+	if( !mStopRequested )
+	{
+		if( mTimeBudget <= 0 || std::chrono::steady_clock::now() < mDeadline )
+			return false;
+		mStopRequested = true;
 	}
+
+	if( !mStopAnnounced.exchange( true ) )
+		std::cout << "stopping after " << getTracedParticleCount() << " rays, finishing the current rays\n";
+	return true;
 }
 
+TraceStatus Tracer::getStatus() const
+{
+	TraceStatus status;
+	status.mTracedRays = getTracedParticleCount();
+	status.mRequestedRays = mRequestedParticles;
+	status.mElapsedTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - mTraceStart ).count();
+	std::size_t accepted = mAcceptedSteps;
+	std::size_t rejected = mRejectedSteps;
+	if( status.mElapsedTime > 0 )
+	{
+		status.mRayRate = (status.mTracedRays - mResumedParticles) / status.mElapsedTime;
+		status.mStepRate = accepted / status.mElapsedTime;
+	}
+	if( accepted + rejected > 0 )
+		status.mRejectedStepRatio = double(rejected) / (accepted + rejected);
+	if( status.mRayRate > 0 )
+	{
+		status.mRemainingTime = std::max( (double)status.mRequestedRays - status.mTracedRays, 0.0 ) / status.mRayRate;
+		if( mTimeBudget > 0 )
+			status.mRemainingTime = std::min( status.mRemainingTime, std::max( mTimeBudget - status.mElapsedTime, 0.0 ) );
+	}
+	status.mStopping = mStopRequested;
+	status.mBytesInUse = getBytesInUse();
+	status.mResidentBytes = getResidentBytes();
+	for( const auto& observer : mMasterObserver.getObservers() )
+		observer->reportStatus( status.mObserverStatus );
+	return status;
+}
+
+void Tracer::printProgress() const
+{
+	TraceStatus status = getStatus();
+	std::cout << "integrate " << status.mTracedRays << " (" << status.mRayRate << " rays/s";
+	if( status.mRemainingTime >= 0 )
+	{
+		double end = status.mElapsedTime + status.mRemainingTime;
+		if( mTimeBudget > 0 && end >= mTimeBudget )
+			std::cout << ", about " << status.mTracedRays + std::size_t( status.mRayRate * status.mRemainingTime )
+					  << " rays within the time budget";
+		else
+			std::cout << ", " << status.mRemainingTime << "s remaining";
+	}
+	std::cout << ") \n";
+}
+
+void Tracer::statusThreadFunction()
+{
+	auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>( mStatusInterval ) );
+	std::unique_lock<std::mutex> lock( mStatusMutex );
+	while( !mStatusCondition.wait_for( lock, interval, [this]() { return mTracingDone; } ) && mWritingStatus )
+	{
+		lock.unlock();
+		writeStatusFile( mStopRequested ? "stopping" : "tracing" );
+		lock.lock();
+	}
+}
+
+void Tracer::writeStatusFile( const char* state )
+{
+	try
+	{
+		TraceStatus status = getStatus();
+		writeFileAtomic( mStatusFile, [&](std::ostream& out) { writeStatusJson( out, status, state ); } );
+	} catch( const std::exception& error )
+	{
+		std::cerr << "could not write status file " << mStatusFile << ", it is no longer updated: " << error.what() << "\n";
+		mWritingStatus = false;
+	}
+}
+
+void Tracer::checkpointBarrier( MasterObserver& thread_observer, std::size_t& steps, std::size_t& rays )
+{
+	if( !mCheckpointing )
+		return;
+
+	if( !mCheckpointRequested )
+	{
+		if( std::chrono::steady_clock::now().time_since_epoch().count() < mNextCheckpoint )
+			return;
+		mCheckpointRequested = true;
+	}
+
+	mStepCount += steps;
+	mFinishedRays += rays;
+	steps = 0;
+	rays = 0;
+	thread_observer.combineLocalWatches();
+
+	std::unique_lock<std::mutex> lock( mCheckpointMutex );
+	++mWaitingThreads;
+	if( mWaitingThreads == mActiveThreads )
+	{
+		completeCheckpoint();
+	}
+	else
+	{
+		std::size_t generation = mCheckpointGeneration;
+		mCheckpointDone.wait( lock, [&]() { return generation != mCheckpointGeneration; } );
+	}
+}
+
+void Tracer::enterCheckpointBarrier()
+{
+	std::lock_guard<std::mutex> lock( mCheckpointMutex );
+	++mActiveThreads;
+}
+
+void Tracer::leaveCheckpointBarrier()
+{
+	std::lock_guard<std::mutex> lock( mCheckpointMutex );
+	--mActiveThreads;
+	if( mWaitingThreads > 0 && mWaitingThreads == mActiveThreads )
+		completeCheckpoint();
+}
+
+void Tracer::completeCheckpoint()
+{
+	PROFILE_BLOCK("checkpoint");
+	try
+	{
+		Checkpoint checkpoint = makeCheckpoint();
+		auto observers = getObserverWriters();
+		writeFileAtomic( mCheckpointFile, [&](std::ostream& out) { writeCheckpoint( out, checkpoint, observers ); } );
+	} catch( const std::exception& error )
+	{
+		// tracing can go on without checkpoints
+		std::cerr << "could not write checkpoint, no further checkpoints are written: " << error.what() << "\n";
+		mCheckpointing = false;
+	}
+
+	mWaitingThreads = 0;
+	mCheckpointRequested = false;
+	mNextCheckpoint = ( std::chrono::steady_clock::now() +
+						std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+								std::chrono::duration<double>(mCheckpointInterval) ) ).time_since_epoch().count();
+	++mCheckpointGeneration;
+	mCheckpointDone.notify_all();
+}
+
+Checkpoint Tracer::makeCheckpoint() const
+{
+	Checkpoint checkpoint;
+	checkpoint.mGeneratorType = mGeneratorType;
+	checkpoint.mRequestedParticles = mRequestedParticles;
+	checkpoint.mRayCount = mFinishedRays;
+	checkpoint.mParticleCount = mMasterObserver.getTracedParticleCount();
+	checkpoint.mStepCount = mStepCount;
+	return checkpoint;
+}
+
+std::vector<ObserverWriter> Tracer::getObserverWriters() const
+{
+	std::vector<ObserverWriter> writers;
+	for( const auto& observer : mMasterObserver.getObservers() )
+		writers.emplace_back( observer->filename(), [&observer](std::ostream& out) { observer->serialize( out ); } );
+	return writers;
+}
+
+void Tracer::resume( init_cond::InitialConditionGenerator& generator )
+{
+	std::ifstream file( mResumeFile, std::ios::in | std::ios::binary );
+	if( !file )
+		THROW_EXCEPTION( std::runtime_error, "Could not open checkpoint %1%", mResumeFile );
+	Checkpoint checkpoint = readCheckpoint( file );
+
+	if( checkpoint.mGeneratorType != mGeneratorType || checkpoint.mRequestedParticles != mRequestedParticles )
+		THROW_EXCEPTION( std::runtime_error, "Checkpoint %1% was written for %2% rays of the %3% generator",
+						 mResumeFile, checkpoint.mRequestedParticles, checkpoint.mGeneratorType );
+
+	const auto& observers = mMasterObserver.getObservers();
+	if( checkpoint.mObservers.size() != observers.size() )
+		THROW_EXCEPTION( std::runtime_error, "Checkpoint %1% contains %2% observers, but %3% are configured",
+						 mResumeFile, checkpoint.mObservers.size(), observers.size() );
+
+	for( std::size_t i = 0; i < observers.size(); ++i )
+	{
+		const auto& saved = checkpoint.mObservers[i];
+		if( saved.first != observers[i]->filename() )
+			THROW_EXCEPTION( std::runtime_error, "Checkpoint %1% contains observer %2% instead of %3%",
+							 mResumeFile, saved.first, observers[i]->filename() );
+		std::istringstream data( saved.second );
+		observers[i]->deserialize( data );
+		if( !data || data.peek() != std::char_traits<char>::eof() )
+			THROW_EXCEPTION( std::runtime_error, "Checkpoint data of observer %1% is corrupt", saved.first );
+	}
+
+	generator.skip( checkpoint.mRayCount );
+	MasterObserver::restoreParticleCounts( checkpoint.mParticleCount, checkpoint.mRayCount );
+	mStepCount = checkpoint.mStepCount;
+	mFinishedRays = checkpoint.mRayCount;
+	std::cout << "resuming from checkpoint after " << checkpoint.mRayCount << " rays\n";
+}
+
+
+void Tracer::setCheckpoint( std::string file_name, double interval )
+{
+	if( !(interval >= 0) )
+		THROW_EXCEPTION( std::invalid_argument, "Checkpoint interval has to be non-negative, got %1%", interval );
+	mCheckpointFile = std::move(file_name);
+	mCheckpointInterval = interval;
+}
+
+void Tracer::setShardFile( std::string file_name, ShardResult shard )
+{
+	mShardFile = std::move(file_name);
+	mShard = std::move(shard);
+}
+
+void Tracer::setStatusFile( std::string file_name, double interval )
+{
+	if( !(interval >= 0) )
+		THROW_EXCEPTION( std::invalid_argument, "Status interval has to be non-negative, got %1%", interval );
+	mStatusFile = std::move(file_name);
+	mStatusInterval = interval;
+}
+
+void Tracer::setTimeBudget( double seconds )
+{
+	if( !(seconds >= 0) )
+		THROW_EXCEPTION( std::invalid_argument, "Time budget has to be non-negative, got %1%", seconds );
+	mTimeBudget = seconds;
+}
+
+void Tracer::requestStop()
+{
+	mStopRequested = true;
+}
+
+void Tracer::setResumeFile( std::string file_name )
+{
+	mResumeFile = std::move(file_name);
+}
 
 void Tracer::setTimeStep(double dt)
 {
@@ -196,6 +706,29 @@ std::size_t Tracer::getMaxThreads( ) const
 	return mMaxThreads;
 }
 
+void Tracer::setNumaReplication( bool replicate )
+{
+	mNumaReplication = replicate;
+}
+
+std::shared_ptr<const RayDynamics> Tracer::getLocalDynamics()
+{
+	if( !mNumaReplication || getNumaNodeCount() < 2 )
+		return mDynamics;
+
+	int node = getCurrentNumaNode();
+	std::lock_guard<std::mutex> lock( mReplicaMutex );
+	auto& replica = mReplicas[node];
+	if( !replica )
+	{
+		// created by this thread, so the kernel places the new grids on its node
+		replica = mDynamics->replicate();
+		if( !replica )
+			replica = mDynamics;
+	}
+	return replica;
+}
+
 void Tracer::setIntegrator(Integrator integrator)
 {
     mIntegrator = integrator;
@@ -206,6 +739,37 @@ const std::vector<std::shared_ptr<Observer>>& Tracer::getObservers() const
 	return mMasterObserver.getObservers();
 }
 
+bool Tracer::saveObservers( const std::string& path ) const
+{
+	PROFILE_BLOCK("save observers");
+	// every observer writes its own file, so all of them can be saved concurrently.
+	auto& pool = ThreadPool::global();
+	std::vector<std::future<void>> saves;
+	for( const auto& o : getObservers() )
+	{
+		saves.push_back( pool.submit( [o, &path]()
+		{
+			PROFILE_BLOCK("save observer");
+			writeFileAtomic( path + "/" + o->filename(), [&o](std::ostream& out) { o->save(out); } );
+		}) );
+	}
+
+	bool success = true;
+	for( auto& save : saves )
+	{
+		try
+		{
+			pool.wait( save );
+		// catch the exception here, so in case one observer cannot be saved we still might save the others.
+		} catch( const std::exception& error )
+		{
+			std::cerr << boost::diagnostic_information(error) << "\n";
+			success = false;
+		}
+	}
+	return success;
+}
+
 void Tracer::setEndTime( double et )
 {
 	mEndTime = et;
@@ -4,6 +4,12 @@
 #include "initial_conditions_fwd.hpp"
 #include "potential.hpp"
 #include "observers/master_observer.hpp"
+#include "checkpoint.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <vector>
 #include <boost/noncopyable.hpp>
 #include "initial_conditions/initial_conditions.hpp"
@@ -21,6 +27,24 @@ struct TraceResult
 	double mMaximumEnergyDeviation;
 	double mMeanEnergyDeviation;
 	std::size_t mParticleCount;
+	std::size_t mStepCount;		//!< number of observed integration steps, summed over all rays
+	bool mStoppedEarly;			//!< whether tracing was stopped by the time budget or requestStop()
+};
+
+/// snapshot of the progress of a trace, see Tracer::getStatus().
+struct TraceStatus
+{
+	std::size_t mTracedRays = 0;		//!< rays traced so far, including those restored from a checkpoint
+	std::size_t mRequestedRays = 0;		//!< rays requested from the initial condition generator
+	double mElapsedTime = 0;			//!< seconds since trace() was called
+	double mRayRate = 0;				//!< rays per second traced by this trace() call
+	double mStepRate = 0;				//!< accepted integrator steps per second
+	double mRejectedStepRatio = 0;		//!< fraction of the integrator steps that were rejected by the error control
+	double mRemainingTime = -1;			//!< expected seconds until all rays are traced or the time budget ends, < 0 if unknown
+	bool mStopping = false;				//!< whether the threads have been asked to stop early
+	std::size_t mBytesInUse = 0;		//!< memory allocated for grids, see getBytesInUse()
+	std::size_t mResidentBytes = 0;		//!< resident memory of the process
+	std::map<std::string, double> mObserverStatus;	//!< live information of the observers, see Observer::reportStatus()
 };
 
 /// \todo some documentation, look if we can reduce the number of member variables (trace monodromy, periodic etc)
@@ -42,6 +66,36 @@ public:
 	/// set the integrator
 	void setIntegrator(Integrator integrator);
 
+	/// \brief writes a checkpoint to \p file_name whenever \p interval seconds have passed since the last one.
+	/// \details For writing a checkpoint, all threads wait until the others have finished their current ray.
+	///			An interval of zero disables checkpoints.
+	void setCheckpoint( std::string file_name, double interval );
+
+	/// continues the next call to trace() from the checkpoint in \p file_name. If empty, trace() starts from the
+	/// first ray.
+	void setResumeFile( std::string file_name );
+
+	/// \brief writes the unnormalized results of the next trace() call to \p file_name, so that they can be merged with
+	///			other shards of the same trace. \p shard describes the shard, the tracer fills in the ray range, the
+	///			potential geometry and the observer data. An empty file name disables this.
+	void setShardFile( std::string file_name, ShardResult shard );
+
+	/// \brief stops claiming new rays once \p seconds have passed since trace() was called.
+	/// \details The rays that are being traced when the budget runs out are finished, so the results contain
+	///			fewer, but complete rays. A budget of zero means no limit.
+	void setTimeBudget( double seconds );
+
+	/// \brief makes the running trace() stop as if its time budget had been used up.
+	/// \details Only sets an atomic flag, so this may be called from a signal handler.
+	void requestStop();
+
+	/// \brief rewrites \p file_name every \p interval seconds with a json object describing the progress of the running
+	/// 		trace (see TraceStatus), and once more when tracing has finished. An interval of zero disables the file.
+	void setStatusFile( std::string file_name, double interval );
+
+	/// gets the progress of the current (or last) trace() call. Can be called from any thread.
+	TraceStatus getStatus() const;
+
 	/// common model for a tracing function, specialised behaviour is inserted via virtual functions
 	TraceResult trace(InitCondGenPtr& initial_condition, InitialConditionConfiguration config);
 
@@ -55,10 +109,16 @@ public:
 	/// Sets the integrator time step.
 	void setTimeStep(double dt);
 
-	/// sets the maximum number of threads used for integration. if \p threads == 0, use 1 thread.
+	/// sets the maximum number of threads used for integration. if \p threads == 0, use 1 thread. The threads are
+	/// taken from the global ThreadPool, so no more than its concurrency are used.
 	void setMaxThreads( std::size_t threads );
 	std::size_t getMaxThreads( ) const;
 
+	/// \brief if enabled on a machine with several NUMA nodes, the tracing threads of each node use their own copy
+	///			of the dynamics and the potential grids, which is allocated by the first thread of the node.
+	/// \details Only useful if the threads stay on their node, i.e. together with pinned threads.
+	void setNumaReplication( bool replicate );
+
 	/// \todo observer access
 	/// returns the actual number of particles traced, which might differ from the amount
 	///	requested when setting up the initial conditions.
@@ -67,6 +127,11 @@ public:
 	// observer vector
 	const std::vector<std::shared_ptr<Observer>>& getObservers() const;
 
+	/// \brief saves every observer to its file in the directory \p path. The observers are saved concurrently, and
+	///			one that fails does not keep the others from being saved. The errors are printed to std::cerr.
+	/// \return whether all observers were saved.
+	bool saveObservers( const std::string& path ) const;
+
 private:
 	// tracing config
 	// error bounds members
@@ -85,14 +150,90 @@ private:
 	// dynamical system spec
 	std::shared_ptr<RayDynamics> mDynamics;
 
+	// per NUMA node copies of mDynamics
+	bool mNumaReplication = false;
+	std::mutex mReplicaMutex;
+	std::map<int, std::shared_ptr<RayDynamics>> mReplicas;
+
+	/// the dynamics the calling thread should use, i.e. the replica of its NUMA node if replication is enabled.
+	std::shared_ptr<const RayDynamics> getLocalDynamics();
+
 	void traceThreadFunction(InitCondGenPtr incoming_wave, bool printer);
 
 	template<class StepperType>
 	void traceThreadFunction_imp(StepperType&& stepper, InitCondGenPtr incoming_wave, bool printer);
 
+	/// called by the tracing threads between two rays. If a checkpoint is due, publishes the \p steps and \p rays
+	/// of the thread and waits until the other threads have arrived or finished, the last of which writes it.
+	void checkpointBarrier( MasterObserver& thread_observer, std::size_t& steps, std::size_t& rays );
+	/// called when a tracing thread starts, before it claims its first ray.
+	void enterCheckpointBarrier();
+	/// called when a tracing thread has finished, after its observers have been reduced.
+	void leaveCheckpointBarrier();
+	/// writes the checkpoint and releases the waiting threads. Requires mCheckpointMutex to be locked.
+	void completeCheckpoint();
+	/// collects the finished rays, without the observer data. The threads must not trace while this is called.
+	Checkpoint makeCheckpoint() const;
+	/// functions that serialize the observers directly into a checkpoint file, see writeCheckpoint().
+	std::vector<ObserverWriter> getObserverWriters() const;
+	/// whether the tracing threads should not start another ray. Announces the stop the first time it is noticed.
+	bool shouldStop();
+	/// prints the number of traced rays, the rate at which they are traced and the expected remaining time.
+	void printProgress() const;
+	/// periodically writes the status file until mTracingDone is set.
+	void statusThreadFunction();
+	/// writes the status file, with \p state describing the phase of the trace. Disables the status file on errors.
+	void writeStatusFile( const char* state );
+	/// restores the observers and counters from mResumeFile, and skips the finished rays of \p generator.
+	void resume( init_cond::InitialConditionGenerator& generator );
+
 	MasterObserver mMasterObserver;
 
+	/// observed integration steps of the current trace call, summed over all threads
+	std::atomic<std::size_t> mStepCount{0};
+
 	std::shared_ptr<EnergyErrorObserver> mEnergyErrorObs;
+
+	// checkpoints
+	std::string mCheckpointFile;
+	double mCheckpointInterval = 0;
+	std::string mResumeFile;
+	std::string mShardFile;
+	ShardResult mShard;
+	/// generator type and particle count of the current trace call, to validate checkpoints.
+	std::string mGeneratorType;
+	std::size_t mRequestedParticles = 0;
+
+	std::atomic<bool> mCheckpointing{false};			//!< whether the current trace call writes checkpoints
+	std::atomic<bool> mCheckpointRequested{false};		//!< whether the threads have to wait for a checkpoint
+	std::atomic<std::chrono::steady_clock::rep> mNextCheckpoint{0};
+	/// finished rays, summed over all threads. Only up to date while a checkpoint is written.
+	std::atomic<std::uint64_t> mFinishedRays{0};
+
+	// time budget
+	double mTimeBudget = 0;
+	std::chrono::steady_clock::time_point mTraceStart;
+	std::chrono::steady_clock::time_point mDeadline;
+	std::size_t mResumedParticles = 0;				//!< rays that were restored from a checkpoint, not traced
+	std::atomic<bool> mStopRequested{false};
+	std::atomic<bool> mStopAnnounced{false};
+	static_assert( ATOMIC_BOOL_LOCK_FREE == 2, "requestStop() has to be lock free to be usable in signal handlers" );
+
+	// live telemetry
+	std::atomic<std::size_t> mAcceptedSteps{0};		//!< integrator steps of the current trace call
+	std::atomic<std::size_t> mRejectedSteps{0};
+	std::string mStatusFile;
+	double mStatusInterval = 0;
+	std::atomic<bool> mWritingStatus{false};
+	std::mutex mStatusMutex;
+	std::condition_variable mStatusCondition;
+	bool mTracingDone = false;						//!< protected by mStatusMutex
+
+	std::mutex mCheckpointMutex;					//!< protects the following barrier state
+	std::condition_variable mCheckpointDone;
+	std::size_t mActiveThreads = 0;					//!< tracing threads that have started and not finished yet
+	std::size_t mWaitingThreads = 0;				//!< threads that wait for the current checkpoint
+	std::size_t mCheckpointGeneration = 0;			//!< incremented for each completed checkpoint
 };
 
 
@@ -0,0 +1,208 @@
+#include "tracer_c_api.h"
+#include "tracer_factory.h"
+#include "tracer.hpp"
+#include "daemon.hpp"
+#include "potential.hpp"
+#include "initial_conditions_fwd.hpp"
+#include "initial_conditions/initial_conditions.hpp"
+#include "initial_conditions/ray_file.hpp"
+#include "observers/observer.hpp"
+#include "global.hpp"
+#include <fstream>
+#include <mutex>
+
+struct bfs_potential
+{
+	std::shared_ptr<Potential> mPotential;
+};
+
+struct bfs_trace
+{
+	std::shared_ptr<Potential> mPotential;		//!< the tracer refers to the potential, so it is kept alive
+	std::shared_ptr<Tracer> mTracer;
+	TraceResult mResult;
+	std::vector<std::string> mFileNames;			//!< file of each observer
+	std::vector<std::vector<ResultArray>> mArrays;	//!< result arrays of each observer
+};
+
+namespace
+{
+	thread_local std::string last_error;
+
+	/// runs \p function, and stores the message of its exception as the last error.
+	/// \return the result of \p function, or \p failed if it threw.
+	template<class T, class F>
+	T guarded( F&& function, T failed )
+	{
+		last_error.clear();
+		try
+		{
+			return function();
+		} catch( const std::exception& error )
+		{
+			last_error = error.what();
+		} catch( ... )
+		{
+			last_error = "unknown error";
+		}
+		return failed;
+	}
+
+	/// protects the shared ray counter of the observers, see bfs_trace_run().
+	std::mutex trace_mutex;
+}
+
+extern "C" const char* bfs_last_error()
+{
+	return last_error.c_str();
+}
+
+extern "C" bfs_potential* bfs_potential_load( const char* file_name )
+{
+	return guarded( [&]() {
+		if( !std::ifstream( file_name, std::ios::in | std::ios::binary ) )
+			THROW_EXCEPTION( std::runtime_error, "Could not open potential file %1%", file_name );
+		return new bfs_potential{ std::make_shared<Potential>( Potential::readFromFile( file_name ) ) };
+	}, (bfs_potential*)nullptr );
+}
+
+extern "C" bfs_potential* bfs_potential_new( size_t dimension, const size_t* extents, const double* support )
+{
+	return guarded( [&]() {
+		if( dimension == 0 )
+			THROW_EXCEPTION( std::invalid_argument, "A potential needs at least one dimension" );
+		std::vector<std::size_t> ext( extents, extents + dimension );
+		std::vector<double> supp( support, support + dimension );
+		return new bfs_potential{ std::make_shared<Potential>( std::move(ext), std::move(supp) ) };
+	}, (bfs_potential*)nullptr );
+}
+
+extern "C" int bfs_potential_set_grid( bfs_potential* potential, const int* derivative, const double* data )
+{
+	return guarded( [&]() {
+		Potential& target = *potential->mPotential;
+		Potential::grid_type grid( target.getExtents() );
+		std::copy( data, data + grid.size(), grid.begin() );
+		if( derivative )
+			target.setDerivative( std::vector<int>( derivative, derivative + target.getDimension() ), std::move(grid) );
+		else
+			target.setPotential( std::move(grid) );
+		return 1;
+	}, 0 );
+}
+
+extern "C" size_t bfs_potential_dimension( const bfs_potential* potential )
+{
+	return potential->mPotential->getDimension();
+}
+
+extern "C" void bfs_potential_free( bfs_potential* potential )
+{
+	delete potential;
+}
+
+extern "C" bfs_trace* bfs_trace_run( bfs_potential* potential, const char* arguments, const double* rays,
+									 uint64_t ray_count, int weighted )
+{
+	return guarded( [&]() {
+		TraceJob job = parseTraceJob( arguments ? arguments : "", false );
+		if( !job.mPotentialFile.empty() )
+			THROW_EXCEPTION( std::invalid_argument, "Unexpected potential file %1%, the potential is given in memory",
+							 job.mPotentialFile );
+
+		std::lock_guard<std::mutex> lock( trace_mutex );
+		if( job.mOverrideStrength )
+			potential->mPotential->setStrength( job.mStrength );
+
+		TracerFactory factory;
+		factory.setPotential( potential->mPotential );
+		factory.setPeriodicBondaries( job.mPeriodic );
+		factory.setObserverConfig( job.mObservers );
+		factory.setDynamicsConfig( job.mDynamics );
+		factory.setThreadCount( job.mThreads );
+		factory.setErrorBounds( job.mAbsErr, job.mRelErr );
+		factory.setEndTime( job.mEndTime );
+		factory.setIntegrator( job.mIntegrator );
+		factory.setTimeStep( job.mTimeStep );
+
+		std::unique_ptr<bfs_trace> trace( new bfs_trace );
+		trace->mPotential = potential->mPotential;
+		trace->mTracer = factory.createTracer();
+
+		std::size_t dimension = trace->mTracer->getDimension();
+		InitCondGenPtr generator;
+		InitialConditionConfiguration config;
+		if( rays )
+		{
+			generator = std::make_shared<init_cond::RayFile>( dimension, rays, ray_count, weighted != 0 );
+			config.setParticleCount( ray_count );
+		} else
+		{
+			generator = createInitialConditionGenerator( dimension, job.mIncoming );
+			config.setParticleCount( job.mParticleCount );
+		}
+		config.setEnergyNormalization( job.mNormalizeEnergy );
+		trace->mTracer->setTimeBudget( job.mTimeBudget );
+		trace->mResult = trace->mTracer->trace( generator, config );
+
+		for( const auto& observer : trace->mTracer->getObservers() )
+		{
+			trace->mFileNames.push_back( observer->filename() );
+			trace->mArrays.push_back( observer->getResultArrays() );
+		}
+		return trace.release();
+	}, (bfs_trace*)nullptr );
+}
+
+extern "C" size_t bfs_trace_particle_count( const bfs_trace* trace )
+{
+	return trace->mResult.mParticleCount;
+}
+
+extern "C" size_t bfs_trace_observer_count( const bfs_trace* trace )
+{
+	return trace->mArrays.size();
+}
+
+extern "C" const char* bfs_trace_observer_file( const bfs_trace* trace, size_t observer )
+{
+	return observer < trace->mFileNames.size() ? trace->mFileNames[observer].c_str() : nullptr;
+}
+
+extern "C" size_t bfs_trace_array_count( const bfs_trace* trace, size_t observer )
+{
+	return observer < trace->mArrays.size() ? trace->mArrays[observer].size() : 0;
+}
+
+extern "C" int bfs_trace_array( const bfs_trace* trace, size_t observer, size_t index, bfs_array* array )
+{
+	return guarded( [&]() {
+		if( observer >= trace->mArrays.size() || index >= trace->mArrays[observer].size() )
+			THROW_EXCEPTION( std::out_of_range, "No result array %1% of observer %2%", index, observer );
+		const ResultArray& result = trace->mArrays[observer][index];
+		if( result.mType == typeid(float) )
+			array->type = BFS_FLOAT32;
+		else if( result.mType == typeid(double) )
+			array->type = BFS_FLOAT64;
+		else
+			THROW_EXCEPTION( std::runtime_error, "Result array %1% has unsupported type %2%", result.mName,
+							 result.mType.name() );
+		array->name = result.mName.c_str();
+		array->data = result.mData;
+		array->rank = result.mShape.size();
+		array->shape = result.mShape.data();
+		return 1;
+	}, 0 );
+}
+
+extern "C" int bfs_trace_save( const bfs_trace* trace, const char* path )
+{
+	return guarded( [&]() {
+		return trace->mTracer->saveObservers( path ) ? 1 : 0;
+	}, 0 );
+}
+
+extern "C" void bfs_trace_free( bfs_trace* trace )
+{
+	delete trace;
+}
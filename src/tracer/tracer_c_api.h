@@ -0,0 +1,103 @@
+#ifndef TRACER_C_API_H_INCLUDED
+#define TRACER_C_API_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \file tracer_c_api.h
+	\brief C interface of the tracer, for use from other languages.
+	\details This is the interface of the shared library `libbranchedflowsim_tracer`, which the python module
+			`branchedflowsim.native` loads with ctypes. It allows tracing potentials and rays that are kept in
+			memory, and reading the results of the observers without writing them to files.
+
+			Functions that can fail return `NULL` or `0` in that case, and bfs_last_error() describes the error.
+			Arrays are passed as pointers to their first element, with the elements in row major order.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bfs_potential bfs_potential;
+typedef struct bfs_trace bfs_trace;
+
+/// element types of a bfs_array
+enum bfs_array_type
+{
+	BFS_FLOAT32 = 0,
+	BFS_FLOAT64 = 1
+};
+
+/// a result array of an observer, see bfs_trace_array().
+typedef struct bfs_array
+{
+	const char* name;
+	const void* data;		//!< first element, valid until the trace is freed
+	int type;				//!< one of bfs_array_type
+	size_t rank;
+	const size_t* shape;	//!< `rank` extents
+} bfs_array;
+
+/// the message of the last error in the calling thread, or an empty string.
+const char* bfs_last_error( void );
+
+/// loads the potential file \p file_name, as written by potgen.
+bfs_potential* bfs_potential_load( const char* file_name );
+
+/// \brief creates a \p dimension dimensional potential without data.
+/// \details \p extents are the number of grid points and \p support the size of the domain along each axis. The
+///			potential and its derivatives have to be set with bfs_potential_set_grid().
+bfs_potential* bfs_potential_new( size_t dimension, const size_t* extents, const double* support );
+
+/// \brief copies \p data, which has the extents of the potential, into the grid of the derivative \p derivative.
+/// \details \p derivative gives the order of the derivative along each axis, or is `NULL` for the potential itself.
+/// \return 1 on success, 0 otherwise.
+int bfs_potential_set_grid( bfs_potential* potential, const int* derivative, const double* data );
+
+/// number of dimensions of \p potential.
+size_t bfs_potential_dimension( const bfs_potential* potential );
+
+/// frees \p potential. Traces on the potential keep its data alive.
+void bfs_potential_free( bfs_potential* potential );
+
+/*! \brief traces \p potential and returns the results.
+	\details \p arguments are the options of the tracer for a single trace, as understood by parseTraceJob(),
+			without the potential file and the result path. Setting the strength with `-s` scales the grids of
+			\p potential. If \p rays is not `NULL`, it contains \p ray_count records of a ray file (position,
+			velocity and, if \p weighted, a weight) that replace the incoming wave and the particle count. The rays
+			are only read during the call.
+
+			Traces within one process are run one after another, as the observers number their rays with a
+			shared counter.
+*/
+bfs_trace* bfs_trace_run( bfs_potential* potential, const char* arguments, const double* rays, uint64_t ray_count,
+						  int weighted );
+
+/// number of rays that were traced.
+size_t bfs_trace_particle_count( const bfs_trace* trace );
+
+/// number of observers of \p trace.
+size_t bfs_trace_observer_count( const bfs_trace* trace );
+
+/// file name that observer number \p observer saves its results to, or `NULL` if there is no such observer.
+const char* bfs_trace_observer_file( const bfs_trace* trace, size_t observer );
+
+/// number of result arrays of observer number \p observer, see Observer::getResultArrays().
+size_t bfs_trace_array_count( const bfs_trace* trace, size_t observer );
+
+/// \brief describes result array \p index of observer number \p observer in \p array.
+/// \return 1 on success, 0 if there is no such array or it has an unsupported type.
+int bfs_trace_array( const bfs_trace* trace, size_t observer, size_t index, bfs_array* array );
+
+/// \brief saves the results of all observers into the existing directory \p path, as the tracer does.
+/// \return 1 if all results were saved, 0 otherwise.
+int bfs_trace_save( const bfs_trace* trace, const char* path );
+
+/// frees \p trace, which invalidates its arrays.
+void bfs_trace_free( bfs_trace* trace );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACER_C_API_H_INCLUDED
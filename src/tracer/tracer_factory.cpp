@@ -9,6 +9,7 @@
 #include "fileIO.hpp"
 #include "interpolation.hpp"
 #include "factory/factory.hpp"
+#include "numa.hpp"
 
 using std::fstream;
 
@@ -17,14 +18,13 @@ TracerFactory::TracerFactory() = default;
 void TracerFactory::loadFile( std::string filename )
 {
 	mFilename = std::move(filename);
-	fstream ifile(mFilename, fstream::in | std::fstream::binary);
-	if( !ifile.is_open() )
+	if( !fstream(mFilename, fstream::in | std::fstream::binary).is_open() )
 	{
 		std::cerr << "could not open potential file " << mFilename << "\n";
 		exit( EXIT_FAILURE );
 	}
 
-	setPotential(Potential::readFromFile(ifile));
+	setPotential(Potential::readFromFile(mFilename));
 }
 
 void TracerFactory::setPotential( Potential p )
@@ -32,6 +32,11 @@ void TracerFactory::setPotential( Potential p )
 	mPotential = std::make_shared<Potential>( std::move(p) );
 }
 
+void TracerFactory::setPotential( std::shared_ptr<Potential> p )
+{
+	mPotential = std::move(p);
+}
+
 void TracerFactory::setPeriodicBondaries( bool pb )
 {
 	mPeriodicBoundaries = pb;
@@ -42,27 +47,17 @@ std::shared_ptr<Tracer> TracerFactory::createTracer() const
 	if(!mPotential)
 		THROW_EXCEPTION( std::runtime_error, "trying to create tracer, but no potential has been set!");
 
-	// figure out whether we need monodromy
-	// create observers
-	bool monodromy = std::any_of(begin(mObserverConfig), end(mObserverConfig),
-				[](const std::vector<std::string>& options ){
-					return getObserverFactory().get_builder(options.front())->need_monodromy(); }
-	);
-	auto dynamics = getDynamicsFactory().create(mDynamicsType, mDynamicsConfig, *mPotential, mPeriodicBoundaries,
-												monodromy);
-		
+	if(mNumaPolicy == NumaPolicy::INTERLEAVE && !mPotential->interleaveMemory() && getNumaNodeCount() > 1)
+		std::cerr << "could not interleave the potential over the NUMA nodes\n";
+
+	auto dynamics = mDynamics ? mDynamics : createDynamics();
 	auto tracer = std::make_shared<Tracer>( *mPotential, std::move(dynamics));
 
 	tracer->setMaxThreads( mThreads );
+	tracer->setNumaReplication( mNumaPolicy == NumaPolicy::REPLICATE );
 
-	// create observers
-	for(const auto& cfg : mObserverConfig)
-	{
-		std::vector<std::string> options;
-		std::copy(cfg.begin() + 1, cfg.end(), std::back_inserter(options));
-		auto observer = getObserverFactory().create(cfg.front(), options, *mPotential);
+	for(auto& observer : createObservers())
 		tracer->addObserver( std::move(observer) );
-	}
 
 	tracer->setErrorBounds( mAbsErr, mRelErr );
 	tracer->setEndTime( mEndTime );
@@ -75,6 +70,43 @@ std::shared_ptr<Tracer> TracerFactory::createTracer() const
 	return tracer;
 }
 
+bool TracerFactory::needsMonodromy() const
+{
+	return std::any_of(begin(mObserverConfig), end(mObserverConfig),
+				[](const std::vector<std::string>& options ){
+					return getObserverFactory().get_builder(options.front())->need_monodromy(); }
+	);
+}
+
+std::shared_ptr<RayDynamics> TracerFactory::createDynamics() const
+{
+	if(!mPotential)
+		THROW_EXCEPTION( std::runtime_error, "trying to create dynamics, but no potential has been set!");
+
+	return getDynamicsFactory().create(mDynamicsType, mDynamicsConfig, *mPotential, mPeriodicBoundaries,
+									   needsMonodromy());
+}
+
+void TracerFactory::setDynamics( std::shared_ptr<RayDynamics> dynamics )
+{
+	mDynamics = std::move(dynamics);
+}
+
+std::vector<std::shared_ptr<Observer>> TracerFactory::createObservers() const
+{
+	if(!mPotential)
+		THROW_EXCEPTION( std::runtime_error, "trying to create observers, but no potential has been set!");
+
+	std::vector<std::shared_ptr<Observer>> observers;
+	for(const auto& cfg : mObserverConfig)
+	{
+		std::vector<std::string> options;
+		std::copy(cfg.begin() + 1, cfg.end(), std::back_inserter(options));
+		observers.push_back( getObserverFactory().create(cfg.front(), options, *mPotential) );
+	}
+	return observers;
+}
+
 void TracerFactory::setPotentialStrength( double strength )
 { ;
 	mPotential->setStrength(strength);
@@ -129,3 +161,15 @@ void TracerFactory::setIntegrator(const std::string& integrator) {
         THROW_EXCEPTION( std::runtime_error, "Unknown integrator %1%", integrator);
     }
 }
+
+void TracerFactory::setNumaPolicy(const std::string& policy) {
+    if(policy == "off") {
+        mNumaPolicy = NumaPolicy::OFF;
+    } else if(policy == "interleave") {
+        mNumaPolicy = NumaPolicy::INTERLEAVE;
+    } else if(policy == "replicate") {
+        mNumaPolicy = NumaPolicy::REPLICATE;
+    } else {
+        THROW_EXCEPTION( std::runtime_error, "Unknown NUMA policy %1%", policy);
+    }
+}
@@ -8,6 +8,8 @@
 
 class Tracer;
 class Potential;
+class Observer;
+class RayDynamics;
 enum class Integrator : int;
 
 class TracerFactory
@@ -20,6 +22,8 @@ public:
 	// set a potential
 	void loadFile( std::string filename );
 	void setPotential( Potential p );
+	/// uses \p p, which may be shared with other factories. setPotentialStrength() then changes it for all of them.
+	void setPotential( std::shared_ptr<Potential> p );
 
 	void setObserverConfig( std::vector<std::string> cfg );
 	void setDynamicsConfig( std::vector<std::string> cfg );
@@ -29,12 +33,27 @@ public:
 	void setEndTime( double et ) { mEndTime = et; };
 	void setTimeStep( double dt ) { mDT = dt; };
 	void setIntegrator(const std::string& integrator);
+	/// how the potential is placed on machines with several NUMA nodes. One of (off, interleave, replicate).
+	void setNumaPolicy(const std::string& policy);
 
 	// potential
 	void setPotentialStrength( double s );
 	std::string getPotentialInfo() const;
 
 	std::shared_ptr<Tracer> createTracer(  ) const;
+
+	/// whether any of the observers given by setObserverConfig() needs the monodromy matrix.
+	bool needsMonodromy() const;
+
+	/// creates the dynamics given by setDynamicsConfig() and setPeriodicBondaries(), for the current observers.
+	std::shared_ptr<RayDynamics> createDynamics() const;
+
+	/// \brief makes createTracer() use \p dynamics instead of creating new ones. They have to be created for the
+	///			potential of this factory, with the same configuration. A null pointer restores the default.
+	void setDynamics( std::shared_ptr<RayDynamics> dynamics );
+
+	/// creates the observers given by setObserverConfig(), for the geometry of the potential.
+	std::vector<std::shared_ptr<Observer>> createObservers() const;
 private:
 	std::string mFilename;
 	bool mPeriodicBoundaries = false;
@@ -44,9 +63,11 @@ private:
 	Integrator mIntegrator = Integrator::RUNGE_KUTTA_CASH_KARP_54_ADAPTIVE;
 	double mEndTime;
 	double mDT = -1;
+	enum class NumaPolicy { OFF, INTERLEAVE, REPLICATE } mNumaPolicy = NumaPolicy::OFF;
 	std::string mPotentialDataString;
 
 	std::shared_ptr<Potential> mPotential;
+	std::shared_ptr<RayDynamics> mDynamics;
 	std::vector<std::vector<std::string>> mObserverConfig;
 	std::string mDynamicsType;
 	std::vector<std::string> mDynamicsConfig;